@@ -5,8 +5,11 @@
   Reads nodes from an OSM file and writes out their locations to a cache
   file. The cache file can then be read with osmium_location_cache_use.
 
+  The cache file has a header describing its contents and a checksum, so
+  it can be checked before it is used and updated later.
+
   Warning: The locations cache file will get huge (>32GB) if you are using
-           the DenseFileArray index even if the input file is small, because
+           the DenseCacheFile index even if the input file is small, because
            it depends on the *largest* node ID, not the number of nodes.
 
   DEMONSTRATES USE OF:
@@ -42,7 +45,7 @@
 
 // For the location index. There are different types of index implementation
 // available. These implementations put the index on disk. See below.
-#include <osmium/index/map/dense_file_array.hpp>
+#include <osmium/index/map/dense_cache_file.hpp>
 #include <osmium/index/map/sparse_file_array.hpp>
 
 // For the NodeLocationForWays handler
@@ -52,9 +55,12 @@
 #include <osmium/visitor.hpp>
 
 // Chose one of these two. "sparse" is best used for small and medium extracts,
-// the "dense" index for large extracts or the whole planet.
-using index_type = osmium::index::map::SparseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
-//using index_type = osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
+// the "dense" index for large extracts or the whole planet. The sparse index
+// writes only the raw data without a header, so if you use it, remove the
+// calls to set_timestamp(), set_sequence_number(), commit(), and count()
+// below.
+//using index_type = osmium::index::map::SparseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
+using index_type = osmium::index::map::DenseCacheFile<osmium::unsigned_object_id_type, osmium::Location>;
 
 // The location handler always depends on the index type
 using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
@@ -82,6 +88,17 @@ int main(int argc, char* argv[]) {
 #endif
     index_type index{fd};
 
+    // Remember where the data came from, if the input file tells us.
+    const osmium::io::Header header{reader.header()};
+    const std::string timestamp{header.get("osmosis_replication_timestamp")};
+    if (!timestamp.empty()) {
+        index.set_timestamp(osmium::Timestamp{timestamp});
+    }
+    const std::string sequence_number{header.get("osmosis_replication_sequence_number")};
+    if (!sequence_number.empty()) {
+        index.set_sequence_number(std::stoull(sequence_number));
+    }
+
     // The handler that stores all node locations in the index.
     location_handler_type location_handler{index};
 
@@ -90,5 +107,11 @@ int main(int argc, char* argv[]) {
 
     // Explicitly close input so we get notified of any errors.
     reader.close();
+
+    // Write the checksum into the cache file. This would also be done
+    // when the index is destroyed, but then we wouldn't see any errors.
+    index.commit();
+
+    std::cout << "Stored " << index.count() << " locations\n";
 }
 
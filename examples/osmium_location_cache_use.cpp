@@ -5,8 +5,11 @@
   This reads ways from an OSM file and writes out the way node locations
   it got from a location cache generated with osmium_location_cache_create.
 
+  The cache file has a header describing its contents and a checksum, so
+  it can be checked before it is used and updated later.
+
   Warning: The locations cache file will get huge (>32GB) if you are using
-           the DenseFileArray index even if the input file is small, because
+           the DenseCacheFile index even if the input file is small, because
            it depends on the *largest* node ID, not the number of nodes.
 
   DEMONSTRATES USE OF:
@@ -42,7 +45,7 @@
 
 // For the location index. There are different types of index implementation
 // available. These implementations put the index on disk. See below.
-#include <osmium/index/map/dense_file_array.hpp>
+#include <osmium/index/map/dense_cache_file.hpp>
 #include <osmium/index/map/sparse_file_array.hpp>
 
 // For the NodeLocationForWays handler
@@ -52,9 +55,12 @@
 #include <osmium/visitor.hpp>
 
 // Chose one of these two. "sparse" is best used for small and medium extracts,
-// the "dense" index for large extracts or the whole planet.
-using index_type = osmium::index::map::SparseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
-//using index_type = osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
+// the "dense" index for large extracts or the whole planet. The sparse index
+// reads only the raw data without a header, so if you use it, remove the
+// calls to is_clean(), count(), timestamp(), sequence_number(), and advise()
+// below.
+//using index_type = osmium::index::map::SparseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
+using index_type = osmium::index::map::DenseCacheFile<osmium::unsigned_object_id_type, osmium::Location>;
 
 // The location handler always depends on the index type
 using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
@@ -95,6 +101,17 @@ int main(int argc, char* argv[]) {
 #endif
     index_type index{fd};
 
+    // Only use a cache that was written completely.
+    if (!index.is_clean()) {
+        std::cerr << "Location cache file '" << cache_filename << "' was not written completely\n";
+        return 1;
+    }
+    std::cerr << "Using cache with " << index.count() << " locations from "
+              << index.timestamp().to_iso() << " (sequence number " << index.sequence_number() << ")\n";
+
+    // Lookups will be all over the place, so reading ahead doesn't help.
+    index.advise(osmium::MemoryMapping::access_advice::random);
+
     // The handler that adds node locations from the index to the ways.
     location_handler_type location_handler{index};
 
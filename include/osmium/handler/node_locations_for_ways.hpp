@@ -37,14 +37,17 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/index/index.hpp>
 #include <osmium/index/map/dummy.hpp>
 #include <osmium/index/node_locations_map.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
 
-#include <limits>
+#include <cstddef>
 #include <type_traits>
+#include <vector>
 
 namespace osmium {
 
@@ -52,6 +55,109 @@ namespace osmium {
 
         using dummy_type = osmium::index::map::Dummy<osmium::unsigned_object_id_type, osmium::Location>;
 
+        namespace detail {
+
+            /**
+             * Looks up the locations for the nodes of ways in batches and
+             * adds them to the ways. Only reads from the indexes, so copies
+             * of this class can be used in several threads at the same time
+             * as long as no locations are added to the indexes.
+             */
+            template <typename TStoragePosIDs, typename TStorageNegIDs>
+            class way_locations_lookup {
+
+                const TStoragePosIDs* m_storage_pos;
+                const TStorageNegIDs* m_storage_neg;
+
+                // Node refs (and their ids) whose locations are looked up
+                // together.
+                std::vector<osmium::unsigned_object_id_type> m_pos_ids;
+                std::vector<osmium::NodeRef*> m_pos_refs;
+                std::vector<osmium::unsigned_object_id_type> m_neg_ids;
+                std::vector<osmium::NodeRef*> m_neg_refs;
+                std::vector<osmium::Location> m_locations;
+
+                bool m_ignore_errors = false;
+
+                template <typename TStorage>
+                bool lookup(const TStorage& storage, std::vector<osmium::unsigned_object_id_type>& ids, std::vector<osmium::NodeRef*>& refs) {
+                    bool found_all = true;
+                    if (!ids.empty()) {
+                        m_locations.resize(ids.size());
+                        storage.get_many(ids.data(), m_locations.data(), ids.size());
+                        for (std::size_t i = 0; i < ids.size(); ++i) {
+                            refs[i]->set_location(m_locations[i]);
+                            if (!m_locations[i]) {
+                                found_all = false;
+                            }
+                        }
+                        ids.clear();
+                        refs.clear();
+                    }
+                    return found_all;
+                }
+
+            public:
+
+                // Number of node refs after which the locations should be
+                // looked up.
+                enum constant_batch_size : std::size_t {
+                    batch_size = 4096
+                };
+
+                way_locations_lookup(const TStoragePosIDs& storage_pos, const TStorageNegIDs& storage_neg) noexcept :
+                    m_storage_pos(&storage_pos),
+                    m_storage_neg(&storage_neg) {
+                }
+
+                void ignore_errors() noexcept {
+                    m_ignore_errors = true;
+                }
+
+                /// The number of node refs waiting for lookup.
+                std::size_t size() const noexcept {
+                    return m_pos_ids.size() + m_neg_ids.size();
+                }
+
+                bool empty() const noexcept {
+                    return m_pos_ids.empty() && m_neg_ids.empty();
+                }
+
+                /**
+                 * Remember the node refs of the way for the next lookup. The
+                 * way must not be moved or changed until then.
+                 */
+                void add(osmium::Way& way) {
+                    for (auto& node_ref : way.nodes()) {
+                        const auto id = node_ref.ref();
+                        if (id >= 0) {
+                            m_pos_ids.push_back(static_cast<osmium::unsigned_object_id_type>( id));
+                            m_pos_refs.push_back(&node_ref);
+                        } else {
+                            m_neg_ids.push_back(static_cast<osmium::unsigned_object_id_type>(-id));
+                            m_neg_refs.push_back(&node_ref);
+                        }
+                    }
+                }
+
+                /**
+                 * Look up the locations of all node refs added and set them.
+                 *
+                 * @throws osmium::not_found if a location is missing and
+                 *         errors are not ignored.
+                 */
+                void lookup() {
+                    const bool found_pos = lookup(*m_storage_pos, m_pos_ids, m_pos_refs);
+                    const bool found_neg = lookup(*m_storage_neg, m_neg_ids, m_neg_refs);
+                    if (!m_ignore_errors && !(found_pos && found_neg)) {
+                        throw osmium::not_found{"location for one or more nodes not found in node location index"};
+                    }
+                }
+
+            }; // class way_locations_lookup
+
+        } // namespace detail
+
         /**
          * Handler to retrieve locations from nodes and add them to ways.
          *
@@ -82,11 +188,10 @@ namespace osmium {
             /// Object that handles the actual storage of the node locations (with negative IDs).
             TStorageNegIDs& m_storage_neg;
 
-            osmium::unsigned_object_id_type m_last_id = 0;
-
-            bool m_ignore_errors = false;
+            // Set when nodes were added after the last prepare_lookup().
+            bool m_must_prepare = false;
 
-            bool m_must_sort = false;
+            detail::way_locations_lookup<TStoragePosIDs, TStorageNegIDs> m_lookup;
 
             // It is okay to have this static dummy instance, even when using several threads,
             // because it is read-only.
@@ -100,7 +205,8 @@ namespace osmium {
             explicit NodeLocationsForWays(TStoragePosIDs& storage_pos,
                                           TStorageNegIDs& storage_neg = get_dummy()) noexcept :
                 m_storage_pos(storage_pos),
-                m_storage_neg(storage_neg) {
+                m_storage_neg(storage_neg),
+                m_lookup(storage_pos, storage_neg) {
             }
 
             NodeLocationsForWays(const NodeLocationsForWays&) = delete;
@@ -111,18 +217,45 @@ namespace osmium {
 
             ~NodeLocationsForWays() noexcept = default;
 
+            /// The type returned by make_lookup().
+            using lookup_type = detail::way_locations_lookup<TStoragePosIDs, TStorageNegIDs>;
+
             void ignore_errors() {
-                m_ignore_errors = true;
+                m_lookup.ignore_errors();
+            }
+
+            /**
+             * Sort the indexes so that locations can be looked up. The
+             * indexes are sorted even if the nodes came in order, because
+             * some of them build their lookup tables in sort(). Sorting is
+             * cheap if there is nothing to sort. This is done
+             * automatically before the first way is handled, call it
+             * explicitly before using make_lookup().
+             */
+            void prepare_lookup() {
+                if (m_must_prepare) {
+                    m_storage_pos.sort();
+                    m_storage_neg.sort();
+                    m_must_prepare = false;
+                }
+            }
+
+            /**
+             * Create an object that can add locations to ways like this
+             * handler does, but which only reads from the indexes. Copies
+             * of it can be used from several threads at the same time, as
+             * long as no nodes are added through this handler. Call
+             * prepare_lookup() before using it.
+             */
+            lookup_type make_lookup() const {
+                return m_lookup;
             }
 
             /**
              * Store the location of the node in the storage.
              */
             void node(const osmium::Node& node) {
-                if (node.positive_id() < m_last_id) {
-                    m_must_sort = true;
-                }
-                m_last_id = node.positive_id();
+                m_must_prepare = true;
 
                 const auto id = node.id();
                 if (id >= 0) {
@@ -147,21 +280,44 @@ namespace osmium {
              * them to the way object.
              */
             void way(osmium::Way& way) {
-                if (m_must_sort) {
-                    m_storage_pos.sort();
-                    m_storage_neg.sort();
-                    m_must_sort = false;
-                    m_last_id = std::numeric_limits<osmium::unsigned_object_id_type>::max();
-                }
-                bool error = false;
-                for (auto& node_ref : way.nodes()) {
-                    node_ref.set_location(get_node_location(node_ref.ref()));
-                    if (!node_ref.location()) {
-                        error = true;
+                prepare_lookup();
+                m_lookup.add(way);
+                m_lookup.lookup();
+            }
+
+            /**
+             * Store the locations of all nodes in the buffer and add the
+             * locations to all ways in the buffer. This does the same as
+             * osmium::apply(buffer, handler), but the locations for the
+             * nodes of many ways are looked up together. This is much
+             * faster with large indexes, because the index can have many
+             * memory accesses in flight at the same time (see
+             * osmium::index::map::Map::get_many()).
+             *
+             * If locations are missing and errors are not ignored, the
+             * osmium::not_found exception is only thrown after all ways
+             * looked up together with the way missing locations have been
+             * updated.
+             */
+            void apply_buffer(osmium::memory::Buffer& buffer) {
+                for (auto& object : buffer.select<osmium::OSMObject>()) {
+                    if (object.type() == osmium::item_type::node) {
+                        if (!m_lookup.empty()) {
+                            m_lookup.lookup();
+                        }
+                        node(static_cast<const osmium::Node&>(object));
+                    } else if (object.type() == osmium::item_type::way) {
+                        if (m_lookup.empty()) {
+                            prepare_lookup();
+                        }
+                        m_lookup.add(static_cast<osmium::Way&>(object));
+                        if (m_lookup.size() >= lookup_type::batch_size) {
+                            m_lookup.lookup();
+                        }
                     }
                 }
-                if (!m_ignore_errors && error) {
-                    throw osmium::not_found{"location for one or more nodes not found in node location index"};
+                if (!m_lookup.empty()) {
+                    m_lookup.lookup();
                 }
             }
 
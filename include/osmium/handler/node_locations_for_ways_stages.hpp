@@ -0,0 +1,166 @@
+#ifndef OSMIUM_HANDLER_NODE_LOCATIONS_FOR_WAYS_STAGES_HPP
+#define OSMIUM_HANDLER_NODE_LOCATIONS_FOR_WAYS_STAGES_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler/check_order.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pipeline.hpp>
+
+#include <utility>
+
+namespace osmium {
+
+    namespace handler {
+
+        namespace detail {
+
+            /**
+             * Pipeline stage storing the node locations in the indexes.
+             * Runs in a single thread. Before the first buffer with ways is
+             * handed to the next stage, the indexes are prepared for
+             * lookups, after that no more nodes are allowed.
+             */
+            template <typename TStoragePosIDs, typename TStorageNegIDs>
+            class store_node_locations_stage {
+
+                NodeLocationsForWays<TStoragePosIDs, TStorageNegIDs>* m_handler;
+                bool m_seen_ways = false;
+
+            public:
+
+                explicit store_node_locations_stage(NodeLocationsForWays<TStoragePosIDs, TStorageNegIDs>& handler) noexcept :
+                    m_handler(&handler) {
+                }
+
+                osmium::memory::Buffer operator()(osmium::memory::Buffer&& buffer) {
+                    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                        if (object.type() == osmium::item_type::node) {
+                            if (m_seen_ways) {
+                                throw osmium::out_of_order_error{"Found a node after a way. Input must be sorted for parallel location lookup.", object.id()};
+                            }
+                            m_handler->node(static_cast<const osmium::Node&>(object));
+                        } else if (!m_seen_ways && object.type() == osmium::item_type::way) {
+                            m_handler->prepare_lookup();
+                            m_seen_ways = true;
+                        }
+                    }
+                    return std::move(buffer);
+                }
+
+            }; // class store_node_locations_stage
+
+            /**
+             * Pipeline stage adding the locations to the ways. Only reads
+             * from the indexes, so it can run in several threads.
+             */
+            template <typename TStoragePosIDs, typename TStorageNegIDs>
+            class add_way_locations_stage {
+
+                using lookup_type = typename NodeLocationsForWays<TStoragePosIDs, TStorageNegIDs>::lookup_type;
+
+                lookup_type m_lookup;
+
+            public:
+
+                explicit add_way_locations_stage(lookup_type&& lookup) :
+                    m_lookup(std::move(lookup)) {
+                }
+
+                osmium::memory::Buffer operator()(osmium::memory::Buffer&& buffer) {
+                    for (auto& way : buffer.select<osmium::Way>()) {
+                        m_lookup.add(way);
+                        if (m_lookup.size() >= lookup_type::batch_size) {
+                            m_lookup.lookup();
+                        }
+                    }
+                    if (!m_lookup.empty()) {
+                        m_lookup.lookup();
+                    }
+                    return std::move(buffer);
+                }
+
+            }; // class add_way_locations_stage
+
+        } // namespace detail
+
+        /**
+         * Add stages to the pipeline that do the same as the
+         * NodeLocationsForWays handler, but look up the locations for the
+         * ways in several threads.
+         *
+         * The first stage runs in a single thread and stores the locations
+         * of all nodes in the indexes. Because the stages keep the order
+         * of the buffers, all nodes are stored before the first buffer with
+         * ways gets to the second stage. From then on the indexes are only
+         * read, so the second stage can look up the locations for the ways
+         * in several threads. This only works if all nodes come before all
+         * ways in the input (as in all sorted OSM files), otherwise an
+         * osmium::out_of_order_error is thrown.
+         *
+         * Usage:
+         * @code
+         * index_type index;
+         * osmium::handler::NodeLocationsForWays<index_type> handler{index};
+         *
+         * osmium::thread::Pipeline pipeline;
+         * osmium::handler::add_node_locations_stages(pipeline, handler, 4);
+         * pipeline.run(reader, writer);
+         * @endcode
+         *
+         * @param pipeline The pipeline to add the stages to.
+         * @param handler The handler with the indexes. Call ignore_errors()
+         *                on it before calling this function if needed.
+         *                It must be alive while the pipeline runs.
+         * @param num_threads The number of threads for looking up the
+         *                    locations. If this is 0, the same rules as
+         *                    for the osmium::thread::Pool apply.
+         * @returns Reference to the pipeline.
+         */
+        template <typename TStoragePosIDs, typename TStorageNegIDs>
+        osmium::thread::Pipeline& add_node_locations_stages(osmium::thread::Pipeline& pipeline, NodeLocationsForWays<TStoragePosIDs, TStorageNegIDs>& handler, int num_threads = 0) {
+            pipeline.add_stage(detail::store_node_locations_stage<TStoragePosIDs, TStorageNegIDs>{handler}, 1, "node_locations");
+            pipeline.add_stage(detail::add_way_locations_stage<TStoragePosIDs, TStorageNegIDs>{handler.make_lookup()}, num_threads, "way_locations");
+            return pipeline;
+        }
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_NODE_LOCATIONS_FOR_WAYS_STAGES_HPP
@@ -0,0 +1,130 @@
+#ifndef OSMIUM_HANDLER_NODE_LOCATIONS_UPDATER_HPP
+#define OSMIUM_HANDLER_NODE_LOCATIONS_UPDATER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstddef>
+
+namespace osmium {
+
+    namespace handler {
+
+        /**
+         * Handler to update a node location index with the changes from
+         * a change file (.osc), for instance a replication diff. Created
+         * and modified nodes set their location in the index, deleted
+         * nodes set the empty location (Location{}), which removes them
+         * from the index. If a change file contains several versions of a
+         * node, they must be in order, which they are in replication
+         * diffs.
+         *
+         * The storage is changed in place, so it has to support updates.
+         * Use the dense indexes (for instance DenseFileArray or
+         * DenseCacheFile) or the UpdatableSparseFileArray. The other
+         * sparse indexes can't be updated this way. After the changes
+         * are applied, make them durable with flush() on file-based
+         * dense indexes (and fsync the file), commit() on the
+         * DenseCacheFile, or checkpoint() on the UpdatableSparseFileArray.
+         *
+         * @tparam TStoragePosIDs Class that handles the actual storage of the node locations
+         *                        (for positive IDs). It must support the set(id, value) method.
+         * @tparam TStorageNegIDs Same but for negative IDs.
+         */
+        template <typename TStoragePosIDs, typename TStorageNegIDs = dummy_type>
+        class NodeLocationsUpdater : public osmium::handler::Handler {
+
+            TStoragePosIDs& m_storage_pos;
+            TStorageNegIDs& m_storage_neg;
+
+            std::size_t m_updated = 0;
+            std::size_t m_removed = 0;
+
+            // Dummy storage for negative ids. Setting values in it does
+            // nothing, so it can be shared.
+            static dummy_type& get_dummy() {
+                static dummy_type instance;
+                return instance;
+            }
+
+        public:
+
+            explicit NodeLocationsUpdater(TStoragePosIDs& storage_pos,
+                                          TStorageNegIDs& storage_neg = get_dummy()) noexcept :
+                m_storage_pos(storage_pos),
+                m_storage_neg(storage_neg) {
+            }
+
+            /**
+             * Set the location of the node in the storage or remove it if
+             * the node was deleted.
+             */
+            void node(const osmium::Node& node) {
+                osmium::Location location;
+                if (node.visible()) {
+                    location = node.location();
+                    ++m_updated;
+                } else {
+                    ++m_removed;
+                }
+
+                const auto id = node.id();
+                if (id >= 0) {
+                    m_storage_pos.set(static_cast<osmium::unsigned_object_id_type>( id), location);
+                } else {
+                    m_storage_neg.set(static_cast<osmium::unsigned_object_id_type>(-id), location);
+                }
+            }
+
+            /// The number of created or modified nodes seen.
+            std::size_t updated() const noexcept {
+                return m_updated;
+            }
+
+            /// The number of deleted nodes seen.
+            std::size_t removed() const noexcept {
+                return m_removed;
+            }
+
+        }; // class NodeLocationsUpdater
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_NODE_LOCATIONS_UPDATER_HPP
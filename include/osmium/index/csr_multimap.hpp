@@ -0,0 +1,578 @@
+#ifndef OSMIUM_INDEX_CSR_MULTIMAP_HPP
+#define OSMIUM_INDEX_CSR_MULTIMAP_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/radix_sort.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        template <typename TId, typename TValue>
+        class CsrMultimapBuilder;
+
+        namespace detail {
+
+            enum constant_csr_bits : unsigned {
+                csr_bits = 16,
+                csr_base_bits = 8
+            };
+
+            enum constant_csr_block_size : uint64_t {
+                csr_block_size = 1ULL << csr_bits
+            };
+
+            // A block with this many keys or more stores the rows for
+            // all ids in the block instead of the keys: (2 bytes for each
+            // id vs. 4 bytes (key and row) for each key present).
+            enum constant_csr_min_dense_keys : std::size_t {
+                csr_min_dense_keys = csr_block_size / 2 + (csr_block_size >> csr_base_bits) + 1
+            };
+
+        } // namespace detail
+
+        /**
+         * Multimap from integer ids to values in "compressed sparse row"
+         * format: All values for the same id are stored next to each
+         * other in one large array and get_all() returns them as a
+         * contiguous range. This is typically used as a reverse index from
+         * node ids to the ids of the ways containing those nodes.
+         *
+         * The ids are divided into blocks of 2^16 ids. For each block the
+         * ids that have values (as 16 bit offsets into the block) and the
+         * position of their values are stored, or, if most ids in the
+         * block have values, only the positions for all ids in the block.
+         * Positions are stored as 16 bit numbers relative to a 32 bit base
+         * for every 256 ids. So apart from the values themselves this
+         * needs only 2 to 4 bytes per id. With 32 bit values (way ids fit
+         * into them at the moment) this needs at most half the memory of
+         * the (id, value) pairs in the other multimaps, and much less if
+         * ids are dense or have several values.
+         *
+         * You can not fill this index directly, use CsrMultimapBuilder.
+         * Once built, it can be read from several threads at the same
+         * time.
+         */
+        template <typename TId, typename TValue>
+        class CsrMultimap {
+
+            friend class CsrMultimapBuilder<TId, TValue>;
+
+            struct block_info {
+
+                // Position of the first value of this block in m_values.
+                uint64_t value_pos = 0;
+
+                // Position of the first row in m_rows or m_wide_rows.
+                uint64_t row_pos = 0;
+
+                // Position of the first key in m_keys (sparse blocks only).
+                uint64_t key_pos = 0;
+
+                // Position of the first base in m_bases (narrow blocks only).
+                uint64_t base_pos = 0;
+
+                // Number of keys. If this is the block size, the block is
+                // dense and doesn't have keys.
+                uint32_t num_rows = 0;
+
+                // Rows are stored as 32 bit numbers in m_wide_rows,
+                // because some rows are too long.
+                bool wide = false;
+
+                bool dense() const noexcept {
+                    return num_rows == osmium::index::detail::csr_block_size;
+                }
+
+            }; // struct block_info
+
+            // Position of each block in m_blocks plus one, 0 for blocks
+            // without any ids.
+            std::vector<uint32_t> m_block_index;
+
+            std::vector<block_info> m_blocks;
+
+            // The offsets in their block of the ids in sparse blocks.
+            std::vector<uint16_t> m_keys;
+
+            // Start of the values for each row relative to the base of
+            // the group of 256 rows it is in. There is one more row per
+            // block marking the end of the last row.
+            std::vector<uint16_t> m_rows;
+
+            // Start of the values of each group of 256 rows relative to
+            // the first value of the block.
+            std::vector<uint32_t> m_bases;
+
+            // Start of the values of each row relative to the first value
+            // of the block for wide blocks.
+            std::vector<uint32_t> m_wide_rows;
+
+            std::vector<TValue> m_values;
+
+            static uint64_t block_num(const uint64_t id) noexcept {
+                return id >> osmium::index::detail::csr_bits;
+            }
+
+            static uint32_t offset(const uint64_t id) noexcept {
+                return static_cast<uint32_t>(id & (osmium::index::detail::csr_block_size - 1));
+            }
+
+            const block_info* find_block(const uint64_t id) const noexcept {
+                const auto num = block_num(id);
+                if (num >= m_block_index.size() || m_block_index[num] == 0) {
+                    return nullptr;
+                }
+                return &m_blocks[m_block_index[num] - 1];
+            }
+
+            // The row for the id in the block or -1 if there is none.
+            std::size_t find_row(const block_info& block, const uint64_t id) const noexcept {
+                const auto off = offset(id);
+                if (block.dense()) {
+                    return off;
+                }
+                const auto begin = m_keys.cbegin() + static_cast<std::ptrdiff_t>(block.key_pos);
+                const auto end = begin + block.num_rows;
+                const auto it = std::lower_bound(begin, end, off);
+                if (it == end || *it != off) {
+                    return static_cast<std::size_t>(-1);
+                }
+                return static_cast<std::size_t>(it - begin);
+            }
+
+            uint64_t row_start(const block_info& block, const std::size_t row) const noexcept {
+                if (block.wide) {
+                    return m_wide_rows[block.row_pos + row];
+                }
+                return m_bases[block.base_pos + (row >> osmium::index::detail::csr_base_bits)] + m_rows[block.row_pos + row];
+            }
+
+        public:
+
+            using key_type = TId;
+            using value_type = TValue;
+
+            CsrMultimap() = default;
+
+            /**
+             * Get all values for the id. They are sorted.
+             *
+             * @returns A pair of pointers to the first value and one past
+             *          the last value. Both are the same if there are no
+             *          values for this id.
+             */
+            std::pair<const TValue*, const TValue*> get_all(const TId id) const noexcept {
+                const block_info* block = find_block(id);
+                if (!block) {
+                    return {nullptr, nullptr};
+                }
+                const auto row = find_row(*block, id);
+                if (row == static_cast<std::size_t>(-1)) {
+                    return {nullptr, nullptr};
+                }
+                const TValue* values = m_values.data() + block->value_pos;
+                return {values + row_start(*block, row), values + row_start(*block, row + 1)};
+            }
+
+            /// The number of values for the id.
+            std::size_t count(const TId id) const noexcept {
+                const auto range = get_all(id);
+                return static_cast<std::size_t>(range.second - range.first);
+            }
+
+            /**
+             * Call func with each value for the id.
+             */
+            template <typename TFunc>
+            void for_each(const TId id, TFunc&& func) const {
+                const auto range = get_all(id);
+                for (auto it = range.first; it != range.second; ++it) {
+                    std::forward<TFunc>(func)(*it);
+                }
+            }
+
+            /// Is this index empty?
+            bool empty() const noexcept {
+                return m_values.empty();
+            }
+
+            /// The number of values in this index.
+            std::size_t size() const noexcept {
+                return m_values.size();
+            }
+
+            /// The number of bytes used by this index.
+            std::size_t used_memory() const noexcept {
+                return m_block_index.capacity() * sizeof(uint32_t) +
+                       m_blocks.capacity() * sizeof(block_info) +
+                       m_keys.capacity() * sizeof(uint16_t) +
+                       m_rows.capacity() * sizeof(uint16_t) +
+                       m_bases.capacity() * sizeof(uint32_t) +
+                       m_wide_rows.capacity() * sizeof(uint32_t) +
+                       m_values.capacity() * sizeof(TValue);
+            }
+
+            void clear() {
+                *this = CsrMultimap{};
+            }
+
+        }; // class CsrMultimap
+
+        /**
+         * Builds a CsrMultimap in two passes over the data: First call
+         * count() for each key (id) and value you want to add, then
+         * prepare(), then set() for the same keys and their values (in
+         * any order), then build() to get the finished index.
+         *
+         * @code
+         * CsrMultimapBuilder<osmium::unsigned_object_id_type, uint32_t> builder;
+         * // first pass
+         * for (const auto& node_ref : way.nodes()) {
+         *     builder.count(node_ref.positive_ref());
+         * }
+         * ...
+         * builder.prepare();
+         * // second pass
+         * for (const auto& node_ref : way.nodes()) {
+         *     builder.set(node_ref.positive_ref(), static_cast<uint32_t>(way.id()));
+         * }
+         * ...
+         * const auto index = builder.build();
+         * @endcode
+         *
+         * The first pass needs 2 bytes per key counted and a few dozen
+         * bytes for each block of 2^16 ids that has keys. The finished
+         * index also needs 4 bytes for every block up to the one with the
+         * largest id. Sorting the keys and laying out the index in
+         * prepare() and sorting the values in build() is done in parallel
+         * in the thread pool. The count() and set() functions must not be
+         * called from several threads at the same time.
+         */
+        template <typename TId, typename TValue>
+        class CsrMultimapBuilder {
+
+            using map_type = CsrMultimap<TId, TValue>;
+            using block_info = typename map_type::block_info;
+
+            // The block numbers and the offsets in their block of all keys
+            // counted for each block with keys, in the order the blocks
+            // were first seen. Sorted by block number in prepare().
+            std::vector<std::pair<uint64_t, std::vector<uint16_t>>> m_counted;
+
+            // Position of each block in m_counted.
+            std::unordered_map<uint64_t, std::size_t> m_counted_pos;
+
+            // Position in m_counted of the block the last key was in.
+            std::size_t m_last_counted = 0;
+
+            map_type m_map;
+
+            std::size_t m_num_set = 0;
+
+            // Block numbers of the blocks in m_map.m_blocks.
+            std::vector<uint64_t> m_block_nums;
+
+            template <typename TFunc>
+            void for_each_block(osmium::thread::Pool* pool, TFunc&& func) {
+                const std::size_t num_blocks = m_block_nums.size();
+                if (num_blocks == 0) {
+                    return;
+                }
+                const std::size_t num_threads = pool ? static_cast<std::size_t>(pool->num_threads()) + 1 : 1;
+                const std::size_t num_chunks = std::min(num_blocks, num_threads * 4);
+                osmium::thread::detail::run_chunks(pool, num_chunks, [&](std::size_t chunk) {
+                    const auto end = num_blocks * (chunk + 1) / num_chunks;
+                    for (auto n = num_blocks * chunk / num_chunks; n < end; ++n) {
+                        func(n);
+                    }
+                });
+            }
+
+            // Call func(row, key, count) for all keys in the sorted keys of
+            // a block, including the keys without values in dense blocks.
+            template <typename TFunc>
+            static void for_each_row(const std::vector<uint16_t>& keys, bool dense, TFunc&& func) {
+                std::size_t row = 0;
+                for (auto it = keys.cbegin(); it != keys.cend();) {
+                    const auto key = *it;
+                    const auto end = std::upper_bound(it, keys.cend(), key);
+                    if (dense) {
+                        for (; row < key; ++row) {
+                            func(row, static_cast<uint16_t>(row), 0);
+                        }
+                    }
+                    func(row++, key, static_cast<std::size_t>(end - it));
+                    it = end;
+                }
+                if (dense) {
+                    for (; row < osmium::index::detail::csr_block_size; ++row) {
+                        func(row, static_cast<uint16_t>(row), 0);
+                    }
+                }
+            }
+
+        public:
+
+            CsrMultimapBuilder() = default;
+
+            /**
+             * Count a key (first pass).
+             */
+            void count(const TId id) {
+                const uint64_t num = map_type::block_num(id);
+                if (m_counted.empty() || m_counted[m_last_counted].first != num) {
+                    auto it = m_counted_pos.find(num);
+                    if (it == m_counted_pos.end()) {
+                        it = m_counted_pos.emplace(num, m_counted.size()).first;
+                        m_counted.emplace_back(num, std::vector<uint16_t>{});
+                    }
+                    m_last_counted = it->second;
+                }
+                m_counted[m_last_counted].second.push_back(static_cast<uint16_t>(map_type::offset(id)));
+            }
+
+            /**
+             * Lay out the index for the keys counted. Call this after the
+             * first and before the second pass.
+             *
+             * Do not call this from a thread of the pool given.
+             *
+             * @param pool Thread pool to use. If this is nullptr, all work
+             *             is done in the current thread.
+             */
+            void prepare(osmium::thread::Pool* pool = &osmium::thread::Pool::default_instance()) {
+                using osmium::index::detail::csr_base_bits;
+
+                std::unordered_map<uint64_t, std::size_t>{}.swap(m_counted_pos);
+                std::sort(m_counted.begin(), m_counted.end(), [](const std::pair<uint64_t, std::vector<uint16_t>>& a, const std::pair<uint64_t, std::vector<uint16_t>>& b) {
+                    return a.first < b.first;
+                });
+
+                m_block_nums.clear();
+                m_block_nums.reserve(m_counted.size());
+                for (const auto& counted : m_counted) {
+                    m_block_nums.push_back(counted.first);
+                }
+                m_map.m_block_index.assign(m_block_nums.empty() ? 0 : m_block_nums.back() + 1, 0);
+                m_map.m_blocks.assign(m_block_nums.size(), block_info{});
+
+                // Sort the keys of each block, find out how many rows it
+                // has and whether the rows fit into 16 bits.
+                for_each_block(pool, [this](std::size_t n) {
+                    auto& keys = m_counted[n].second;
+                    std::sort(keys.begin(), keys.end());
+                    if (keys.size() > std::numeric_limits<uint32_t>::max()) {
+                        throw std::length_error{"too many values for ids in one block of CsrMultimap"};
+                    }
+
+                    std::size_t num_keys = 0;
+                    for_each_row(keys, false, [&num_keys](std::size_t /*row*/, uint16_t /*key*/, std::size_t /*count*/) {
+                        ++num_keys;
+                    });
+
+                    block_info& block = m_map.m_blocks[n];
+                    const bool dense = num_keys >= osmium::index::detail::csr_min_dense_keys;
+                    block.num_rows = dense ? static_cast<uint32_t>(osmium::index::detail::csr_block_size) : static_cast<uint32_t>(num_keys);
+
+                    std::size_t group_count = 0;
+                    for_each_row(keys, dense, [&](std::size_t row, uint16_t /*key*/, std::size_t count) {
+                        if ((row & ((1U << csr_base_bits) - 1)) == 0) {
+                            group_count = 0;
+                        }
+                        group_count += count;
+                        if (group_count > std::numeric_limits<uint16_t>::max()) {
+                            block.wide = true;
+                        }
+                    });
+                });
+
+                // Assign the space for each block.
+                uint64_t value_pos = 0;
+                uint64_t row_pos = 0;
+                uint64_t wide_row_pos = 0;
+                uint64_t key_pos = 0;
+                uint64_t base_pos = 0;
+                for (std::size_t n = 0; n < m_block_nums.size(); ++n) {
+                    block_info& block = m_map.m_blocks[n];
+                    m_map.m_block_index[m_block_nums[n]] = static_cast<uint32_t>(n + 1);
+                    block.value_pos = value_pos;
+                    value_pos += m_counted[n].second.size();
+                    if (block.wide) {
+                        block.row_pos = wide_row_pos;
+                        wide_row_pos += block.num_rows + 1;
+                    } else {
+                        block.row_pos = row_pos;
+                        row_pos += block.num_rows + 1;
+                        block.base_pos = base_pos;
+                        base_pos += (block.num_rows >> csr_base_bits) + 1;
+                    }
+                    if (!block.dense()) {
+                        block.key_pos = key_pos;
+                        key_pos += block.num_rows;
+                    }
+                }
+                m_map.m_values.resize(value_pos);
+                m_map.m_rows.resize(row_pos);
+                m_map.m_wide_rows.resize(wide_row_pos);
+                m_map.m_keys.resize(key_pos);
+                m_map.m_bases.resize(base_pos);
+
+                // Fill in the keys and rows. Each row is set to the end of
+                // its values, set() fills them from the back.
+                for_each_block(pool, [this](std::size_t n) {
+                    auto& keys = m_counted[n].second;
+                    const block_info& block = m_map.m_blocks[n];
+
+                    uint32_t end = 0;
+                    uint32_t base = 0;
+                    const auto set_row = [&](std::size_t row) {
+                        if (block.wide) {
+                            m_map.m_wide_rows[block.row_pos + row] = end;
+                        } else {
+                            m_map.m_rows[block.row_pos + row] = static_cast<uint16_t>(end - base);
+                        }
+                    };
+                    for_each_row(keys, block.dense(), [&](std::size_t row, uint16_t key, std::size_t count) {
+                        if (!block.wide && (row & ((1U << csr_base_bits) - 1)) == 0) {
+                            base = end;
+                            m_map.m_bases[block.base_pos + (row >> csr_base_bits)] = base;
+                        }
+                        if (!block.dense()) {
+                            m_map.m_keys[block.key_pos + row] = key;
+                        }
+                        end += static_cast<uint32_t>(count);
+                        set_row(row);
+                    });
+
+                    // The extra row marking the end of the last one.
+                    if (!block.wide && (block.num_rows & ((1U << csr_base_bits) - 1)) == 0) {
+                        base = end;
+                        m_map.m_bases[block.base_pos + (block.num_rows >> csr_base_bits)] = base;
+                    }
+                    set_row(block.num_rows);
+
+                    std::vector<uint16_t>{}.swap(keys);
+                });
+
+                std::vector<std::pair<uint64_t, std::vector<uint16_t>>>{}.swap(m_counted);
+                m_last_counted = 0;
+                m_num_set = 0;
+            }
+
+            /**
+             * Add a value for a key (second pass). The key must have been
+             * set exactly as often as it was counted in the first pass.
+             * If it isn't, some values end up with the wrong keys. This
+             * is only detected if, in total, more values are set than
+             * were counted. It never writes outside the index.
+             *
+             * @throws osmium::not_found if the key wasn't counted.
+             * @throws std::runtime_error if more values are set than were
+             *         counted.
+             */
+            void set(const TId id, const TValue value) {
+                const block_info* block = m_map.find_block(id);
+                if (!block) {
+                    throw osmium::not_found{id};
+                }
+                const auto row = m_map.find_row(*block, id);
+                if (row == static_cast<std::size_t>(-1)) {
+                    throw osmium::not_found{id};
+                }
+
+                uint64_t pos = 0;
+                if (block->wide) {
+                    auto& cursor = m_map.m_wide_rows[block->row_pos + row];
+                    if (cursor == 0) {
+                        throw std::runtime_error{"CsrMultimapBuilder: key set more often than counted"};
+                    }
+                    pos = --cursor;
+                } else {
+                    auto& cursor = m_map.m_rows[block->row_pos + row];
+                    if (cursor == 0) {
+                        throw std::runtime_error{"CsrMultimapBuilder: key set more often than counted"};
+                    }
+                    pos = m_map.m_bases[block->base_pos + (row >> osmium::index::detail::csr_base_bits)] + --cursor;
+                }
+                m_map.m_values[block->value_pos + pos] = value;
+                ++m_num_set;
+            }
+
+            /**
+             * Finish the index: Sort the values of each key. This is done
+             * in parallel in the thread pool. Do not call this from a
+             * thread of the pool given.
+             *
+             * @param pool Thread pool to use. If this is nullptr, all work
+             *             is done in the current thread.
+             * @throws std::runtime_error if fewer values were set than
+             *         keys counted.
+             */
+            map_type build(osmium::thread::Pool* pool = &osmium::thread::Pool::default_instance()) {
+                if (m_num_set != m_map.m_values.size()) {
+                    throw std::runtime_error{"CsrMultimapBuilder: fewer values set than keys counted"};
+                }
+
+                for_each_block(pool, [this](std::size_t n) {
+                    const block_info& block = m_map.m_blocks[n];
+                    TValue* values = m_map.m_values.data() + block.value_pos;
+                    for (std::size_t row = 0; row < block.num_rows; ++row) {
+                        std::sort(values + m_map.row_start(block, row), values + m_map.row_start(block, row + 1));
+                    }
+                });
+
+                m_block_nums.clear();
+                m_num_set = 0;
+                return std::move(m_map);
+            }
+
+        }; // class CsrMultimapBuilder
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_CSR_MULTIMAP_HPP
@@ -0,0 +1,169 @@
+#ifndef OSMIUM_INDEX_DETAIL_ID_LOOKUP_TABLE_HPP
+#define OSMIUM_INDEX_DETAIL_ID_LOOKUP_TABLE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/prefetch.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * Top-level index over a vector of (id, value) pairs sorted by
+             * id. It splits the range of ids into buckets of equal width
+             * and stores where each bucket starts in the vector. A lookup
+             * only has to search the few elements in the bucket of the id
+             * instead of the whole vector. For the fairly uniformly
+             * distributed ids in OSM data that is one access to the table
+             * and one or two cache lines in the vector instead of a binary
+             * search touching dozens of cache lines.
+             *
+             * The table is only valid as long as the vector isn't changed.
+             * It remembers the number of elements it was built for, so
+             * adding elements makes it invalid.
+             */
+            class IdLookupTable {
+
+                // Average number of elements per bucket.
+                enum constant_bucket_size : std::size_t {
+                    bucket_size = 8
+                };
+
+                std::vector<std::size_t> m_start;
+                uint64_t m_min_id = 0;
+                unsigned int m_shift = 0;
+                std::size_t m_size = 0;
+
+            public:
+
+                /**
+                 * Build the table for the elements in [begin, end). They
+                 * must be sorted by id (the first member of each element).
+                 */
+                template <typename TIterator>
+                void build(TIterator begin, TIterator end) {
+                    clear();
+                    if (begin == end) {
+                        return;
+                    }
+
+                    m_size = static_cast<std::size_t>(end - begin);
+                    m_min_id = static_cast<uint64_t>((*begin).first);
+                    const uint64_t range = static_cast<uint64_t>((*(end - 1)).first) - m_min_id;
+
+                    unsigned int bits = 1;
+                    while ((std::size_t(1) << bits) * bucket_size < m_size) {
+                        ++bits;
+                    }
+                    unsigned int range_bits = 0;
+                    while (range_bits < 64 && (range >> range_bits) != 0) {
+                        ++range_bits;
+                    }
+                    m_shift = range_bits > bits ? range_bits - bits : 0;
+
+                    const std::size_t num_buckets = static_cast<std::size_t>(range >> m_shift) + 1;
+                    m_start.reserve(num_buckets + 1);
+                    std::size_t pos = 0;
+                    for (auto it = begin; it != end; ++it, ++pos) {
+                        const auto bucket = static_cast<std::size_t>((static_cast<uint64_t>((*it).first) - m_min_id) >> m_shift);
+                        while (m_start.size() <= bucket) {
+                            m_start.push_back(pos);
+                        }
+                    }
+                    m_start.push_back(m_size);
+                }
+
+                void clear() {
+                    m_start.clear();
+                    m_start.shrink_to_fit();
+                    m_min_id = 0;
+                    m_shift = 0;
+                    m_size = 0;
+                }
+
+                /**
+                 * Is this table usable for a vector with size elements?
+                 */
+                bool valid_for(std::size_t size) const noexcept {
+                    return !m_start.empty() && m_size == size;
+                }
+
+                /**
+                 * Return the range of positions in the vector where an
+                 * element with the specified id can be.
+                 */
+                template <typename TId>
+                std::pair<std::size_t, std::size_t> range(const TId id) const noexcept {
+                    // Ids below the minimum wrap around and end up behind
+                    // the last bucket just like ids above the maximum.
+                    const uint64_t bucket = (static_cast<uint64_t>(id) - m_min_id) >> m_shift;
+                    if (bucket >= m_start.size() - 1) {
+                        return {m_size, m_size};
+                    }
+                    const auto b = static_cast<std::size_t>(bucket);
+                    return {m_start[b], m_start[b + 1]};
+                }
+
+                /**
+                 * Prefetch the part of the table needed to look up the
+                 * specified id.
+                 */
+                template <typename TId>
+                void prefetch(const TId id) const noexcept {
+                    const uint64_t bucket = (static_cast<uint64_t>(id) - m_min_id) >> m_shift;
+                    if (bucket < m_start.size() - 1) {
+                        osmium::index::detail::prefetch(&m_start[static_cast<std::size_t>(bucket)]);
+                    }
+                }
+
+                std::size_t used_memory() const noexcept {
+                    return sizeof(std::size_t) * m_start.capacity();
+                }
+
+            }; // class IdLookupTable
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_ID_LOOKUP_TABLE_HPP
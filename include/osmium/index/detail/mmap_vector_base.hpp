@@ -34,6 +34,7 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/index/index.hpp>
+#include <osmium/util/config.hpp>
 #include <osmium/util/memory_mapping.hpp>
 
 #include <algorithm>
@@ -71,8 +72,22 @@ namespace osmium {
                 shrink_to_fit();
             }
 
+            /**
+             * Create anonymously mapped vector. If the environment variable
+             * OSMIUM_USE_HUGE_PAGES is set to "on", "true", "yes", or "1",
+             * huge pages are requested for the memory. If the environment
+             * variable OSMIUM_NUMA_POLICY is set to "interleave" or "local",
+             * that NUMA memory policy is used.
+             */
             explicit mmap_vector_base(size_t capacity = mmap_vector_size_increment) :
                 m_mapping(capacity) {
+                if (osmium::config::use_huge_pages()) {
+                    m_mapping.use_huge_pages();
+                }
+                const auto policy = osmium::config::get_numa_policy();
+                if (policy != osmium::config::numa_policy::none) {
+                    m_mapping.set_numa_policy(policy);
+                }
                 std::fill_n(data(), capacity, osmium::index::empty_value<T>());
             }
 
@@ -100,6 +115,45 @@ namespace osmium {
                 return m_size == 0;
             }
 
+            /**
+             * Ask the operating system to back this vector with huge pages.
+             * See osmium::MemoryMapping::use_huge_pages().
+             */
+            bool use_huge_pages() noexcept {
+                return m_mapping.use_huge_pages();
+            }
+
+            /**
+             * Write all changes back to the file if this vector is backed
+             * by a file. See osmium::MemoryMapping::flush().
+             */
+            void flush() const {
+                m_mapping.flush();
+            }
+
+            /**
+             * Were huge pages requested successfully for this vector?
+             */
+            bool huge_pages() const noexcept {
+                return m_mapping.huge_pages();
+            }
+
+            /**
+             * The number of bytes of this vector currently backed by huge
+             * pages. This is expensive, don't call it often.
+             */
+            size_t huge_page_bytes() const {
+                return m_mapping.huge_page_bytes();
+            }
+
+            /**
+             * Set the NUMA memory policy for this vector. See
+             * osmium::MemoryMapping::set_numa_policy().
+             */
+            bool set_numa_policy(osmium::config::numa_policy policy) noexcept {
+                return m_mapping.set_numa_policy(policy);
+            }
+
             const_pointer data() const {
                 return m_mapping.begin();
             }
@@ -0,0 +1,66 @@
+#ifndef OSMIUM_INDEX_DETAIL_POPCOUNT_HPP
+#define OSMIUM_INDEX_DETAIL_POPCOUNT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstdint>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * The number of bits set in value. With GCC and clang this
+             * uses the popcnt instruction if the compiler is allowed to
+             * (for instance with -mpopcnt or -march=native).
+             */
+            inline int popcount(uint64_t value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+                return __builtin_popcountll(value);
+#else
+                value = value - ((value >> 1U) & 0x5555555555555555ULL);
+                value = (value & 0x3333333333333333ULL) + ((value >> 2U) & 0x3333333333333333ULL);
+                value = (value + (value >> 4U)) & 0x0f0f0f0f0f0f0f0fULL;
+                return static_cast<int>((value * 0x0101010101010101ULL) >> 56U);
+#endif
+            }
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_POPCOUNT_HPP
@@ -0,0 +1,107 @@
+#ifndef OSMIUM_INDEX_DETAIL_SORT_BY_ID_HPP
+#define OSMIUM_INDEX_DETAIL_SORT_BY_ID_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/radix_sort.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            // Below this size std::sort is fast enough and doesn't need
+            // the extra memory.
+            enum constant_min_radix_sort_size : std::size_t {
+                min_radix_sort_size = 1024 * 1024
+            };
+
+            /**
+             * Sort a vector of (id, value) pairs as used in the sparse maps
+             * and multimaps. The result is the same as from std::sort, ie.
+             * sorted by id and then by value.
+             *
+             * Large vectors are sorted with a parallel radix sort on the
+             * id. This needs a temporary vector of the same size and type as
+             * the vector to be sorted, so if the vector is backed by a file,
+             * so is the temporary storage.
+             */
+            template <typename TVector>
+            void sort_by_id(TVector& vector) {
+                using element_type = typename TVector::value_type;
+
+                if (vector.size() < min_radix_sort_size) {
+                    std::sort(vector.begin(), vector.end());
+                    return;
+                }
+
+                // Ids can be negative, so sort by the distance from the
+                // smallest id. This also keeps the number of passes low.
+                const auto min_id = std::min_element(vector.begin(), vector.end())->first;
+                {
+                    TVector scratch;
+                    scratch.resize(vector.size());
+                    osmium::thread::radix_sort(vector.begin(), vector.end(), scratch.begin(), [min_id](const element_type& element) {
+                        return static_cast<uint64_t>(element.first) - static_cast<uint64_t>(min_id);
+                    });
+                }
+
+                // The radix sort is stable, so elements with the same id
+                // are still in the order they were added. Sort them by value.
+                const auto end = vector.end();
+                auto it = vector.begin();
+                while (it != end) {
+                    const auto id = it->first;
+                    const auto run_end = std::find_if(it + 1, end, [id](const element_type& element) {
+                        return element.first != id;
+                    });
+                    if (std::distance(it, run_end) > 1) {
+                        std::sort(it, run_end);
+                    }
+                    it = run_end;
+                }
+            }
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_SORT_BY_ID_HPP
@@ -33,12 +33,18 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/id_lookup_table.hpp>
+#include <osmium/index/detail/prefetch.hpp>
+#include <osmium/index/detail/sort_by_id.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/map.hpp>
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/config.hpp>
 
 #include <algorithm>
+#include <cassert>
 #include <cstddef>
+#include <iterator>
 #include <utility>
 
 namespace osmium {
@@ -78,6 +84,57 @@ namespace osmium {
                     m_vector[id] = value;
                 }
 
+                /**
+                 * Make room for all ids up to and including max_id, so that
+                 * they can be set with set_concurrent() or set_range()
+                 * without growing the map.
+                 *
+                 * This is not thread-safe. Call it before starting the
+                 * threads filling the map.
+                 */
+                void reserve_ids(const TId max_id) {
+                    if (size() <= max_id) {
+                        m_vector.resize(max_id + 1);
+                    }
+                }
+
+                /**
+                 * Set the value for an id without growing the map.
+                 *
+                 * Several threads can call this at the same time as long
+                 * as they set different ids and no other function changing
+                 * the map is called at the same time. (Each id is stored in
+                 * its own memory location, so there is no data race.)
+                 *
+                 * @pre id <= max_id given to reserve_ids()
+                 */
+                void set_concurrent(const TId id, const TValue value) noexcept {
+                    assert(id < size());
+                    m_vector[id] = value;
+                }
+
+                /**
+                 * Set the values for consecutive ids starting at first_id
+                 * from the range [begin, end). This is much faster than
+                 * calling set() for each id. The map grows if needed.
+                 *
+                 * If all ids in the range were reserved with reserve_ids()
+                 * beforehand, the map doesn't grow and several threads can
+                 * set disjoint ranges at the same time like with
+                 * set_concurrent().
+                 */
+                template <typename TIterator>
+                void set_range(const TId first_id, TIterator begin, TIterator end) {
+                    const auto count = static_cast<std::size_t>(std::distance(begin, end));
+                    if (count == 0) {
+                        return;
+                    }
+                    if (size() < first_id + count) {
+                        m_vector.resize(first_id + count);
+                    }
+                    std::copy(begin, end, m_vector.begin() + first_id);
+                }
+
                 TValue get(const TId id) const final {
                     if (id >= m_vector.size()) {
                         throw osmium::not_found{id};
@@ -96,6 +153,19 @@ namespace osmium {
                     return m_vector[id];
                 }
 
+                void get_many(const TId* ids, TValue* values, const std::size_t count) const noexcept final {
+                    const std::size_t size = m_vector.size();
+                    for (std::size_t i = 0; i < count; ++i) {
+                        if (i + osmium::index::detail::prefetch_distance < count) {
+                            const auto ahead = ids[i + osmium::index::detail::prefetch_distance];
+                            if (ahead < size) {
+                                osmium::index::detail::prefetch(&m_vector[ahead]);
+                            }
+                        }
+                        values[i] = ids[i] < size ? m_vector[ids[i]] : osmium::index::empty_value<TValue>();
+                    }
+                }
+
                 std::size_t size() const final {
                     return m_vector.size();
                 }
@@ -108,6 +178,47 @@ namespace osmium {
                     return sizeof(TValue) * size();
                 }
 
+                /**
+                 * Ask the operating system to back the memory used by this
+                 * map with huge pages. Only available for the mmap-based
+                 * maps (DenseMmapArray, SparseMmapArray, etc.).
+                 *
+                 * @returns true if the hint was accepted, false otherwise.
+                 */
+                bool use_huge_pages() noexcept {
+                    return m_vector.use_huge_pages();
+                }
+
+                /**
+                 * The number of bytes used by this map currently backed by
+                 * huge pages. Only available for the mmap-based maps.
+                 */
+                std::size_t huge_page_bytes() const {
+                    return m_vector.huge_page_bytes();
+                }
+
+                /**
+                 * Write all changes back to the file and wait until this
+                 * is done. Only available for the file-based maps
+                 * (DenseFileArray, SparseFileArray). Together with an
+                 * fsync() on the file descriptor this makes the data safe
+                 * from system crashes.
+                 */
+                void flush() const {
+                    m_vector.flush();
+                }
+
+                /**
+                 * Set the NUMA memory policy for the memory used by this
+                 * map, see osmium::set_numa_policy(). Only available for the
+                 * mmap-based maps. Call this before adding data to the map.
+                 *
+                 * @returns true if the policy was set, false otherwise.
+                 */
+                bool set_numa_policy(osmium::config::numa_policy policy) noexcept {
+                    return m_vector.set_numa_policy(policy);
+                }
+
                 void clear() final {
                     m_vector.clear();
                     m_vector.shrink_to_fit();
@@ -158,14 +269,23 @@ namespace osmium {
 
                 vector_type m_vector;
 
+                // Built by sort() to speed up lookups. Not used if elements
+                // were added after that.
+                osmium::index::detail::IdLookupTable m_lookup_table;
+
                 typename vector_type::const_iterator find_id(const TId id) const noexcept {
                     const element_type element {
                         id,
                         osmium::index::empty_value<TValue>()
                     };
-                    return std::lower_bound(m_vector.begin(), m_vector.end(), element, [](const element_type& a, const element_type& b) {
+                    const auto compare = [](const element_type& a, const element_type& b) {
                         return a.first < b.first;
-                    });
+                    };
+                    if (m_lookup_table.valid_for(m_vector.size())) {
+                        const auto range = m_lookup_table.range(id);
+                        return std::lower_bound(m_vector.cbegin() + range.first, m_vector.cbegin() + range.second, element, compare);
+                    }
+                    return std::lower_bound(m_vector.begin(), m_vector.end(), element, compare);
                 }
 
             public:
@@ -200,6 +320,31 @@ namespace osmium {
                     return result->second;
                 }
 
+                void get_many(const TId* ids, TValue* values, const std::size_t count) const noexcept final {
+                    if (!m_lookup_table.valid_for(m_vector.size())) {
+                        Map<TId, TValue>::get_many(ids, values, count);
+                        return;
+                    }
+
+                    // Two stages of prefetching: First the entry in the
+                    // lookup table, then the start of the range in the
+                    // vector found through that entry.
+                    constexpr const std::size_t distance = osmium::index::detail::prefetch_distance;
+                    for (std::size_t i = 0; i < count; ++i) {
+                        if (i + 2 * distance < count) {
+                            m_lookup_table.prefetch(ids[i + 2 * distance]);
+                        }
+                        if (i + distance < count) {
+                            const auto range = m_lookup_table.range(ids[i + distance]);
+                            if (range.first < range.second) {
+                                osmium::index::detail::prefetch(&*(m_vector.cbegin() + range.first));
+                            }
+                        }
+                        const auto result = find_id(ids[i]);
+                        values[i] = (result == m_vector.end() || result->first != ids[i]) ? osmium::index::empty_value<TValue>() : result->second;
+                    }
+                }
+
                 std::size_t size() const final {
                     return m_vector.size();
                 }
@@ -209,16 +354,80 @@ namespace osmium {
                 }
 
                 std::size_t used_memory() const final {
-                    return sizeof(element_type) * size();
+                    return sizeof(element_type) * size() + m_lookup_table.used_memory();
+                }
+
+                /**
+                 * Ask the operating system to back the memory used by this
+                 * map with huge pages. Only available for the mmap-based
+                 * maps (DenseMmapArray, SparseMmapArray, etc.).
+                 *
+                 * @returns true if the hint was accepted, false otherwise.
+                 */
+                bool use_huge_pages() noexcept {
+                    return m_vector.use_huge_pages();
+                }
+
+                /**
+                 * The number of bytes used by this map currently backed by
+                 * huge pages. Only available for the mmap-based maps.
+                 */
+                std::size_t huge_page_bytes() const {
+                    return m_vector.huge_page_bytes();
+                }
+
+                /**
+                 * Write all changes back to the file and wait until this
+                 * is done. Only available for the file-based maps
+                 * (DenseFileArray, SparseFileArray). Together with an
+                 * fsync() on the file descriptor this makes the data safe
+                 * from system crashes.
+                 */
+                void flush() const {
+                    m_vector.flush();
+                }
+
+                /**
+                 * Set the NUMA memory policy for the memory used by this
+                 * map, see osmium::set_numa_policy(). Only available for the
+                 * mmap-based maps. Call this before adding data to the map.
+                 *
+                 * @returns true if the policy was set, false otherwise.
+                 */
+                bool set_numa_policy(osmium::config::numa_policy policy) noexcept {
+                    return m_vector.set_numa_policy(policy);
                 }
 
                 void clear() final {
                     m_vector.clear();
                     m_vector.shrink_to_fit();
+                    m_lookup_table.clear();
+                }
+
+                /**
+                 * Sort the map by id and build a lookup table that makes
+                 * get() and get_noexcept() faster. If the data is already
+                 * sorted, for instance because the map was created from a
+                 * file written by dump_as_list(), only the lookup table is
+                 * built.
+                 *
+                 * Do not change the ids through the iterators after calling
+                 * this.
+                 */
+                void sort() final {
+                    if (!std::is_sorted(m_vector.cbegin(), m_vector.cend())) {
+                        osmium::index::detail::sort_by_id(m_vector);
+                    }
+                    m_lookup_table.build(m_vector.cbegin(), m_vector.cend());
                 }
 
-                void sort() final {
-                    std::sort(m_vector.begin(), m_vector.end());
+                /**
+                 * Build the lookup table like sort() does, but without
+                 * checking whether the data is sorted. Use this only if the
+                 * data is known to be sorted by id.
+                 */
+                void build_lookup_table() {
+                    m_lookup_table.build(m_vector.cbegin(), m_vector.cend());
                 }
 
                 void dump_as_list(const int fd) final {
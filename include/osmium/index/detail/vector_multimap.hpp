@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/sort_by_id.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/multimap.hpp>
 #include <osmium/io/detail/read_write.hpp>
@@ -121,7 +122,7 @@ namespace osmium {
                 }
 
                 void sort() final {
-                    std::sort(m_vector.begin(), m_vector.end());
+                    osmium::index::detail::sort_by_id(m_vector);
                 }
 
                 void remove(const TId id, const TValue value) {
@@ -135,7 +136,7 @@ namespace osmium {
                 }
 
                 void consolidate() {
-                    std::sort(m_vector.begin(), m_vector.end());
+                    osmium::index::detail::sort_by_id(m_vector);
                 }
 
                 void erase_removed() {
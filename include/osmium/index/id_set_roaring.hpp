@@ -0,0 +1,1426 @@
+#ifndef OSMIUM_INDEX_ID_SET_ROARING_HPP
+#define OSMIUM_INDEX_ID_SET_ROARING_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/popcount.hpp>
+#include <osmium/index/id_set.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * Exception thrown when serialized data given to an
+         * IdSetRoaringView is not a valid serialized IdSetRoaring.
+         */
+        struct id_set_format_error : public std::runtime_error {
+
+            explicit id_set_format_error(const std::string& what) :
+                std::runtime_error(what) {
+            }
+
+            explicit id_set_format_error(const char* what) :
+                std::runtime_error(what) {
+            }
+
+        }; // struct id_set_format_error
+
+        template <typename T>
+        class IdSetRoaring;
+
+        template <typename T>
+        class IdSetRoaringView;
+
+        namespace detail {
+
+            enum roaring_container_type : uint32_t {
+                roaring_array  = 1, // sorted 16 bit values
+                roaring_bitmap = 2, // 2^16 bits
+                roaring_run    = 3  // sorted (first, last) pairs of 16 bit values
+            };
+
+            enum constant_roaring : uint32_t {
+                roaring_bits = 16,
+                roaring_container_size = 1U << roaring_bits,
+                roaring_bitmap_words = roaring_container_size / 64,
+                // Containers with up to this many ids are stored as
+                // arrays, larger ones as bitmaps, unless runs are smaller.
+                roaring_max_array = 4096
+            };
+
+            enum constant_roaring_format : uint32_t {
+                roaring_format_version = 1,
+                roaring_byte_order_mark = 0x01020304
+            };
+
+            constexpr const char roaring_magic[8] = {'O', 'S', 'M', 'I', 'D', 'S', 'E', 'T'};
+
+            /**
+             * The header at the beginning of a serialized IdSetRoaring.
+             * It is followed by num_containers roaring_file_container
+             * descriptions (sorted by key) and then the data of the
+             * containers, each 8 byte aligned. All numbers are in the byte
+             * order of the machine writing the data.
+             */
+            struct roaring_file_header {
+                char magic[8];
+                uint32_t byte_order_mark;
+                uint32_t version;
+                uint32_t id_size;
+                uint32_t reserved;
+                uint64_t num_containers;
+                uint64_t cardinality;
+            }; // struct roaring_file_header
+
+            struct roaring_file_container {
+                uint64_t key;         // id >> 16 for all ids in this container
+                uint64_t offset;      // of the data from the beginning of the header
+                uint32_t type;        // roaring_container_type
+                uint32_t cardinality; // number of ids in this container
+                uint32_t num_values;  // number of 16 bit values (array and run containers)
+                uint32_t reserved;
+            }; // struct roaring_file_container
+
+            static_assert(std::is_standard_layout<roaring_file_header>::value, "roaring_file_header must be standard layout");
+            static_assert(std::is_standard_layout<roaring_file_container>::value, "roaring_file_container must be standard layout");
+            static_assert(sizeof(roaring_file_header) % 8 == 0, "roaring_file_header must be a multiple of 8 bytes");
+            static_assert(sizeof(roaring_file_container) % 8 == 0, "roaring_file_container must be a multiple of 8 bytes");
+
+            inline std::size_t roaring_align(std::size_t size) noexcept {
+                return (size + 7U) & ~static_cast<std::size_t>(7U);
+            }
+
+            // The number of trailing zero bits, value must not be 0.
+            inline int roaring_ctz(uint64_t value) noexcept {
+                return popcount((value & (~value + 1U)) - 1U);
+            }
+
+            inline void roaring_set_bit_range(uint64_t* bits, uint32_t first, uint32_t last) noexcept {
+                const uint32_t first_word = first >> 6U;
+                const uint32_t last_word = last >> 6U;
+                const uint64_t first_mask = ~0ULL << (first & 63U);
+                const uint64_t last_mask = ~0ULL >> (63U - (last & 63U));
+                if (first_word == last_word) {
+                    bits[first_word] |= first_mask & last_mask;
+                    return;
+                }
+                bits[first_word] |= first_mask;
+                std::fill(bits + first_word + 1, bits + last_word, ~0ULL);
+                bits[last_word] |= last_mask;
+            }
+
+            inline void roaring_clear_bit_range(uint64_t* bits, uint32_t first, uint32_t last) noexcept {
+                const uint32_t first_word = first >> 6U;
+                const uint32_t last_word = last >> 6U;
+                const uint64_t first_mask = ~0ULL << (first & 63U);
+                const uint64_t last_mask = ~0ULL >> (63U - (last & 63U));
+                if (first_word == last_word) {
+                    bits[first_word] &= ~(first_mask & last_mask);
+                    return;
+                }
+                bits[first_word] &= ~first_mask;
+                std::fill(bits + first_word + 1, bits + last_word, 0ULL);
+                bits[last_word] &= ~last_mask;
+            }
+
+            inline uint32_t roaring_count_bits(const uint64_t* bits) noexcept {
+                uint32_t count = 0;
+                for (uint32_t i = 0; i < roaring_bitmap_words; ++i) {
+                    count += static_cast<uint32_t>(popcount(bits[i]));
+                }
+                return count;
+            }
+
+            /**
+             * Read-only reference to the data of a container, either in
+             * an IdSetRoaring or in serialized data.
+             */
+            struct roaring_container_ref {
+
+                uint32_t type = 0;
+                uint32_t cardinality = 0;
+
+                // Sorted values (array) or (first, last) pairs (run).
+                const uint16_t* values = nullptr;
+                uint32_t num_values = 0;
+
+                // Bitmap with roaring_bitmap_words words.
+                const uint64_t* bits = nullptr;
+
+                uint32_t num_runs() const noexcept {
+                    return num_values / 2;
+                }
+
+                uint16_t run_first(uint32_t n) const noexcept {
+                    return values[n * 2];
+                }
+
+                uint16_t run_last(uint32_t n) const noexcept {
+                    return values[n * 2 + 1];
+                }
+
+                // The first run with run_first() > low.
+                uint32_t upper_run(uint32_t low) const noexcept {
+                    uint32_t begin = 0;
+                    uint32_t end = num_runs();
+                    while (begin < end) {
+                        const uint32_t middle = begin + (end - begin) / 2;
+                        if (run_first(middle) <= low) {
+                            begin = middle + 1;
+                        } else {
+                            end = middle;
+                        }
+                    }
+                    return begin;
+                }
+
+                bool contains(uint32_t low) const noexcept {
+                    switch (type) {
+                        case roaring_array:
+                            return std::binary_search(values, values + num_values, static_cast<uint16_t>(low));
+                        case roaring_bitmap:
+                            return ((bits[low >> 6U] >> (low & 63U)) & 1U) != 0;
+                        default: {
+                            const uint32_t run = upper_run(low);
+                            return run > 0 && low <= run_last(run - 1);
+                        }
+                    }
+                }
+
+                // Call func with each value in this container.
+                template <typename TFunc>
+                void for_each(TFunc&& func) const {
+                    switch (type) {
+                        case roaring_array:
+                            for (uint32_t i = 0; i < num_values; ++i) {
+                                func(static_cast<uint32_t>(values[i]));
+                            }
+                            break;
+                        case roaring_bitmap:
+                            for (uint32_t w = 0; w < roaring_bitmap_words; ++w) {
+                                for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+                                    func(w * 64 + static_cast<uint32_t>(roaring_ctz(word)));
+                                }
+                            }
+                            break;
+                        default:
+                            for (uint32_t n = 0; n < num_runs(); ++n) {
+                                for (uint32_t v = run_first(n); v <= run_last(n); ++v) {
+                                    func(v);
+                                }
+                            }
+                    }
+                }
+
+                // The number of runs needed to store this container.
+                uint32_t count_runs() const noexcept {
+                    switch (type) {
+                        case roaring_array: {
+                            uint32_t runs = num_values > 0 ? 1 : 0;
+                            for (uint32_t i = 1; i < num_values; ++i) {
+                                if (values[i] != values[i - 1] + 1) {
+                                    ++runs;
+                                }
+                            }
+                            return runs;
+                        }
+                        case roaring_bitmap: {
+                            uint32_t runs = 0;
+                            uint64_t carry = 0;
+                            for (uint32_t w = 0; w < roaring_bitmap_words; ++w) {
+                                runs += static_cast<uint32_t>(popcount(bits[w] & ~((bits[w] << 1U) | carry)));
+                                carry = bits[w] >> 63U;
+                            }
+                            return runs;
+                        }
+                        default:
+                            return num_runs();
+                    }
+                }
+
+            }; // struct roaring_container_ref
+
+            /**
+             * A container of an IdSetRoaring holding the ids with the same
+             * upper bits (key).
+             */
+            class roaring_container {
+
+                std::vector<uint16_t> m_values;
+                std::vector<uint64_t> m_bits;
+                uint64_t m_key;
+                uint32_t m_type = roaring_array;
+                uint32_t m_cardinality = 0;
+
+                void set_array(std::vector<uint16_t>&& values) {
+                    m_values = std::move(values);
+                    std::vector<uint64_t>{}.swap(m_bits);
+                    m_type = roaring_array;
+                    m_cardinality = static_cast<uint32_t>(m_values.size());
+                }
+
+                void set_bitmap(std::vector<uint64_t>&& bits, uint32_t cardinality) {
+                    m_bits = std::move(bits);
+                    std::vector<uint16_t>{}.swap(m_values);
+                    m_type = roaring_bitmap;
+                    m_cardinality = cardinality;
+                }
+
+                // Store the values from ref as array or bitmap depending
+                // on its cardinality.
+                void assign_plain(const roaring_container_ref& ref) {
+                    if (ref.cardinality <= roaring_max_array) {
+                        std::vector<uint16_t> values;
+                        values.reserve(ref.cardinality);
+                        ref.for_each([&values](uint32_t v) {
+                            values.push_back(static_cast<uint16_t>(v));
+                        });
+                        set_array(std::move(values));
+                        return;
+                    }
+                    std::vector<uint64_t> bits(roaring_bitmap_words);
+                    if (ref.type == roaring_run) {
+                        for (uint32_t n = 0; n < ref.num_runs(); ++n) {
+                            roaring_set_bit_range(bits.data(), ref.run_first(n), ref.run_last(n));
+                        }
+                    } else {
+                        ref.for_each([&bits](uint32_t v) {
+                            bits[v >> 6U] |= 1ULL << (v & 63U);
+                        });
+                    }
+                    set_bitmap(std::move(bits), ref.cardinality);
+                }
+
+                // Convert bitmaps with few values to arrays.
+                void normalize() {
+                    if (m_type == roaring_bitmap && m_cardinality <= roaring_max_array) {
+                        assign_plain(ref());
+                    }
+                }
+
+                // Convert runs to arrays or bitmaps. The container ref
+                // points to the original data in tmp or ref itself.
+                static roaring_container_ref plain(const roaring_container_ref& ref, roaring_container& tmp) {
+                    if (ref.type != roaring_run) {
+                        return ref;
+                    }
+                    tmp.assign_plain(ref);
+                    return tmp.ref();
+                }
+
+                static void or_into(uint64_t* bits, const roaring_container_ref& ref) noexcept {
+                    if (ref.type == roaring_bitmap) {
+                        for (uint32_t i = 0; i < roaring_bitmap_words; ++i) {
+                            bits[i] |= ref.bits[i];
+                        }
+                        return;
+                    }
+                    for (uint32_t i = 0; i < ref.num_values; ++i) {
+                        bits[ref.values[i] >> 6U] |= 1ULL << (ref.values[i] & 63U);
+                    }
+                }
+
+                // Values of array a that are (or are not) in b.
+                static std::vector<uint16_t> filter(const roaring_container_ref& a, const roaring_container_ref& b, bool keep_if_contained) {
+                    std::vector<uint16_t> values;
+                    for (uint32_t i = 0; i < a.num_values; ++i) {
+                        if (b.contains(a.values[i]) == keep_if_contained) {
+                            values.push_back(a.values[i]);
+                        }
+                    }
+                    return values;
+                }
+
+                // Intersection of two sorted arrays. If one is much
+                // smaller than the other, its values are searched in the
+                // larger one instead of merging.
+                static std::vector<uint16_t> intersect_arrays(const roaring_container_ref& a, const roaring_container_ref& b) {
+                    std::vector<uint16_t> values;
+                    if (a.num_values * 32 < b.num_values || b.num_values * 32 < a.num_values) {
+                        const roaring_container_ref& small = a.num_values < b.num_values ? a : b;
+                        const roaring_container_ref& large = a.num_values < b.num_values ? b : a;
+                        const uint16_t* it = large.values;
+                        const uint16_t* const end = large.values + large.num_values;
+                        for (uint32_t i = 0; i < small.num_values && it != end; ++i) {
+                            it = std::lower_bound(it, end, small.values[i]);
+                            if (it != end && *it == small.values[i]) {
+                                values.push_back(*it);
+                            }
+                        }
+                        return values;
+                    }
+                    values.reserve(std::min(a.num_values, b.num_values));
+                    std::set_intersection(a.values, a.values + a.num_values,
+                                          b.values, b.values + b.num_values,
+                                          std::back_inserter(values));
+                    return values;
+                }
+
+            public:
+
+                explicit roaring_container(uint64_t key) noexcept :
+                    m_key(key) {
+                }
+
+                // Copy the data from a container ref.
+                roaring_container(uint64_t key, const roaring_container_ref& ref) :
+                    m_key(key),
+                    m_type(ref.type),
+                    m_cardinality(ref.cardinality) {
+                    if (ref.type == roaring_bitmap) {
+                        m_bits.assign(ref.bits, ref.bits + roaring_bitmap_words);
+                    } else {
+                        m_values.assign(ref.values, ref.values + ref.num_values);
+                    }
+                }
+
+                uint64_t key() const noexcept {
+                    return m_key;
+                }
+
+                uint32_t type() const noexcept {
+                    return m_type;
+                }
+
+                uint32_t cardinality() const noexcept {
+                    return m_cardinality;
+                }
+
+                roaring_container_ref ref() const noexcept {
+                    roaring_container_ref r;
+                    r.type = m_type;
+                    r.cardinality = m_cardinality;
+                    r.values = m_values.data();
+                    r.num_values = static_cast<uint32_t>(m_values.size());
+                    r.bits = m_bits.data();
+                    return r;
+                }
+
+                // Add value, returns true if it wasn't in the container.
+                bool set(uint32_t low) {
+                    const auto value = static_cast<uint16_t>(low);
+                    switch (m_type) {
+                        case roaring_array: {
+                            const auto it = std::lower_bound(m_values.begin(), m_values.end(), value);
+                            if (it != m_values.end() && *it == value) {
+                                return false;
+                            }
+                            if (m_cardinality < roaring_max_array) {
+                                m_values.insert(it, value);
+                                ++m_cardinality;
+                                return true;
+                            }
+                            std::vector<uint64_t> bits(roaring_bitmap_words);
+                            or_into(bits.data(), ref());
+                            set_bitmap(std::move(bits), m_cardinality);
+                            return set(low);
+                        }
+                        case roaring_bitmap: {
+                            auto& word = m_bits[low >> 6U];
+                            const uint64_t mask = 1ULL << (low & 63U);
+                            if ((word & mask) != 0) {
+                                return false;
+                            }
+                            word |= mask;
+                            ++m_cardinality;
+                            return true;
+                        }
+                        default: {
+                            const uint32_t run = ref().upper_run(low);
+                            if (run > 0 && low <= m_values[run * 2 - 1]) {
+                                return false;
+                            }
+                            const bool extends_prev = run > 0 && m_values[run * 2 - 1] + 1U == low;
+                            const bool extends_next = run * 2 < m_values.size() && m_values[run * 2] == low + 1U;
+                            if (extends_prev && extends_next) {
+                                m_values[run * 2 - 1] = m_values[run * 2 + 1];
+                                m_values.erase(m_values.begin() + run * 2, m_values.begin() + run * 2 + 2);
+                            } else if (extends_prev) {
+                                m_values[run * 2 - 1] = value;
+                            } else if (extends_next) {
+                                m_values[run * 2] = value;
+                            } else {
+                                const uint16_t pair[2] = {value, value};
+                                m_values.insert(m_values.begin() + run * 2, pair, pair + 2);
+                            }
+                            ++m_cardinality;
+                            return true;
+                        }
+                    }
+                }
+
+                // Remove value, returns true if it was in the container.
+                bool unset(uint32_t low) {
+                    const auto value = static_cast<uint16_t>(low);
+                    switch (m_type) {
+                        case roaring_array: {
+                            const auto it = std::lower_bound(m_values.begin(), m_values.end(), value);
+                            if (it == m_values.end() || *it != value) {
+                                return false;
+                            }
+                            m_values.erase(it);
+                            --m_cardinality;
+                            return true;
+                        }
+                        case roaring_bitmap: {
+                            auto& word = m_bits[low >> 6U];
+                            const uint64_t mask = 1ULL << (low & 63U);
+                            if ((word & mask) == 0) {
+                                return false;
+                            }
+                            word &= ~mask;
+                            --m_cardinality;
+                            normalize();
+                            return true;
+                        }
+                        default: {
+                            const uint32_t run = ref().upper_run(low);
+                            if (run == 0 || low > m_values[run * 2 - 1]) {
+                                return false;
+                            }
+                            auto& first = m_values[run * 2 - 2];
+                            auto& last = m_values[run * 2 - 1];
+                            if (first == last) {
+                                m_values.erase(m_values.begin() + run * 2 - 2, m_values.begin() + run * 2);
+                            } else if (first == value) {
+                                ++first;
+                            } else if (last == value) {
+                                --last;
+                            } else {
+                                const uint16_t pair[2] = {static_cast<uint16_t>(value + 1U), last};
+                                last = static_cast<uint16_t>(value - 1U);
+                                m_values.insert(m_values.begin() + run * 2, pair, pair + 2);
+                            }
+                            --m_cardinality;
+                            return true;
+                        }
+                    }
+                }
+
+                /**
+                 * Store the container as runs if that is smaller than
+                 * storing it as array or bitmap.
+                 */
+                void optimize() {
+                    const roaring_container_ref r = ref();
+                    const std::size_t run_bytes = r.count_runs() * 2 * sizeof(uint16_t);
+                    const std::size_t plain_bytes = m_cardinality <= roaring_max_array ? m_cardinality * sizeof(uint16_t)
+                                                                                       : roaring_bitmap_words * sizeof(uint64_t);
+                    if (run_bytes >= plain_bytes) {
+                        if (m_type == roaring_run) {
+                            assign_plain(r);
+                        }
+                        return;
+                    }
+                    if (m_type == roaring_run) {
+                        return;
+                    }
+                    std::vector<uint16_t> runs;
+                    runs.reserve(run_bytes / sizeof(uint16_t));
+                    r.for_each([&runs](uint32_t v) {
+                        if (!runs.empty() && runs.back() + 1U == v) {
+                            runs.back() = static_cast<uint16_t>(v);
+                        } else {
+                            runs.push_back(static_cast<uint16_t>(v));
+                            runs.push_back(static_cast<uint16_t>(v));
+                        }
+                    });
+                    m_values = std::move(runs);
+                    std::vector<uint64_t>{}.swap(m_bits);
+                    m_type = roaring_run;
+                }
+
+                std::size_t used_memory() const noexcept {
+                    return m_values.capacity() * sizeof(uint16_t) + m_bits.capacity() * sizeof(uint64_t);
+                }
+
+                /// The size of the data of this container when serialized.
+                std::size_t serialized_size() const noexcept {
+                    return roaring_align(m_type == roaring_bitmap ? m_bits.size() * sizeof(uint64_t)
+                                                                  : m_values.size() * sizeof(uint16_t));
+                }
+
+                void serialize(char* data) const noexcept {
+                    if (m_type == roaring_bitmap) {
+                        std::memcpy(data, m_bits.data(), m_bits.size() * sizeof(uint64_t));
+                    } else if (!m_values.empty()) {
+                        std::memcpy(data, m_values.data(), m_values.size() * sizeof(uint16_t));
+                    }
+                }
+
+                static roaring_container unite(uint64_t key, const roaring_container_ref& a, const roaring_container_ref& b) {
+                    roaring_container result{key};
+                    roaring_container tmp_a{key};
+                    roaring_container tmp_b{key};
+                    const roaring_container_ref pa = plain(a, tmp_a);
+                    const roaring_container_ref pb = plain(b, tmp_b);
+
+                    if (pa.type == roaring_array && pb.type == roaring_array &&
+                        pa.cardinality + pb.cardinality <= roaring_max_array) {
+                        std::vector<uint16_t> values;
+                        values.reserve(pa.cardinality + pb.cardinality);
+                        std::set_union(pa.values, pa.values + pa.num_values,
+                                       pb.values, pb.values + pb.num_values,
+                                       std::back_inserter(values));
+                        result.set_array(std::move(values));
+                        return result;
+                    }
+
+                    std::vector<uint64_t> bits(roaring_bitmap_words);
+                    or_into(bits.data(), pa);
+                    or_into(bits.data(), pb);
+                    const uint32_t cardinality = roaring_count_bits(bits.data());
+                    result.set_bitmap(std::move(bits), cardinality);
+                    result.normalize();
+                    return result;
+                }
+
+                static roaring_container intersect(uint64_t key, const roaring_container_ref& a, const roaring_container_ref& b) {
+                    roaring_container result{key};
+                    if (a.type == roaring_array && b.type == roaring_array) {
+                        result.set_array(intersect_arrays(a, b));
+                    } else if (a.type == roaring_array) {
+                        result.set_array(filter(a, b, true));
+                    } else if (b.type == roaring_array) {
+                        result.set_array(filter(b, a, true));
+                    } else {
+                        roaring_container tmp_a{key};
+                        roaring_container tmp_b{key};
+                        const roaring_container_ref pa = plain(a, tmp_a);
+                        const roaring_container_ref pb = plain(b, tmp_b);
+                        if (pa.type == roaring_array || pb.type == roaring_array) {
+                            return intersect(key, pa, pb);
+                        }
+                        std::vector<uint64_t> bits(roaring_bitmap_words);
+                        for (uint32_t i = 0; i < roaring_bitmap_words; ++i) {
+                            bits[i] = pa.bits[i] & pb.bits[i];
+                        }
+                        const uint32_t cardinality = roaring_count_bits(bits.data());
+                        result.set_bitmap(std::move(bits), cardinality);
+                        result.normalize();
+                    }
+                    return result;
+                }
+
+                static roaring_container subtract(uint64_t key, const roaring_container_ref& a, const roaring_container_ref& b) {
+                    roaring_container result{key};
+                    roaring_container tmp_a{key};
+                    const roaring_container_ref pa = plain(a, tmp_a);
+
+                    if (pa.type == roaring_array) {
+                        if (b.type == roaring_array) {
+                            std::vector<uint16_t> values;
+                            values.reserve(pa.num_values);
+                            std::set_difference(pa.values, pa.values + pa.num_values,
+                                                b.values, b.values + b.num_values,
+                                                std::back_inserter(values));
+                            result.set_array(std::move(values));
+                        } else {
+                            result.set_array(filter(pa, b, false));
+                        }
+                        return result;
+                    }
+
+                    std::vector<uint64_t> bits(pa.bits, pa.bits + roaring_bitmap_words);
+                    switch (b.type) {
+                        case roaring_array:
+                            for (uint32_t i = 0; i < b.num_values; ++i) {
+                                bits[b.values[i] >> 6U] &= ~(1ULL << (b.values[i] & 63U));
+                            }
+                            break;
+                        case roaring_bitmap:
+                            for (uint32_t i = 0; i < roaring_bitmap_words; ++i) {
+                                bits[i] &= ~b.bits[i];
+                            }
+                            break;
+                        default:
+                            for (uint32_t n = 0; n < b.num_runs(); ++n) {
+                                roaring_clear_bit_range(bits.data(), b.run_first(n), b.run_last(n));
+                            }
+                    }
+                    const uint32_t cardinality = roaring_count_bits(bits.data());
+                    result.set_bitmap(std::move(bits), cardinality);
+                    result.normalize();
+                    return result;
+                }
+
+            }; // class roaring_container
+
+            /**
+             * Const_iterator for iterating over an IdSetRoaring or
+             * IdSetRoaringView in order.
+             */
+            template <typename T, typename TSet>
+            class roaring_iterator {
+
+                const TSet* m_set;
+                std::size_t m_pos;
+                roaring_container_ref m_ref;
+                uint64_t m_base = 0;
+                uint32_t m_low = 0;
+
+                // Index into the values for array and run containers.
+                uint32_t m_index = 0;
+
+                bool next_bit(uint32_t from) noexcept {
+                    uint32_t w = from >> 6U;
+                    uint64_t word = m_ref.bits[w] & (~0ULL << (from & 63U));
+                    while (word == 0) {
+                        if (++w == roaring_bitmap_words) {
+                            return false;
+                        }
+                        word = m_ref.bits[w];
+                    }
+                    m_low = w * 64 + static_cast<uint32_t>(roaring_ctz(word));
+                    return true;
+                }
+
+                void load() noexcept {
+                    if (m_pos == m_set->end_pos()) {
+                        return;
+                    }
+                    m_ref = m_set->ref_at(m_pos);
+                    m_base = m_set->key_at(m_pos) << roaring_bits;
+                    m_index = 0;
+                    if (m_ref.type == roaring_bitmap) {
+                        next_bit(0);
+                    } else {
+                        m_low = m_ref.values[0];
+                    }
+                }
+
+                void next_container() noexcept {
+                    m_pos = m_set->next_pos(m_pos);
+                    load();
+                }
+
+            public:
+
+                using iterator_category = std::forward_iterator_tag;
+                using difference_type   = std::ptrdiff_t;
+                using value_type        = T;
+                using pointer           = value_type*;
+                using reference         = value_type&;
+
+                roaring_iterator(const TSet* set, std::size_t pos) noexcept :
+                    m_set(set),
+                    m_pos(pos) {
+                    load();
+                }
+
+                roaring_iterator<T, TSet>& operator++() noexcept {
+                    assert(m_pos != m_set->end_pos());
+                    switch (m_ref.type) {
+                        case roaring_array:
+                            if (++m_index < m_ref.num_values) {
+                                m_low = m_ref.values[m_index];
+                                return *this;
+                            }
+                            break;
+                        case roaring_bitmap:
+                            if (m_low + 1 < roaring_container_size && next_bit(m_low + 1)) {
+                                return *this;
+                            }
+                            break;
+                        default:
+                            if (m_low < m_ref.run_last(m_index)) {
+                                ++m_low;
+                                return *this;
+                            }
+                            if (++m_index < m_ref.num_runs()) {
+                                m_low = m_ref.run_first(m_index);
+                                return *this;
+                            }
+                    }
+                    next_container();
+                    return *this;
+                }
+
+                roaring_iterator<T, TSet> operator++(int) noexcept {
+                    roaring_iterator<T, TSet> tmp{*this};
+                    operator++();
+                    return tmp;
+                }
+
+                bool operator==(const roaring_iterator<T, TSet>& rhs) const noexcept {
+                    return m_set == rhs.m_set && m_pos == rhs.m_pos &&
+                           (m_pos == m_set->end_pos() || m_low == rhs.m_low);
+                }
+
+                bool operator!=(const roaring_iterator<T, TSet>& rhs) const noexcept {
+                    return !(*this == rhs);
+                }
+
+                T operator*() const noexcept {
+                    assert(m_pos != m_set->end_pos());
+                    return static_cast<T>(m_base | m_low);
+                }
+
+            }; // class roaring_iterator
+
+        } // namespace detail
+
+        /**
+         * A compressed set of Ids of the given type modelled after
+         * "Roaring Bitmaps". The Ids are split into containers of 2^16 Ids
+         * each sharing the upper bits. Each container is stored as sorted
+         * array of the lower 16 bits (up to 4096 Ids), as bitmap (more
+         * Ids) or, after calling optimize(), as runs of consecutive Ids if
+         * that is smaller. This needs much less memory than IdSetDense for
+         * sparse sets, and about the same for dense sets.
+         *
+         * Unions, intersections and differences of sets (operators |=,
+         * &= and -=) work on whole containers at once. Bitmaps are
+         * combined word by word and counted with the popcount instruction
+         * where available.
+         *
+         * The set can be serialized into a compact form which can be
+         * used with IdSetRoaringView without copying, for instance from
+         * a memory-mapped file.
+         */
+        template <typename T>
+        class IdSetRoaring : public IdSet<T> {
+
+            static_assert(std::is_unsigned<T>::value, "Needs unsigned type");
+            static_assert(sizeof(T) >= 4, "Needs at least 32bit type");
+
+            friend class detail::roaring_iterator<T, IdSetRoaring<T>>;
+
+            // Position of the container for each key plus one, 0 if
+            // there is no container for this key.
+            std::vector<uint32_t> m_index;
+
+            // The containers in no particular order.
+            std::vector<detail::roaring_container> m_containers;
+
+            std::size_t m_size = 0;
+
+            static uint64_t key_of(T id) noexcept {
+                return static_cast<uint64_t>(id) >> detail::roaring_bits;
+            }
+
+            static uint32_t low_of(T id) noexcept {
+                return static_cast<uint32_t>(id & (detail::roaring_container_size - 1));
+            }
+
+            detail::roaring_container* find(uint64_t key) noexcept {
+                if (key >= m_index.size() || m_index[key] == 0) {
+                    return nullptr;
+                }
+                return &m_containers[m_index[key] - 1];
+            }
+
+            const detail::roaring_container* find(uint64_t key) const noexcept {
+                if (key >= m_index.size() || m_index[key] == 0) {
+                    return nullptr;
+                }
+                return &m_containers[m_index[key] - 1];
+            }
+
+            detail::roaring_container& find_or_create(uint64_t key) {
+                if (key >= m_index.size()) {
+                    m_index.resize(key + 1);
+                }
+                if (m_index[key] == 0) {
+                    m_containers.emplace_back(key);
+                    m_index[key] = static_cast<uint32_t>(m_containers.size());
+                }
+                return m_containers[m_index[key] - 1];
+            }
+
+            // Put container in place of the container for its key or
+            // remove it if it is empty.
+            void replace(detail::roaring_container&& container) {
+                const uint64_t key = container.key();
+                detail::roaring_container* old = find(key);
+                if (old) {
+                    m_size -= old->cardinality();
+                    if (container.cardinality() == 0) {
+                        remove(key);
+                        return;
+                    }
+                    *old = std::move(container);
+                } else {
+                    if (container.cardinality() == 0) {
+                        return;
+                    }
+                    find_or_create(key) = std::move(container);
+                }
+                m_size += find(key)->cardinality();
+            }
+
+            // Remove the container for the key by moving the last
+            // container into its place.
+            void remove(uint64_t key) {
+                const uint32_t pos = m_index[key] - 1;
+                m_index[key] = 0;
+                if (pos + 1 != m_containers.size()) {
+                    m_containers[pos] = std::move(m_containers.back());
+                    m_index[m_containers[pos].key()] = pos + 1;
+                }
+                m_containers.pop_back();
+            }
+
+            // The interface used by the iterator: positions are keys.
+
+            std::size_t next_pos(std::size_t pos) const noexcept {
+                ++pos;
+                while (pos < m_index.size() && m_index[pos] == 0) {
+                    ++pos;
+                }
+                return pos;
+            }
+
+            std::size_t end_pos() const noexcept {
+                return m_index.size();
+            }
+
+            detail::roaring_container_ref ref_at(std::size_t pos) const noexcept {
+                return m_containers[m_index[pos] - 1].ref();
+            }
+
+            uint64_t key_at(std::size_t pos) const noexcept {
+                return pos;
+            }
+
+            template <typename TOther>
+            void unite_with(const TOther& other) {
+                other.for_each_container([this](uint64_t key, const detail::roaring_container_ref& ref) {
+                    const detail::roaring_container* container = find(key);
+                    if (container) {
+                        replace(detail::roaring_container::unite(key, container->ref(), ref));
+                    } else {
+                        replace(detail::roaring_container{key, ref});
+                    }
+                });
+            }
+
+            template <typename TOther>
+            void intersect_with(const TOther& other) {
+                std::size_t pos = 0;
+                while (pos < m_containers.size()) {
+                    const uint64_t key = m_containers[pos].key();
+                    const detail::roaring_container_ref ref = other.container(key);
+                    if (ref.cardinality == 0) {
+                        m_size -= m_containers[pos].cardinality();
+                        remove(key);
+                        continue;
+                    }
+                    replace(detail::roaring_container::intersect(key, m_containers[pos].ref(), ref));
+                    if (find(key)) {
+                        ++pos;
+                    }
+                }
+            }
+
+            template <typename TOther>
+            void subtract(const TOther& other) {
+                other.for_each_container([this](uint64_t key, const detail::roaring_container_ref& ref) {
+                    const detail::roaring_container* container = find(key);
+                    if (container) {
+                        replace(detail::roaring_container::subtract(key, container->ref(), ref));
+                    }
+                });
+            }
+
+        public:
+
+            using const_iterator = detail::roaring_iterator<T, IdSetRoaring<T>>;
+
+            IdSetRoaring() = default;
+
+            /**
+             * Add the Id to the set if it is not already in there.
+             *
+             * @param id The Id to set.
+             * @returns true if the Id was added, false if it was already set.
+             */
+            bool check_and_set(T id) {
+                if (find_or_create(key_of(id)).set(low_of(id))) {
+                    ++m_size;
+                    return true;
+                }
+                return false;
+            }
+
+            /**
+             * Add the given Id to the set.
+             *
+             * @param id The Id to set.
+             */
+            void set(T id) final {
+                check_and_set(id);
+            }
+
+            /**
+             * Remove the given Id from the set.
+             *
+             * @param id The Id to remove.
+             */
+            void unset(T id) {
+                detail::roaring_container* container = find(key_of(id));
+                if (container && container->unset(low_of(id))) {
+                    --m_size;
+                    if (container->cardinality() == 0) {
+                        remove(key_of(id));
+                    }
+                }
+            }
+
+            /**
+             * Is the Id in the set?
+             *
+             * @param id The Id to check.
+             */
+            bool get(T id) const noexcept final {
+                const detail::roaring_container* container = find(key_of(id));
+                return container && container->ref().contains(low_of(id));
+            }
+
+            /**
+             * Is the set empty?
+             */
+            bool empty() const noexcept final {
+                return m_size == 0;
+            }
+
+            /**
+             * The number of Ids stored in the set.
+             */
+            std::size_t size() const noexcept {
+                return m_size;
+            }
+
+            /**
+             * Clear the set.
+             */
+            void clear() final {
+                m_index.clear();
+                m_containers.clear();
+                m_size = 0;
+            }
+
+            std::size_t used_memory() const noexcept final {
+                std::size_t memory = m_index.capacity() * sizeof(uint32_t) +
+                                     m_containers.capacity() * sizeof(detail::roaring_container);
+                for (const auto& container : m_containers) {
+                    memory += container.used_memory();
+                }
+                return memory;
+            }
+
+            /**
+             * Store containers as runs of consecutive Ids where that
+             * needs less memory. Call this after adding Ids, especially
+             * before serializing the set. Adding Ids to containers stored
+             * as runs can be slow if there are many runs.
+             */
+            void optimize() {
+                for (auto& container : m_containers) {
+                    container.optimize();
+                }
+            }
+
+            /**
+             * Call func(key, container_ref) for each container in order
+             * of the keys. This is a low-level interface used for
+             * combining sets.
+             */
+            template <typename TFunc>
+            void for_each_container(TFunc&& func) const {
+                for (std::size_t key = 0; key < m_index.size(); ++key) {
+                    if (m_index[key] != 0) {
+                        func(static_cast<uint64_t>(key), m_containers[m_index[key] - 1].ref());
+                    }
+                }
+            }
+
+            /**
+             * Get the container for the key. Its cardinality is 0 if there
+             * is none. This is a low-level interface used for combining
+             * sets.
+             */
+            detail::roaring_container_ref container(uint64_t key) const noexcept {
+                const detail::roaring_container* c = find(key);
+                return c ? c->ref() : detail::roaring_container_ref{};
+            }
+
+            /// Add all Ids in the other set to this set.
+            IdSetRoaring<T>& operator|=(const IdSetRoaring<T>& other) {
+                if (&other != this) {
+                    unite_with(other);
+                }
+                return *this;
+            }
+
+            /// Add all Ids in the other set to this set.
+            IdSetRoaring<T>& operator|=(const IdSetRoaringView<T>& other) {
+                unite_with(other);
+                return *this;
+            }
+
+            /// Remove all Ids not in the other set from this set.
+            IdSetRoaring<T>& operator&=(const IdSetRoaring<T>& other) {
+                if (&other != this) {
+                    intersect_with(other);
+                }
+                return *this;
+            }
+
+            /// Remove all Ids not in the other set from this set.
+            IdSetRoaring<T>& operator&=(const IdSetRoaringView<T>& other) {
+                intersect_with(other);
+                return *this;
+            }
+
+            /// Remove all Ids in the other set from this set.
+            IdSetRoaring<T>& operator-=(const IdSetRoaring<T>& other) {
+                if (&other == this) {
+                    clear();
+                } else {
+                    subtract(other);
+                }
+                return *this;
+            }
+
+            /// Remove all Ids in the other set from this set.
+            IdSetRoaring<T>& operator-=(const IdSetRoaringView<T>& other) {
+                subtract(other);
+                return *this;
+            }
+
+            /**
+             * The number of bytes needed to serialize this set.
+             */
+            std::size_t serialized_size() const noexcept {
+                std::size_t size = sizeof(detail::roaring_file_header) +
+                                   m_containers.size() * sizeof(detail::roaring_file_container);
+                for (const auto& container : m_containers) {
+                    size += container.serialized_size();
+                }
+                return size;
+            }
+
+            /**
+             * Serialize this set into the buffer which must have space for
+             * serialized_size() bytes. The data can be used with
+             * IdSetRoaringView. It can only be read on machines with the
+             * same byte order.
+             */
+            void serialize(char* buffer) const {
+                detail::roaring_file_header header{};
+                std::copy_n(detail::roaring_magic, sizeof(header.magic), header.magic);
+                header.byte_order_mark = detail::roaring_byte_order_mark;
+                header.version = detail::roaring_format_version;
+                header.id_size = sizeof(T);
+                header.num_containers = m_containers.size();
+                header.cardinality = m_size;
+                std::memcpy(buffer, &header, sizeof(header));
+
+                char* description = buffer + sizeof(header);
+                std::size_t offset = sizeof(header) + m_containers.size() * sizeof(detail::roaring_file_container);
+                for_each_container([&](uint64_t key, const detail::roaring_container_ref& ref) {
+                    const detail::roaring_container& container = *find(key);
+                    detail::roaring_file_container fc{};
+                    fc.key = key;
+                    fc.offset = offset;
+                    fc.type = ref.type;
+                    fc.cardinality = ref.cardinality;
+                    fc.num_values = ref.type == detail::roaring_bitmap ? 0 : ref.num_values;
+                    std::memcpy(description, &fc, sizeof(fc));
+                    description += sizeof(fc);
+
+                    const std::size_t size = container.serialized_size();
+                    std::memset(buffer + offset, 0, size);
+                    container.serialize(buffer + offset);
+                    offset += size;
+                });
+            }
+
+            /**
+             * Serialize this set into a string.
+             */
+            std::string serialize() const {
+                std::string data(serialized_size(), '\0');
+                serialize(&data[0]);
+                return data;
+            }
+
+            const_iterator begin() const noexcept {
+                return {this, m_index.empty() || m_index[0] != 0 ? 0 : next_pos(0)};
+            }
+
+            const_iterator end() const noexcept {
+                return {this, end_pos()};
+            }
+
+            const_iterator cbegin() const noexcept {
+                return begin();
+            }
+
+            const_iterator cend() const noexcept {
+                return end();
+            }
+
+        }; // class IdSetRoaring
+
+        /**
+         * Read-only view on a serialized IdSetRoaring. The data is used
+         * in place and must stay valid while the view is used. It must be
+         * aligned to 8 bytes (memory-mapped files and memory from the
+         * usual allocators are).
+         */
+        template <typename T>
+        class IdSetRoaringView {
+
+            static_assert(std::is_unsigned<T>::value, "Needs unsigned type");
+            static_assert(sizeof(T) >= 4, "Needs at least 32bit type");
+
+            friend class detail::roaring_iterator<T, IdSetRoaringView<T>>;
+
+            const char* m_data = nullptr;
+            const detail::roaring_file_container* m_containers = nullptr;
+            std::size_t m_num_containers = 0;
+            std::size_t m_size = 0;
+
+            const detail::roaring_file_container* find(uint64_t key) const noexcept {
+                const auto end = m_containers + m_num_containers;
+                const auto it = std::lower_bound(m_containers, end, key, [](const detail::roaring_file_container& fc, uint64_t k) {
+                    return fc.key < k;
+                });
+                if (it == end || it->key != key) {
+                    return nullptr;
+                }
+                return it;
+            }
+
+            detail::roaring_container_ref make_ref(const detail::roaring_file_container& fc) const noexcept {
+                detail::roaring_container_ref ref;
+                ref.type = fc.type;
+                ref.cardinality = fc.cardinality;
+                if (fc.type == detail::roaring_bitmap) {
+                    ref.bits = reinterpret_cast<const uint64_t*>(m_data + fc.offset);
+                } else {
+                    ref.values = reinterpret_cast<const uint16_t*>(m_data + fc.offset);
+                    ref.num_values = fc.num_values;
+                }
+                return ref;
+            }
+
+            static void check_container(const detail::roaring_file_container& fc, std::size_t size) {
+                std::size_t bytes = 0;
+                switch (fc.type) {
+                    case detail::roaring_array:
+                        if (fc.num_values != fc.cardinality || fc.cardinality > detail::roaring_container_size) {
+                            throw id_set_format_error{"Invalid array container in serialized IdSet"};
+                        }
+                        bytes = fc.num_values * sizeof(uint16_t);
+                        break;
+                    case detail::roaring_bitmap:
+                        bytes = detail::roaring_bitmap_words * sizeof(uint64_t);
+                        break;
+                    case detail::roaring_run:
+                        if (fc.num_values % 2 != 0 || fc.num_values > detail::roaring_container_size) {
+                            throw id_set_format_error{"Invalid run container in serialized IdSet"};
+                        }
+                        bytes = fc.num_values * sizeof(uint16_t);
+                        break;
+                    default:
+                        throw id_set_format_error{"Unknown container type in serialized IdSet"};
+                }
+                if (fc.cardinality == 0 || fc.cardinality > detail::roaring_container_size ||
+                    fc.offset % 8 != 0 || fc.offset > size || bytes > size - fc.offset) {
+                    throw id_set_format_error{"Invalid container in serialized IdSet"};
+                }
+            }
+
+            // The interface used by the iterator: positions are indexes
+            // into the container descriptions.
+
+            std::size_t next_pos(std::size_t pos) const noexcept {
+                return pos + 1;
+            }
+
+            std::size_t end_pos() const noexcept {
+                return m_num_containers;
+            }
+
+            detail::roaring_container_ref ref_at(std::size_t pos) const noexcept {
+                return make_ref(m_containers[pos]);
+            }
+
+            uint64_t key_at(std::size_t pos) const noexcept {
+                return m_containers[pos].key;
+            }
+
+        public:
+
+            using const_iterator = detail::roaring_iterator<T, IdSetRoaringView<T>>;
+
+            /// An empty view.
+            IdSetRoaringView() = default;
+
+            /**
+             * Create a view on serialized data. Checks the structure of
+             * the data, but not the contents of the containers.
+             *
+             * @param data Pointer to the data, aligned to 8 bytes.
+             * @param size Size of the data.
+             * @throws id_set_format_error if the data is not a serialized
+             *         IdSetRoaring with this Id type.
+             */
+            IdSetRoaringView(const char* data, std::size_t size) :
+                m_data(data) {
+                if (reinterpret_cast<std::uintptr_t>(data) % 8 != 0) {
+                    throw id_set_format_error{"Serialized IdSet must be aligned to 8 bytes"};
+                }
+                if (size < sizeof(detail::roaring_file_header)) {
+                    throw id_set_format_error{"Serialized IdSet too short"};
+                }
+                detail::roaring_file_header header;
+                std::memcpy(&header, data, sizeof(header));
+                if (!std::equal(header.magic, header.magic + sizeof(header.magic), detail::roaring_magic)) {
+                    throw id_set_format_error{"Not a serialized IdSet"};
+                }
+                if (header.byte_order_mark != detail::roaring_byte_order_mark) {
+                    throw id_set_format_error{"Serialized IdSet written on machine with different byte order"};
+                }
+                if (header.version != detail::roaring_format_version) {
+                    throw id_set_format_error{"Unsupported serialized IdSet version " + std::to_string(header.version)};
+                }
+                if (header.id_size != sizeof(T)) {
+                    throw id_set_format_error{"Serialized IdSet has wrong Id size"};
+                }
+                if (header.num_containers > (size - sizeof(header)) / sizeof(detail::roaring_file_container)) {
+                    throw id_set_format_error{"Serialized IdSet too short"};
+                }
+
+                m_containers = reinterpret_cast<const detail::roaring_file_container*>(data + sizeof(header));
+                m_num_containers = static_cast<std::size_t>(header.num_containers);
+
+                uint64_t cardinality = 0;
+                for (std::size_t i = 0; i < m_num_containers; ++i) {
+                    check_container(m_containers[i], size);
+                    if (i > 0 && m_containers[i].key <= m_containers[i - 1].key) {
+                        throw id_set_format_error{"Containers in serialized IdSet not sorted"};
+                    }
+                    cardinality += m_containers[i].cardinality;
+                }
+                if (cardinality != header.cardinality) {
+                    throw id_set_format_error{"Wrong number of Ids in serialized IdSet"};
+                }
+                m_size = static_cast<std::size_t>(cardinality);
+            }
+
+            /**
+             * Is the Id in the set?
+             *
+             * @param id The Id to check.
+             */
+            bool get(T id) const noexcept {
+                const detail::roaring_file_container* fc = find(static_cast<uint64_t>(id) >> detail::roaring_bits);
+                return fc && make_ref(*fc).contains(static_cast<uint32_t>(id & (detail::roaring_container_size - 1)));
+            }
+
+            /**
+             * Is the set empty?
+             */
+            bool empty() const noexcept {
+                return m_size == 0;
+            }
+
+            /**
+             * The number of Ids in the set.
+             */
+            std::size_t size() const noexcept {
+                return m_size;
+            }
+
+            /**
+             * Call func(key, container_ref) for each container in order
+             * of the keys. This is a low-level interface used for
+             * combining sets.
+             */
+            template <typename TFunc>
+            void for_each_container(TFunc&& func) const {
+                for (std::size_t i = 0; i < m_num_containers; ++i) {
+                    func(m_containers[i].key, make_ref(m_containers[i]));
+                }
+            }
+
+            /**
+             * Get the container for the key. Its cardinality is 0 if there
+             * is none. This is a low-level interface used for combining
+             * sets.
+             */
+            detail::roaring_container_ref container(uint64_t key) const noexcept {
+                const detail::roaring_file_container* fc = find(key);
+                return fc ? make_ref(*fc) : detail::roaring_container_ref{};
+            }
+
+            const_iterator begin() const noexcept {
+                return {this, 0};
+            }
+
+            const_iterator end() const noexcept {
+                return {this, end_pos()};
+            }
+
+            const_iterator cbegin() const noexcept {
+                return begin();
+            }
+
+            const_iterator cend() const noexcept {
+                return end();
+            }
+
+        }; // class IdSetRoaringView
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_ID_SET_ROARING_HPP
@@ -145,6 +145,24 @@ namespace osmium {
                  */
                 virtual TValue get_noexcept(const TId id) const noexcept = 0;
 
+                /**
+                 * Retrieve values for several ids at once. The result is
+                 * the same as from calling get_noexcept() for each id, but
+                 * implementations can overlap the memory accesses for
+                 * different ids which is much faster for large indexes.
+                 *
+                 * @param ids Pointer to count ids to look for.
+                 * @param values Pointer to space for count values which
+                 *               will be set to the value for each id or
+                 *               the empty value if the id is not found.
+                 * @param count Number of ids.
+                 */
+                virtual void get_many(const TId* ids, TValue* values, const size_t count) const noexcept {
+                    for (size_t i = 0; i < count; ++i) {
+                        values[i] = get_noexcept(ids[i]);
+                    }
+                }
+
                 /**
                  * Get the approximate number of items in the storage. The storage
                  * might allocate memory in blocks, so this size might not be
@@ -0,0 +1,579 @@
+#ifndef OSMIUM_INDEX_MAP_ADAPTIVE_MEM_HPP
+#define OSMIUM_INDEX_MAP_ADAPTIVE_MEM_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/popcount.hpp>
+#include <osmium/index/detail/prefetch.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_ADAPTIVE_MEM
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * In-memory index that chooses the best storage for each block
+             * of 2^16 ids separately, depending on how many of the ids in
+             * the block are used:
+             *
+             * - sparse: sorted offsets (2 bytes each) and values, for
+             *   blocks with few ids.
+             * - bitmap: one bit per id in the block, the number of bits set
+             *   before each 64 bit word, and the values of the ids present
+             *   packed together. The value for an id is found with a
+             *   popcount, no search is needed.
+             * - dense: a value for every id in the block, for (nearly) full
+             *   blocks.
+             *
+             * Blocks start out sparse and are converted when they fill up.
+             * So extracts with clustered ids use little memory while
+             * lookups in well-filled blocks are about as fast as in a
+             * dense index. (FlexMem, on the other hand, switches from
+             * sparse to dense for all ids at once.)
+             *
+             * Ids in a block are best set in order, which they are when
+             * reading OSM files. Values for ids already in the index can
+             * always be changed. Ids set out of order (smaller than the
+             * largest id in their block so far) are kept aside until
+             * sort() is called, like in the other sparse indexes, or
+             * until their block becomes dense.
+             *
+             * Like all indexes, this can be read from several threads at
+             * the same time, but it must not be changed while doing so.
+             */
+            template <typename TId, typename TValue>
+            class AdaptiveMem : public osmium::index::map::Map<TId, TValue> {
+
+                enum constant_bits {
+                    bits = 16
+                };
+
+                enum constant_block_size : uint64_t {
+                    block_size = 1ull << bits
+                };
+
+                enum constant_words_per_block : uint64_t {
+                    words_per_block = block_size / 64
+                };
+
+                // A sparse block needs 2 bytes per entry more than a
+                // bitmap block for the offsets, a bitmap block needs 10
+                // bytes per word (bits and rank). Above this number of
+                // entries the bitmap block is smaller.
+                enum constant_max_sparse_entries : std::size_t {
+                    max_sparse_entries = words_per_block * (sizeof(uint64_t) + sizeof(uint16_t)) / sizeof(uint16_t)
+                };
+
+                // When a block is 7/8 full, a dense block needs only about
+                // 10% more memory than a bitmap block, but lookups don't
+                // need to touch the bitmap.
+                enum constant_min_dense_entries : std::size_t {
+                    min_dense_entries = block_size - block_size / 8
+                };
+
+                enum class block_type : uint8_t {
+                    sparse,
+                    bitmap,
+                    dense
+                };
+
+                struct block {
+
+                    // sparse: sorted offsets of the ids in the block
+                    std::vector<uint16_t> offsets;
+
+                    // bitmap: one bit per id
+                    std::vector<uint64_t> bitmap;
+
+                    // bitmap: number of entries before each word in the bitmap
+                    std::vector<uint16_t> ranks;
+
+                    // sparse and bitmap: the values in the order of the ids,
+                    // dense: the values for all ids
+                    std::vector<TValue> values;
+
+                    // number of non-empty values
+                    std::size_t count = 0;
+
+                    // sparse and bitmap: one more than the largest offset
+                    uint32_t end = 0;
+
+                    block_type type = block_type::sparse;
+
+                }; // struct block
+
+                using offset_entry = std::pair<uint32_t, TValue>;
+
+                // Position of each block in m_blocks plus one, 0 for blocks
+                // without any ids.
+                std::vector<uint32_t> m_block_index;
+
+                std::vector<block> m_blocks;
+
+                // Entries set out of order, merged into the blocks by sort().
+                std::vector<std::pair<uint64_t, TValue>> m_unsorted;
+
+                enum constant_not_found : std::size_t {
+                    not_found = static_cast<std::size_t>(-1)
+                };
+
+                static uint64_t block_num(const uint64_t id) noexcept {
+                    return id >> bits;
+                }
+
+                static uint32_t offset(const uint64_t id) noexcept {
+                    return static_cast<uint32_t>(id & (block_size - 1));
+                }
+
+                const block* find_block(const uint64_t num) const noexcept {
+                    if (num >= m_block_index.size() || m_block_index[num] == 0) {
+                        return nullptr;
+                    }
+                    return &m_blocks[m_block_index[num] - 1];
+                }
+
+                block& get_block(const uint64_t num) {
+                    if (num >= m_block_index.size()) {
+                        m_block_index.resize(num + 1);
+                    }
+                    if (m_block_index[num] == 0) {
+                        m_blocks.emplace_back();
+                        m_block_index[num] = static_cast<uint32_t>(m_blocks.size());
+                    }
+                    return m_blocks[m_block_index[num] - 1];
+                }
+
+                // Position of the value for the offset in a sparse or bitmap
+                // block.
+                static std::size_t find_entry(const block& b, const uint32_t off) noexcept {
+                    if (b.type == block_type::sparse) {
+                        const auto it = std::lower_bound(b.offsets.cbegin(), b.offsets.cend(), off);
+                        if (it == b.offsets.cend() || *it != off) {
+                            return not_found;
+                        }
+                        return static_cast<std::size_t>(it - b.offsets.cbegin());
+                    }
+                    if (off >= b.end) {
+                        return not_found;
+                    }
+                    const uint64_t word = b.bitmap[off >> 6U];
+                    const uint64_t mask = 1ULL << (off & 63U);
+                    if ((word & mask) == 0) {
+                        return not_found;
+                    }
+                    return b.ranks[off >> 6U] + static_cast<std::size_t>(osmium::index::detail::popcount(word & (mask - 1)));
+                }
+
+                static TValue get_value(const block& b, const uint32_t off) noexcept {
+                    if (b.type == block_type::dense) {
+                        return b.values[off];
+                    }
+                    const auto pos = find_entry(b, off);
+                    if (pos == not_found) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return b.values[pos];
+                }
+
+                // Call func(offset, value) for all entries in the block with
+                // non-empty values in order of their offsets.
+                template <typename TFunc>
+                static void for_each_entry(const block& b, TFunc&& func) {
+                    switch (b.type) {
+                        case block_type::sparse:
+                            for (std::size_t i = 0; i < b.offsets.size(); ++i) {
+                                if (b.values[i] != osmium::index::empty_value<TValue>()) {
+                                    func(b.offsets[i], b.values[i]);
+                                }
+                            }
+                            break;
+                        case block_type::bitmap: {
+                                std::size_t pos = 0;
+                                for (uint32_t w = 0; w < b.bitmap.size(); ++w) {
+                                    for (uint64_t word = b.bitmap[w]; word != 0; word &= word - 1) {
+                                        const auto bit = osmium::index::detail::popcount((word & (~word + 1)) - 1);
+                                        const TValue& value = b.values[pos++];
+                                        if (value != osmium::index::empty_value<TValue>()) {
+                                            func(w * 64 + static_cast<uint32_t>(bit), value);
+                                        }
+                                    }
+                                }
+                            }
+                            break;
+                        case block_type::dense:
+                            for (uint32_t off = 0; off < b.values.size(); ++off) {
+                                if (b.values[off] != osmium::index::empty_value<TValue>()) {
+                                    func(off, b.values[off]);
+                                }
+                            }
+                            break;
+                    }
+                }
+
+                static void update_ranks(block& b) {
+                    uint16_t rank = 0;
+                    for (std::size_t w = 0; w < words_per_block; ++w) {
+                        b.ranks[w] = rank;
+                        rank = static_cast<uint16_t>(rank + osmium::index::detail::popcount(b.bitmap[w]));
+                    }
+                }
+
+                static void convert_to_bitmap(block& b) {
+                    b.bitmap.assign(words_per_block, 0);
+                    b.ranks.assign(words_per_block, 0);
+                    for (const auto off : b.offsets) {
+                        b.bitmap[off >> 6U] |= 1ULL << (off & 63U);
+                    }
+                    update_ranks(b);
+                    b.offsets.clear();
+                    b.offsets.shrink_to_fit();
+                    b.type = block_type::bitmap;
+                }
+
+                static void convert_to_dense(block& b) {
+                    std::vector<TValue> values(block_size, osmium::index::empty_value<TValue>());
+                    for_each_entry(b, [&values](const uint32_t off, const TValue& value) {
+                        values[off] = value;
+                    });
+                    b.values.swap(values);
+                    b.offsets.clear();
+                    b.offsets.shrink_to_fit();
+                    b.bitmap.clear();
+                    b.bitmap.shrink_to_fit();
+                    b.ranks.clear();
+                    b.ranks.shrink_to_fit();
+                    b.type = block_type::dense;
+                }
+
+                // Change a value already in the block (or any value in a
+                // dense block) and keep the count up to date.
+                static void set_slot(block& b, TValue& slot, const TValue value) {
+                    if (slot == osmium::index::empty_value<TValue>() && value != osmium::index::empty_value<TValue>()) {
+                        ++b.count;
+                    } else if (slot != osmium::index::empty_value<TValue>() && value == osmium::index::empty_value<TValue>()) {
+                        --b.count;
+                    }
+                    slot = value;
+                }
+
+                static void set_dense(block& b, const uint32_t off, const TValue value) {
+                    set_slot(b, b.values[off], value);
+                }
+
+                // Add an entry after all entries in a sparse or bitmap block.
+                // Empty values are not stored.
+                static void append(block& b, const uint32_t off, const TValue value) {
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        return;
+                    }
+                    if (b.type == block_type::sparse) {
+                        b.offsets.push_back(static_cast<uint16_t>(off));
+                    } else {
+                        // The ranks of the words after the last word used
+                        // so far are not kept up to date, they are never
+                        // looked at because their bits are all zero.
+                        const uint32_t word = off >> 6U;
+                        for (uint32_t w = b.end == 0 ? 0 : ((b.end - 1) >> 6U) + 1; w <= word; ++w) {
+                            b.ranks[w] = static_cast<uint16_t>(b.values.size());
+                        }
+                        b.bitmap[word] |= 1ULL << (off & 63U);
+                    }
+                    b.values.push_back(value);
+                    ++b.count;
+                    b.end = off + 1;
+
+                    if (b.type == block_type::sparse && b.values.size() > max_sparse_entries) {
+                        convert_to_bitmap(b);
+                    } else if (b.type == block_type::bitmap && b.values.size() >= min_dense_entries) {
+                        convert_to_dense(b);
+                    }
+                }
+
+                // Rebuild a block from the entries (sorted by offset,
+                // without duplicates and empty values) using the best
+                // storage for them.
+                static void build_block(block& b, const std::vector<offset_entry>& entries) {
+                    b = block{};
+                    b.count = entries.size();
+                    if (entries.size() >= min_dense_entries) {
+                        b.type = block_type::dense;
+                        b.values.assign(block_size, osmium::index::empty_value<TValue>());
+                        for (const auto& entry : entries) {
+                            b.values[entry.first] = entry.second;
+                        }
+                        return;
+                    }
+
+                    b.values.reserve(entries.size());
+                    if (entries.size() > max_sparse_entries) {
+                        b.type = block_type::bitmap;
+                        b.bitmap.assign(words_per_block, 0);
+                        b.ranks.assign(words_per_block, 0);
+                        for (const auto& entry : entries) {
+                            b.bitmap[entry.first >> 6U] |= 1ULL << (entry.first & 63U);
+                            b.values.push_back(entry.second);
+                        }
+                        update_ranks(b);
+                    } else {
+                        b.offsets.reserve(entries.size());
+                        for (const auto& entry : entries) {
+                            b.offsets.push_back(static_cast<uint16_t>(entry.first));
+                            b.values.push_back(entry.second);
+                        }
+                    }
+                    if (!entries.empty()) {
+                        b.end = entries.back().first + 1;
+                    }
+                }
+
+                // Writes to a dense block go straight into the block, so
+                // entries for it still waiting for sort() must be moved
+                // into it when it becomes dense. Otherwise they would
+                // overwrite newer values when sort() is called.
+                void move_unsorted_into(block& b, const uint64_t num) {
+                    const auto end = std::remove_if(m_unsorted.begin(), m_unsorted.end(), [&b, num](const std::pair<uint64_t, TValue>& entry) {
+                        if (block_num(entry.first) != num) {
+                            return false;
+                        }
+                        set_dense(b, offset(entry.first), entry.second);
+                        return true;
+                    });
+                    m_unsorted.erase(end, m_unsorted.end());
+                }
+
+            public:
+
+                /// Number of blocks using each kind of storage.
+                struct block_stats {
+                    std::size_t sparse = 0;
+                    std::size_t bitmap = 0;
+                    std::size_t dense = 0;
+                };
+
+                AdaptiveMem() = default;
+
+                /**
+                 * The number of ids with a non-empty value. Ids set out of
+                 * order are counted each time they were set until sort()
+                 * is called.
+                 */
+                std::size_t size() const noexcept final {
+                    std::size_t count = std::count_if(m_unsorted.cbegin(), m_unsorted.cend(), [](const std::pair<uint64_t, TValue>& entry) {
+                        return entry.second != osmium::index::empty_value<TValue>();
+                    });
+                    for (const auto& b : m_blocks) {
+                        count += b.count;
+                    }
+                    return count;
+                }
+
+                std::size_t used_memory() const noexcept final {
+                    std::size_t bytes = sizeof(AdaptiveMem) +
+                                        m_block_index.capacity() * sizeof(uint32_t) +
+                                        m_blocks.capacity() * sizeof(block) +
+                                        m_unsorted.capacity() * sizeof(std::pair<uint64_t, TValue>);
+                    for (const auto& b : m_blocks) {
+                        bytes += b.offsets.capacity() * sizeof(uint16_t) +
+                                 b.bitmap.capacity() * sizeof(uint64_t) +
+                                 b.ranks.capacity() * sizeof(uint16_t) +
+                                 b.values.capacity() * sizeof(TValue);
+                    }
+                    return bytes;
+                }
+
+                void set(const TId id, const TValue value) final {
+                    block& b = get_block(block_num(id));
+                    const uint32_t off = offset(id);
+
+                    if (b.type == block_type::dense) {
+                        set_dense(b, off, value);
+                        return;
+                    }
+
+                    if (off >= b.end) {
+                        append(b, off, value);
+                        if (b.type == block_type::dense) {
+                            move_unsorted_into(b, block_num(id));
+                        }
+                        return;
+                    }
+
+                    const auto pos = find_entry(b, off);
+                    if (pos != not_found) {
+                        set_slot(b, b.values[pos], value);
+                        return;
+                    }
+
+                    m_unsorted.emplace_back(id, value);
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    const block* b = find_block(block_num(id));
+                    if (!b) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return get_value(*b, offset(id));
+                }
+
+                TValue get(const TId id) const final {
+                    const auto value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                void get_many(const TId* ids, TValue* values, const std::size_t count) const noexcept final {
+                    for (std::size_t i = 0; i < count; ++i) {
+                        if (i + osmium::index::detail::prefetch_distance < count) {
+                            const uint64_t ahead = ids[i + osmium::index::detail::prefetch_distance];
+                            const block* b = find_block(block_num(ahead));
+                            if (b) {
+                                if (b->type == block_type::dense) {
+                                    osmium::index::detail::prefetch(&b->values[offset(ahead)]);
+                                } else if (b->type == block_type::bitmap) {
+                                    osmium::index::detail::prefetch(&b->bitmap[offset(ahead) >> 6U]);
+                                }
+                            }
+                        }
+                        values[i] = get_noexcept(ids[i]);
+                    }
+                }
+
+                void clear() final {
+                    m_block_index.clear();
+                    m_block_index.shrink_to_fit();
+                    m_blocks.clear();
+                    m_blocks.shrink_to_fit();
+                    m_unsorted.clear();
+                    m_unsorted.shrink_to_fit();
+                }
+
+                /**
+                 * Merge the entries that were set out of order into their
+                 * blocks. The blocks affected are rebuilt with the best
+                 * storage for them.
+                 */
+                void sort() final {
+                    if (m_unsorted.empty()) {
+                        return;
+                    }
+
+                    // Stable, so that the last value set for an id wins.
+                    std::stable_sort(m_unsorted.begin(), m_unsorted.end(), [](const std::pair<uint64_t, TValue>& a, const std::pair<uint64_t, TValue>& b) {
+                        return a.first < b.first;
+                    });
+
+                    std::vector<offset_entry> entries;
+                    std::vector<offset_entry> merged;
+                    auto it = m_unsorted.cbegin();
+                    while (it != m_unsorted.cend()) {
+                        const uint64_t num = block_num(it->first);
+                        block& b = get_block(num);
+
+                        entries.clear();
+                        for_each_entry(b, [&entries](const uint32_t off, const TValue& value) {
+                            entries.emplace_back(off, value);
+                        });
+
+                        merged.clear();
+                        auto existing = entries.cbegin();
+                        for (; it != m_unsorted.cend() && block_num(it->first) == num; ++it) {
+                            const auto next = std::next(it);
+                            if (next != m_unsorted.cend() && next->first == it->first) {
+                                continue;
+                            }
+                            const uint32_t off = offset(it->first);
+                            for (; existing != entries.cend() && existing->first < off; ++existing) {
+                                merged.push_back(*existing);
+                            }
+                            if (existing != entries.cend() && existing->first == off) {
+                                ++existing;
+                            }
+                            if (it->second != osmium::index::empty_value<TValue>()) {
+                                merged.emplace_back(off, it->second);
+                            }
+                        }
+                        merged.insert(merged.end(), existing, entries.cend());
+
+                        build_block(b, merged);
+                    }
+
+                    m_unsorted.clear();
+                    m_unsorted.shrink_to_fit();
+                }
+
+                /// Count the blocks using each kind of storage.
+                block_stats stats() const noexcept {
+                    block_stats result;
+                    for (const auto& b : m_blocks) {
+                        switch (b.type) {
+                            case block_type::sparse:
+                                ++result.sparse;
+                                break;
+                            case block_type::bitmap:
+                                ++result.bitmap;
+                                break;
+                            case block_type::dense:
+                                ++result.dense;
+                                break;
+                        }
+                    }
+                    return result;
+                }
+
+            }; // class AdaptiveMem
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::AdaptiveMem, adaptive_mem)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_ADAPTIVE_MEM_HPP
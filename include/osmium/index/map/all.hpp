@@ -33,15 +33,19 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
-#include <osmium/index/map/dense_file_array.hpp>  // IWYU pragma: keep
-#include <osmium/index/map/dense_mem_array.hpp>   // IWYU pragma: keep
-#include <osmium/index/map/dense_mmap_array.hpp>  // IWYU pragma: keep
-#include <osmium/index/map/dummy.hpp>             // IWYU pragma: keep
-#include <osmium/index/map/flex_mem.hpp>          // IWYU pragma: keep
-#include <osmium/index/map/sparse_file_array.hpp> // IWYU pragma: keep
-#include <osmium/index/map/sparse_mem_array.hpp>  // IWYU pragma: keep
-#include <osmium/index/map/sparse_mem_map.hpp>    // IWYU pragma: keep
-#include <osmium/index/map/sparse_mem_table.hpp>  // IWYU pragma: keep
-#include <osmium/index/map/sparse_mmap_array.hpp> // IWYU pragma: keep
+#include <osmium/index/map/adaptive_mem.hpp>           // IWYU pragma: keep
+#include <osmium/index/map/dense_cache_file.hpp>       // IWYU pragma: keep
+#include <osmium/index/map/dense_compressed_array.hpp> // IWYU pragma: keep
+#include <osmium/index/map/dense_file_array.hpp>       // IWYU pragma: keep
+#include <osmium/index/map/dense_mem_array.hpp>        // IWYU pragma: keep
+#include <osmium/index/map/dense_mmap_array.hpp>       // IWYU pragma: keep
+#include <osmium/index/map/dummy.hpp>                  // IWYU pragma: keep
+#include <osmium/index/map/flex_mem.hpp>               // IWYU pragma: keep
+#include <osmium/index/map/sparse_file_array.hpp>      // IWYU pragma: keep
+#include <osmium/index/map/sparse_mem_array.hpp>       // IWYU pragma: keep
+#include <osmium/index/map/sparse_mem_map.hpp>         // IWYU pragma: keep
+#include <osmium/index/map/sparse_mem_table.hpp>       // IWYU pragma: keep
+#include <osmium/index/map/sparse_mmap_array.hpp>      // IWYU pragma: keep
+#include <osmium/index/map/updatable_sparse_file_array.hpp> // IWYU pragma: keep
 
 #endif // OSMIUM_INDEX_MAP_ALL_HPP
@@ -0,0 +1,532 @@
+#ifndef OSMIUM_INDEX_MAP_DENSE_CACHE_FILE_HPP
+#define OSMIUM_INDEX_MAP_DENSE_CACHE_FILE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/create_map_with_fd.hpp>
+#include <osmium/index/detail/mmap_vector_base.hpp>
+#include <osmium/index/detail/prefetch.hpp>
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_DENSE_CACHE_FILE
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * Exception thrown when a cache file can't be opened because it
+         * isn't a cache file or was written with settings not compatible
+         * with the current program.
+         */
+        struct cache_file_error : public std::runtime_error {
+
+            explicit cache_file_error(const std::string& what) :
+                std::runtime_error(what) {
+            }
+
+            explicit cache_file_error(const char* what) :
+                std::runtime_error(what) {
+            }
+
+        }; // struct cache_file_error
+
+        namespace detail {
+
+            enum constant_cache_file : uint32_t {
+                cache_file_version = 1,
+                cache_file_header_size = 4096,
+                cache_file_byte_order_mark = 0x01020304
+            };
+
+            enum cache_file_layout : uint32_t {
+                cache_file_layout_dense = 1
+            };
+
+            enum cache_file_flags : uint32_t {
+                // The data checksum is valid, ie. the file was committed
+                // and not changed since.
+                cache_file_flag_clean = 1,
+                // The data is sorted by id.
+                cache_file_flag_sorted = 2
+            };
+
+            /**
+             * The header at the beginning of a cache file. It is followed
+             * by padding up to header_size and then the data. All numbers
+             * are in the byte order of the machine writing the file, the
+             * byte order mark is used to detect files from machines with
+             * a different byte order.
+             */
+            struct cache_file_header {
+                char magic[8];
+                uint32_t byte_order_mark;
+                uint32_t version;
+                uint32_t header_size;
+                uint32_t layout;
+                uint32_t id_size;
+                uint32_t value_size;
+                uint32_t flags;
+                uint32_t reserved;
+                uint64_t num_entries;     // number of ids (max id + 1)
+                uint64_t capacity;        // number of entries in the file
+                uint64_t count;           // number of entries with a value
+                uint64_t min_id;
+                uint64_t max_id;
+                int64_t timestamp;        // of the source data (seconds since epoch)
+                uint64_t sequence_number; // replication sequence number
+                uint64_t data_checksum;   // checksum of the first num_entries entries
+                uint64_t header_checksum; // checksum of the bytes before this field
+            }; // struct cache_file_header
+
+            static_assert(std::is_standard_layout<cache_file_header>::value, "cache_file_header must be standard layout");
+            static_assert(sizeof(cache_file_header) <= cache_file_header_size, "cache_file_header too large");
+
+            constexpr const char cache_file_magic[8] = {'O', 'S', 'M', 'C', 'A', 'C', 'H', 'E'};
+
+            /**
+             * Fast 64 bit checksum (not cryptographically secure) over
+             * some data. It works on 8 byte words and is used to detect
+             * corrupt cache files.
+             */
+            inline uint64_t cache_checksum(const char* data, std::size_t size) noexcept {
+                uint64_t hash = 0xcbf29ce484222325ULL;
+                const auto mix = [&hash](uint64_t word) {
+                    hash = (hash ^ word) * 0x100000001b3ULL;
+                    hash ^= hash >> 29U;
+                };
+                std::size_t i = 0;
+                for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+                    uint64_t word;
+                    std::memcpy(&word, data + i, sizeof(uint64_t));
+                    mix(word);
+                }
+                uint64_t last = size;
+                std::memcpy(&last, data + i, size - i);
+                mix(last);
+                return hash;
+            }
+
+            inline uint64_t header_checksum(const cache_file_header& header) noexcept {
+                return cache_checksum(reinterpret_cast<const char*>(&header), offsetof(cache_file_header, header_checksum));
+            }
+
+        } // namespace detail
+
+        namespace map {
+
+            /**
+             * Dense index stored in a self-describing file. The file starts
+             * with a header (see detail::cache_file_header) describing the
+             * layout, id range, and number of entries, the timestamp and
+             * replication sequence number of the source data, and a
+             * checksum of the data. The data itself is stored like in the
+             * DenseFileArray after the header.
+             *
+             * Opening an existing file only maps it into memory and checks
+             * the header, so it is instant. It can then be used as is or
+             * updated. When the file is changed, the header is marked as not
+             * clean first (and written to disk), the data checksum is only
+             * updated when commit() is called (the destructor does this for
+             * you). So a cache file that is not clean was not completely
+             * written, probably because the program crashed, and should not
+             * be trusted. Call verify() to check the data against the
+             * checksum.
+             *
+             * Note that commit() reads all data to calculate the checksum,
+             * this will take some time for large files.
+             */
+            template <typename TId, typename TValue>
+            class DenseCacheFile : public osmium::index::map::Map<TId, TValue> {
+
+                using header_type = osmium::index::detail::cache_file_header;
+
+                osmium::MemoryMapping m_mapping;
+                bool m_modified = false;
+
+                static std::size_t bytes_for(std::size_t capacity) noexcept {
+                    return osmium::index::detail::cache_file_header_size + capacity * sizeof(TValue);
+                }
+
+                header_type& header_data() {
+                    return *m_mapping.get_addr<header_type>();
+                }
+
+                const header_type& header_data() const {
+                    return *m_mapping.get_addr<header_type>();
+                }
+
+                TValue* data() {
+                    return reinterpret_cast<TValue*>(m_mapping.get_addr<char>() + osmium::index::detail::cache_file_header_size);
+                }
+
+                const TValue* data() const {
+                    return reinterpret_cast<const TValue*>(m_mapping.get_addr<char>() + osmium::index::detail::cache_file_header_size);
+                }
+
+                void update_header_checksum() {
+                    header_data().header_checksum = osmium::index::detail::header_checksum(header_data());
+                }
+
+                // Mark the file as changed and make sure this gets to disk
+                // before the data is changed.
+                void mark_modified() {
+                    if (m_modified) {
+                        return;
+                    }
+                    m_modified = true;
+                    header_data().flags &= ~static_cast<uint32_t>(osmium::index::detail::cache_file_flag_clean);
+                    update_header_checksum();
+                    m_mapping.flush();
+                }
+
+                void init_header() {
+                    header_type& header = header_data();
+                    std::memset(&header, 0, osmium::index::detail::cache_file_header_size);
+                    std::copy_n(osmium::index::detail::cache_file_magic, sizeof(header.magic), header.magic);
+                    header.byte_order_mark = osmium::index::detail::cache_file_byte_order_mark;
+                    header.version = osmium::index::detail::cache_file_version;
+                    header.header_size = osmium::index::detail::cache_file_header_size;
+                    header.layout = osmium::index::detail::cache_file_layout_dense;
+                    header.id_size = sizeof(TId);
+                    header.value_size = sizeof(TValue);
+                    header.flags = osmium::index::detail::cache_file_flag_sorted;
+                    header.capacity = osmium::detail::mmap_vector_size_increment;
+                    std::fill_n(data(), header.capacity, osmium::index::empty_value<TValue>());
+                    update_header_checksum();
+                    m_modified = true;
+                }
+
+                void check_header(std::size_t file_size) const {
+                    const header_type& header = header_data();
+                    if (!std::equal(header.magic, header.magic + sizeof(header.magic), osmium::index::detail::cache_file_magic)) {
+                        throw osmium::index::cache_file_error{"Not a cache file"};
+                    }
+                    if (header.byte_order_mark != osmium::index::detail::cache_file_byte_order_mark) {
+                        throw osmium::index::cache_file_error{"Cache file written on machine with different byte order"};
+                    }
+                    if (header.version != osmium::index::detail::cache_file_version) {
+                        throw osmium::index::cache_file_error{"Unsupported cache file version " + std::to_string(header.version)};
+                    }
+                    if (header.header_checksum != osmium::index::detail::header_checksum(header)) {
+                        throw osmium::index::cache_file_error{"Cache file header is corrupt"};
+                    }
+                    if (header.header_size != osmium::index::detail::cache_file_header_size ||
+                        header.layout != osmium::index::detail::cache_file_layout_dense) {
+                        throw osmium::index::cache_file_error{"Cache file has wrong layout"};
+                    }
+                    if (header.id_size != sizeof(TId) || header.value_size != sizeof(TValue)) {
+                        throw osmium::index::cache_file_error{"Cache file has wrong id or value size"};
+                    }
+                    if (header.num_entries > header.capacity || file_size != bytes_for(header.capacity)) {
+                        throw osmium::index::cache_file_error{"Cache file has wrong size"};
+                    }
+                }
+
+                void grow(std::size_t capacity) {
+                    const auto old_capacity = header_data().capacity;
+                    m_mapping.resize(bytes_for(capacity));
+                    std::fill(data() + old_capacity, data() + capacity, osmium::index::empty_value<TValue>());
+                    header_data().capacity = capacity;
+                }
+
+                static std::size_t mapping_size(std::size_t file_size) {
+                    if (file_size == 0) {
+                        return bytes_for(osmium::detail::mmap_vector_size_increment);
+                    }
+                    if (file_size < osmium::index::detail::cache_file_header_size) {
+                        throw osmium::index::cache_file_error{"Cache file too small"};
+                    }
+                    return file_size;
+                }
+
+                DenseCacheFile(int fd, std::size_t file_size) :
+                    m_mapping(mapping_size(file_size), osmium::MemoryMapping::mapping_mode::write_shared, fd) {
+                    if (file_size == 0) {
+                        init_header();
+                    } else {
+                        check_header(file_size);
+                    }
+                }
+
+            public:
+
+                /**
+                 * Create a cache in a temporary file.
+                 */
+                DenseCacheFile() :
+                    DenseCacheFile(osmium::detail::create_tmp_file()) {
+                }
+
+                /**
+                 * Open the cache file fd. If the file is empty, a new cache
+                 * is created in it. The file must have been opened for
+                 * reading and writing. Existing files are not changed until
+                 * something is written to the cache.
+                 *
+                 * @throws osmium::index::cache_file_error if the file is not
+                 *         a valid cache file for this id and value type.
+                 */
+                explicit DenseCacheFile(int fd) :
+                    DenseCacheFile(fd, osmium::file_size(fd)) {
+                }
+
+                DenseCacheFile(const DenseCacheFile&) = delete;
+                DenseCacheFile& operator=(const DenseCacheFile&) = delete;
+
+                DenseCacheFile(DenseCacheFile&&) = delete;
+                DenseCacheFile& operator=(DenseCacheFile&&) = delete;
+
+                ~DenseCacheFile() noexcept {
+                    try {
+                        commit();
+                    } catch (...) { // NOLINT(bugprone-empty-catch)
+                        // Ignore any exceptions because destructor must not throw.
+                        // The file stays marked as not clean.
+                    }
+                }
+
+                /// The header of the cache file.
+                const osmium::index::detail::cache_file_header& header() const {
+                    return header_data();
+                }
+
+                /**
+                 * Was the data checksum updated after the last change?
+                 */
+                bool is_clean() const {
+                    return (header_data().flags & osmium::index::detail::cache_file_flag_clean) != 0;
+                }
+
+                /// Timestamp of the data this cache was created from.
+                osmium::Timestamp timestamp() const {
+                    return osmium::Timestamp{header_data().timestamp};
+                }
+
+                void set_timestamp(const osmium::Timestamp& timestamp) {
+                    mark_modified();
+                    header_data().timestamp = timestamp.seconds_since_epoch();
+                    update_header_checksum();
+                }
+
+                /// Replication sequence number of the data this cache was created from.
+                uint64_t sequence_number() const {
+                    return header_data().sequence_number;
+                }
+
+                void set_sequence_number(uint64_t sequence_number) {
+                    mark_modified();
+                    header_data().sequence_number = sequence_number;
+                    update_header_checksum();
+                }
+
+                /// The number of ids with a value.
+                std::size_t count() const {
+                    return static_cast<std::size_t>(header_data().count);
+                }
+
+                /**
+                 * The smallest id with a value. Only valid if count() > 0.
+                 * If values were removed (by setting the empty value), this
+                 * is only a lower bound.
+                 */
+                TId min_id() const {
+                    return static_cast<TId>(header_data().min_id);
+                }
+
+                /**
+                 * The largest id with a value. Only valid if count() > 0.
+                 * If values were removed, this is only an upper bound.
+                 */
+                TId max_id() const {
+                    return static_cast<TId>(header_data().max_id);
+                }
+
+                /**
+                 * Calculate the data checksum, mark the file as clean and
+                 * flush everything to disk. Does nothing if nothing was
+                 * changed since the last commit.
+                 */
+                void commit() {
+                    if (!m_modified) {
+                        return;
+                    }
+                    header_type& header = header_data();
+                    header.data_checksum = osmium::index::detail::cache_checksum(reinterpret_cast<const char*>(data()), header.num_entries * sizeof(TValue));
+                    header.flags |= osmium::index::detail::cache_file_flag_clean;
+                    update_header_checksum();
+                    m_mapping.flush();
+                    m_modified = false;
+                }
+
+                /**
+                 * Check that the file is clean and the data matches the
+                 * checksum. This reads all data.
+                 */
+                bool verify() const {
+                    return is_clean() &&
+                           header_data().data_checksum == osmium::index::detail::cache_checksum(reinterpret_cast<const char*>(data()), header_data().num_entries * sizeof(TValue));
+                }
+
+                /**
+                 * Ask the operating system to back the memory with huge
+                 * pages. See osmium::MemoryMapping::use_huge_pages().
+                 */
+                bool use_huge_pages() noexcept {
+                    return m_mapping.use_huge_pages();
+                }
+
+                /**
+                 * Tell the operating system how the cache will be accessed.
+                 * Use random access for lookups into a large cache and
+                 * will_need to load a cache into memory in the background.
+                 * See osmium::MemoryMapping::advise().
+                 */
+                bool advise(osmium::MemoryMapping::access_advice advice) const noexcept {
+                    return m_mapping.advise(advice);
+                }
+
+                void reserve(const std::size_t size) final {
+                    if (size > header_data().capacity) {
+                        mark_modified();
+                        grow(size);
+                    }
+                }
+
+                void set(const TId id, const TValue value) final {
+                    mark_modified();
+                    if (id >= header_data().capacity) {
+                        grow(static_cast<std::size_t>(id) + osmium::detail::mmap_vector_size_increment);
+                    }
+                    // Only get this after grow(), it changes the address.
+                    header_type& header = header_data();
+                    if (id >= header.num_entries) {
+                        header.num_entries = static_cast<uint64_t>(id) + 1;
+                    }
+                    TValue& slot = data()[id];
+                    if (slot == osmium::index::empty_value<TValue>() && value != osmium::index::empty_value<TValue>()) {
+                        if (header.count == 0 || id < header.min_id) {
+                            header.min_id = id;
+                        }
+                        if (header.count == 0 || id > header.max_id) {
+                            header.max_id = id;
+                        }
+                        ++header.count;
+                    } else if (slot != osmium::index::empty_value<TValue>() && value == osmium::index::empty_value<TValue>()) {
+                        --header.count;
+                    }
+                    slot = value;
+                }
+
+                TValue get(const TId id) const final {
+                    const TValue value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    if (id >= header_data().num_entries) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return data()[id];
+                }
+
+                void get_many(const TId* ids, TValue* values, const std::size_t count) const noexcept final {
+                    const TValue* values_data = data();
+                    const uint64_t size = header_data().num_entries;
+                    for (std::size_t i = 0; i < count; ++i) {
+                        if (i + osmium::index::detail::prefetch_distance < count) {
+                            const auto ahead = ids[i + osmium::index::detail::prefetch_distance];
+                            if (ahead < size) {
+                                osmium::index::detail::prefetch(values_data + ahead);
+                            }
+                        }
+                        values[i] = ids[i] < size ? values_data[ids[i]] : osmium::index::empty_value<TValue>();
+                    }
+                }
+
+                std::size_t size() const final {
+                    return static_cast<std::size_t>(header_data().num_entries);
+                }
+
+                std::size_t used_memory() const final {
+                    return m_mapping.size();
+                }
+
+                void clear() final {
+                    mark_modified();
+                    m_mapping.resize(bytes_for(osmium::detail::mmap_vector_size_increment));
+                    init_header();
+                }
+
+                void dump_as_array(const int fd) final {
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(data()), size() * sizeof(TValue));
+                }
+
+            }; // class DenseCacheFile
+
+            template <typename TId, typename TValue>
+            struct create_map<TId, TValue, DenseCacheFile> {
+                DenseCacheFile<TId, TValue>* operator()(const std::vector<std::string>& config) {
+                    return osmium::index::detail::create_map_with_fd<DenseCacheFile<TId, TValue>>(config);
+                }
+            };
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseCacheFile, dense_cache_file)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_DENSE_CACHE_FILE_HPP
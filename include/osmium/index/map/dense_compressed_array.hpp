@@ -0,0 +1,370 @@
+#ifndef OSMIUM_INDEX_MAP_DENSE_COMPRESSED_ARRAY_HPP
+#define OSMIUM_INDEX_MAP_DENSE_COMPRESSED_ARRAY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_DENSE_COMPRESSED_ARRAY
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * A dense index for node locations that needs much less memory
+             * than the DenseMemArray if the locations of nodes with
+             * neighbouring ids are near each other (which they usually are
+             * in OSM data).
+             *
+             * The ids are split into blocks of a fixed size. For each block
+             * the minimum x and y coordinates are stored as a base and each
+             * location is stored as the difference to this base with as
+             * many bits as the largest difference in the block needs. Finding
+             * the block for an id and decoding a location from it are O(1).
+             *
+             * Locations are collected in an uncompressed "open" block until
+             * an id from a different block is set. So set() is fastest if
+             * ids are set in increasing order as they appear in OSM files.
+             * Setting an id in a block that was already compressed works,
+             * but is slow and the memory used by the old version of the
+             * block is only given back by sort().
+             *
+             * Only works with osmium::Location as value type.
+             */
+            template <typename TId, typename TValue>
+            class DenseCompressedArray : public osmium::index::map::Map<TId, TValue> {
+
+                static_assert(std::is_same<TValue, osmium::Location>::value,
+                              "DenseCompressedArray only works with osmium::Location values");
+
+                enum constant_bits {
+                    bits = 8
+                };
+
+                enum constant_block_size : uint64_t {
+                    block_size = 1ull << bits
+                };
+
+                struct block_header {
+                    // Position of the block data in m_data (in words).
+                    uint64_t offset = 0;
+                    int32_t base_x = 0;
+                    int32_t base_y = 0;
+                    // Number of bits per x/y value. The block is empty if
+                    // bits_x is 0. The largest x value that fits into bits_x
+                    // marks an empty entry.
+                    uint8_t bits_x = 0;
+                    uint8_t bits_y = 0;
+                };
+
+                std::vector<block_header> m_blocks;
+
+                // Packed data of all blocks. For each block first all x
+                // values, then all y values.
+                std::vector<uint64_t> m_data;
+
+                // The uncompressed block currently written to.
+                std::vector<TValue> m_open_block;
+                uint64_t m_open_block_num = 0;
+                bool m_has_open_block = false;
+
+                static uint64_t block(const uint64_t id) noexcept {
+                    return id >> bits;
+                }
+
+                static uint64_t offset(const uint64_t id) noexcept {
+                    return id & (block_size - 1);
+                }
+
+                static uint8_t bit_width(uint64_t value) noexcept {
+                    uint8_t width = 0;
+                    while (value) {
+                        ++width;
+                        value >>= 1U;
+                    }
+                    return width;
+                }
+
+                static uint64_t mask(const unsigned width) noexcept {
+                    return (1ULL << width) - 1;
+                }
+
+                static uint64_t read_bits(const uint64_t* words, const uint64_t pos, const unsigned width) noexcept {
+                    if (width == 0) {
+                        return 0;
+                    }
+                    const uint64_t* word = words + (pos >> 6U);
+                    const unsigned shift = pos & 63U;
+                    uint64_t value = *word >> shift;
+                    if (shift + width > 64) {
+                        value |= word[1] << (64 - shift);
+                    }
+                    return value & mask(width);
+                }
+
+                static void write_bits(uint64_t* words, const uint64_t pos, const unsigned width, const uint64_t value) noexcept {
+                    if (width == 0) {
+                        return;
+                    }
+                    uint64_t* word = words + (pos >> 6U);
+                    const unsigned shift = pos & 63U;
+                    *word |= value << shift;
+                    if (shift + width > 64) {
+                        word[1] |= value >> (64 - shift);
+                    }
+                }
+
+                static bool is_empty(const TValue value) noexcept {
+                    return value == osmium::index::empty_value<TValue>();
+                }
+
+                // Number of words in m_data used by the block.
+                static uint64_t block_words(const block_header& header) noexcept {
+                    // block_size is a multiple of 64, so each block uses a
+                    // whole number of words.
+                    return block_size / 64 * (header.bits_x + header.bits_y);
+                }
+
+                TValue decode(const block_header& header, const uint64_t num) const noexcept {
+                    const uint64_t* words = m_data.data() + header.offset;
+                    const uint64_t dx = read_bits(words, num * header.bits_x, header.bits_x);
+                    if (dx == mask(header.bits_x)) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    const uint64_t dy = read_bits(words, block_size * header.bits_x + num * header.bits_y, header.bits_y);
+                    return TValue{static_cast<int32_t>(header.base_x + static_cast<int64_t>(dx)),
+                                  static_cast<int32_t>(header.base_y + static_cast<int64_t>(dy))};
+                }
+
+                // Compress the open block and append it to m_data.
+                void close_open_block() {
+                    m_has_open_block = false;
+                    block_header& header = m_blocks[m_open_block_num];
+                    header = block_header{};
+
+                    int64_t min_x = 0;
+                    int64_t max_x = 0;
+                    int64_t min_y = 0;
+                    int64_t max_y = 0;
+                    bool found = false;
+                    for (const auto& value : m_open_block) {
+                        if (is_empty(value)) {
+                            continue;
+                        }
+                        if (found) {
+                            min_x = std::min<int64_t>(min_x, value.x());
+                            max_x = std::max<int64_t>(max_x, value.x());
+                            min_y = std::min<int64_t>(min_y, value.y());
+                            max_y = std::max<int64_t>(max_y, value.y());
+                        } else {
+                            min_x = max_x = value.x();
+                            min_y = max_y = value.y();
+                            found = true;
+                        }
+                    }
+
+                    if (!found) {
+                        return;
+                    }
+
+                    header.offset = m_data.size();
+                    header.base_x = static_cast<int32_t>(min_x);
+                    header.base_y = static_cast<int32_t>(min_y);
+                    // One more than needed for x so there is a marker
+                    // for empty entries.
+                    header.bits_x = bit_width(static_cast<uint64_t>(max_x - min_x) + 1);
+                    header.bits_y = bit_width(static_cast<uint64_t>(max_y - min_y));
+
+                    m_data.resize(m_data.size() + block_words(header));
+                    uint64_t* words = m_data.data() + header.offset;
+
+                    const uint64_t empty_x = mask(header.bits_x);
+                    for (uint64_t num = 0; num < block_size; ++num) {
+                        const TValue value = m_open_block[num];
+                        if (is_empty(value)) {
+                            write_bits(words, num * header.bits_x, header.bits_x, empty_x);
+                        } else {
+                            write_bits(words, num * header.bits_x, header.bits_x, static_cast<uint64_t>(value.x() - min_x));
+                            write_bits(words, block_size * header.bits_x + num * header.bits_y, header.bits_y, static_cast<uint64_t>(value.y() - min_y));
+                        }
+                    }
+                }
+
+                // Make the block with the given number the open block.
+                void open_block(const uint64_t block_num) {
+                    if (m_has_open_block) {
+                        close_open_block();
+                    }
+                    if (block_num >= m_blocks.size()) {
+                        m_blocks.resize(block_num + 1);
+                    }
+
+                    m_open_block.assign(block_size, osmium::index::empty_value<TValue>());
+                    const block_header& header = m_blocks[block_num];
+                    if (header.bits_x != 0) {
+                        for (uint64_t num = 0; num < block_size; ++num) {
+                            m_open_block[num] = decode(header, num);
+                        }
+                    }
+
+                    m_open_block_num = block_num;
+                    m_has_open_block = true;
+                }
+
+            public:
+
+                DenseCompressedArray() = default;
+
+                void reserve(const std::size_t size) final {
+                    m_blocks.reserve(block(size) + 1);
+                }
+
+                void set(const TId id, const TValue value) final {
+                    const uint64_t block_num = block(id);
+                    if (!m_has_open_block || block_num != m_open_block_num) {
+                        open_block(block_num);
+                    }
+                    m_open_block[offset(id)] = value;
+                }
+
+                TValue get(const TId id) const final {
+                    const TValue value = get_noexcept(id);
+                    if (is_empty(value)) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    const uint64_t block_num = block(id);
+                    if (m_has_open_block && block_num == m_open_block_num) {
+                        return m_open_block[offset(id)];
+                    }
+                    if (block_num >= m_blocks.size()) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    const block_header& header = m_blocks[block_num];
+                    if (header.bits_x == 0) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return decode(header, offset(id));
+                }
+
+                std::size_t size() const final {
+                    return m_blocks.size() * block_size;
+                }
+
+                std::size_t used_memory() const final {
+                    return sizeof(block_header) * m_blocks.size() +
+                           sizeof(uint64_t) * m_data.size() +
+                           sizeof(TValue) * m_open_block.size();
+                }
+
+                void clear() final {
+                    m_blocks.clear();
+                    m_blocks.shrink_to_fit();
+                    m_data.clear();
+                    m_data.shrink_to_fit();
+                    m_open_block.clear();
+                    m_open_block.shrink_to_fit();
+                    m_has_open_block = false;
+                }
+
+                /**
+                 * Compress the open block and release unused memory. If
+                 * blocks were changed after they had been compressed, the
+                 * data is rewritten without their old versions. Call this
+                 * after all data was added.
+                 */
+                void sort() final {
+                    if (m_has_open_block) {
+                        close_open_block();
+                    }
+                    m_open_block.clear();
+                    m_open_block.shrink_to_fit();
+
+                    uint64_t live_words = 0;
+                    for (const auto& header : m_blocks) {
+                        live_words += block_words(header);
+                    }
+                    if (live_words < m_data.size()) {
+                        std::vector<uint64_t> data;
+                        data.reserve(live_words);
+                        for (auto& header : m_blocks) {
+                            if (header.bits_x == 0) {
+                                continue;
+                            }
+                            const auto begin = m_data.cbegin() + static_cast<std::ptrdiff_t>(header.offset);
+                            header.offset = data.size();
+                            data.insert(data.end(), begin, begin + static_cast<std::ptrdiff_t>(block_words(header)));
+                        }
+                        m_data.swap(data);
+                    }
+                    m_data.shrink_to_fit();
+                }
+
+                void dump_as_array(const int fd) final {
+                    std::vector<TValue> values(block_size);
+                    for (uint64_t block_num = 0; block_num < m_blocks.size(); ++block_num) {
+                        for (uint64_t num = 0; num < block_size; ++num) {
+                            values[num] = get_noexcept(block_num * block_size + num);
+                        }
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(values.data()), sizeof(TValue) * block_size);
+                    }
+                }
+
+            }; // class DenseCompressedArray
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseCompressedArray, dense_compressed_array)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_DENSE_COMPRESSED_ARRAY_HPP
@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/prefetch.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/map.hpp>
 
@@ -211,6 +212,22 @@ namespace osmium {
                     return get_sparse(id);
                 }
 
+                void get_many(const TId* ids, TValue* values, const std::size_t count) const noexcept final {
+                    if (!m_dense) {
+                        Map<TId, TValue>::get_many(ids, values, count);
+                        return;
+                    }
+                    for (std::size_t i = 0; i < count; ++i) {
+                        if (i + osmium::index::detail::prefetch_distance < count) {
+                            const uint64_t ahead = ids[i + osmium::index::detail::prefetch_distance];
+                            if (block(ahead) < m_dense_blocks.size() && !m_dense_blocks[block(ahead)].empty()) {
+                                osmium::index::detail::prefetch(&m_dense_blocks[block(ahead)][offset(ahead)]);
+                            }
+                        }
+                        values[i] = get_dense(ids[i]);
+                    }
+                }
+
                 TValue get(const TId id) const final {
                     const auto value = get_noexcept(id);
                     if (value == osmium::index::empty_value<TValue>()) {
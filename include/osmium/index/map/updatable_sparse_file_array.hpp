@@ -0,0 +1,471 @@
+#ifndef OSMIUM_INDEX_MAP_UPDATABLE_SPARSE_FILE_ARRAY_HPP
+#define OSMIUM_INDEX_MAP_UPDATABLE_SPARSE_FILE_ARRAY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/index/map/sparse_file_array.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/util/file.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <fcntl.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_UPDATABLE_SPARSE_FILE_ARRAY
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            inline int open_index_file(const std::string& filename, int flags) {
+#ifdef _WIN32
+                flags |= O_BINARY;
+#endif
+                const int fd = ::open(filename.c_str(), flags | O_RDWR | O_CREAT, 0644); // NOLINT(hicpp-signed-bitwise)
+                if (fd < 0) {
+                    throw std::system_error{errno, std::system_category(), std::string("Open failed for '") + filename + "'"};
+                }
+                return fd;
+            }
+
+            /**
+             * Atomically replace the file "to" by the file "from" and make
+             * sure the change gets to disk. Both files must be closed.
+             */
+            inline void replace_file(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+                if (!MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+                    throw std::system_error{static_cast<int>(GetLastError()), std::system_category(), std::string("Rename failed for '") + from + "'"};
+                }
+#else
+                if (std::rename(from.c_str(), to.c_str()) != 0) {
+                    throw std::system_error{errno, std::system_category(), std::string("Rename failed for '") + from + "'"};
+                }
+
+                // The directory entry has to be synced, too.
+                const auto pos = to.rfind('/');
+                const std::string dir = pos == std::string::npos ? "." : (pos == 0 ? "/" : to.substr(0, pos));
+                const int fd = ::open(dir.c_str(), O_RDONLY); // NOLINT(hicpp-signed-bitwise)
+                if (fd < 0) {
+                    throw std::system_error{errno, std::system_category(), std::string("Open failed for '") + dir + "'"};
+                }
+                // Some file systems can't fsync directories, that's okay.
+                if (::fsync(fd) != 0 && errno != EINVAL) {
+                    const int error = errno;
+                    ::close(fd);
+                    throw std::system_error{error, std::system_category(), "Fsync failed"};
+                }
+                osmium::io::detail::reliable_close(fd);
+#endif
+            }
+
+        } // namespace detail
+
+        namespace map {
+
+            /**
+             * Sparse index in a file that can be updated efficiently, for
+             * instance with the changes from replication diffs.
+             *
+             * The data is kept in the file "filename" sorted by id in the
+             * same format that the SparseFileArray uses (and dump_as_list()
+             * writes), so existing files can be used. Changes are not
+             * written into this file directly, because that would mean
+             * moving around large parts of it for every new id. Instead
+             * they are kept in memory and appended to a log in the file
+             * "filename.log". Setting the empty value for an id removes
+             * it from the index. Newer values in the log override older
+             * ones and the values in the main file.
+             *
+             * When the number of ids in the log reaches the merge
+             * threshold, or when merge() is called, the changes are
+             * merged with the main file into a new file that replaces the
+             * main file, and the log is cleared. This only needs one pass
+             * over the main file.
+             *
+             * Changes are safe from program and system crashes after
+             * checkpoint() or merge() was called: When the index is opened
+             * again, the log is read and all changes in it are applied
+             * again. Because only the newest value for each id is kept,
+             * applying changes again is harmless. So, after a crash, you
+             * can re-apply all replication diffs since the last checkpoint.
+             *
+             * Only one program at a time must use the files.
+             */
+            template <typename TId, typename TValue>
+            class UpdatableSparseFileArray : public osmium::index::map::Map<TId, TValue> {
+
+                using main_type = osmium::index::map::SparseFileArray<TId, TValue>;
+                using element_type = typename main_type::element_type;
+
+                // Number of log entries buffered before they are written.
+                enum constant_log_buffer_size : std::size_t {
+                    log_buffer_size = 64 * 1024
+                };
+
+                // Number of entries written at once when merging.
+                enum constant_merge_buffer_size : std::size_t {
+                    merge_buffer_size = 1024 * 1024
+                };
+
+                std::string m_filename;
+                std::size_t m_merge_threshold;
+                int m_fd = -1;
+                int m_log_fd = -1;
+                std::unique_ptr<main_type> m_main;
+                std::unordered_map<TId, TValue> m_changes;
+                std::vector<element_type> m_log_buffer;
+
+                std::string log_filename() const {
+                    return m_filename + ".log";
+                }
+
+                void open_main() {
+                    m_fd = osmium::index::detail::open_index_file(m_filename, 0);
+                    m_main.reset(new main_type{m_fd});
+                    // The main file is always sorted, it was written by
+                    // merge() or by dump_as_list() of a sparse index.
+                    m_main->build_lookup_table();
+                }
+
+                void close_main() {
+                    m_main.reset();
+                    osmium::io::detail::reliable_close(m_fd);
+                    m_fd = -1;
+                }
+
+                void write_log() {
+                    if (m_log_buffer.empty()) {
+                        return;
+                    }
+                    osmium::io::detail::reliable_write(m_log_fd, reinterpret_cast<const char*>(m_log_buffer.data()), m_log_buffer.size() * sizeof(element_type));
+                    m_log_buffer.clear();
+                }
+
+                // Read the changes from the log. A partially written entry
+                // at the end (from a crash while writing) is removed.
+                void read_log() {
+                    const std::size_t size = osmium::file_size(m_log_fd);
+                    const std::size_t num_entries = size / sizeof(element_type);
+                    if (size % sizeof(element_type) != 0) {
+                        osmium::resize_file(m_log_fd, num_entries * sizeof(element_type));
+                    }
+
+                    std::vector<element_type> buffer(log_buffer_size);
+                    std::size_t remaining = num_entries;
+                    while (remaining > 0) {
+                        const std::size_t count = std::min(remaining, buffer.size());
+                        std::size_t bytes = 0;
+                        while (bytes < count * sizeof(element_type)) {
+                            const auto nread = osmium::io::detail::reliable_read(m_log_fd, reinterpret_cast<char*>(buffer.data()) + bytes, static_cast<unsigned int>(count * sizeof(element_type) - bytes));
+                            if (nread == 0) {
+                                throw std::runtime_error{"Unexpected end of log file '" + log_filename() + "'"};
+                            }
+                            bytes += static_cast<std::size_t>(nread);
+                        }
+                        for (std::size_t i = 0; i < count; ++i) {
+                            m_changes[buffer[i].first] = buffer[i].second;
+                        }
+                        remaining -= count;
+                    }
+                }
+
+                void write_merged(int fd) const {
+                    std::vector<element_type> changes(m_changes.cbegin(), m_changes.cend());
+                    std::sort(changes.begin(), changes.end(), [](const element_type& a, const element_type& b) {
+                        return a.first < b.first;
+                    });
+
+                    std::vector<element_type> buffer;
+                    buffer.reserve(merge_buffer_size);
+                    const auto add = [&buffer, fd](const element_type& element) {
+                        buffer.push_back(element);
+                        if (buffer.size() == merge_buffer_size) {
+                            osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(element_type));
+                            buffer.clear();
+                        }
+                    };
+
+                    auto it = m_main->cbegin();
+                    const auto end = m_main->cend();
+                    for (const auto& change : changes) {
+                        for (; it != end && it->first < change.first; ++it) {
+                            add(*it);
+                        }
+                        while (it != end && it->first == change.first) {
+                            ++it;
+                        }
+                        if (change.second != osmium::index::empty_value<TValue>()) {
+                            add(change);
+                        }
+                    }
+                    for (; it != end; ++it) {
+                        add(*it);
+                    }
+
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(element_type));
+                }
+
+            public:
+
+                /// Default for the number of changed ids that triggers a merge.
+                enum constant_default_merge_threshold : std::size_t {
+                    default_merge_threshold = 1024 * 1024
+                };
+
+                /**
+                 * Open the index in the file filename and its log. The
+                 * files are created if they don't exist. Any changes in
+                 * the log are read.
+                 *
+                 * @param filename Name of the main index file.
+                 * @param merge_threshold Merge changes into the main file
+                 *        when this many ids were changed.
+                 * @throws std::system_error if the files can't be opened.
+                 * @throws std::runtime_error if the main file has the
+                 *         wrong size.
+                 */
+                explicit UpdatableSparseFileArray(const std::string& filename, std::size_t merge_threshold = default_merge_threshold) :
+                    m_filename(filename),
+                    m_merge_threshold(merge_threshold) {
+                    open_main();
+                    m_log_fd = osmium::index::detail::open_index_file(log_filename(), O_APPEND); // NOLINT(hicpp-signed-bitwise)
+                    read_log();
+                    m_log_buffer.reserve(log_buffer_size);
+                }
+
+                UpdatableSparseFileArray(const UpdatableSparseFileArray&) = delete;
+                UpdatableSparseFileArray& operator=(const UpdatableSparseFileArray&) = delete;
+
+                UpdatableSparseFileArray(UpdatableSparseFileArray&&) = delete;
+                UpdatableSparseFileArray& operator=(UpdatableSparseFileArray&&) = delete;
+
+                /**
+                 * Writes outstanding changes to the log (without syncing
+                 * it to disk) and closes the files.
+                 */
+                ~UpdatableSparseFileArray() noexcept {
+                    try {
+                        write_log();
+                    } catch (...) { // NOLINT(bugprone-empty-catch)
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                    m_main.reset();
+                    if (m_fd >= 0) {
+                        ::close(m_fd);
+                    }
+                    ::close(m_log_fd);
+                }
+
+                void set(const TId id, const TValue value) final {
+                    m_changes[id] = value;
+                    m_log_buffer.emplace_back(id, value);
+                    if (m_log_buffer.size() == log_buffer_size) {
+                        write_log();
+                    }
+                    if (m_changes.size() >= m_merge_threshold) {
+                        merge();
+                    }
+                }
+
+                /**
+                 * Remove the id from the index. This is the same as setting
+                 * the empty value.
+                 */
+                void remove(const TId id) {
+                    set(id, osmium::index::empty_value<TValue>());
+                }
+
+                TValue get(const TId id) const final {
+                    const TValue value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    const auto it = m_changes.find(id);
+                    if (it != m_changes.end()) {
+                        return it->second;
+                    }
+                    return m_main->get_noexcept(id);
+                }
+
+                void get_many(const TId* ids, TValue* values, const std::size_t count) const noexcept final {
+                    m_main->get_many(ids, values, count);
+                    if (m_changes.empty()) {
+                        return;
+                    }
+                    for (std::size_t i = 0; i < count; ++i) {
+                        const auto it = m_changes.find(ids[i]);
+                        if (it != m_changes.end()) {
+                            values[i] = it->second;
+                        }
+                    }
+                }
+
+                /**
+                 * The number of entries in the main file plus the number of
+                 * changed ids. This overestimates the number of ids in the
+                 * index if ids were changed or removed.
+                 */
+                std::size_t size() const final {
+                    return m_main->size() + m_changes.size();
+                }
+
+                /// The number of changed ids not yet merged into the main file.
+                std::size_t num_changes() const noexcept {
+                    return m_changes.size();
+                }
+
+                std::size_t used_memory() const final {
+                    return m_main->used_memory() +
+                           m_changes.size() * (sizeof(element_type) + 2 * sizeof(void*)) +
+                           m_log_buffer.capacity() * sizeof(element_type);
+                }
+
+                /**
+                 * Make sure all changes so far survive a crash by writing
+                 * them to the log and syncing it to disk. This is cheap
+                 * compared to merge(). Call this after each replication
+                 * diff and only then record that the diff was applied.
+                 */
+                void checkpoint() {
+                    write_log();
+                    osmium::io::detail::reliable_fsync(m_log_fd);
+                }
+
+                /**
+                 * Merge all changes into the main file. The merged data is
+                 * written to "filename.new" first, which then atomically
+                 * replaces the main file. The log is only cleared after
+                 * that. Does nothing if there are no changes.
+                 */
+                void merge() {
+                    if (m_changes.empty()) {
+                        return;
+                    }
+
+                    const std::string new_filename = m_filename + ".new";
+                    const int new_fd = osmium::io::detail::open_for_writing(new_filename, osmium::io::overwrite::allow);
+                    try {
+                        write_merged(new_fd);
+                        osmium::io::detail::reliable_fsync(new_fd);
+                    } catch (...) {
+                        ::close(new_fd);
+                        throw;
+                    }
+                    osmium::io::detail::reliable_close(new_fd);
+
+                    // The old file is closed first, on some systems it
+                    // can't be replaced while in use.
+                    close_main();
+                    try {
+                        osmium::index::detail::replace_file(new_filename, m_filename);
+                    } catch (...) {
+                        open_main();
+                        throw;
+                    }
+                    open_main();
+
+                    m_changes.clear();
+                    m_log_buffer.clear();
+                    osmium::resize_file(m_log_fd, 0);
+                    osmium::io::detail::reliable_fsync(m_log_fd);
+                }
+
+                /**
+                 * Remove all entries from the index and the log.
+                 */
+                void clear() final {
+                    m_changes.clear();
+                    m_log_buffer.clear();
+                    osmium::resize_file(m_log_fd, 0);
+                    m_main.reset();
+                    osmium::resize_file(m_fd, 0);
+                    m_main.reset(new main_type{m_fd});
+                }
+
+                /**
+                 * Does nothing. Data in this index is always sorted and
+                 * lookups take the changes not yet merged into account.
+                 * Changes are only merged when the merge threshold is
+                 * reached, when merge() is called, or when the index is
+                 * dumped.
+                 */
+                void sort() final {
+                }
+
+                /**
+                 * Write all ids and values in the index to the file fd.
+                 * All changes are merged into the main file first.
+                 */
+                void dump_as_list(const int fd) final {
+                    merge();
+                    m_main->dump_as_list(fd);
+                }
+
+                /**
+                 * Write all ids and values in the index to the file fd.
+                 * For a sparse index this is the same as dump_as_list().
+                 * All changes are merged into the main file first.
+                 */
+                void dump_as_array(const int fd) final {
+                    merge();
+                    m_main->dump_as_array(fd);
+                }
+
+            }; // class UpdatableSparseFileArray
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_MAP_UPDATABLE_SPARSE_FILE_ARRAY_HPP
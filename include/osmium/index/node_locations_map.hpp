@@ -39,6 +39,18 @@ DEALINGS IN THE SOFTWARE.
 
 #define OSMIUM_WANT_NODE_LOCATION_MAPS
 
+#ifdef OSMIUM_HAS_INDEX_MAP_ADAPTIVE_MEM
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::AdaptiveMem, adaptive_mem)
+#endif
+
+#ifdef OSMIUM_HAS_INDEX_MAP_DENSE_CACHE_FILE
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseCacheFile, dense_cache_file)
+#endif
+
+#ifdef OSMIUM_HAS_INDEX_MAP_DENSE_COMPRESSED_ARRAY
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseCompressedArray, dense_compressed_array)
+#endif
+
 #ifdef OSMIUM_HAS_INDEX_MAP_DENSE_FILE_ARRAY
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseFileArray, dense_file_array)
 #endif
@@ -48,6 +48,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file_compression.hpp>
 #include <osmium/io/writer_options.hpp>
 #include <osmium/util/compatibility.hpp>
+#include <osmium/util/trace.hpp>
 
 #include <bzlib.h>
 
@@ -194,10 +195,12 @@ namespace osmium {
             }
 
             std::string read() final {
+                osmium::TraceSpan span{"bzip2_decompress"};
                 std::string buffer;
 
                 if (!m_stream_end) {
-                    buffer.resize(osmium::io::Decompressor::input_buffer_size);
+                    advise_read(m_file ? ::fileno(m_file) : -1, offset());
+                    buffer.resize(chunk_size());
                     int error;
                     assert(buffer.size() < std::numeric_limits<int>::max());
                     const int nread = ::BZ2_bzRead(&error, m_bzfile, const_cast<char*>(buffer.data()), static_cast<int>(buffer.size()));
@@ -289,6 +292,7 @@ namespace osmium {
             }
 
             std::string read() final {
+                osmium::TraceSpan span{"bzip2_decompress"};
                 std::string output;
 
                 if (m_buffer) {
@@ -36,6 +36,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
+#include <osmium/io/reader_options.hpp>
 #include <osmium/io/writer_options.hpp>
 #include <osmium/util/file.hpp>
 
@@ -95,10 +96,52 @@ namespace osmium {
             std::atomic<std::size_t> m_file_size{0};
             std::atomic<std::size_t> m_offset{0};
 
+            std::size_t m_chunk_size = input_buffer_size;
+            osmium::io::read_advice m_read_advice = osmium::io::read_advice::normal;
+            bool m_read_advice_given = false;
+
+        protected:
+
+            /**
+             * Give the operating system hints on how the file is read
+             * according to the read_advice set. Decompressors reading from
+             * a file descriptor call this before each read.
+             *
+             * @param fd File descriptor the data is read from.
+             * @param offset Current offset into the file.
+             */
+            void advise_read(int fd, std::size_t offset) noexcept {
+                if (m_read_advice == osmium::io::read_advice::normal || fd < 0) {
+                    return;
+                }
+
+                if (!m_read_advice_given) {
+                    m_read_advice_given = true;
+                    osmium::io::detail::advise_read_access(fd, m_read_advice);
+                }
+
+                osmium::io::detail::advise_will_need(fd, offset + m_chunk_size, m_chunk_size);
+
+                if (m_read_advice == osmium::io::read_advice::streaming) {
+                    osmium::io::detail::remove_buffered_pages(fd, offset);
+                }
+            }
+
         public:
 
+            /// Default size of the chunks read from the input.
             static constexpr unsigned int input_buffer_size = 1024 * 1024;
 
+            /// Smallest allowed size of the chunks read from the input.
+            static constexpr unsigned int min_input_buffer_size = 4 * 1024;
+
+            /**
+             * Largest allowed size of the chunks read from the input. The
+             * compression libraries take sizes as int or unsigned int, so
+             * this must stay well below INT_MAX.
+             */
+            static constexpr unsigned int max_input_buffer_size = 1024 * 1024 * 1024;
+
             Decompressor() = default;
 
             Decompressor(const Decompressor&) = delete;
@@ -129,6 +172,42 @@ namespace osmium {
                 m_offset = offset;
             }
 
+            /**
+             * The size of the chunks read from the input. (Decompressors
+             * might return less data than this in each read() call.)
+             */
+            std::size_t chunk_size() const noexcept {
+                return m_chunk_size;
+            }
+
+            /**
+             * Set the size of the chunks read from the input. Values smaller
+             * than min_input_buffer_size or larger than max_input_buffer_size
+             * will be set to those values. Must be called before the first
+             * call to read().
+             */
+            void set_chunk_size(std::size_t size) noexcept {
+                if (size < min_input_buffer_size) {
+                    m_chunk_size = min_input_buffer_size;
+                } else if (size > max_input_buffer_size) {
+                    m_chunk_size = max_input_buffer_size;
+                } else {
+                    m_chunk_size = size;
+                }
+            }
+
+            osmium::io::read_advice read_advice() const noexcept {
+                return m_read_advice;
+            }
+
+            /**
+             * Set the hints given to the operating system on how the input
+             * is read. Must be called before the first call to read().
+             */
+            void set_read_advice(osmium::io::read_advice advice) noexcept {
+                m_read_advice = advice;
+            }
+
         }; // class Decompressor
 
         /**
@@ -304,8 +383,9 @@ namespace osmium {
                         buffer.append(m_buffer, size);
                     }
                 } else {
-                    buffer.resize(osmium::io::Decompressor::input_buffer_size);
-                    const auto nread = detail::reliable_read(m_fd, const_cast<char*>(buffer.data()), osmium::io::Decompressor::input_buffer_size);
+                    advise_read(m_fd, m_offset);
+                    buffer.resize(chunk_size());
+                    const auto nread = detail::reliable_read(m_fd, const_cast<char*>(buffer.data()), static_cast<unsigned int>(buffer.size()));
                     buffer.resize(std::string::size_type(nread));
                 }
 
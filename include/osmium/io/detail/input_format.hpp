@@ -33,12 +33,14 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/io/detail/memory_limiter.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/pool.hpp>
 
@@ -58,21 +60,62 @@ namespace osmium {
 
             struct parser_arguments {
                 osmium::thread::Pool& pool;
-                future_string_queue_type& input_queue;
-                future_buffer_queue_type& output_queue;
+                string_queue_type& input_queue;
+                buffer_queue_type& output_queue;
                 std::promise<osmium::io::Header>& header_promise;
                 osmium::osm_entity_bits::type read_which_entities;
                 osmium::io::read_meta read_metadata;
+                MemoryLimiter* memory_limiter;
+                osmium::memory::BufferPool* buffer_pool;
             };
 
+            /**
+             * Wraps a function returning a buffer (usually run in the thread
+             * pool) so that the memory used by its input and by the
+             * resulting buffer is accounted for in the MemoryLimiter. The
+             * input must have been accounted for as output of the parser
+             * before.
+             */
+            template <typename TFunction>
+            class memory_accounted_task {
+
+                TFunction m_function;
+                MemoryLimiter* m_memory_limiter;
+                std::size_t m_input_size;
+
+            public:
+
+                memory_accounted_task(TFunction&& function, MemoryLimiter* memory_limiter, std::size_t input_size) :
+                    m_function(std::forward<TFunction>(function)),
+                    m_memory_limiter(memory_limiter),
+                    m_input_size(input_size) {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    osmium::memory::Buffer buffer;
+                    try {
+                        buffer = m_function();
+                    } catch (...) {
+                        m_memory_limiter->release_output(m_input_size);
+                        throw;
+                    }
+                    m_memory_limiter->add_output(buffer.capacity());
+                    m_memory_limiter->release_output(m_input_size);
+                    return buffer;
+                }
+
+            }; // class memory_accounted_task
+
             class Parser {
 
                 osmium::thread::Pool& m_pool;
-                future_buffer_queue_type& m_output_queue;
+                buffer_queue_type& m_output_queue;
                 std::promise<osmium::io::Header>& m_header_promise;
                 queue_wrapper<std::string> m_input_queue;
                 osmium::osm_entity_bits::type m_read_which_entities;
                 osmium::io::read_meta m_read_metadata;
+                MemoryLimiter* m_memory_limiter;
+                osmium::memory::BufferPool* m_buffer_pool;
                 bool m_header_is_done;
 
             protected:
@@ -89,6 +132,22 @@ namespace osmium {
                     return m_read_metadata;
                 }
 
+                osmium::memory::BufferPool* buffer_pool() const noexcept {
+                    return m_buffer_pool;
+                }
+
+                /**
+                 * Get a new (empty) buffer with at least the given capacity.
+                 * If the Reader was given a BufferPool, the buffer is taken
+                 * from there.
+                 */
+                osmium::memory::Buffer get_buffer(std::size_t capacity) {
+                    if (m_buffer_pool) {
+                        return m_buffer_pool->get(capacity);
+                    }
+                    return osmium::memory::Buffer{capacity};
+                }
+
                 bool header_is_done() const noexcept {
                     return m_header_is_done;
                 }
@@ -108,14 +167,33 @@ namespace osmium {
                 }
 
                 /**
-                 * Wrap the buffer into a future and add it to the output queue.
+                 * Add the buffer to the output queue. Blocks if the memory
+                 * limit of the Reader (if any) is reached.
                  */
                 void send_to_output_queue(osmium::memory::Buffer&& buffer) {
+                    if (m_memory_limiter) {
+                        m_memory_limiter->acquire_output(buffer.capacity());
+                    }
                     add_to_queue(m_output_queue, std::move(buffer));
                 }
 
-                void send_to_output_queue(std::future<osmium::memory::Buffer>&& future) {
-                    m_output_queue.push(std::move(future));
+                /**
+                 * Run the function in the thread pool and add the resulting
+                 * buffer to the output queue. The buffers end up in the
+                 * queue in the order this function was called, regardless
+                 * of when they are ready. The memory used by the input
+                 * data of the function (input_size bytes) and by the
+                 * resulting buffer are accounted for. Blocks if the memory
+                 * limit of the Reader (if any) is reached.
+                 */
+                template <typename TFunction>
+                void send_to_output_queue_via_pool(TFunction&& function, std::size_t input_size) {
+                    if (m_memory_limiter && m_memory_limiter->limit()) {
+                        m_memory_limiter->acquire_output(input_size);
+                        add_task_to_queue(m_pool, m_output_queue, memory_accounted_task<TFunction>{std::forward<TFunction>(function), m_memory_limiter, input_size});
+                    } else {
+                        add_task_to_queue(m_pool, m_output_queue, std::forward<TFunction>(function));
+                    }
                 }
 
             public:
@@ -127,6 +205,8 @@ namespace osmium {
                     m_input_queue(args.input_queue),
                     m_read_which_entities(args.read_which_entities),
                     m_read_metadata(args.read_metadata),
+                    m_memory_limiter(args.memory_limiter),
+                    m_buffer_pool(args.buffer_pool),
                     m_header_is_done(false) {
                 }
 
@@ -141,7 +221,11 @@ namespace osmium {
                 virtual void run() = 0;
 
                 std::string get_input() {
-                    return m_input_queue.pop();
+                    std::string data{m_input_queue.pop()};
+                    if (m_memory_limiter) {
+                        m_memory_limiter->release_input(data.size());
+                    }
+                    return data;
                 }
 
                 bool input_done() const {
@@ -152,6 +236,11 @@ namespace osmium {
                     try {
                         run();
                     } catch (...) {
+                        if (m_memory_limiter) {
+                            // The rest of the input will not be consumed
+                            // normally, so nobody must wait for it.
+                            m_memory_limiter->shutdown();
+                        }
                         std::exception_ptr exception = std::current_exception();
                         set_header_exception(exception);
                         add_to_queue(m_output_queue, std::move(exception));
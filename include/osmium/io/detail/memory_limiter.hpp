@@ -0,0 +1,247 @@
+#ifndef OSMIUM_IO_DETAIL_MEMORY_LIMITER_HPP
+#define OSMIUM_IO_DETAIL_MEMORY_LIMITER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/util.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Keeps track of the memory used by the data in the queues
+             * between the threads of the Reader and blocks the producers
+             * if more than the configured limit is used.
+             *
+             * Memory is accounted in two parts: "input" is the raw data
+             * read from the file and not yet used by the parser, "output" is
+             * the data handed from the parser to the application (blobs
+             * still being decoded and the resulting buffers).
+             *
+             * The thread reading the input blocks if the total memory use
+             * is above the limit. The parser blocks if the total memory use
+             * is above the limit and there is output it has to wait for. The
+             * memory held by the input is not enough to block the parser,
+             * because only the parser itself can release it. Neither blocks
+             * if no memory is accounted for the part it is waiting on, so
+             * objects larger than the limit can always pass.
+             *
+             * If the limit is 0, nothing is accounted and nothing blocks.
+             * After shutdown() was called nothing blocks any more. This must
+             * be called when the data in the queues is not going to be
+             * consumed normally, for instance because of an error.
+             */
+            class MemoryLimiter {
+
+                const std::size_t m_limit;
+
+                mutable std::mutex m_mutex;
+
+                /// Used to signal producers when memory was released.
+                std::condition_variable m_space_available;
+
+                std::size_t m_input = 0;
+                std::size_t m_output = 0;
+                std::size_t m_max_used = 0;
+                bool m_shutdown = false;
+
+                /// Called when memory was released.
+                osmium::thread::detail::change_listener m_listener;
+
+                void update_max_used() noexcept {
+                    if (m_input + m_output > m_max_used) {
+                        m_max_used = m_input + m_output;
+                    }
+                }
+
+            public:
+
+                explicit MemoryLimiter(std::size_t limit = 0) noexcept :
+                    m_limit(limit) {
+                }
+
+                MemoryLimiter(const MemoryLimiter&) = delete;
+                MemoryLimiter& operator=(const MemoryLimiter&) = delete;
+
+                MemoryLimiter(MemoryLimiter&&) = delete;
+                MemoryLimiter& operator=(MemoryLimiter&&) = delete;
+
+                ~MemoryLimiter() noexcept = default;
+
+                /// The configured limit in bytes (0 if there is no limit).
+                std::size_t limit() const noexcept {
+                    return m_limit;
+                }
+
+                /// The number of bytes currently accounted for.
+                std::size_t used() const {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    return m_input + m_output;
+                }
+
+                /// The largest number of bytes accounted for so far.
+                std::size_t max_used() const {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    return m_max_used;
+                }
+
+                /**
+                 * Set a function that is called whenever memory is released
+                 * or shutdown() is called. See
+                 * osmium::thread::OrderedQueue::set_listener().
+                 */
+                void set_listener(std::function<void()> listener) {
+                    m_listener.set(std::move(listener));
+                }
+
+                /**
+                 * Account for size bytes of input data. Blocks while the
+                 * limit would be exceeded and any memory is used at all.
+                 */
+                void acquire_input(std::size_t size) {
+                    if (!m_limit) {
+                        return;
+                    }
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    m_space_available.wait(lock, [this, size] {
+                        return m_shutdown || m_input + m_output == 0 || m_input + m_output + size <= m_limit;
+                    });
+                    m_input += size;
+                    update_max_used();
+                }
+
+                /**
+                 * Like acquire_input(), but returns false instead of
+                 * blocking if the limit would be exceeded.
+                 */
+                bool try_acquire_input(std::size_t size) {
+                    if (!m_limit) {
+                        return true;
+                    }
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    if (!(m_shutdown || m_input + m_output == 0 || m_input + m_output + size <= m_limit)) {
+                        return false;
+                    }
+                    m_input += size;
+                    update_max_used();
+                    return true;
+                }
+
+                void release_input(std::size_t size) {
+                    if (!m_limit) {
+                        return;
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock{m_mutex};
+                        m_input -= size < m_input ? size : m_input;
+                    }
+                    m_space_available.notify_all();
+                    m_listener();
+                }
+
+                /**
+                 * Account for size bytes of output data. Blocks while the
+                 * limit would be exceeded and there is output data that
+                 * will be released by other threads.
+                 */
+                void acquire_output(std::size_t size) {
+                    if (!m_limit) {
+                        return;
+                    }
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    m_space_available.wait(lock, [this, size] {
+                        return m_shutdown || m_output == 0 || m_input + m_output + size <= m_limit;
+                    });
+                    m_output += size;
+                    update_max_used();
+                }
+
+                /**
+                 * Account for size bytes of output data. Never blocks. This
+                 * is used from the worker threads of the pool which must
+                 * never block.
+                 */
+                void add_output(std::size_t size) {
+                    if (!m_limit) {
+                        return;
+                    }
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_output += size;
+                    update_max_used();
+                }
+
+                void release_output(std::size_t size) {
+                    if (!m_limit) {
+                        return;
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock{m_mutex};
+                        m_output -= size < m_output ? size : m_output;
+                    }
+                    m_space_available.notify_all();
+                    m_listener();
+                }
+
+                /**
+                 * Stop blocking. Wakes up all threads currently waiting.
+                 */
+                void shutdown() {
+                    if (!m_limit) {
+                        return;
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock{m_mutex};
+                        m_shutdown = true;
+                    }
+                    m_space_available.notify_all();
+                    m_listener();
+                }
+
+            }; // class MemoryLimiter
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_MEMORY_LIMITER_HPP
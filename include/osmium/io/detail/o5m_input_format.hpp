@@ -508,7 +508,7 @@ namespace osmium {
                 }
 
                 void flush() {
-                    osmium::memory::Buffer buffer{buffer_size};
+                    osmium::memory::Buffer buffer{get_buffer(buffer_size)};
                     using std::swap;
                     swap(m_buffer, buffer);
                     send_to_output_queue(std::move(buffer));
@@ -603,7 +603,7 @@ namespace osmium {
 
                 explicit O5mParser(parser_arguments& args) :
                     Parser(args),
-                    m_buffer(buffer_size),
+                    m_buffer(get_buffer(buffer_size)),
                     m_data(m_input.data()),
                     m_end(m_data) {
                 }
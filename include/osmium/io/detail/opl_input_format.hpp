@@ -39,6 +39,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/util/trace.hpp>
 
 #include <cstdint>
 #include <memory>
@@ -58,9 +59,11 @@ namespace osmium {
             template <typename T>
             void line_by_line(T& worker) {
                 std::string rest;
+                uint64_t sequence = 0;
 
                 while (!worker.input_done()) {
                     std::string input{worker.get_input()};
+                    osmium::TraceSpan span{"opl_parse", sequence++};
                     std::string::size_type ppos = 0;
 
                     if (!rest.empty()) {
@@ -100,12 +103,12 @@ namespace osmium {
 
             class OPLParser : public Parser {
 
-                osmium::memory::Buffer m_buffer{1024*1024};
+                osmium::memory::Buffer m_buffer;
                 uint64_t m_line_count = 0;
 
                 void maybe_flush() {
                     if (m_buffer.committed() > 800*1024) {
-                        osmium::memory::Buffer buffer{1024*1024};
+                        osmium::memory::Buffer buffer{get_buffer(1024*1024)};
                         using std::swap;
                         swap(m_buffer, buffer);
                         send_to_output_queue(std::move(buffer));
@@ -116,7 +119,8 @@ namespace osmium {
             public:
 
                 explicit OPLParser(parser_arguments& args) :
-                    Parser(args) {
+                    Parser(args),
+                    m_buffer(get_buffer(1024*1024)) {
                     set_header_value(osmium::io::Header{});
                 }
 
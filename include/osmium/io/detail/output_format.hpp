@@ -39,6 +39,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/thread/pool.hpp>
 
 #include <array>
@@ -66,8 +67,18 @@ namespace osmium {
 
                 std::shared_ptr<std::string> m_out;
 
-                explicit OutputBlock(osmium::memory::Buffer&& buffer) :
-                    m_input_buffer(std::make_shared<osmium::memory::Buffer>(std::move(buffer))),
+                static std::shared_ptr<osmium::memory::Buffer> make_input_buffer(osmium::memory::Buffer&& buffer, osmium::memory::BufferPool* buffer_pool) {
+                    if (buffer_pool) {
+                        // The buffer is given back to the pool once the last
+                        // copy of this block is gone.
+                        return std::shared_ptr<osmium::memory::Buffer>(new osmium::memory::Buffer{std::move(buffer)},
+                                                                       osmium::memory::BufferPoolDeleter{buffer_pool});
+                    }
+                    return std::make_shared<osmium::memory::Buffer>(std::move(buffer));
+                }
+
+                explicit OutputBlock(osmium::memory::Buffer&& buffer, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    m_input_buffer(make_input_buffer(std::move(buffer), buffer_pool)),
                     m_out(std::make_shared<std::string>()) {
                 }
 
@@ -109,19 +120,40 @@ namespace osmium {
             protected:
 
                 osmium::thread::Pool& m_pool;
-                future_string_queue_type& m_output_queue;
+                string_queue_type& m_output_queue;
+                osmium::memory::BufferPool* m_buffer_pool = nullptr;
 
                 /**
-                 * Wrap the string into a future and add it to the output
-                 * queue.
+                 * Add the string to the output queue.
                  */
                 void send_to_output_queue(std::string&& data) {
                     add_to_queue(m_output_queue, std::move(data));
                 }
 
+                /**
+                 * Run the function in the thread pool and add the resulting
+                 * string to the output queue. The strings end up in the
+                 * queue in the order this function was called, regardless
+                 * of when they are ready.
+                 */
+                template <typename TFunction>
+                void send_to_output_queue_via_pool(TFunction&& function) {
+                    add_task_to_queue(m_pool, m_output_queue, std::forward<TFunction>(function));
+                }
+
+                /**
+                 * Give a buffer that has been written out back to the buffer
+                 * pool (if there is one).
+                 */
+                void recycle(osmium::memory::Buffer&& buffer) {
+                    if (m_buffer_pool) {
+                        m_buffer_pool->put(std::move(buffer));
+                    }
+                }
+
             public:
 
-                OutputFormat(osmium::thread::Pool& pool, future_string_queue_type& output_queue) noexcept :
+                OutputFormat(osmium::thread::Pool& pool, string_queue_type& output_queue) noexcept :
                     m_pool(pool),
                     m_output_queue(output_queue) {
                 }
@@ -134,6 +166,14 @@ namespace osmium {
 
                 virtual ~OutputFormat() noexcept = default;
 
+                /**
+                 * Set the pool buffers are given back to after they have
+                 * been written out.
+                 */
+                void set_buffer_pool(osmium::memory::BufferPool* buffer_pool) noexcept {
+                    m_buffer_pool = buffer_pool;
+                }
+
                 virtual void write_header(const osmium::io::Header& /*header*/) {
                 }
 
@@ -155,7 +195,7 @@ namespace osmium {
 
             public:
 
-                using create_output_type = std::function<osmium::io::detail::OutputFormat*(osmium::thread::Pool&, const osmium::io::File&, future_string_queue_type&)>;
+                using create_output_type = std::function<osmium::io::detail::OutputFormat*(osmium::thread::Pool&, const osmium::io::File&, string_queue_type&)>;
 
             private:
 
@@ -183,7 +223,7 @@ namespace osmium {
                     return true;
                 }
 
-                std::unique_ptr<osmium::io::detail::OutputFormat> create_output(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) const {
+                std::unique_ptr<osmium::io::detail::OutputFormat> create_output(osmium::thread::Pool& pool, const osmium::io::File& file, string_queue_type& output_queue) const {
                     const auto func = callbacks(file.format());
                     if (func) {
                         return std::unique_ptr<osmium::io::detail::OutputFormat>((func)(pool, file, output_queue));
@@ -203,7 +243,7 @@ namespace osmium {
 
             public:
 
-                BlackholeOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& /*file*/, future_string_queue_type& output_queue) :
+                BlackholeOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& /*file*/, string_queue_type& output_queue) :
                     OutputFormat(pool, output_queue) {
                 }
 
@@ -215,7 +255,8 @@ namespace osmium {
 
                 ~BlackholeOutputFormat() noexcept final = default;
 
-                void write_buffer(osmium::memory::Buffer&& /*buffer*/) final {
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    recycle(std::move(buffer));
                 }
 
             }; // class BlackholeOutputFormat
@@ -223,7 +264,7 @@ namespace osmium {
             // we want the register_output_format() function to run, setting
             // the variable is only a side-effect, it will never be used
             const bool registered_blackhole_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::blackhole,
-                [](osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) {
+                [](osmium::thread::Pool& pool, const osmium::io::File& file, string_queue_type& output_queue) {
                     return new osmium::io::detail::BlackholeOutputFormat(pool, file, output_queue);
             });
 
@@ -40,6 +40,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/osm/box.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
@@ -51,6 +52,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
 #include <osmium/util/delta.hpp>
+#include <osmium/util/trace.hpp>
 
 #include <protozero/iterators.hpp>
 #include <protozero/pbf_message.hpp>
@@ -92,7 +94,7 @@ namespace osmium {
 
                 osmium::osm_entity_bits::type m_read_types;
 
-                osmium::memory::Buffer m_buffer { initial_buffer_size };
+                osmium::memory::Buffer m_buffer;
 
                 osmium::io::read_meta m_read_metadata;
 
@@ -704,9 +706,10 @@ namespace osmium {
 
             public:
 
-                PBFPrimitiveBlockDecoder(const data_view& data, osmium::osm_entity_bits::type read_types, osmium::io::read_meta read_metadata) :
+                PBFPrimitiveBlockDecoder(const data_view& data, osmium::osm_entity_bits::type read_types, osmium::io::read_meta read_metadata, osmium::memory::BufferPool* buffer_pool = nullptr) :
                     m_data(data),
                     m_read_types(read_types),
+                    m_buffer(buffer_pool ? buffer_pool->get(initial_buffer_size) : osmium::memory::Buffer{initial_buffer_size}),
                     m_read_metadata(read_metadata) {
                 }
 
@@ -885,18 +888,28 @@ namespace osmium {
                 std::shared_ptr<std::string> m_input_buffer;
                 osmium::osm_entity_bits::type m_read_types;
                 osmium::io::read_meta m_read_metadata;
+                osmium::memory::BufferPool* m_buffer_pool;
+                uint64_t m_sequence;
 
             public:
 
-                PBFDataBlobDecoder(std::string&& input_buffer, osmium::osm_entity_bits::type read_types, osmium::io::read_meta read_metadata) :
+                PBFDataBlobDecoder(std::string&& input_buffer, osmium::osm_entity_bits::type read_types, osmium::io::read_meta read_metadata, osmium::memory::BufferPool* buffer_pool = nullptr, uint64_t sequence = 0) :
                     m_input_buffer(std::make_shared<std::string>(std::move(input_buffer))),
                     m_read_types(read_types),
-                    m_read_metadata(read_metadata) {
+                    m_read_metadata(read_metadata),
+                    m_buffer_pool(buffer_pool),
+                    m_sequence(sequence) {
                 }
 
                 osmium::memory::Buffer operator()() {
                     std::string output;
-                    PBFPrimitiveBlockDecoder decoder{decode_blob(*m_input_buffer, output), m_read_types, m_read_metadata};
+                    data_view data;
+                    {
+                        osmium::TraceSpan span{"pbf_decompress", m_sequence};
+                        data = decode_blob(*m_input_buffer, output);
+                    }
+                    osmium::TraceSpan span{"pbf_decode", m_sequence};
+                    PBFPrimitiveBlockDecoder decoder{data, m_read_types, m_read_metadata, m_buffer_pool};
                     return decoder();
                 }
 
@@ -43,6 +43,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
+#include <osmium/util/trace.hpp>
 
 #include <protozero/pbf_message.hpp>
 #include <protozero/types.hpp>
@@ -180,13 +181,23 @@ namespace osmium {
                 }
 
                 void parse_data_blobs() {
-                    while (const auto size = check_type_and_get_blob_size("OSMData")) {
-                        std::string input_buffer{read_from_input_queue_with_check(size)};
+                    uint64_t sequence = 0;
+                    while (true) {
+                        std::string input_buffer;
+                        {
+                            osmium::TraceSpan span{"pbf_read_blob", sequence};
+                            const auto size = check_type_and_get_blob_size("OSMData");
+                            if (size == 0) {
+                                break;
+                            }
+                            input_buffer = read_from_input_queue_with_check(size);
+                        }
+                        const auto size = input_buffer.size();
 
-                        PBFDataBlobDecoder data_blob_parser{std::move(input_buffer), read_types(), read_metadata()};
+                        PBFDataBlobDecoder data_blob_parser{std::move(input_buffer), read_types(), read_metadata(), buffer_pool(), sequence++};
 
                         if (osmium::config::use_pool_threads_for_pbf_parsing()) {
-                            send_to_output_queue(get_pool().submit(std::move(data_blob_parser)));
+                            send_to_output_queue_via_pool(std::move(data_blob_parser), size);
                         } else {
                             send_to_output_queue(data_blob_parser());
                         }
@@ -61,6 +61,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/util/cast.hpp>
 #include <osmium/util/delta.hpp>
 #include <osmium/util/misc.hpp>
+#include <osmium/util/trace.hpp>
 #include <osmium/visitor.hpp>
 
 #include <protozero/pbf_builder.hpp>
@@ -170,6 +171,7 @@ namespace osmium {
                  */
                 std::string operator()() {
                     assert(m_msg.size() <= max_uncompressed_blob_size);
+                    osmium::TraceSpan span{"pbf_encode"};
 
                     std::string blob_data;
                     protozero::pbf_builder<FileFormat::Blob> pbf_blob{blob_data};
@@ -454,11 +456,11 @@ namespace osmium {
 
                     primitive_block.add_message(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, m_primitive_block.group_data());
 
-                    m_output_queue.push(m_pool.submit(
+                    send_to_output_queue_via_pool(
                         SerializeBlob{std::move(primitive_block_data),
                                       pbf_blob_type::data,
                                       m_options.use_compression}
-                    ));
+                    );
                 }
 
                 template <typename T>
@@ -510,7 +512,7 @@ namespace osmium {
 
             public:
 
-                PBFOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
+                PBFOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, string_queue_type& output_queue) :
                     OutputFormat(pool, output_queue),
                     m_primitive_block(m_options) {
 
@@ -572,15 +574,16 @@ namespace osmium {
                         pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_osmosis_replication_base_url, osmosis_replication_base_url);
                     }
 
-                    m_output_queue.push(m_pool.submit(
+                    send_to_output_queue_via_pool(
                         SerializeBlob{std::move(data),
                                       pbf_blob_type::header,
                                       m_options.use_compression}
-                        ));
+                    );
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
                     osmium::apply(buffer.cbegin(), buffer.cend(), *this);
+                    recycle(std::move(buffer));
                 }
 
                 void write_end() final {
@@ -672,7 +675,7 @@ namespace osmium {
             // we want the register_output_format() function to run, setting
             // the variable is only a side-effect, it will never be used
             const bool registered_pbf_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::pbf,
-                [](osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) {
+                [](osmium::thread::Pool& pool, const osmium::io::File& file, string_queue_type& output_queue) {
                     return new osmium::io::detail::PBFOutputFormat{pool, file, output_queue};
             });
 
@@ -34,12 +34,12 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/memory/buffer.hpp>
-#include <osmium/thread/queue.hpp>
+#include <osmium/thread/ordered_queue.hpp>
+#include <osmium/thread/pool.hpp>
 
-#include <cassert>
 #include <exception>
-#include <future>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 namespace osmium {
@@ -48,64 +48,118 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * The queues between the threads reading, parsing, and
+             * writing data. They keep the data in order even if it is
+             * produced out of order in the thread pool and can also
+             * transport exceptions.
+             */
             template <typename T>
-            using future_queue_type = osmium::thread::Queue<std::future<T>>;
+            using ordered_queue_type = osmium::thread::OrderedQueue<T>;
 
             /**
              * This type of queue contains buffers with OSM data in them.
              * The "end of file" is marked by an invalid Buffer.
-             * The buffers are wrapped in a std::future so that they can also
-             * transport exceptions. The future also helps with keeping the
-             * data in order.
              */
-            using future_buffer_queue_type = future_queue_type<osmium::memory::Buffer>;
+            using buffer_queue_type = ordered_queue_type<osmium::memory::Buffer>;
 
             /**
              * This type of queue contains OSM file data in the form it is
              * stored on disk, ie encoded as XML, PBF, etc.
              * The "end of file" is marked by an empty string.
-             * The strings are wrapped in a std::future so that they can also
-             * transport exceptions. The future also helps with keeping the
-             * data in order.
              */
-            using future_string_queue_type = future_queue_type<std::string>;
+            using string_queue_type = ordered_queue_type<std::string>;
 
+            /// @deprecated Use ordered_queue_type instead.
             template <typename T>
-            inline void add_to_queue(future_queue_type<T>& queue, T&& data) {
-                std::promise<T> promise;
-                queue.push(promise.get_future());
-                promise.set_value(std::forward<T>(data));
+            using future_queue_type = ordered_queue_type<T>;
+
+            /// @deprecated Use buffer_queue_type instead.
+            using future_buffer_queue_type = buffer_queue_type;
+
+            /// @deprecated Use string_queue_type instead.
+            using future_string_queue_type = string_queue_type;
+
+            template <typename T>
+            inline void add_to_queue(ordered_queue_type<T>& queue, T&& data) {
+                queue.push(std::forward<T>(data));
             }
 
             template <typename T>
-            inline void add_to_queue(future_queue_type<T>& queue, std::exception_ptr&& exception) {
-                std::promise<T> promise;
-                queue.push(promise.get_future());
-                promise.set_exception(std::move(exception));
+            inline void add_to_queue(ordered_queue_type<T>& queue, std::exception_ptr&& exception) {
+                queue.push_exception(std::move(exception));
             }
 
             template <typename T>
-            inline void add_end_of_data_to_queue(future_queue_type<T>& queue) {
+            inline void add_end_of_data_to_queue(ordered_queue_type<T>& queue) {
                 add_to_queue<T>(queue, T{});
             }
 
+            /**
+             * Task run in the thread pool. It calls the function and sets
+             * the result (or the exception thrown) for the ticket in the
+             * queue.
+             */
+            template <typename T, typename TFunction>
+            class ordered_task {
+
+                ordered_queue_type<T>* m_queue;
+                typename ordered_queue_type<T>::ticket_type m_ticket;
+                TFunction m_function;
+
+            public:
+
+                ordered_task(ordered_queue_type<T>& queue, typename ordered_queue_type<T>::ticket_type ticket, TFunction&& function) :
+                    m_queue(&queue),
+                    m_ticket(ticket),
+                    m_function(std::move(function)) {
+                }
+
+                void operator()() {
+                    try {
+                        m_queue->set_value(m_ticket, m_function());
+                    } catch (...) {
+                        m_queue->set_exception(m_ticket, std::current_exception());
+                    }
+                }
+
+            }; // class ordered_task
+
+            /**
+             * Reserve the next place in the queue and run the function in
+             * the thread pool. The result of the function (or the exception
+             * it throws) will end up at that place in the queue. Blocks if
+             * the queue is full.
+             */
+            template <typename T, typename TFunction>
+            inline void add_task_to_queue(osmium::thread::Pool& pool, ordered_queue_type<T>& queue, TFunction&& function) {
+                using function_type = typename std::decay<TFunction>::type;
+                function_type func(std::forward<TFunction>(function));
+                const auto ticket = queue.reserve();
+                try {
+                    pool.submit_detached(ordered_task<T, function_type>{queue, ticket, std::move(func)});
+                } catch (...) {
+                    queue.set_exception(ticket, std::current_exception());
+                }
+            }
+
             inline bool at_end_of_data(const std::string& data) noexcept {
                 return data.empty();
             }
 
-            inline bool at_end_of_data(osmium::memory::Buffer& buffer) noexcept {
+            inline bool at_end_of_data(const osmium::memory::Buffer& buffer) noexcept {
                 return !buffer;
             }
 
             template <typename T>
             class queue_wrapper {
 
-                future_queue_type<T>& m_queue;
+                ordered_queue_type<T>& m_queue;
                 bool m_has_reached_end_of_data;
 
             public:
 
-                explicit queue_wrapper(future_queue_type<T>& queue) :
+                explicit queue_wrapper(ordered_queue_type<T>& queue) :
                     m_queue(queue),
                     m_has_reached_end_of_data(false) {
                 }
@@ -137,10 +191,7 @@ namespace osmium {
                 T pop() {
                     T data;
                     if (!m_has_reached_end_of_data) {
-                        std::future<T> data_future;
-                        m_queue.wait_and_pop(data_future);
-                        assert(data_future.valid());
-                        data = std::move(data_future.get());
+                        data = m_queue.pop();
                         if (at_end_of_data(data)) {
                             m_has_reached_end_of_data = true;
                         }
@@ -148,6 +199,24 @@ namespace osmium {
                     return data;
                 }
 
+                /**
+                 * Like pop(), but returns false instead of blocking if
+                 * the next data isn't available yet.
+                 */
+                bool try_pop(T& data) {
+                    if (m_has_reached_end_of_data) {
+                        data = T{};
+                        return true;
+                    }
+                    if (!m_queue.try_pop(data)) {
+                        return false;
+                    }
+                    if (at_end_of_data(data)) {
+                        m_has_reached_end_of_data = true;
+                    }
+                    return true;
+                }
+
             }; // class queue_wrapper
 
         } // namespace detail
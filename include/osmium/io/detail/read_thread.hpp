@@ -34,11 +34,18 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/io/compression.hpp>
+#include <osmium/io/detail/memory_limiter.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/thread/execution_context.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/util/config.hpp>
+#include <osmium/util/numa.hpp>
+#include <osmium/util/trace.hpp>
 
 #include <atomic>
+#include <cstdint>
 #include <exception>
+#include <memory>
 #include <string>
 #include <thread>
 #include <utility>
@@ -49,33 +56,160 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * Reads data from the input file and (optionally) decompresses
+             * it in steps run by an ExecutionContext. Each step reads one
+             * chunk, steps that would block on the queue or the memory
+             * limiter return without doing anything. Listeners on both
+             * notify the task when that might have changed. This does the
+             * same as
+             * the thread started by the ReadThreadManager otherwise.
+             */
+            class ReadTask : public osmium::thread::ExecutionContext::Task {
+
+                using step_result = osmium::thread::ExecutionContext::step_result;
+
+                osmium::io::Decompressor& m_decompressor;
+                string_queue_type& m_queue;
+                MemoryLimiter* m_memory_limiter;
+                const std::atomic<bool>& m_done;
+
+                std::string m_data{};
+                std::exception_ptr m_exception{};
+                std::uint64_t m_sequence = 0;
+                bool m_at_end = false;
+
+                // Only this task adds to the queue, so if there is space
+                // now, adding to the queue will not block.
+                bool queue_has_space() const noexcept {
+                    return m_queue.size() < m_queue.capacity();
+                }
+
+                step_result finish() {
+                    if (!queue_has_space()) {
+                        return step_result::idle;
+                    }
+                    if (m_exception) {
+                        add_to_queue(m_queue, std::move(m_exception));
+                        m_exception = nullptr;
+                        return step_result::progress;
+                    }
+                    add_end_of_data_to_queue(m_queue);
+                    remove_listeners();
+                    return step_result::done;
+                }
+
+                void remove_listeners() {
+                    m_queue.set_listener(nullptr);
+                    if (m_memory_limiter) {
+                        m_memory_limiter->set_listener(nullptr);
+                    }
+                }
+
+            public:
+
+                ReadTask(osmium::io::Decompressor& decompressor,
+                         string_queue_type& queue,
+                         MemoryLimiter* memory_limiter,
+                         const std::atomic<bool>& done) :
+                    m_decompressor(decompressor),
+                    m_queue(queue),
+                    m_memory_limiter(memory_limiter),
+                    m_done(done) {
+                    m_queue.set_listener([this] {
+                        notify();
+                    });
+                    if (m_memory_limiter) {
+                        m_memory_limiter->set_listener([this] {
+                            notify();
+                        });
+                    }
+                }
+
+                step_result step() override {
+                    if (m_at_end) {
+                        return finish();
+                    }
+
+                    try {
+                        if (m_done) {
+                            m_at_end = true;
+                            m_decompressor.close();
+                            return step_result::progress;
+                        }
+
+                        if (m_data.empty()) {
+                            {
+                                osmium::TraceSpan span{"read", m_sequence++};
+                                m_data = m_decompressor.read();
+                            }
+                            if (at_end_of_data(m_data)) {
+                                m_at_end = true;
+                                m_decompressor.close();
+                            }
+                            return step_result::progress;
+                        }
+
+                        if (!queue_has_space() ||
+                            (m_memory_limiter && !m_memory_limiter->try_acquire_input(m_data.size()))) {
+                            return step_result::idle;
+                        }
+                        add_to_queue(m_queue, std::move(m_data));
+                        m_data.clear();
+                    } catch (...) {
+                        m_at_end = true;
+                        m_exception = std::current_exception();
+                    }
+
+                    return step_result::progress;
+                }
+
+            }; // class ReadTask
+
             /**
              * This code uses an internally managed thread to read data from
              * the input file and (optionally) decompress it. The result is
              * sent to the given queue. Any exceptions will also be send to
              * the queue.
+             *
+             * If an ExecutionContext is given, no thread is started. The
+             * work is done by a ReadTask in the context instead.
              */
             class ReadThreadManager {
 
                 // only used in the sub-thread
                 osmium::io::Decompressor& m_decompressor;
-                future_string_queue_type& m_queue;
+                string_queue_type& m_queue;
+                MemoryLimiter* m_memory_limiter;
 
                 // used in both threads
                 std::atomic<bool> m_done;
 
                 // only used in the main thread
                 std::thread m_thread;
+                osmium::thread::task_handler m_task;
 
                 void run_in_thread() {
                     osmium::thread::set_thread_name("_osmium_read");
+                    if (osmium::config::pin_threads()) {
+                        // Keep I/O thread on the first NUMA node.
+                        osmium::pin_current_thread_to_node(0);
+                    }
 
                     try {
+                        std::uint64_t sequence = 0;
                         while (!m_done) {
-                            std::string data {m_decompressor.read()};
+                            std::string data;
+                            {
+                                osmium::TraceSpan span{"read", sequence++};
+                                data = m_decompressor.read();
+                            }
                             if (at_end_of_data(data)) {
                                 break;
                             }
+                            if (m_memory_limiter) {
+                                m_memory_limiter->acquire_input(data.size());
+                            }
                             add_to_queue(m_queue, std::move(data));
                         }
 
@@ -90,11 +224,18 @@ namespace osmium {
             public:
 
                 ReadThreadManager(osmium::io::Decompressor& decompressor,
-                                  future_string_queue_type& queue) :
+                                  string_queue_type& queue,
+                                  MemoryLimiter* memory_limiter = nullptr,
+                                  osmium::thread::ExecutionContext* context = nullptr) :
                     m_decompressor(decompressor),
                     m_queue(queue),
-                    m_done(false),
-                    m_thread(std::thread(&ReadThreadManager::run_in_thread, this)) {
+                    m_memory_limiter(memory_limiter),
+                    m_done(false) {
+                    if (context) {
+                        m_task = osmium::thread::task_handler{*context, std::make_shared<ReadTask>(decompressor, queue, memory_limiter, m_done)};
+                    } else {
+                        m_thread = std::thread(&ReadThreadManager::run_in_thread, this);
+                    }
                 }
 
                 ReadThreadManager(const ReadThreadManager&) = delete;
@@ -111,8 +252,9 @@ namespace osmium {
                     }
                 }
 
-                void stop() noexcept {
+                void stop() {
                     m_done = true;
+                    m_task.notify();
                 }
 
                 void close() {
@@ -120,6 +262,7 @@ namespace osmium {
                     if (m_thread.joinable()) {
                         m_thread.join();
                     }
+                    m_task.wait();
                 }
 
             }; // class ReadThreadManager
@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/io/reader_options.hpp>
 #include <osmium/io/writer_options.hpp>
 
 #include <cerrno>
@@ -198,6 +199,70 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Tell the operating system how the file is going to be read.
+             * This only works on Linux, on other systems it does nothing.
+             * Errors are ignored, because this is only a hint.
+             *
+             * @param fd File descriptor.
+             * @param advice How the file is going to be read.
+             */
+            inline void advise_read_access(const int fd, const osmium::io::read_advice advice) noexcept {
+#ifdef __linux__
+                if (advice == osmium::io::read_advice::normal) {
+                    return;
+                }
+                ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+                if (advice == osmium::io::read_advice::streaming) {
+                    ::posix_fadvise(fd, 0, 0, POSIX_FADV_NOREUSE);
+                }
+#else
+                (void)fd;
+                (void)advice;
+#endif
+            }
+
+            /**
+             * Tell the operating system that the given range of the file
+             * will be needed soon, so that it can start reading it in the
+             * background. This only works on Linux, on other systems it
+             * does nothing.
+             *
+             * @param fd File descriptor.
+             * @param offset Start of the range.
+             * @param size Length of the range.
+             */
+            inline void advise_will_need(const int fd, const std::size_t offset, const std::size_t size) noexcept {
+#ifdef __linux__
+                ::posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+#else
+                (void)fd;
+                (void)offset;
+                (void)size;
+#endif
+            }
+
+            /**
+             * Remove the pages of the file up to (about) the given offset
+             * from the page cache. The last few pages before the offset are
+             * kept, because they might still be in use. This only works on
+             * Linux, on other systems it does nothing.
+             *
+             * @param fd File descriptor.
+             * @param offset Offset up to which the pages can be removed.
+             */
+            inline void remove_buffered_pages(const int fd, const std::size_t offset) noexcept {
+#ifdef __linux__
+                constexpr const std::size_t keep_size = 64UL * 1024UL;
+                if (offset > keep_size) {
+                    ::posix_fadvise(fd, 0, static_cast<off_t>(offset - keep_size), POSIX_FADV_DONTNEED);
+                }
+#else
+                (void)fd;
+                (void)offset;
+#endif
+            }
+
         } // namespace detail
 
     } // namespace io
@@ -35,8 +35,13 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/compression.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/thread/execution_context.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/util/config.hpp>
+#include <osmium/util/numa.hpp>
+#include <osmium/util/trace.hpp>
 
+#include <cstdint>
 #include <exception>
 #include <future>
 #include <memory>
@@ -62,7 +67,7 @@ namespace osmium {
 
             public:
 
-                WriteThread(future_string_queue_type& input_queue,
+                WriteThread(string_queue_type& input_queue,
                             std::unique_ptr<osmium::io::Compressor>&& compressor,
                             std::promise<bool>&& promise) :
                     m_queue(input_queue),
@@ -80,13 +85,19 @@ namespace osmium {
 
                 void operator()() {
                     osmium::thread::set_thread_name("_osmium_write");
+                    if (osmium::config::pin_threads()) {
+                        // Keep I/O thread on the first NUMA node.
+                        osmium::pin_current_thread_to_node(0);
+                    }
 
                     try {
+                        uint64_t sequence = 0;
                         while (true) {
                             const std::string data{m_queue.pop()};
                             if (at_end_of_data(data)) {
                                 break;
                             }
+                            osmium::TraceSpan span{"write", sequence++};
                             m_compressor->write(data);
                         }
                         m_compressor->close();
@@ -99,6 +110,85 @@ namespace osmium {
 
             }; // class WriteThread
 
+            /**
+             * Does the same as the WriteThread, but in steps run by an
+             * ExecutionContext. Each step writes one chunk of data. If there
+             * is no data in the queue, the step returns immediately and a
+             * listener on the queue notifies the task when data arrives.
+             */
+            class WriteTask : public osmium::thread::ExecutionContext::Task {
+
+                using step_result = osmium::thread::ExecutionContext::step_result;
+
+                string_queue_type& m_queue;
+                std::unique_ptr<osmium::io::Compressor> m_compressor;
+                std::promise<bool> m_promise;
+                std::uint64_t m_sequence = 0;
+
+                // After an error the rest of the data is popped from the
+                // queue and thrown away.
+                bool m_failed = false;
+
+                step_result finished() {
+                    m_queue.set_listener(nullptr);
+                    return step_result::done;
+                }
+
+                void fail() {
+                    if (!m_failed) {
+                        m_failed = true;
+                        m_promise.set_exception(std::current_exception());
+                    }
+                }
+
+            public:
+
+                WriteTask(string_queue_type& queue,
+                          std::unique_ptr<osmium::io::Compressor>&& compressor,
+                          std::promise<bool>&& promise) :
+                    m_queue(queue),
+                    m_compressor(std::move(compressor)),
+                    m_promise(std::move(promise)) {
+                    m_queue.set_listener([this] {
+                        notify();
+                    });
+                }
+
+                step_result step() override {
+                    std::string data;
+                    try {
+                        if (!m_queue.try_pop(data)) {
+                            return step_result::idle;
+                        }
+                    } catch (...) {
+                        fail();
+                        return step_result::progress;
+                    }
+
+                    try {
+                        if (at_end_of_data(data)) {
+                            if (!m_failed) {
+                                m_compressor->close();
+                                m_promise.set_value(true);
+                            }
+                            return finished();
+                        }
+                        if (!m_failed) {
+                            osmium::TraceSpan span{"write", m_sequence++};
+                            m_compressor->write(data);
+                        }
+                    } catch (...) {
+                        fail();
+                        if (at_end_of_data(data)) {
+                            return finished();
+                        }
+                    }
+
+                    return step_result::progress;
+                }
+
+            }; // class WriteTask
+
         } // namespace detail
 
     } // namespace io
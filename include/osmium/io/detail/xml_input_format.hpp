@@ -55,6 +55,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/types_from_string.hpp>
 #include <osmium/osm/way.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/util/trace.hpp>
 
 #include <expat.h>
 
@@ -698,7 +699,7 @@ namespace osmium {
                 void flush_buffer() {
                     if (m_buffer.committed() > buffer_size / 10 * 9) {
                         send_to_output_queue(std::move(m_buffer));
-                        osmium::memory::Buffer buffer{buffer_size};
+                        osmium::memory::Buffer buffer{get_buffer(buffer_size)};
                         using std::swap;
                         swap(m_buffer, buffer);
                     }
@@ -708,7 +709,7 @@ namespace osmium {
 
                 explicit XMLParser(parser_arguments& args) :
                     Parser(args),
-                    m_buffer(buffer_size) {
+                    m_buffer(get_buffer(buffer_size)) {
                 }
 
                 XMLParser(const XMLParser&) = delete;
@@ -724,8 +725,10 @@ namespace osmium {
 
                     ExpatXMLParser parser{this};
 
+                    uint64_t sequence = 0;
                     while (!input_done()) {
                         const std::string data{get_input()};
+                        osmium::TraceSpan span{"xml_parse", sequence++};
                         parser(data, input_done());
                         if (read_types() == osmium::osm_entity_bits::nothing && header_is_done()) {
                             break;
@@ -48,6 +48,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file_compression.hpp>
 #include <osmium/io/writer_options.hpp>
 #include <osmium/util/compatibility.hpp>
+#include <osmium/util/trace.hpp>
 
 #include <zlib.h>
 
@@ -157,11 +158,13 @@ namespace osmium {
 
         class GzipDecompressor : public Decompressor {
 
+            int m_fd;
             gzFile m_gzfile;
 
         public:
 
             explicit GzipDecompressor(int fd) :
+                m_fd(fd),
                 m_gzfile(::gzdopen(fd, "r")) {
                 if (!m_gzfile) {
                     detail::throw_gzip_error(m_gzfile, "read initialization failed");
@@ -183,7 +186,9 @@ namespace osmium {
             }
 
             std::string read() final {
-                std::string buffer(osmium::io::Decompressor::input_buffer_size, '\0');
+                osmium::TraceSpan span{"gzip_decompress"};
+                advise_read(m_fd, offset());
+                std::string buffer(chunk_size(), '\0');
                 assert(buffer.size() < std::numeric_limits<unsigned int>::max());
                 int nread = ::gzread(m_gzfile, const_cast<char*>(buffer.data()), static_cast<unsigned int>(buffer.size()));
                 if (nread < 0) {
@@ -248,6 +253,7 @@ namespace osmium {
             }
 
             std::string read() final {
+                osmium::TraceSpan span{"gzip_decompress"};
                 std::string output;
 
                 if (m_buffer) {
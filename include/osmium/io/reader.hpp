@@ -35,13 +35,16 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/compression.hpp>
 #include <osmium/io/detail/input_format.hpp>
+#include <osmium/io/detail/memory_limiter.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/detail/read_thread.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/reader_options.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
@@ -76,6 +79,13 @@ namespace osmium {
                 return n > 2 ? n : 2;
             }
 
+            inline std::size_t get_input_queue_size(std::size_t read_ahead) noexcept {
+                if (read_ahead == 0) {
+                    return get_input_queue_size();
+                }
+                return read_ahead > 2 ? read_ahead : 2;
+            }
+
             inline std::size_t get_osmdata_queue_size() noexcept {
                 const std::size_t n = osmium::config::get_max_queue_size("OSMDATA", 20);
                 return n > 2 ? n : 2;
@@ -106,13 +116,15 @@ namespace osmium {
 
             int m_childpid = 0;
 
-            detail::future_string_queue_type m_input_queue;
+            detail::MemoryLimiter m_memory_limiter;
+
+            detail::string_queue_type m_input_queue;
 
             std::unique_ptr<osmium::io::Decompressor> m_decompressor;
 
             osmium::io::detail::ReadThreadManager m_read_thread_manager;
 
-            detail::future_buffer_queue_type m_osmdata_queue;
+            detail::buffer_queue_type m_osmdata_queue;
             detail::queue_wrapper<osmium::memory::Buffer> m_osmdata_queue_wrapper;
 
             std::future<osmium::io::Header> m_header_future{};
@@ -125,26 +137,73 @@ namespace osmium {
             osmium::osm_entity_bits::type m_read_which_entities = osmium::osm_entity_bits::all;
             osmium::io::read_meta m_read_metadata = osmium::io::read_meta::yes;
 
-            void set_option(osmium::thread::Pool& pool) noexcept {
-                m_pool = &pool;
+            struct options_type {
+                osmium::thread::Pool* pool = nullptr;
+                osmium::osm_entity_bits::type read_which_entities = osmium::osm_entity_bits::all;
+                osmium::io::read_meta read_metadata = osmium::io::read_meta::yes;
+                osmium::io::read_advice advice = osmium::io::read_advice::normal;
+                std::size_t chunk_size = osmium::io::Decompressor::input_buffer_size;
+                std::size_t read_ahead = 0;
+                std::size_t memory_limit = 0;
+                osmium::memory::BufferPool* buffer_pool = nullptr;
+                osmium::thread::ExecutionContext* context = nullptr;
+            };
+
+            static void set_option(options_type& options, osmium::thread::Pool& pool) noexcept {
+                options.pool = &pool;
+            }
+
+            static void set_option(options_type& options, osmium::thread::ExecutionContext& context) noexcept {
+                options.context = &context;
             }
 
-            void set_option(osmium::osm_entity_bits::type value) noexcept {
-                m_read_which_entities = value;
+            static void set_option(options_type& options, osmium::osm_entity_bits::type value) noexcept {
+                options.read_which_entities = value;
             }
 
-            void set_option(osmium::io::read_meta value) noexcept {
-                m_read_metadata = value;
+            static void set_option(options_type& options, osmium::io::read_meta value) noexcept {
+                options.read_metadata = value;
+            }
+
+            static void set_option(options_type& options, osmium::io::read_advice value) noexcept {
+                options.advice = value;
+            }
+
+            static void set_option(options_type& options, osmium::io::read_chunk_size value) noexcept {
+                options.chunk_size = value.value;
+            }
+
+            static void set_option(options_type& options, osmium::io::read_ahead value) noexcept {
+                options.read_ahead = value.value;
+            }
+
+            static void set_option(options_type& options, osmium::io::queue_memory_limit value) noexcept {
+                options.memory_limit = value.value;
+            }
+
+            static void set_option(options_type& options, osmium::memory::BufferPool& buffer_pool) noexcept {
+                options.buffer_pool = &buffer_pool;
+            }
+
+            template <typename... TArgs>
+            static options_type make_options(TArgs&&... args) {
+                options_type options;
+                (void)std::initializer_list<int>{
+                    (set_option(options, args), 0)...
+                };
+                return options;
             }
 
             // This function will run in a separate thread.
             static void parser_thread(osmium::thread::Pool& pool,
                                       const detail::ParserFactory::create_parser_type& creator,
-                                      detail::future_string_queue_type& input_queue,
-                                      detail::future_buffer_queue_type& osmdata_queue,
+                                      detail::string_queue_type& input_queue,
+                                      detail::buffer_queue_type& osmdata_queue,
                                       std::promise<osmium::io::Header>&& header_promise,
                                       osmium::osm_entity_bits::type read_which_entities,
-                                      osmium::io::read_meta read_metadata) {
+                                      osmium::io::read_meta read_metadata,
+                                      detail::MemoryLimiter* memory_limiter,
+                                      osmium::memory::BufferPool* buffer_pool) {
                 std::promise<osmium::io::Header> promise{std::move(header_promise)};
                 osmium::io::detail::parser_arguments args = {
                     pool,
@@ -152,7 +211,9 @@ namespace osmium {
                     osmdata_queue,
                     promise,
                     read_which_entities,
-                    read_metadata
+                    read_metadata,
+                    memory_limiter,
+                    buffer_pool
                 };
                 creator(args)->parse();
             }
@@ -226,6 +287,51 @@ namespace osmium {
                 return osmium::io::detail::open_for_reading(filename);
             }
 
+            static std::unique_ptr<osmium::io::Decompressor> make_decompressor(const osmium::io::File& file, const options_type& options, int* childpid) {
+                std::unique_ptr<osmium::io::Decompressor> decompressor{file.buffer() ?
+                    osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), file.buffer(), file.buffer_size()) :
+                    osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), open_input_file_or_url(file.filename(), childpid))};
+
+                decompressor->set_chunk_size(options.chunk_size);
+                decompressor->set_read_advice(options.advice);
+
+                return decompressor;
+            }
+
+            /**
+             * Handle a buffer popped from the output queue. Returns true
+             * if it should be handed to the user, ie. if it marks the end
+             * of the data or contains data.
+             */
+            bool use_buffer(const osmium::memory::Buffer& buffer) {
+                m_memory_limiter.release_output(buffer.capacity());
+                if (detail::at_end_of_data(buffer)) {
+                    m_status = status::eof;
+                    m_read_thread_manager.close();
+                    return true;
+                }
+                return buffer.committed() > 0;
+            }
+
+            Reader(const osmium::io::File& file, options_type&& options) :
+                m_file(file.check()),
+                m_pool(options.pool ? options.pool : (options.context ? &options.context->pool() : &thread::Pool::default_instance())),
+                m_creator(detail::ParserFactory::instance().get_creator_function(m_file)),
+                m_memory_limiter(options.memory_limit),
+                m_input_queue(detail::get_input_queue_size(options.read_ahead), "raw_input"),
+                m_decompressor(make_decompressor(m_file, options, &m_childpid)),
+                m_read_thread_manager(*m_decompressor, m_input_queue, &m_memory_limiter, options.context),
+                m_osmdata_queue(detail::get_osmdata_queue_size(), "parser_results"),
+                m_osmdata_queue_wrapper(m_osmdata_queue),
+                m_file_size(m_decompressor->file_size()),
+                m_read_which_entities(options.read_which_entities),
+                m_read_metadata(options.read_metadata) {
+
+                std::promise<osmium::io::Header> header_promise;
+                m_header_future = header_promise.get_future();
+                m_thread = osmium::thread::thread_handler{parser_thread, std::ref(*m_pool), std::ref(m_creator), std::ref(m_input_queue), std::ref(m_osmdata_queue), std::move(header_promise), m_read_which_entities, m_read_metadata, &m_memory_limiter, options.buffer_pool};
+            }
+
         public:
 
             /**
@@ -247,33 +353,41 @@ namespace osmium {
              *      etc.) is not read possibly speeding up the read. Not all
              *      file formats use this setting.
              *
+             * * osmium::thread::Pool&: Reference to a thread pool that should
+             *      be used for reading instead of the default pool.
+             *
+             * * osmium::io::read_advice: Hints for the operating system on
+             *      how the file is read. Use osmium::io::read_advice::streaming
+             *      when reading large files to keep them from evicting other
+             *      data (such as memory-mapped indexes) from the page cache.
+             *      The default is osmium::io::read_advice::normal.
+             *
+             * * osmium::io::read_chunk_size: Size of the chunks the input
+             *      file is read in.
+             *
+             * * osmium::io::read_ahead: Number of chunks that can be read
+             *      ahead of the parser.
+             *
+             * * osmium::io::queue_memory_limit: Maximum number of bytes held
+             *      in the internal queues of the Reader. Reading will block
+             *      until the application has consumed enough data if this
+             *      is reached. Default is no limit.
+             *
+             * * osmium::memory::BufferPool&: The buffers returned by read()
+             *      are taken from this pool if possible. Give buffers you
+             *      don't need any more back to the pool to reuse them.
+             *
+             * * osmium::thread::ExecutionContext&: Read the input using the
+             *      I/O threads of this context instead of a thread of its
+             *      own. The thread pool of the context is used unless a pool
+             *      is given explicitly. The context must outlive the Reader.
+             *
              * @throws osmium::io_error If there was an error.
              * @throws std::system_error If the file could not be opened.
              */
             template <typename... TArgs>
             explicit Reader(const osmium::io::File& file, TArgs&&... args) :
-                m_file(file.check()),
-                m_creator(detail::ParserFactory::instance().get_creator_function(m_file)),
-                m_input_queue(detail::get_input_queue_size(), "raw_input"),
-                m_decompressor(m_file.buffer() ?
-                    osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), m_file.buffer(), m_file.buffer_size()) :
-                    osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), open_input_file_or_url(m_file.filename(), &m_childpid))),
-                m_read_thread_manager(*m_decompressor, m_input_queue),
-                m_osmdata_queue(detail::get_osmdata_queue_size(), "parser_results"),
-                m_osmdata_queue_wrapper(m_osmdata_queue),
-                m_file_size(m_decompressor->file_size()) {
-
-                (void)std::initializer_list<int>{
-                    (set_option(args), 0)...
-                };
-
-                if (!m_pool) {
-                    m_pool = &thread::Pool::default_instance();
-                }
-
-                std::promise<osmium::io::Header> header_promise;
-                m_header_future = header_promise.get_future();
-                m_thread = osmium::thread::thread_handler{parser_thread, std::ref(*m_pool), std::ref(m_creator), std::ref(m_input_queue), std::ref(m_osmdata_queue), std::move(header_promise), m_read_which_entities, m_read_metadata};
+                Reader(file, make_options(std::forward<TArgs>(args)...)) {
             }
 
             template <typename... TArgs>
@@ -311,6 +425,8 @@ namespace osmium {
             void close() {
                 m_status = status::closed;
 
+                m_memory_limiter.shutdown();
+
                 m_read_thread_manager.stop();
 
                 m_osmdata_queue_wrapper.drain();
@@ -387,13 +503,47 @@ namespace osmium {
                     // keep getting the next buffer until there is one with data.
                     while (true) {
                         buffer = m_osmdata_queue_wrapper.pop();
-                        if (detail::at_end_of_data(buffer)) {
-                            m_status = status::eof;
-                            m_read_thread_manager.close();
+                        if (use_buffer(buffer)) {
                             return buffer;
                         }
-                        if (buffer.committed() > 0) {
-                            return buffer;
+                    }
+                } catch (...) {
+                    close();
+                    m_status = status::error;
+                    throw;
+                }
+            }
+
+            /**
+             * Like read(), but never blocks waiting for the threads
+             * reading and parsing the input. If the next buffer isn't
+             * available yet, false is returned and the caller can do
+             * something else and try again later. This way a single
+             * thread can work on several readers at the same time.
+             *
+             * @param buffer Set to the next buffer if true is returned. An
+             *               invalid buffer signals end-of-file.
+             * @returns true if a buffer (or end-of-file) was returned,
+             *          false if no data is available yet.
+             * @throws Some form of osmium::io_error if there is an error.
+             */
+            bool try_read(osmium::memory::Buffer& buffer) {
+                if (m_status != status::okay) {
+                    throw io_error{"Can not read from reader when in status 'closed', 'eof', or 'error'"};
+                }
+
+                if (m_read_which_entities == osmium::osm_entity_bits::nothing) {
+                    m_status = status::eof;
+                    buffer = osmium::memory::Buffer{};
+                    return true;
+                }
+
+                try {
+                    osmium::memory::Buffer next;
+                    while (m_osmdata_queue_wrapper.try_pop(next)) {
+                        if (use_buffer(next)) {
+                            buffer = std::move(next);
+                            return true;
                         }
                     }
                 } catch (...) {
@@ -401,6 +551,8 @@ namespace osmium {
                     m_status = status::error;
                     throw;
                 }
+
+                return false;
             }
 
             /**
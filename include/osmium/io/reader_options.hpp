@@ -0,0 +1,121 @@
+#ifndef OSMIUM_IO_READER_OPTIONS_HPP
+#define OSMIUM_IO_READER_OPTIONS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * How is the input file going to be accessed? This is passed on to
+         * the operating system as a hint (using posix_fadvise(2)) so that it
+         * can optimize read-ahead and page cache usage. Hints are silently
+         * ignored on systems or inputs (such as pipes) that don't support
+         * them.
+         */
+        enum class read_advice {
+
+            /// No hints, the operating system defaults are used.
+            normal = 0,
+
+            /// The file is read from start to end, the operating system
+            /// can read ahead more aggressively.
+            sequential = 1,
+
+            /// Like sequential, but the data is only read once. Pages that
+            /// have already been consumed are removed from the page cache
+            /// so that reading large files does not evict other data (such
+            /// as memory-mapped indexes) from the cache.
+            streaming = 2
+
+        };
+
+        /**
+         * Size of the chunks (in bytes) in which the input file is read
+         * and, if it is compressed, decompressed. The default is
+         * osmium::io::Decompressor::input_buffer_size. Values outside the
+         * range from min_input_buffer_size to max_input_buffer_size are
+         * clamped to that range.
+         */
+        struct read_chunk_size {
+
+            std::size_t value;
+
+            explicit constexpr read_chunk_size(std::size_t size) noexcept :
+                value(size) {
+            }
+
+        }; // struct read_chunk_size
+
+        /**
+         * The number of chunks the reader thread is allowed to read ahead of
+         * the parser. This overwrites the queue size set with the environment
+         * variable OSMIUM_MAX_INPUT_QUEUE_SIZE. The minimum is 2.
+         */
+        struct read_ahead {
+
+            std::size_t value;
+
+            explicit constexpr read_ahead(std::size_t chunks) noexcept :
+                value(chunks) {
+            }
+
+        }; // struct read_ahead
+
+        /**
+         * Maximum number of bytes held in the queues between the threads of
+         * the Reader (raw input data, data being decoded, and decoded
+         * buffers not yet returned by read()). If the limit is reached,
+         * reading and parsing will block until the application has consumed
+         * enough data. This is a soft limit: A single chunk of data or a
+         * single buffer larger than the limit can always pass. The default
+         * is 0 meaning no limit.
+         */
+        struct queue_memory_limit {
+
+            std::size_t value;
+
+            explicit constexpr queue_memory_limit(std::size_t bytes) noexcept :
+                value(bytes) {
+            }
+
+        }; // struct queue_memory_limit
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_READER_OPTIONS_HPP
@@ -43,6 +43,9 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/header.hpp>
 #include <osmium/io/writer_options.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/execution_context.hpp>
 #include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
@@ -104,7 +107,7 @@ namespace osmium {
 
             osmium::io::File m_file;
 
-            detail::future_string_queue_type m_output_queue{detail::get_output_queue_size(), "raw_output"};
+            detail::string_queue_type m_output_queue{detail::get_output_queue_size(), "raw_output"};
 
             std::unique_ptr<osmium::io::detail::OutputFormat> m_output{nullptr};
 
@@ -112,10 +115,14 @@ namespace osmium {
 
             size_t m_buffer_size = default_buffer_size;
 
+            osmium::memory::BufferPool* m_buffer_pool = nullptr;
+
             std::future<bool> m_write_future{};
 
             osmium::thread::thread_handler m_thread{};
 
+            osmium::thread::task_handler m_task{};
+
             enum class status {
                 okay   = 0, // normal writing
                 error  = 1, // some error occurred while writing
@@ -123,7 +130,7 @@ namespace osmium {
             } m_status = status::okay;
 
             // This function will run in a separate thread.
-            static void write_thread(detail::future_string_queue_type& output_queue,
+            static void write_thread(detail::string_queue_type& output_queue,
                                      std::unique_ptr<osmium::io::Compressor>&& compressor,
                                      std::promise<bool>&& write_promise) {
                 detail::WriteThread write_thread{output_queue,
@@ -138,11 +145,17 @@ namespace osmium {
                 }
             }
 
+            osmium::memory::Buffer new_buffer() {
+                if (m_buffer_pool) {
+                    return m_buffer_pool->get(m_buffer_size, osmium::memory::Buffer::auto_grow::no);
+                }
+                return osmium::memory::Buffer{m_buffer_size, osmium::memory::Buffer::auto_grow::no};
+            }
+
             void do_flush() {
                 osmium::thread::check_for_exception(m_write_future);
                 if (m_buffer && m_buffer.committed() > 0) {
-                    osmium::memory::Buffer buffer{m_buffer_size,
-                                                  osmium::memory::Buffer::auto_grow::no};
+                    osmium::memory::Buffer buffer{new_buffer()};
                     using std::swap;
                     swap(m_buffer, buffer);
 
@@ -171,12 +184,22 @@ namespace osmium {
                 overwrite allow_overwrite = overwrite::no;
                 fsync sync = fsync::no;
                 osmium::thread::Pool* pool = nullptr;
+                osmium::memory::BufferPool* buffer_pool = nullptr;
+                osmium::thread::ExecutionContext* context = nullptr;
             };
 
             static void set_option(options_type& options, osmium::thread::Pool& pool) {
                 options.pool = &pool;
             }
 
+            static void set_option(options_type& options, osmium::thread::ExecutionContext& context) {
+                options.context = &context;
+            }
+
+            static void set_option(options_type& options, osmium::memory::BufferPool& buffer_pool) {
+                options.buffer_pool = &buffer_pool;
+            }
+
             static void set_option(options_type& options, const osmium::io::Header& header) {
                 options.header = header;
             }
@@ -222,6 +245,20 @@ namespace osmium {
              *       before closing it? Can be osmium::io::fsync::yes or
              *       osmium::io::fsync::no (default).
              *
+             * * osmium::thread::Pool&: Reference to a thread pool that should
+             *       be used for writing instead of the default pool.
+             *
+             * * osmium::memory::BufferPool&: Buffers are given back to this
+             *       pool after they have been written out so that they can
+             *       be reused. The internal buffer used when writing single
+             *       items is also taken from this pool.
+             *
+             * * osmium::thread::ExecutionContext&: Write the output using
+             *       the I/O threads of this context instead of a thread of
+             *       its own. The thread pool of the context is used unless a
+             *       pool is given explicitly. The context must outlive the
+             *       Writer.
+             *
              * @throws osmium::io_error If there was an error.
              * @throws std::system_error If the file could not be opened.
              */
@@ -236,10 +273,12 @@ namespace osmium {
                 };
 
                 if (!options.pool) {
-                    options.pool = &thread::Pool::default_instance();
+                    options.pool = options.context ? &options.context->pool() : &thread::Pool::default_instance();
                 }
 
                 m_output = osmium::io::detail::OutputFormatFactory::instance().create_output(*options.pool, m_file, m_output_queue);
+                m_output->set_buffer_pool(options.buffer_pool);
+                m_buffer_pool = options.buffer_pool;
 
                 if (options.header.get("generator").empty()) {
                     options.header.set("generator", "libosmium/" LIBOSMIUM_VERSION_STRING);
@@ -252,7 +291,11 @@ namespace osmium {
 
                 std::promise<bool> write_promise;
                 m_write_future = write_promise.get_future();
-                m_thread = osmium::thread::thread_handler{write_thread, std::ref(m_output_queue), std::move(compressor), std::move(write_promise)};
+                if (options.context) {
+                    m_task = osmium::thread::task_handler{*options.context, std::make_shared<detail::WriteTask>(m_output_queue, std::move(compressor), std::move(write_promise))};
+                } else {
+                    m_thread = osmium::thread::thread_handler{write_thread, std::ref(m_output_queue), std::move(compressor), std::move(write_promise)};
+                }
 
                 ensure_cleanup([&](){
                     m_output->write_header(options.header);
@@ -336,8 +379,7 @@ namespace osmium {
             void operator()(const osmium::memory::Item& item) {
                 ensure_cleanup([&](){
                     if (!m_buffer) {
-                        m_buffer = osmium::memory::Buffer{m_buffer_size,
-                                                          osmium::memory::Buffer::auto_grow::no};
+                        m_buffer = new_buffer();
                     }
                     try {
                         m_buffer.push_back(item);
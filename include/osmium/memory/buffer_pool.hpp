@@ -0,0 +1,246 @@
+#ifndef OSMIUM_MEMORY_BUFFER_POOL_HPP
+#define OSMIUM_MEMORY_BUFFER_POOL_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * A thread-safe pool of buffers that are not needed any more and
+         * can be reused instead of allocating new ones. This saves the
+         * allocation and deallocation of memory (and the page faults that
+         * come with it) for each buffer when many buffers of the same size
+         * are used one after the other, for instance when reading and
+         * writing OSM files.
+         *
+         * Only buffers with internal memory management are kept in the
+         * pool. The buffers are kept in size classes (powers of two) of
+         * their capacity. At most max_buffers buffers are kept, buffers
+         * given back to the pool when it is full are freed.
+         *
+         * Example:
+         * @code
+         *     osmium::memory::BufferPool buffer_pool;
+         *     osmium::io::Reader reader{"input.osm.pbf", buffer_pool};
+         *     while (osmium::memory::Buffer buffer = reader.read()) {
+         *         ...use buffer...
+         *         buffer_pool.put(std::move(buffer));
+         *     }
+         * @endcode
+         */
+        class BufferPool {
+
+            enum constant_num_size_classes : std::size_t {
+                num_size_classes = sizeof(std::size_t) * 8
+            };
+
+            mutable std::mutex m_mutex;
+
+            std::vector<std::vector<Buffer>> m_buffers;
+
+            std::size_t m_max_buffers;
+
+            std::size_t m_size = 0;
+
+            std::size_t m_reused = 0;
+
+            std::size_t m_allocated = 0;
+
+            static std::size_t size_class(std::size_t capacity) noexcept {
+                std::size_t n = 0;
+                while (capacity >>= 1U) {
+                    ++n;
+                }
+                return n;
+            }
+
+            bool get_from_pool(std::size_t size_class, std::size_t capacity, Buffer& buffer) {
+                auto& buffers = m_buffers[size_class];
+                for (auto it = buffers.rbegin(); it != buffers.rend(); ++it) {
+                    if (it->capacity() >= capacity) {
+                        using std::swap;
+                        swap(buffer, *it);
+                        buffers.erase(std::next(it).base());
+                        --m_size;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+        public:
+
+            static constexpr const std::size_t default_max_buffers = 32;
+
+            /**
+             * Create a buffer pool.
+             *
+             * @param max_buffers The maximum number of buffers kept.
+             */
+            explicit BufferPool(std::size_t max_buffers = default_max_buffers) :
+                m_buffers(num_size_classes),
+                m_max_buffers(max_buffers) {
+            }
+
+            BufferPool(const BufferPool&) = delete;
+            BufferPool& operator=(const BufferPool&) = delete;
+
+            BufferPool(BufferPool&&) = delete;
+            BufferPool& operator=(BufferPool&&) = delete;
+
+            ~BufferPool() noexcept = default;
+
+            /**
+             * Get an empty buffer with at least the given capacity. If there
+             * is a suitable buffer in the pool it is used, otherwise a new
+             * buffer is created.
+             *
+             * @param capacity The minimum capacity of the buffer.
+             * @param auto_grow Should the buffer automatically grow when it
+             *        becomes to small?
+             */
+            Buffer get(std::size_t capacity, Buffer::auto_grow auto_grow = Buffer::auto_grow::yes) {
+                const auto sc = size_class(capacity);
+                {
+                    Buffer buffer;
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    if (get_from_pool(sc, capacity, buffer) ||
+                        (sc + 1 < num_size_classes && get_from_pool(sc + 1, capacity, buffer))) {
+                        ++m_reused;
+                        lock.unlock();
+                        buffer.m_auto_grow = auto_grow;
+                        return buffer;
+                    }
+                    ++m_allocated;
+                }
+                return Buffer{capacity, auto_grow};
+            }
+
+            /**
+             * Give a buffer that is not needed any more back to the pool.
+             * The buffer will be cleared. Invalid buffers and buffers
+             * with external memory management are ignored. If the pool is
+             * full, the buffer is freed.
+             *
+             * @pre No builder can be open on this buffer.
+             */
+            void put(Buffer&& buffer) {
+                if (!buffer.m_memory) {
+                    return;
+                }
+
+                Buffer tmp{std::move(buffer)};
+                tmp.clear();
+                tmp.m_full = nullptr;
+
+                const auto sc = size_class(tmp.capacity());
+                std::lock_guard<std::mutex> lock{m_mutex};
+                if (m_size < m_max_buffers) {
+                    m_buffers[sc].push_back(std::move(tmp));
+                    ++m_size;
+                }
+            }
+
+            /// The number of buffers currently in the pool.
+            std::size_t size() const {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                return m_size;
+            }
+
+            /// The number of times get() returned a buffer from the pool.
+            std::size_t reused() const {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                return m_reused;
+            }
+
+            /// The number of times get() had to allocate a new buffer.
+            std::size_t allocated() const {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                return m_allocated;
+            }
+
+            /// Free all buffers in the pool.
+            void clear() {
+                std::vector<std::vector<Buffer>> buffers(num_size_classes);
+                {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    using std::swap;
+                    swap(m_buffers, buffers);
+                    m_size = 0;
+                }
+            }
+
+        }; // class BufferPool
+
+        /**
+         * Deleter for std::shared_ptr<Buffer> giving the buffer back to
+         * a BufferPool (if there is one) instead of just freeing it.
+         */
+        class BufferPoolDeleter {
+
+            BufferPool* m_pool;
+
+        public:
+
+            explicit BufferPoolDeleter(BufferPool* pool) noexcept :
+                m_pool(pool) {
+            }
+
+            void operator()(Buffer* buffer) const {
+                if (m_pool) {
+                    try {
+                        m_pool->put(std::move(*buffer));
+                    } catch (...) {
+                        // Ignore any exceptions, the buffer will just be freed.
+                    }
+                }
+                delete buffer;
+            }
+
+        }; // class BufferPoolDeleter
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_BUFFER_POOL_HPP
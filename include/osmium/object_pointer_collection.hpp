@@ -35,6 +35,8 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/handler.hpp>
 #include <osmium/osm/object.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/radix_sort.hpp>
 
 #include <boost/iterator/indirect_iterator.hpp>
 
@@ -91,6 +93,25 @@ namespace osmium {
             std::sort(m_objects.begin(), m_objects.end(), std::forward<TCompare>(compare));
         }
 
+        /**
+         * Sort objects by an unsigned integer key using a parallel radix
+         * sort (see osmium::thread::radix_sort()). The sort is stable, so
+         * objects with the same key keep their order. This is much faster
+         * than sort() for large collections.
+         *
+         * @param key Functor returning the key for an object. It is
+         *            called with a const osmium::OSMObject&.
+         * @param pool Thread pool to use. If this is nullptr, the sort is
+         *             done in the current thread.
+         */
+        template <typename TKey>
+        void radix_sort(TKey&& key, osmium::thread::Pool* pool = &osmium::thread::Pool::default_instance()) {
+            std::vector<osmium::OSMObject*> scratch(m_objects.size());
+            osmium::thread::radix_sort(m_objects.begin(), m_objects.end(), scratch.begin(), [&key](const osmium::OSMObject* object) {
+                return key(*object);
+            }, pool);
+        }
+
         /**
          * Make objects unique according to the specified equality functor.
          *
@@ -0,0 +1,322 @@
+#ifndef OSMIUM_THREAD_BOUNDED_QUEUE_HPP
+#define OSMIUM_THREAD_BOUNDED_QUEUE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/queue_stats.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility> // IWYU pragma: keep
+
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+# include <iostream>
+#endif
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * A thread-safe queue with a fixed capacity for any number of
+         * producers and consumers.
+         *
+         * Pushing and popping elements is lock-free (based on the bounded
+         * MPMC queue by Dmitry Vyukov). Only if a thread has to wait
+         * because the queue is full or empty, a mutex and condition
+         * variables are used to put it to sleep and wake it up again. The
+         * mutex is only touched by the other side if there actually is
+         * a thread waiting.
+         *
+         * It has the same interface as osmium::thread::Queue and can be
+         * used instead of it if the maximum size is known in advance.
+         */
+        template <typename T>
+        class BoundedQueue {
+
+            struct cell {
+                std::atomic<std::size_t> sequence;
+                T value;
+            }; // struct cell
+
+            // Used to keep the positions on separate cache lines.
+            enum constant_cache_line_size : std::size_t {
+                cache_line_size = 64
+            };
+
+            const std::size_t m_capacity;
+
+            /// Name of this queue (for debugging only).
+            const std::string m_name;
+
+            std::unique_ptr<cell[]> m_cells;
+
+            char m_padding1[cache_line_size];
+
+            std::atomic<std::size_t> m_enqueue_pos{0};
+
+            char m_padding2[cache_line_size];
+
+            std::atomic<std::size_t> m_dequeue_pos{0};
+
+            char m_padding3[cache_line_size];
+
+            std::atomic<int> m_waiting_producers{0};
+
+            std::atomic<int> m_waiting_consumers{0};
+
+            std::mutex m_mutex;
+
+            /// Used to signal consumers when data is available in the queue.
+            std::condition_variable m_data_available;
+
+            /// Used to signal producers when queue is not full.
+            std::condition_variable m_space_available;
+
+            detail::queue_counters m_counters;
+
+            detail::queue_registration m_registration{[this] {
+                return stats();
+            }};
+
+            void pushed(std::size_t bytes) noexcept {
+                m_counters.add_bytes(bytes);
+                m_counters.update_max_size(size());
+                wake_up(m_waiting_consumers, m_data_available);
+            }
+
+            bool try_push_value(T& value) {
+                std::size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                while (true) {
+                    cell& c = m_cells[pos % m_capacity];
+                    const std::size_t seq = c.sequence.load(std::memory_order_acquire);
+                    if (seq == pos) {
+                        if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1)) {
+                            c.value = std::move(value);
+                            c.sequence.store(pos + 1, std::memory_order_release);
+                            return true;
+                        }
+                    } else if (seq < pos) {
+                        return false; // queue is full
+                    } else {
+                        pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            bool try_pop_value(T& value) {
+                std::size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                while (true) {
+                    cell& c = m_cells[pos % m_capacity];
+                    const std::size_t seq = c.sequence.load(std::memory_order_acquire);
+                    if (seq == pos + 1) {
+                        if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1)) {
+                            value = std::move(c.value);
+                            c.value = T{};
+                            c.sequence.store(pos + m_capacity, std::memory_order_release);
+                            return true;
+                        }
+                    } else if (seq < pos + 1) {
+                        return false; // queue is empty
+                    } else {
+                        pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            // Wake up a thread waiting on the condition variable if there
+            // is one. Locking the mutex makes sure the waiting thread is
+            // either already waiting or will see the new state.
+            void wake_up(const std::atomic<int>& waiting, std::condition_variable& condition) {
+                if (waiting > 0) {
+                    {
+                        std::lock_guard<std::mutex> lock{m_mutex};
+                    }
+                    condition.notify_one();
+                }
+            }
+
+        public:
+
+            /// Capacity used if 0 is given as maximum size.
+            static constexpr const std::size_t default_capacity = 1024;
+
+            /**
+             * Construct a queue.
+             *
+             * @param max_size Maximum number of elements in the queue. If
+             *                 this is 0, default_capacity is used. The
+             *                 minimum is 2, because the algorithm can't
+             *                 tell a full from an empty queue with only
+             *                 one element.
+             * @param name Optional name for this queue. (Used for debugging.)
+             */
+            explicit BoundedQueue(std::size_t max_size = 0, std::string name = "") :
+                m_capacity(max_size == 0 ? default_capacity : (max_size < 2 ? 2 : max_size)),
+                m_name(std::move(name)),
+                m_cells(new cell[m_capacity]) {
+                for (std::size_t i = 0; i < m_capacity; ++i) {
+                    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            BoundedQueue(const BoundedQueue&) = delete;
+            BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+            BoundedQueue(BoundedQueue&&) = delete;
+            BoundedQueue& operator=(BoundedQueue&&) = delete;
+
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+            ~BoundedQueue() {
+                std::cerr << stats() << '\n';
+            }
+#else
+            ~BoundedQueue() = default;
+#endif
+
+            /// The maximum number of elements in the queue.
+            std::size_t capacity() const noexcept {
+                return m_capacity;
+            }
+
+            /**
+             * Push an element onto the queue. If the queue is full, this
+             * call will block until there is space in the queue.
+             */
+            void push(T value) {
+                const std::size_t bytes = detail::queue_item_bytes(value);
+                if (!try_push_value(value)) {
+                    const auto start = detail::queue_counters::now();
+                    do {
+                        std::unique_lock<std::mutex> lock{m_mutex};
+                        ++m_waiting_producers;
+                        m_space_available.wait(lock, [this] {
+                            return size() < m_capacity;
+                        });
+                        --m_waiting_producers;
+                    } while (!try_push_value(value));
+                    m_counters.add_full_wait(start);
+                }
+                pushed(bytes);
+            }
+
+            /**
+             * Push an element onto the queue if there is space.
+             *
+             * @returns true if the element was pushed, false if the queue
+             *          is full. In that case value is not changed.
+             */
+            bool try_push(T& value) {
+                const std::size_t bytes = detail::queue_item_bytes(value);
+                if (try_push_value(value)) {
+                    pushed(bytes);
+                    return true;
+                }
+                return false;
+            }
+
+            /**
+             * Pop an element from the queue. If the queue is empty, this
+             * call will block until there is an element in the queue.
+             */
+            void wait_and_pop(T& value) {
+                if (!try_pop_value(value)) {
+                    const auto start = detail::queue_counters::now();
+                    do {
+                        std::unique_lock<std::mutex> lock{m_mutex};
+                        ++m_waiting_consumers;
+                        m_data_available.wait(lock, [this] {
+                            return !empty();
+                        });
+                        --m_waiting_consumers;
+                    } while (!try_pop_value(value));
+                    m_counters.add_empty_wait(start);
+                }
+                wake_up(m_waiting_producers, m_space_available);
+            }
+
+            /**
+             * Pop an element from the queue if there is one.
+             *
+             * @returns true if an element was popped, false if the queue
+             *          is empty.
+             */
+            bool try_pop(T& value) {
+                if (try_pop_value(value)) {
+                    wake_up(m_waiting_producers, m_space_available);
+                    return true;
+                }
+                return false;
+            }
+
+            /**
+             * Is the queue empty? The result is only a snapshot if other
+             * threads are using the queue at the same time.
+             */
+            bool empty() const noexcept {
+                return size() == 0;
+            }
+
+            /**
+             * The number of elements in the queue. The result is only a
+             * snapshot if other threads are using the queue at the same
+             * time.
+             */
+            std::size_t size() const noexcept {
+                const std::size_t dequeue_pos = m_dequeue_pos.load();
+                const std::size_t enqueue_pos = m_enqueue_pos.load();
+                return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+            }
+
+            /// Get statistics for this queue.
+            queue_stats stats() const {
+                const std::size_t dequeue_pos = m_dequeue_pos.load();
+                const std::size_t enqueue_pos = m_enqueue_pos.load();
+                const std::size_t size = enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+                return m_counters.get(m_name, m_capacity, size, enqueue_pos, dequeue_pos);
+            }
+
+        }; // class BoundedQueue
+
+        template <typename T>
+        constexpr const std::size_t BoundedQueue<T>::default_capacity;
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_BOUNDED_QUEUE_HPP
@@ -0,0 +1,387 @@
+#ifndef OSMIUM_THREAD_EXECUTION_CONTEXT_HPP
+#define OSMIUM_THREAD_EXECUTION_CONTEXT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/util.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * Shared threads for several Readers and Writers.
+         *
+         * Normally each Reader starts its own thread reading the input
+         * and each Writer its own thread writing the output. When many
+         * of them are used at the same time, for instance when merging
+         * many files, most of these threads are idle most of the time.
+         *
+         * If an ExecutionContext is given to the Readers and Writers,
+         * reading and writing are done in small steps by a fixed number
+         * of I/O threads owned by the context instead. Each step reads
+         * or writes one chunk of data and a task that can't make progress
+         * (because a queue is full or empty) doesn't block a thread. It
+         * is set aside until the queue it waits on changes. The
+         * context also owns the thread pool used by the Readers and
+         * Writers for parsing and encoding.
+         *
+         * Each Reader still uses one thread of its own running the parser.
+         *
+         * The ExecutionContext must outlive all Readers and Writers
+         * using it.
+         */
+        class ExecutionContext {
+
+        public:
+
+            /// Result of one step of a task.
+            enum class step_result {
+                progress = 0, // some work was done
+                idle     = 1, // nothing could be done right now
+                done     = 2  // the task is finished
+            };
+
+            /**
+             * A task run cooperatively by the I/O threads of an
+             * ExecutionContext. The step() function is called repeatedly
+             * until it returns step_result::done. It is never called
+             * from more than one thread at the same time. It should not
+             * block waiting for other threads and it must not throw.
+             *
+             * After step() returned step_result::idle, it is not called
+             * again until notify() is called. Tasks usually arrange for
+             * this with a listener on the queue they wait on.
+             */
+            class Task {
+
+                friend class ExecutionContext;
+
+                std::mutex m_mutex;
+                std::condition_variable m_finished_cond;
+                bool m_finished = false;
+
+                std::atomic<ExecutionContext*> m_context{nullptr};
+
+                // These are protected by the mutex of the context.
+
+                // The task is waiting for notify().
+                bool m_parked = false;
+
+                // notify() was called while the task was queued or running.
+                bool m_notified = false;
+
+            public:
+
+                Task() = default;
+
+                Task(const Task&) = delete;
+                Task& operator=(const Task&) = delete;
+
+                Task(Task&&) = delete;
+                Task& operator=(Task&&) = delete;
+
+                virtual ~Task() noexcept = default;
+
+                virtual step_result step() = 0;
+
+                /**
+                 * Tell the ExecutionContext that this task might be able
+                 * to make progress again. Can be called from any thread
+                 * at any time.
+                 */
+                void notify();
+
+                /// Called by the ExecutionContext after the last step.
+                void set_finished() {
+                    {
+                        std::lock_guard<std::mutex> lock{m_mutex};
+                        m_finished = true;
+                    }
+                    m_finished_cond.notify_all();
+                }
+
+                /// Wait until the last step of this task has run.
+                void wait() {
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    m_finished_cond.wait(lock, [this] {
+                        return m_finished;
+                    });
+                }
+
+            }; // class Task
+
+        private:
+
+            osmium::thread::Pool m_pool;
+
+            std::mutex m_mutex;
+            std::condition_variable m_tasks_available;
+
+            // Tasks not currently run by any thread.
+            std::deque<std::shared_ptr<Task>> m_tasks;
+
+            // Tasks waiting for notify().
+            std::vector<std::shared_ptr<Task>> m_parked;
+
+            // Number of tasks (waiting or running).
+            std::size_t m_num_tasks = 0;
+
+            bool m_shutdown = false;
+
+            std::vector<std::thread> m_threads;
+
+            void io_thread() {
+                osmium::thread::set_thread_name("_osmium_io");
+
+                while (true) {
+                    std::shared_ptr<Task> task;
+                    {
+                        std::unique_lock<std::mutex> lock{m_mutex};
+                        m_tasks_available.wait(lock, [this] {
+                            return m_shutdown || !m_tasks.empty();
+                        });
+                        if (m_shutdown) {
+                            return;
+                        }
+                        task = std::move(m_tasks.front());
+                        m_tasks.pop_front();
+                        task->m_notified = false;
+                    }
+
+                    const step_result result = task->step();
+
+                    if (result == step_result::done) {
+                        {
+                            std::lock_guard<std::mutex> lock{m_mutex};
+                            --m_num_tasks;
+                        }
+                        task->set_finished();
+                        continue;
+                    }
+
+                    {
+                        std::lock_guard<std::mutex> lock{m_mutex};
+                        if (result == step_result::idle && !task->m_notified) {
+                            // Nothing changed while the task ran, so it
+                            // can't make progress before it is notified.
+                            task->m_parked = true;
+                            m_parked.push_back(std::move(task));
+                            continue;
+                        }
+                        m_tasks.push_back(std::move(task));
+                    }
+                    m_tasks_available.notify_one();
+                }
+            }
+
+            void wake(Task& task) {
+                {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    if (!task.m_parked) {
+                        task.m_notified = true;
+                        return;
+                    }
+                    task.m_parked = false;
+                    const auto it = std::find_if(m_parked.begin(), m_parked.end(), [&task](const std::shared_ptr<Task>& t) {
+                        return t.get() == &task;
+                    });
+                    assert(it != m_parked.end());
+                    m_tasks.push_back(std::move(*it));
+                    m_parked.erase(it);
+                }
+                m_tasks_available.notify_one();
+            }
+
+        public:
+
+            /**
+             * Create an ExecutionContext.
+             *
+             * @param num_io_threads Number of threads used for reading
+             *                       and writing. (Minimum 1.)
+             * @param num_pool_threads Number of threads in the thread
+             *                         pool. See the constructor of
+             *                         osmium::thread::Pool for the meaning
+             *                         of this value.
+             */
+            explicit ExecutionContext(int num_io_threads = 1, int num_pool_threads = osmium::thread::Pool::default_num_threads) :
+                m_pool(num_pool_threads) {
+                if (num_io_threads < 1) {
+                    num_io_threads = 1;
+                }
+                try {
+                    for (int i = 0; i < num_io_threads; ++i) {
+                        m_threads.emplace_back(&ExecutionContext::io_thread, this);
+                    }
+                } catch (...) {
+                    shutdown();
+                    throw;
+                }
+            }
+
+            ExecutionContext(const ExecutionContext&) = delete;
+            ExecutionContext& operator=(const ExecutionContext&) = delete;
+
+            ExecutionContext(ExecutionContext&&) = delete;
+            ExecutionContext& operator=(ExecutionContext&&) = delete;
+
+            ~ExecutionContext() {
+                shutdown();
+            }
+
+            /// The thread pool used for parsing and encoding.
+            osmium::thread::Pool& pool() noexcept {
+                return m_pool;
+            }
+
+            /// The number of I/O threads.
+            int num_io_threads() const noexcept {
+                return static_cast<int>(m_threads.size());
+            }
+
+            /// The number of tasks that are not finished yet.
+            std::size_t num_tasks() {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                return m_num_tasks;
+            }
+
+            /**
+             * Add a task. It will be run by the I/O threads until it is
+             * finished. Use Task::wait() to wait for this.
+             */
+            void add_task(std::shared_ptr<Task> task) {
+                task->m_context = this;
+                {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_tasks.push_back(std::move(task));
+                    ++m_num_tasks;
+                }
+                m_tasks_available.notify_one();
+            }
+
+        private:
+
+            void shutdown() {
+                {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_shutdown = true;
+                }
+                m_tasks_available.notify_all();
+                for (auto& thread : m_threads) {
+                    if (thread.joinable()) {
+                        thread.join();
+                    }
+                }
+            }
+
+        }; // class ExecutionContext
+
+        inline void ExecutionContext::Task::notify() {
+            ExecutionContext* context = m_context.load();
+            if (context) {
+                context->wake(*this);
+            }
+        }
+
+        /**
+         * Adds a task to an ExecutionContext and waits for it to finish
+         * when destroyed. This is for tasks what thread_handler is for
+         * threads.
+         */
+        class task_handler {
+
+            std::shared_ptr<ExecutionContext::Task> m_task;
+
+        public:
+
+            task_handler() = default;
+
+            task_handler(ExecutionContext& context, std::shared_ptr<ExecutionContext::Task> task) :
+                m_task(std::move(task)) {
+                context.add_task(m_task);
+            }
+
+            task_handler(const task_handler&) = delete;
+            task_handler& operator=(const task_handler&) = delete;
+
+            task_handler(task_handler&&) noexcept = default;
+
+            /// Waits for the current task (if any) before taking the other.
+            task_handler& operator=(task_handler&& other) {
+                if (&other != this) {
+                    wait();
+                    m_task = std::move(other.m_task);
+                }
+                return *this;
+            }
+
+            ~task_handler() {
+                wait();
+            }
+
+            /// Notify the task (if there is one), see Task::notify().
+            void notify() {
+                if (m_task) {
+                    m_task->notify();
+                }
+            }
+
+            /// Wait for the task to finish (if there is one).
+            void wait() {
+                if (m_task) {
+                    m_task->wait();
+                    m_task.reset();
+                }
+            }
+
+        }; // class task_handler
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_EXECUTION_CONTEXT_HPP
@@ -33,7 +33,9 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
-#include <memory>
+#include <cstddef>
+#include <new>
+#include <type_traits>
 #include <utility>
 
 namespace osmium {
@@ -43,85 +45,164 @@ namespace osmium {
         /**
          * This function wrapper can collect move-only functions unlike
          * std::function which needs copyable functions.
-         * Taken from the book "C++ Concurrency in Action".
+         * Based on the class from the book "C++ Concurrency in Action".
+         *
+         * Small functions (such as a std::packaged_task) are stored inside
+         * the wrapper itself, so wrapping them doesn't need an extra memory
+         * allocation. Larger functions are stored on the heap.
          */
         class function_wrapper {
 
-            struct impl_base {
+            enum constant_inline_size : std::size_t {
+                inline_size = 4 * sizeof(void*)
+            };
 
-                impl_base() noexcept = default;
+            using storage_type = typename std::aligned_storage<inline_size, alignof(std::max_align_t)>::type;
 
-                impl_base(const impl_base&) noexcept = default;
-                impl_base& operator=(const impl_base&) noexcept = default;
+            enum class operation {
+                call,
+                move,
+                destroy
+            };
 
-                impl_base(impl_base&&) noexcept = default;
-                impl_base& operator=(impl_base&&) noexcept = default;
+            // Type erased operations on the stored function. For "call"
+            // this returns what the wrapper returns when called, for the
+            // other operations the return value is ignored. For "move"
+            // the function is moved from "other" into "self".
+            using manager_type = bool (*)(operation op, function_wrapper& self, function_wrapper& other);
 
-                virtual ~impl_base() noexcept = default;
+            storage_type m_storage;
+            manager_type m_manager = nullptr;
 
-                virtual bool call() {
-                    return true;
+            template <typename F>
+            struct fits_inline : std::integral_constant<bool,
+                sizeof(F) <= sizeof(storage_type) &&
+                alignof(storage_type) % alignof(F) == 0 &&
+                std::is_nothrow_move_constructible<F>::value> {
+            };
+
+            template <typename F>
+            F* inline_functor() noexcept {
+                return reinterpret_cast<F*>(&m_storage);
+            }
+
+            template <typename F>
+            F*& heap_functor() noexcept {
+                return *reinterpret_cast<F**>(&m_storage);
+            }
+
+            template <typename F>
+            static bool manage_inline(operation op, function_wrapper& self, function_wrapper& other) {
+                switch (op) {
+                    case operation::call:
+                        (*self.inline_functor<F>())();
+                        break;
+                    case operation::move:
+                        new (&self.m_storage) F(std::move(*other.inline_functor<F>()));
+                        other.inline_functor<F>()->~F();
+                        break;
+                    case operation::destroy:
+                        self.inline_functor<F>()->~F();
+                        break;
                 }
+                return false;
+            }
 
-            }; // struct impl_base
+            template <typename F>
+            static bool manage_heap(operation op, function_wrapper& self, function_wrapper& other) {
+                switch (op) {
+                    case operation::call:
+                        (*self.heap_functor<F>())();
+                        break;
+                    case operation::move:
+                        self.heap_functor<F>() = other.heap_functor<F>();
+                        break;
+                    case operation::destroy:
+                        delete self.heap_functor<F>();
+                        break;
+                }
+                return false;
+            }
 
-            std::unique_ptr<impl_base> impl;
+            // Manager for the special function wrapper that makes the
+            // worker thread shut down.
+            static bool manage_shutdown(operation op, function_wrapper& /*self*/, function_wrapper& /*other*/) noexcept {
+                return op == operation::call;
+            }
 
             template <typename F>
-            struct impl_type : impl_base {
+            void init(F&& functor, std::true_type /*fits_inline*/) {
+                new (&m_storage) F(std::move(functor));
+                m_manager = &manage_inline<F>;
+            }
 
-                F m_functor;
+            template <typename F>
+            void init(F&& functor, std::false_type /*fits_inline*/) {
+                heap_functor<F>() = new F(std::move(functor));
+                m_manager = &manage_heap<F>;
+            }
 
-                explicit impl_type(F&& functor) :
-                    m_functor(std::forward<F>(functor)) {
+            void move_from(function_wrapper& other) noexcept {
+                if (other.m_manager) {
+                    other.m_manager(operation::move, *this, other);
+                    m_manager = other.m_manager;
+                    other.m_manager = nullptr;
                 }
+            }
 
-                bool call() override {
-                    m_functor();
-                    return false;
+            void reset() noexcept {
+                if (m_manager) {
+                    m_manager(operation::destroy, *this, *this);
+                    m_manager = nullptr;
                 }
-
-            }; // struct impl_type
+            }
 
         public:
 
             // Constructor must not be "explicit" for wrapper
             // to work seemlessly.
-            template <typename TFunction>
+            template <typename TFunction, typename F = typename std::decay<TFunction>::type,
+                      typename std::enable_if<!std::is_same<F, function_wrapper>::value, int>::type = 0>
             // cppcheck-suppress noExplicitConstructor
-            function_wrapper(TFunction&& f) : // NOLINT(google-explicit-constructor, hicpp-explicit-conversions, misc-forwarding-reference-overload)
-                impl(new impl_type<TFunction>(std::forward<TFunction>(f))) {
+            function_wrapper(TFunction&& f) { // NOLINT(google-explicit-constructor, hicpp-explicit-conversions, misc-forwarding-reference-overload)
+                F functor(std::forward<TFunction>(f));
+                init(std::move(functor), fits_inline<F>{});
             }
 
             // The integer parameter is only used to signal that we want
             // the special function wrapper that makes the worker thread
             // shut down.
-            explicit function_wrapper(int /*dummy*/) :
-                impl(new impl_base()) {
+            explicit function_wrapper(int /*dummy*/) noexcept :
+                m_manager(&manage_shutdown) {
             }
 
             bool operator()() {
-                return impl->call();
+                return m_manager(operation::call, *this, *this);
             }
 
-            function_wrapper() = default;
+            function_wrapper() noexcept = default;
 
             function_wrapper(const function_wrapper&) = delete;
             function_wrapper& operator=(const function_wrapper&) = delete;
 
-            function_wrapper(function_wrapper&& other) noexcept :
-                impl(std::move(other.impl)) {
+            function_wrapper(function_wrapper&& other) noexcept {
+                move_from(other);
             }
 
             function_wrapper& operator=(function_wrapper&& other) noexcept {
-                impl = std::move(other.impl);
+                if (this != &other) {
+                    reset();
+                    move_from(other);
+                }
                 return *this;
             }
 
-            ~function_wrapper() = default;
+            ~function_wrapper() noexcept {
+                reset();
+            }
 
-            explicit operator bool() const {
-                return static_cast<bool>(impl);
+            explicit operator bool() const noexcept {
+                return m_manager != nullptr;
             }
 
         }; // class function_wrapper
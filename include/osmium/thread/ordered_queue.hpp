@@ -0,0 +1,403 @@
+#ifndef OSMIUM_THREAD_ORDERED_QUEUE_HPP
+#define OSMIUM_THREAD_ORDERED_QUEUE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/queue_stats.hpp>
+#include <osmium/thread/util.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility> // IWYU pragma: keep
+
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+# include <iostream>
+#endif
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * A thread-safe queue that delivers results in a fixed order even
+         * if they become available in a different order.
+         *
+         * A producer first reserves a place in the queue, getting a ticket
+         * (a sequence number). Later (possibly in a different thread) it
+         * sets the value or an exception for that ticket. The consumer gets
+         * the values in the order of the tickets, waiting for the next
+         * value if it is not available yet. This works like a queue of
+         * std::future objects, but without the allocation of the shared
+         * state for each element.
+         *
+         * The queue has a fixed capacity (the size of the "reorder
+         * window"). reserve() blocks if that many tickets are outstanding.
+         *
+         * Any number of threads can reserve tickets and set values, but
+         * there must only be one consumer.
+         *
+         * Reserving, setting values, and popping are lock-free. Only
+         * if a thread has to wait, it goes to sleep on a condition
+         * variable.
+         */
+        template <typename T>
+        class OrderedQueue {
+
+            struct slot {
+                std::atomic<bool> ready{false};
+                T value{};
+                std::exception_ptr exception{};
+            }; // struct slot
+
+            // Used to keep the positions on separate cache lines.
+            enum constant_cache_line_size : std::size_t {
+                cache_line_size = 64
+            };
+
+            const std::size_t m_capacity;
+
+            /// Name of this queue (for debugging only).
+            const std::string m_name;
+
+            std::unique_ptr<slot[]> m_slots;
+
+            char m_padding1[cache_line_size];
+
+            /// The next ticket handed out by reserve().
+            std::atomic<std::size_t> m_next_ticket{0};
+
+            char m_padding2[cache_line_size];
+
+            /// The ticket of the next value returned by pop().
+            std::atomic<std::size_t> m_next_pop{0};
+
+            char m_padding3[cache_line_size];
+
+            std::atomic<int> m_waiting_producers{0};
+
+            std::atomic<int> m_waiting_consumers{0};
+
+            /// Number of threads currently in set_value() or set_exception().
+            std::atomic<int> m_active_setters{0};
+
+            std::mutex m_mutex;
+
+            /// Used to signal the consumer when the next value is ready.
+            std::condition_variable m_data_available;
+
+            /// Used to signal producers when the queue is not full.
+            std::condition_variable m_space_available;
+
+            /// Called when a value becomes ready or a place becomes free.
+            detail::change_listener m_listener;
+
+            detail::queue_counters m_counters;
+
+            detail::queue_registration m_registration{[this] {
+                return stats();
+            }};
+
+            bool has_space() const noexcept {
+                return m_next_ticket.load() - m_next_pop.load() < m_capacity;
+            }
+
+            void wake_up(const std::atomic<int>& waiting, std::condition_variable& condition) {
+                if (waiting > 0) {
+                    {
+                        std::lock_guard<std::mutex> lock{m_mutex};
+                    }
+                    condition.notify_all();
+                }
+            }
+
+            T take(slot& s, std::size_t pos) {
+                T value{std::move(s.value)};
+                s.value = T{};
+                std::exception_ptr exception{std::move(s.exception)};
+                s.exception = nullptr;
+                s.ready.store(false);
+
+                m_next_pop.store(pos + 1);
+                wake_up(m_waiting_producers, m_space_available);
+                m_listener();
+
+                if (exception) {
+                    std::rethrow_exception(exception);
+                }
+                return value;
+            }
+
+            void set_ready(slot& s) {
+                s.ready.store(true);
+                wake_up(m_waiting_consumers, m_data_available);
+                m_listener();
+                // This must be the last access to the queue in this thread,
+                // the queue might be destructed right after.
+                --m_active_setters;
+            }
+
+        public:
+
+            using ticket_type = std::size_t;
+
+            /// Capacity used if 0 is given as maximum size.
+            static constexpr const std::size_t default_capacity = 1024;
+
+            /**
+             * Construct a queue.
+             *
+             * @param max_size Maximum number of outstanding tickets. If
+             *                 this is 0, default_capacity is used.
+             * @param name Optional name for this queue. (Used for debugging.)
+             */
+            explicit OrderedQueue(std::size_t max_size = 0, std::string name = "") :
+                m_capacity(max_size > 0 ? max_size : default_capacity),
+                m_name(std::move(name)),
+                m_slots(new slot[m_capacity]) {
+            }
+
+            OrderedQueue(const OrderedQueue&) = delete;
+            OrderedQueue& operator=(const OrderedQueue&) = delete;
+
+            OrderedQueue(OrderedQueue&&) = delete;
+            OrderedQueue& operator=(OrderedQueue&&) = delete;
+
+            /**
+             * The destructor waits for threads still finishing up in
+             * set_value() or set_exception(). This happens when the last
+             * value was already popped but the thread setting it hasn't
+             * returned yet.
+             */
+            ~OrderedQueue() {
+                while (m_active_setters > 0) {
+                    std::this_thread::yield();
+                }
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+                std::cerr << stats() << '\n';
+#endif
+            }
+
+            /// The maximum number of outstanding tickets.
+            std::size_t capacity() const noexcept {
+                return m_capacity;
+            }
+
+            /**
+             * Set a function that is called whenever a value becomes ready
+             * or a place in the queue becomes free. It is called from the
+             * thread making the change and must not use the queue. This is
+             * used to wake up tasks run by an ExecutionContext instead of
+             * polling the queue. Set an empty function to remove it; once
+             * this returns, the old function is not called any more.
+             */
+            void set_listener(std::function<void()> listener) {
+                m_listener.set(std::move(listener));
+            }
+
+            /**
+             * Reserve the next place in the queue. Blocks if the queue is
+             * full. The value for the returned ticket must be set later
+             * using set_value() or set_exception(), otherwise the consumer
+             * will wait forever.
+             */
+            ticket_type reserve() {
+                std::size_t ticket = m_next_ticket.load();
+                while (true) {
+                    const std::size_t next_pop = m_next_pop.load();
+                    if (ticket - next_pop >= m_capacity) {
+                        const auto start = detail::queue_counters::now();
+                        std::unique_lock<std::mutex> lock{m_mutex};
+                        ++m_waiting_producers;
+                        m_space_available.wait(lock, [this] {
+                            return has_space();
+                        });
+                        --m_waiting_producers;
+                        m_counters.add_full_wait(start);
+                        ticket = m_next_ticket.load();
+                    } else if (m_next_ticket.compare_exchange_weak(ticket, ticket + 1)) {
+                        m_counters.update_max_size(ticket + 1 - next_pop);
+                        return ticket;
+                    }
+                }
+            }
+
+            /**
+             * Set the value for a ticket.
+             *
+             * @pre The ticket was returned from reserve() and no value or
+             *      exception was set for it yet.
+             */
+            void set_value(ticket_type ticket, T value) {
+                ++m_active_setters;
+                m_counters.add_bytes(detail::queue_item_bytes(value));
+                slot& s = m_slots[ticket % m_capacity];
+                s.value = std::move(value);
+                set_ready(s);
+            }
+
+            /**
+             * Set an exception for a ticket. It will be thrown from pop()
+             * in place of a value.
+             *
+             * @pre The ticket was returned from reserve() and no value or
+             *      exception was set for it yet.
+             */
+            void set_exception(ticket_type ticket, std::exception_ptr exception) {
+                ++m_active_setters;
+                slot& s = m_slots[ticket % m_capacity];
+                s.exception = std::move(exception);
+                set_ready(s);
+            }
+
+            /**
+             * Reserve a place and set its value. Blocks if the queue is
+             * full.
+             */
+            void push(T value) {
+                set_value(reserve(), std::move(value));
+            }
+
+            /**
+             * Reserve a place and set an exception for it. Blocks if the
+             * queue is full.
+             */
+            void push_exception(std::exception_ptr exception) {
+                set_exception(reserve(), std::move(exception));
+            }
+
+            /**
+             * Get the next value from the queue. Blocks until it is
+             * available. If an exception was set instead of a value, it is
+             * thrown.
+             *
+             * Must only be called from one thread at a time.
+             */
+            T pop() {
+                const std::size_t pos = m_next_pop.load();
+                slot& s = m_slots[pos % m_capacity];
+                if (!s.ready.load()) {
+                    const auto start = detail::queue_counters::now();
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    ++m_waiting_consumers;
+                    m_data_available.wait(lock, [&s] {
+                        return s.ready.load();
+                    });
+                    --m_waiting_consumers;
+                    m_counters.add_empty_wait(start);
+                }
+
+                return take(s, pos);
+            }
+
+            /**
+             * Get the next value (or exception) from the queue wrapped in
+             * a ready future. Blocks until it is available.
+             *
+             * Must only be called from one thread at a time.
+             *
+             * @deprecated This is for code written for the former queues
+             *             of futures. Use pop() instead.
+             */
+            void wait_and_pop(std::future<T>& future) {
+                std::promise<T> promise;
+                future = promise.get_future();
+                try {
+                    promise.set_value(pop());
+                } catch (...) {
+                    promise.set_exception(std::current_exception());
+                }
+            }
+
+            /**
+             * Get the next value from the queue if it is available. Never
+             * blocks. If an exception was set instead of a value, it is
+             * thrown.
+             *
+             * Must only be called from one thread at a time.
+             *
+             * @param value Set to the next value if it is available.
+             * @returns true if a value was popped, false if the next value
+             *          isn't available yet.
+             */
+            bool try_pop(T& value) {
+                const std::size_t pos = m_next_pop.load();
+                slot& s = m_slots[pos % m_capacity];
+                if (!s.ready.load()) {
+                    return false;
+                }
+                value = take(s, pos);
+                return true;
+            }
+
+            /**
+             * The number of outstanding tickets (reserved places in the
+             * queue with or without a value). The result is only a
+             * snapshot if other threads are using the queue at the same
+             * time.
+             */
+            std::size_t size() const noexcept {
+                const std::size_t next_pop = m_next_pop.load();
+                const std::size_t next_ticket = m_next_ticket.load();
+                return next_ticket > next_pop ? next_ticket - next_pop : 0;
+            }
+
+            bool empty() const noexcept {
+                return size() == 0;
+            }
+
+            /// Get statistics for this queue.
+            queue_stats stats() const {
+                const std::size_t next_pop = m_next_pop.load();
+                const std::size_t next_ticket = m_next_ticket.load();
+                const std::size_t size = next_ticket > next_pop ? next_ticket - next_pop : 0;
+                return m_counters.get(m_name, m_capacity, size, next_ticket, next_pop);
+            }
+
+        }; // class OrderedQueue
+
+        template <typename T>
+        constexpr const std::size_t OrderedQueue<T>::default_capacity;
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_ORDERED_QUEUE_HPP
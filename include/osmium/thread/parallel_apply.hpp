@@ -0,0 +1,372 @@
+#ifndef OSMIUM_THREAD_PARALLEL_APPLY_HPP
+#define OSMIUM_THREAD_PARALLEL_APPLY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/bounded_queue.hpp>
+#include <osmium/thread/ordered_queue.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/util.hpp>
+#include <osmium/util/config.hpp>
+#include <osmium/util/trace.hpp>
+#include <osmium/visitor.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace thread {
+
+        namespace detail {
+
+            inline std::size_t get_apply_queue_size(int num_threads) noexcept {
+                return static_cast<std::size_t>(num_threads) * 2;
+            }
+
+            template <typename THandler>
+            void apply_buffer(osmium::memory::Buffer& buffer, THandler& handler) {
+                osmium::TraceSpan span{"apply"};
+                for (auto& item : buffer) {
+                    osmium::apply_item(item, handler);
+                }
+            }
+
+            template <typename THandler>
+            class apply_worker {
+
+                osmium::thread::BoundedQueue<osmium::memory::Buffer>& m_queue;
+                THandler& m_handler;
+                std::exception_ptr& m_exception;
+                std::atomic<bool>& m_failed;
+
+            public:
+
+                apply_worker(osmium::thread::BoundedQueue<osmium::memory::Buffer>& queue,
+                             THandler& handler,
+                             std::exception_ptr& exception,
+                             std::atomic<bool>& failed) :
+                    m_queue(queue),
+                    m_handler(handler),
+                    m_exception(exception),
+                    m_failed(failed) {
+                }
+
+                void operator()() {
+                    osmium::thread::set_thread_name("_osmium_apply");
+
+                    // Keep popping buffers until the end marker (an invalid
+                    // buffer) arrives even if something failed so that the
+                    // thread filling the queue never blocks forever.
+                    while (true) {
+                        osmium::memory::Buffer buffer;
+                        m_queue.wait_and_pop(buffer);
+                        if (!buffer) {
+                            break;
+                        }
+                        if (m_failed) {
+                            continue;
+                        }
+                        try {
+                            apply_buffer(buffer, m_handler);
+                        } catch (...) {
+                            m_exception = std::current_exception();
+                            m_failed = true;
+                        }
+                    }
+
+                    if (!m_failed) {
+                        try {
+                            osmium::apply_flush(m_handler);
+                        } catch (...) {
+                            m_exception = std::current_exception();
+                            m_failed = true;
+                        }
+                    }
+                }
+
+            }; // class apply_worker
+
+            template <typename THandlerFactory>
+            using factory_result_type = typename std::decay<decltype(std::declval<THandlerFactory&>()())>::type;
+
+            struct ordered_result {
+
+                osmium::memory::Buffer buffer;
+                bool done;
+
+                explicit ordered_result(osmium::memory::Buffer&& b = osmium::memory::Buffer{}, bool d = false) :
+                    buffer(std::move(b)),
+                    done(d) {
+                }
+
+            }; // struct ordered_result
+
+            using ordered_result_queue_type = osmium::thread::OrderedQueue<ordered_result>;
+
+            struct ordered_work_item {
+
+                ordered_result_queue_type::ticket_type ticket;
+                osmium::memory::Buffer buffer;
+
+                explicit ordered_work_item(ordered_result_queue_type::ticket_type t = 0, osmium::memory::Buffer&& b = osmium::memory::Buffer{}) :
+                    ticket(t),
+                    buffer(std::move(b)) {
+                }
+
+            }; // struct ordered_work_item
+
+        } // namespace detail
+
+        /**
+         * Apply handlers to all objects from a source in several threads.
+         *
+         * The source (usually an osmium::io::Reader) is read in the calling
+         * thread and the buffers are handed out to num_threads worker
+         * threads. Each worker thread has its own handler instance created
+         * by calling the factory, so the handler doesn't need any locking
+         * for its state. The order in which the buffers are processed is
+         * not defined, the objects in one buffer are always handled in
+         * order by the same handler.
+         *
+         * After all data was read and handled, the merge function is called
+         * in the calling thread once for each handler (in the order they
+         * were created) so that the results can be combined.
+         *
+         * If the source, a handler, or the merge function throws an
+         * exception, processing is stopped and the exception is re-thrown
+         * after all worker threads are finished. If there are several
+         * exceptions, only the first one is re-thrown.
+         *
+         * @tparam TSource Class with a read() function returning buffers.
+         *                 An invalid buffer signals the end of data.
+         * @param source The source of the data.
+         * @param factory Function without arguments returning a new
+         *                handler. Called num_threads times in the calling
+         *                thread. The handler type must be move
+         *                constructible.
+         * @param merge Function called with a reference to each handler
+         *              at the end.
+         * @param num_threads Number of worker threads. The same rules as
+         *                    for the osmium::thread::Pool apply, so 0 means
+         *                    using the setting from OSMIUM_POOL_THREADS or
+         *                    the number of cores minus 2 if that isn't set.
+         */
+        template <typename TSource, typename THandlerFactory, typename TMergeFunction>
+        void parallel_apply(TSource& source, THandlerFactory&& factory, TMergeFunction&& merge, int num_threads = 0) {
+            using handler_type = detail::factory_result_type<THandlerFactory>;
+
+            num_threads = detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency());
+
+            std::vector<handler_type> handlers;
+            handlers.reserve(num_threads);
+            for (int i = 0; i < num_threads; ++i) {
+                handlers.push_back(factory());
+            }
+
+            osmium::thread::BoundedQueue<osmium::memory::Buffer> queue{detail::get_apply_queue_size(num_threads), "apply"};
+            std::vector<std::exception_ptr> exceptions(num_threads + 1);
+            std::atomic<bool> failed{false};
+
+            {
+                std::vector<osmium::thread::thread_handler> threads;
+                threads.reserve(num_threads);
+                for (int i = 0; i < num_threads; ++i) {
+                    threads.emplace_back(detail::apply_worker<handler_type>{queue, handlers[i], exceptions[i + 1], failed});
+                }
+
+                try {
+                    while (!failed) {
+                        osmium::memory::Buffer buffer{source.read()};
+                        if (!buffer) {
+                            break;
+                        }
+                        queue.push(std::move(buffer));
+                    }
+                } catch (...) {
+                    exceptions[0] = std::current_exception();
+                    failed = true;
+                }
+
+                for (int i = 0; i < num_threads; ++i) {
+                    queue.push(osmium::memory::Buffer{});
+                }
+
+                // the destructors of the thread handlers wait for the
+                // threads to finish
+            }
+
+            for (const auto& exception : exceptions) {
+                if (exception) {
+                    std::rethrow_exception(exception);
+                }
+            }
+
+            for (auto& handler : handlers) {
+                merge(handler);
+            }
+        }
+
+        /**
+         * Process all buffers from a source in several threads and hand
+         * the results to an output function in the original order.
+         *
+         * The source (usually an osmium::io::Reader) is read in a separate
+         * thread and the buffers are handed out to num_threads worker
+         * threads. Each worker thread has its own handler instance created
+         * by calling the factory. The handler is called with each input
+         * buffer (as rvalue) and must return an osmium::memory::Buffer
+         * with the results. The output function (for instance an
+         * osmium::io::Writer) is called in the calling thread with the
+         * results (as rvalue) in the same order as the input buffers were
+         * read. Invalid result buffers are not given to the output function.
+         *
+         * The number of buffers in flight is limited, so reading will
+         * block if the output function is slower than the input.
+         *
+         * If the source, a handler, or the output function throws an
+         * exception, processing is stopped and the exception is re-thrown
+         * after all threads are finished.
+         *
+         * @tparam TSource Class with a read() function returning buffers.
+         *                 An invalid buffer signals the end of data.
+         * @param source The source of the data.
+         * @param factory Function without arguments returning a new
+         *                handler. Called num_threads times in the calling
+         *                thread. The handler type must be move
+         *                constructible.
+         * @param output Function called with each (valid) result buffer.
+         * @param num_threads Number of worker threads. See parallel_apply().
+         */
+        template <typename TSource, typename THandlerFactory, typename TOutputFunction>
+        void parallel_apply_ordered(TSource& source, THandlerFactory&& factory, TOutputFunction&& output, int num_threads = 0) {
+            using handler_type = detail::factory_result_type<THandlerFactory>;
+
+            num_threads = detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency());
+
+            std::vector<handler_type> handlers;
+            handlers.reserve(num_threads);
+            for (int i = 0; i < num_threads; ++i) {
+                handlers.push_back(factory());
+            }
+
+            const std::size_t queue_size = detail::get_apply_queue_size(num_threads);
+            osmium::thread::BoundedQueue<detail::ordered_work_item> work_queue{queue_size, "apply_work"};
+            detail::ordered_result_queue_type result_queue{queue_size, "apply_results"};
+            std::atomic<bool> failed{false};
+            std::exception_ptr exception;
+
+            std::vector<osmium::thread::thread_handler> threads;
+            threads.reserve(num_threads + 1);
+
+            for (int i = 0; i < num_threads; ++i) {
+                threads.emplace_back([&work_queue, &result_queue, &failed](handler_type& handler) {
+                    osmium::thread::set_thread_name("_osmium_apply");
+                    while (true) {
+                        detail::ordered_work_item item;
+                        work_queue.wait_and_pop(item);
+                        if (!item.buffer) {
+                            break;
+                        }
+                        if (failed) {
+                            result_queue.set_value(item.ticket, detail::ordered_result{});
+                            continue;
+                        }
+                        try {
+                            result_queue.set_value(item.ticket, detail::ordered_result{handler(std::move(item.buffer)), false});
+                        } catch (...) {
+                            result_queue.set_exception(item.ticket, std::current_exception());
+                        }
+                    }
+                }, std::ref(handlers[i]));
+            }
+
+            threads.emplace_back([&source, &work_queue, &result_queue, &failed, num_threads]() {
+                osmium::thread::set_thread_name("_osmium_apply_in");
+                try {
+                    while (!failed) {
+                        osmium::memory::Buffer buffer{source.read()};
+                        if (!buffer) {
+                            break;
+                        }
+                        const auto ticket = result_queue.reserve();
+                        work_queue.push(detail::ordered_work_item{ticket, std::move(buffer)});
+                    }
+                } catch (...) {
+                    result_queue.push_exception(std::current_exception());
+                }
+                for (int i = 0; i < num_threads; ++i) {
+                    work_queue.push(detail::ordered_work_item{});
+                }
+                result_queue.push(detail::ordered_result{osmium::memory::Buffer{}, true});
+            });
+
+            // Pop results until the end marker arrives. After an error the
+            // results are still popped (and thrown away) so that no thread
+            // blocks on a full queue.
+            while (true) {
+                try {
+                    detail::ordered_result result{result_queue.pop()};
+                    if (result.done) {
+                        break;
+                    }
+                    if (result.buffer && !failed) {
+                        output(std::move(result.buffer));
+                    }
+                } catch (...) {
+                    if (!failed) {
+                        exception = std::current_exception();
+                        failed = true;
+                    }
+                }
+            }
+
+            threads.clear();
+
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+        }
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_PARALLEL_APPLY_HPP
@@ -0,0 +1,362 @@
+#ifndef OSMIUM_THREAD_PIPELINE_HPP
+#define OSMIUM_THREAD_PIPELINE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/ordered_queue.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/util.hpp>
+#include <osmium/util/config.hpp>
+#include <osmium/util/trace.hpp>
+#include <osmium/visitor.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace thread {
+
+        namespace detail {
+
+            inline std::size_t get_pipeline_queue_size() noexcept {
+                const std::size_t n = osmium::config::get_max_queue_size("PIPELINE", 20);
+                return n > 2 ? n : 2;
+            }
+
+        } // namespace detail
+
+        /**
+         * A pipeline of processing stages for OSM data running concurrently.
+         *
+         * Data is read from a source (usually an osmium::io::Reader) in its
+         * own thread, goes through all stages in the order they were added,
+         * and ends up in a sink (for instance an osmium::io::Writer) which is
+         * called in the thread calling run(). Each stage gets a buffer and
+         * returns a buffer (which can be the same or a new one). Stages
+         * are connected by queues of limited size, if a stage can't keep up,
+         * the stages before it (and the source) will block.
+         *
+         * A stage can run in several threads. The buffers are still handed
+         * to the next stage (and the sink) in the original order. Each
+         * thread of a stage gets its own copy of the stage function, so
+         * function objects with state don't need any locking, but they
+         * will only see some of the buffers. Stages that need to see all
+         * data in order (like the NodeLocationsForWays handler) must run
+         * in a single thread. (See osmium::handler::add_node_locations_stages()
+         * for a way to add node locations to ways in several threads.)
+         *
+         * Usage:
+         * @code
+         * osmium::io::Reader reader{"input.osm.pbf"};
+         * osmium::io::Writer writer{"output.osm.pbf"};
+         *
+         * osmium::thread::Pipeline pipeline;
+         * pipeline.add_stage(filter_function, 4);
+         * pipeline.add_handler_stage(location_handler);
+         * pipeline.run(reader, writer);
+         *
+         * writer.close();
+         * reader.close();
+         * @endcode
+         */
+        class Pipeline {
+
+        public:
+
+            /// The type of the function called in each stage.
+            using stage_function_type = std::function<osmium::memory::Buffer(osmium::memory::Buffer&&)>;
+
+        private:
+
+            struct item {
+
+                osmium::memory::Buffer buffer;
+                bool done;
+
+                explicit item(osmium::memory::Buffer&& b = osmium::memory::Buffer{}, bool d = false) :
+                    buffer(std::move(b)),
+                    done(d) {
+                }
+
+            }; // struct item
+
+            using queue_type = osmium::thread::OrderedQueue<item>;
+
+            struct stage {
+                stage_function_type function;
+                int num_threads;
+                std::string name;
+            }; // struct stage
+
+            // State shared by all threads of a stage.
+            struct stage_state {
+                std::mutex mutex{};
+                bool finished = false;
+            }; // struct stage_state
+
+            class stage_worker {
+
+                stage_function_type m_function;
+                queue_type& m_input;
+                queue_type& m_output;
+                stage_state& m_state;
+                const std::atomic<bool>& m_failed;
+
+            public:
+
+                stage_worker(const stage_function_type& function, queue_type& input, queue_type& output, stage_state& state, const std::atomic<bool>& failed) :
+                    m_function(function),
+                    m_input(input),
+                    m_output(output),
+                    m_state(state),
+                    m_failed(failed) {
+                }
+
+                void operator()() {
+                    osmium::thread::set_thread_name("_osmium_stage");
+
+                    while (true) {
+                        queue_type::ticket_type ticket;
+                        item in;
+
+                        // Popping the input and reserving the place in the
+                        // output must happen together to keep the order.
+                        {
+                            std::lock_guard<std::mutex> lock{m_state.mutex};
+                            if (m_state.finished) {
+                                return;
+                            }
+                            ticket = m_output.reserve();
+                            try {
+                                in = m_input.pop();
+                            } catch (...) {
+                                m_output.set_exception(ticket, std::current_exception());
+                                continue;
+                            }
+                            if (in.done) {
+                                m_state.finished = true;
+                                m_output.set_value(ticket, std::move(in));
+                                return;
+                            }
+                        }
+
+                        if (m_failed || !in.buffer) {
+                            m_output.set_value(ticket, item{});
+                            continue;
+                        }
+
+                        try {
+                            osmium::TraceSpan span{"stage", ticket};
+                            m_output.set_value(ticket, item{m_function(std::move(in.buffer))});
+                        } catch (...) {
+                            m_output.set_exception(ticket, std::current_exception());
+                        }
+                    }
+                }
+
+            }; // class stage_worker
+
+            std::vector<stage> m_stages;
+            std::size_t m_queue_size;
+
+        public:
+
+            /**
+             * Create an empty pipeline.
+             *
+             * @param queue_size The size of the queues between the stages.
+             *                   If this is 0, the size is taken from the
+             *                   environment variable
+             *                   OSMIUM_MAX_PIPELINE_QUEUE_SIZE (default 20).
+             */
+            explicit Pipeline(std::size_t queue_size = 0) :
+                m_stages(),
+                m_queue_size(queue_size > 0 ? queue_size : detail::get_pipeline_queue_size()) {
+            }
+
+            /// The size of the queues between the stages.
+            std::size_t queue_size() const noexcept {
+                return m_queue_size;
+            }
+
+            /// The number of stages in this pipeline.
+            std::size_t num_stages() const noexcept {
+                return m_stages.size();
+            }
+
+            /**
+             * Add a stage at the end of the pipeline.
+             *
+             * @param function The function to call for each buffer. It gets
+             *                 the buffer as rvalue and must return a buffer.
+             *                 If it returns an invalid buffer, the later
+             *                 stages and the sink don't see it.
+             * @param num_threads The number of threads for this stage. If
+             *                    this is 0, the same rules as for the
+             *                    osmium::thread::Pool apply.
+             * @param name Optional name for this stage.
+             * @returns Reference to this pipeline.
+             */
+            Pipeline& add_stage(stage_function_type function, int num_threads = 1, std::string name = "") {
+                if (num_threads <= 0) {
+                    num_threads = detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency());
+                }
+                m_stages.push_back(stage{std::move(function), num_threads, std::move(name)});
+                return *this;
+            }
+
+            /**
+             * Add a stage calling a handler for all objects at the end of
+             * the pipeline. The stage runs in a single thread, so the
+             * handler sees all objects in order. The handler gets non-const
+             * objects, so it can change them (in place). The handler is
+             * taken by reference and must be alive while the pipeline runs.
+             *
+             * @param handler The handler.
+             * @param name Optional name for this stage.
+             * @returns Reference to this pipeline.
+             */
+            template <typename THandler>
+            Pipeline& add_handler_stage(THandler& handler, std::string name = "") {
+                return add_stage([&handler](osmium::memory::Buffer&& buffer) {
+                    osmium::apply(buffer.begin(), buffer.end(), handler);
+                    return std::move(buffer);
+                }, 1, std::move(name));
+            }
+
+            /**
+             * Run the pipeline until all data is read from the source and
+             * was processed. The source is read in its own thread, the sink
+             * is called in the calling thread with each (valid) buffer
+             * coming out of the last stage as rvalue.
+             *
+             * If the source, a stage, or the sink throw an exception,
+             * processing is stopped and the first exception is re-thrown
+             * after all threads have finished.
+             *
+             * @tparam TSource Class with a read() function returning
+             *                 buffers. An invalid buffer signals the end
+             *                 of data.
+             * @param source The source of the data.
+             * @param sink Function (or osmium::io::Writer) called with the
+             *             result buffers.
+             */
+            template <typename TSource, typename TSink>
+            void run(TSource& source, TSink&& sink) {
+                std::vector<std::unique_ptr<queue_type>> queues;
+                for (std::size_t i = 0; i <= m_stages.size(); ++i) {
+                    std::string name{"pipeline"};
+                    if (i > 0 && !m_stages[i - 1].name.empty()) {
+                        name += "_" + m_stages[i - 1].name;
+                    }
+                    queues.emplace_back(new queue_type{m_queue_size, name});
+                }
+
+                std::vector<std::unique_ptr<stage_state>> states;
+                for (std::size_t i = 0; i < m_stages.size(); ++i) {
+                    states.emplace_back(new stage_state{});
+                }
+
+                std::atomic<bool> failed{false};
+                std::exception_ptr exception;
+
+                std::vector<osmium::thread::thread_handler> threads;
+
+                threads.emplace_back([&source, &queues, &failed]() {
+                    osmium::thread::set_thread_name("_osmium_pipe_in");
+                    queue_type& queue = *queues.front();
+                    try {
+                        while (!failed) {
+                            osmium::memory::Buffer buffer{source.read()};
+                            if (!buffer) {
+                                break;
+                            }
+                            queue.push(item{std::move(buffer)});
+                        }
+                    } catch (...) {
+                        queue.push_exception(std::current_exception());
+                    }
+                    queue.push(item{osmium::memory::Buffer{}, true});
+                });
+
+                for (std::size_t i = 0; i < m_stages.size(); ++i) {
+                    for (int n = 0; n < m_stages[i].num_threads; ++n) {
+                        threads.emplace_back(stage_worker{m_stages[i].function, *queues[i], *queues[i + 1], *states[i], failed});
+                    }
+                }
+
+                // Pop results until the end marker arrives. After an error
+                // the results are still popped (and thrown away) so that no
+                // thread blocks on a full queue.
+                queue_type& queue = *queues.back();
+                while (true) {
+                    try {
+                        item result{queue.pop()};
+                        if (result.done) {
+                            break;
+                        }
+                        if (result.buffer && !failed) {
+                            sink(std::move(result.buffer));
+                        }
+                    } catch (...) {
+                        if (!failed) {
+                            exception = std::current_exception();
+                            failed = true;
+                        }
+                    }
+                }
+
+                threads.clear();
+
+                if (exception) {
+                    std::rethrow_exception(exception);
+                }
+            }
+
+        }; // class Pipeline
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_PIPELINE_HPP
@@ -34,12 +34,19 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/thread/function_wrapper.hpp>
-#include <osmium/thread/queue.hpp>
+#include <osmium/thread/queue_stats.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
+#include <osmium/util/numa.hpp>
 
+#include <atomic>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <type_traits>
 #include <utility>
@@ -84,7 +91,19 @@ namespace osmium {
         } // namespace detail
 
         /**
-         *  Thread pool.
+         * Thread pool.
+         *
+         * Each worker thread has its own task queue. Tasks submitted from
+         * outside the pool are distributed round-robin over these queues,
+         * tasks submitted from inside a worker thread go into the queue of
+         * that thread. Workers take tasks from their own queue first and
+         * steal tasks from the other queues if their own is empty. This
+         * way the worker threads don't all contend for the same lock.
+         * Tasks are run in the order they were submitted to a queue.
+         *
+         * The total number of tasks waiting in all queues is limited,
+         * submit() will block when the limit is reached (unless called
+         * from a worker thread of the pool).
          */
         class Pool {
 
@@ -118,19 +137,159 @@ namespace osmium {
 
             }; // class thread_joiner
 
-            osmium::thread::Queue<function_wrapper> m_work_queue;
+            /// The task queue of one worker thread.
+            struct work_queue {
+                std::mutex mutex;
+                std::deque<function_wrapper> tasks;
+            }; // struct work_queue
+
+            /// Identifies the pool and worker a thread belongs to.
+            struct worker_id {
+                const Pool* pool;
+                std::size_t index;
+            }; // struct worker_id
+
+            static worker_id& current_worker() noexcept {
+                static thread_local worker_id id{nullptr, 0};
+                return id;
+            }
+
+            std::vector<std::unique_ptr<work_queue>> m_queues;
+
+            const std::size_t m_max_queue_size;
+
+            /// Number of tasks in all queues.
+            std::atomic<std::size_t> m_pending{0};
+
+            /// Number of tasks submitted so far.
+            std::atomic<std::uint64_t> m_submitted{0};
+
+            /// Used to distribute tasks from outside the pool.
+            std::atomic<std::size_t> m_next_queue{0};
+
+            /// Number of workers waiting for work.
+            std::atomic<int> m_sleeping{0};
+
+            /// Number of threads waiting for space in the queues.
+            std::atomic<int> m_blocked{0};
+
+            std::atomic<bool> m_shutdown{false};
+
+            /// Only used together with the condition variables.
+            std::mutex m_mutex;
+            std::condition_variable m_work_available;
+            std::condition_variable m_space_available;
+
             std::vector<std::thread> m_threads{};
             thread_joiner m_joiner;
             int m_num_threads;
+            bool m_pin_threads;
+
+            detail::queue_counters m_counters{};
+
+            detail::queue_registration m_registration{[this] {
+                return stats();
+            }};
+
+            bool pop_from(std::size_t index, function_wrapper& task) {
+                auto& queue = *m_queues[index];
+                std::lock_guard<std::mutex> lock{queue.mutex};
+                if (queue.tasks.empty()) {
+                    return false;
+                }
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                return true;
+            }
+
+            bool take_task(std::size_t index, function_wrapper& task) {
+                const auto num_queues = m_queues.size();
+                for (std::size_t i = 0; i < num_queues; ++i) {
+                    if (pop_from((index + i) % num_queues, task)) {
+                        --m_pending;
+                        if (m_blocked > 0) {
+                            {
+                                std::lock_guard<std::mutex> lock{m_mutex};
+                            }
+                            m_space_available.notify_one();
+                        }
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            // Wait until there is work or the pool is shut down. Returns
+            // false if the worker should exit.
+            bool wait_for_work() {
+                const auto start = detail::queue_counters::now();
+                std::unique_lock<std::mutex> lock{m_mutex};
+                ++m_sleeping;
+                m_work_available.wait(lock, [this] {
+                    return m_pending > 0 || m_shutdown;
+                });
+                --m_sleeping;
+                m_counters.add_empty_wait(start);
+                return m_pending > 0;
+            }
+
+            void wait_for_space() {
+                if (m_max_queue_size == 0 || m_pending < m_max_queue_size) {
+                    return;
+                }
+                const auto start = detail::queue_counters::now();
+                std::unique_lock<std::mutex> lock{m_mutex};
+                ++m_blocked;
+                m_space_available.wait(lock, [this] {
+                    return m_pending < m_max_queue_size || m_shutdown;
+                });
+                --m_blocked;
+                m_counters.add_full_wait(start);
+            }
+
+            void enqueue(function_wrapper&& task) {
+                const auto& worker = current_worker();
+                const bool in_worker = worker.pool == this;
+                if (!in_worker) {
+                    wait_for_space();
+                }
 
-            void worker_thread() {
+                // Count before pushing so that m_pending never underflows.
+                m_counters.update_max_size(++m_pending);
+                ++m_submitted;
+                const auto index = in_worker ? worker.index : m_next_queue++ % m_queues.size();
+                {
+                    auto& queue = *m_queues[index];
+                    std::lock_guard<std::mutex> lock{queue.mutex};
+                    queue.tasks.push_back(std::move(task));
+                }
+
+                if (m_sleeping > 0) {
+                    {
+                        std::lock_guard<std::mutex> lock{m_mutex};
+                    }
+                    m_work_available.notify_one();
+                }
+            }
+
+            void worker_thread(int n) {
                 osmium::thread::set_thread_name("_osmium_worker");
+                if (m_pin_threads) {
+                    osmium::pin_current_thread_to_cpu(osmium::NumaTopology::system().cpu_for_thread(static_cast<std::size_t>(n)));
+                }
+
+                const auto index = static_cast<std::size_t>(n);
+                current_worker() = worker_id{this, index};
+
                 while (true) {
                     function_wrapper task;
-                    m_work_queue.wait_and_pop(task);
-                    if (task && task()) {
-                        // The called tasks returns true only when the
-                        // worker thread should shut down.
+                    if (take_task(index, task)) {
+                        if (task()) {
+                            // The called tasks returns true only when the
+                            // worker thread should shut down.
+                            return;
+                        }
+                    } else if (!wait_for_work()) {
                         return;
                     }
                 }
@@ -155,15 +314,25 @@ namespace osmium {
              *
              * If max_queue_size is 0, the queue size is read from
              * the environment variable OSMIUM_MAX_WORK_QUEUE_SIZE.
+             *
+             * If pin_threads is true, each thread is pinned to one CPU.
+             * The threads are distributed round-robin over the NUMA nodes
+             * (see osmium::NumaTopology). The default is read from the
+             * environment variable OSMIUM_PIN_THREADS.
              */
-            explicit Pool(int num_threads = default_num_threads, std::size_t max_queue_size = default_queue_size) :
-                m_work_queue(max_queue_size > 0 ? max_queue_size : detail::get_work_queue_size(), "work"),
+            explicit Pool(int num_threads = default_num_threads, std::size_t max_queue_size = default_queue_size, bool pin_threads = osmium::config::pin_threads()) :
+                m_max_queue_size(max_queue_size > 0 ? max_queue_size : detail::get_work_queue_size()),
                 m_joiner(m_threads),
-                m_num_threads(detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency())) {
+                m_num_threads(detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency())),
+                m_pin_threads(pin_threads) {
+
+                for (int i = 0; i < m_num_threads; ++i) {
+                    m_queues.emplace_back(new work_queue{});
+                }
 
                 try {
                     for (int i = 0; i < m_num_threads; ++i) {
-                        m_threads.emplace_back(&Pool::worker_thread, this);
+                        m_threads.emplace_back(&Pool::worker_thread, this, i);
                     }
                 } catch (...) {
                     shutdown_all_workers();
@@ -176,11 +345,17 @@ namespace osmium {
                 return pool;
             }
 
+            /**
+             * Tell all worker threads to shut down. They will finish all
+             * tasks already submitted before they do that.
+             */
             void shutdown_all_workers() {
-                for (int i = 0; i < m_num_threads; ++i) {
-                    // The special function wrapper makes a worker shut down.
-                    m_work_queue.push(function_wrapper{0});
+                {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_shutdown = true;
                 }
+                m_work_available.notify_all();
+                m_space_available.notify_all();
             }
 
             Pool(const Pool&) = delete;
@@ -197,12 +372,29 @@ namespace osmium {
                 return m_num_threads;
             }
 
+            /// Are the threads in this pool pinned to CPUs?
+            bool pin_threads() const noexcept {
+                return m_pin_threads;
+            }
+
+            /// The number of tasks waiting to be run.
             std::size_t queue_size() const {
-                return m_work_queue.size();
+                return m_pending;
             }
 
             bool queue_empty() const {
-                return m_work_queue.empty();
+                return m_pending == 0;
+            }
+
+            /**
+             * Get statistics for the task queues of this pool. The empty
+             * wait time is the time the worker threads were idle, the full
+             * wait time is the time threads submitting tasks were blocked.
+             */
+            queue_stats stats() const {
+                const std::size_t pending = m_pending;
+                const std::uint64_t submitted = m_submitted;
+                return m_counters.get("pool", m_max_queue_size, pending, submitted, submitted > pending ? submitted - pending : 0);
             }
 
             template <typename TFunction>
@@ -211,11 +403,21 @@ namespace osmium {
 
                 std::packaged_task<result_type()> task{std::forward<TFunction>(func)};
                 std::future<result_type> future_result{task.get_future()};
-                m_work_queue.push(std::move(task));
+                enqueue(std::move(task));
 
                 return future_result;
             }
 
+            /**
+             * Run the function in the thread pool without a way to get
+             * the result. This is cheaper than submit() because there is no
+             * std::future involved. The function must not throw.
+             */
+            template <typename TFunction>
+            void submit_detached(TFunction&& func) {
+                enqueue(function_wrapper{std::forward<TFunction>(func)});
+            }
+
         }; // class Pool
 
     } // namespace thread
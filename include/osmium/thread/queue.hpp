@@ -33,16 +33,18 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/thread/queue_stats.hpp>
+
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <mutex>
 #include <queue>
 #include <string>
 #include <utility> // IWYU pragma: keep
 
 #ifdef OSMIUM_DEBUG_QUEUE_SIZE
-# include <atomic>
 # include <iostream>
 #endif
 
@@ -73,27 +75,17 @@ namespace osmium {
             /// Used to signal producers when queue is not full.
             std::condition_variable m_space_available;
 
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-            /// The largest size the queue has been so far.
-            std::size_t m_largest_size;
+            /// The number of elements pushed (protected by m_mutex).
+            std::uint64_t m_pushed = 0;
 
-            /// The number of times push() was called on the queue.
-            std::atomic<int> m_push_counter;
+            /// The number of elements popped (protected by m_mutex).
+            std::uint64_t m_popped = 0;
 
-            /// The number of times the queue was full and a thread pushing
-            /// to the queue was blocked.
-            std::atomic<int> m_full_counter;
+            detail::queue_counters m_counters;
 
-            /**
-             * The number of times wait_and_pop(with_timeout)() was called
-             * on the queue.
-             */
-            std::atomic<int> m_pop_counter;
-
-            /// The number of times the queue was full and a thread pushing
-            /// to the queue was blocked.
-            std::atomic<int> m_empty_counter;
-#endif
+            detail::queue_registration m_registration{[this] {
+                return stats();
+            }};
 
         public:
 
@@ -107,16 +99,7 @@ namespace osmium {
             explicit Queue(std::size_t max_size = 0, std::string name = "") :
                 m_max_size(max_size),
                 m_name(std::move(name)),
-                m_queue()
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ,
-                m_largest_size(0),
-                m_push_counter(0),
-                m_full_counter(0),
-                m_pop_counter(0),
-                m_empty_counter(0)
-#endif
-            {
+                m_queue() {
             }
 
             Queue(const Queue&) = delete;
@@ -127,14 +110,7 @@ namespace osmium {
 
 #ifdef OSMIUM_DEBUG_QUEUE_SIZE
             ~Queue() {
-                std::cerr << "queue '" << m_name
-                          << "' with max_size=" << m_max_size
-                          << " had largest size " << m_largest_size
-                          << " and was full " << m_full_counter
-                          << " times in " << m_push_counter
-                          << " push() calls and was empty " << m_empty_counter
-                          << " times in " << m_pop_counter
-                          << " pop() calls\n";
+                std::cerr << stats() << '\n';
             }
 #else
             ~Queue() = default;
@@ -146,46 +122,37 @@ namespace osmium {
              */
             void push(T value) {
                 constexpr const std::chrono::milliseconds max_wait{10};
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ++m_push_counter;
-#endif
-                if (m_max_size) {
-                    while (size() >= m_max_size) {
+                if (m_max_size && size() >= m_max_size) {
+                    const auto start = detail::queue_counters::now();
+                    do {
                         std::unique_lock<std::mutex> lock{m_mutex};
                         m_space_available.wait_for(lock, max_wait, [this] {
                             return m_queue.size() < m_max_size;
                         });
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                        ++m_full_counter;
-#endif
-                    }
+                    } while (size() >= m_max_size);
+                    m_counters.add_full_wait(start);
                 }
+                m_counters.add_bytes(detail::queue_item_bytes(value));
                 std::lock_guard<std::mutex> lock{m_mutex};
                 m_queue.push(std::move(value));
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                if (m_largest_size < m_queue.size()) {
-                    m_largest_size = m_queue.size();
-                }
-#endif
+                ++m_pushed;
+                m_counters.update_max_size(m_queue.size());
                 m_data_available.notify_one();
             }
 
             void wait_and_pop(T& value) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ++m_pop_counter;
-#endif
                 std::unique_lock<std::mutex> lock{m_mutex};
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
                 if (m_queue.empty()) {
-                    ++m_empty_counter;
+                    const auto start = detail::queue_counters::now();
+                    m_data_available.wait(lock, [this] {
+                        return !m_queue.empty();
+                    });
+                    m_counters.add_empty_wait(start);
                 }
-#endif
-                m_data_available.wait(lock, [this] {
-                    return !m_queue.empty();
-                });
                 if (!m_queue.empty()) {
                     value = std::move(m_queue.front());
                     m_queue.pop();
+                    ++m_popped;
                     lock.unlock();
                     if (m_max_size) {
                         m_space_available.notify_one();
@@ -194,19 +161,14 @@ namespace osmium {
             }
 
             bool try_pop(T& value) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ++m_pop_counter;
-#endif
                 {
                     std::lock_guard<std::mutex> lock{m_mutex};
                     if (m_queue.empty()) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                        ++m_empty_counter;
-#endif
                         return false;
                     }
                     value = std::move(m_queue.front());
                     m_queue.pop();
+                    ++m_popped;
                 }
                 if (m_max_size) {
                     m_space_available.notify_one();
@@ -224,6 +186,12 @@ namespace osmium {
                 return m_queue.size();
             }
 
+            /// Get statistics for this queue.
+            queue_stats stats() const {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                return m_counters.get(m_name, m_max_size, m_queue.size(), m_pushed, m_popped);
+            }
+
         }; // class Queue
 
     } // namespace thread
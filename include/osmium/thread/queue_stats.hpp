@@ -0,0 +1,384 @@
+#ifndef OSMIUM_THREAD_QUEUE_STATS_HPP
+#define OSMIUM_THREAD_QUEUE_STATS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * Statistics about a queue (or the thread pool) at some point in
+         * time. All times are the sum over all threads using the queue.
+         */
+        struct queue_stats {
+
+            /// Name of the queue.
+            std::string name{};
+
+            /// Maximum number of elements in the queue (0 = unlimited).
+            std::size_t capacity = 0;
+
+            /// Number of elements in the queue.
+            std::size_t size = 0;
+
+            /// Largest number of elements the queue ever had (high-water mark).
+            std::size_t max_size = 0;
+
+            /// Number of elements pushed into the queue.
+            std::uint64_t pushed = 0;
+
+            /// Number of elements popped from the queue.
+            std::uint64_t popped = 0;
+
+            /// Number of bytes pushed into the queue (only counted for
+            /// buffers and strings).
+            std::uint64_t bytes_pushed = 0;
+
+            /// Number of times a producer had to wait because the queue
+            /// was full.
+            std::uint64_t full_count = 0;
+
+            /// Number of times a consumer had to wait because the queue
+            /// was empty.
+            std::uint64_t empty_count = 0;
+
+            /// Time producers were blocked because the queue was full.
+            std::chrono::nanoseconds full_wait{0};
+
+            /// Time consumers were blocked because the queue was empty.
+            std::chrono::nanoseconds empty_wait{0};
+
+            /// Time since the queue was created.
+            std::chrono::nanoseconds lifetime{0};
+
+            /// Elements popped per second over the lifetime of the queue.
+            double items_per_second() const noexcept {
+                const auto seconds = std::chrono::duration<double>(lifetime).count();
+                return seconds > 0 ? static_cast<double>(popped) / seconds : 0.0;
+            }
+
+            /// Bytes pushed per second over the lifetime of the queue.
+            double bytes_per_second() const noexcept {
+                const auto seconds = std::chrono::duration<double>(lifetime).count();
+                return seconds > 0 ? static_cast<double>(bytes_pushed) / seconds : 0.0;
+            }
+
+        }; // struct queue_stats
+
+        template <typename TChar, typename TTraits>
+        inline std::basic_ostream<TChar, TTraits>& operator<<(std::basic_ostream<TChar, TTraits>& out, const queue_stats& stats) {
+            out << "queue '" << stats.name << "' size=" << stats.size;
+            if (stats.capacity > 0) {
+                out << '/' << stats.capacity;
+            }
+            out << " max_size=" << stats.max_size
+                << " pushed=" << stats.pushed
+                << " popped=" << stats.popped
+                << " items/s=" << stats.items_per_second()
+                << " bytes/s=" << stats.bytes_per_second()
+                << " full=" << stats.full_count
+                << " (" << std::chrono::duration<double>(stats.full_wait).count() << "s)"
+                << " empty=" << stats.empty_count
+                << " (" << std::chrono::duration<double>(stats.empty_wait).count() << "s)";
+            return out;
+        }
+
+        namespace detail {
+
+            template <typename T>
+            inline auto queue_item_bytes(const T& value, int) noexcept -> decltype(value.committed()) {
+                return value.committed();
+            }
+
+            inline std::size_t queue_item_bytes(const std::string& value, int) noexcept {
+                return value.size();
+            }
+
+            template <typename T>
+            inline std::size_t queue_item_bytes(const T& /*value*/, long) noexcept { // NOLINT(google-runtime-int)
+                return 0;
+            }
+
+            /**
+             * Get the number of bytes in a queue element. This is the
+             * committed size for buffers, the size for strings, and 0 for
+             * everything else.
+             */
+            template <typename T>
+            inline std::size_t queue_item_bytes(const T& value) noexcept {
+                return queue_item_bytes(value, 0);
+            }
+
+            /**
+             * The counters for queue statistics kept in addition to what
+             * the queues have anyway. The wait times are only measured when
+             * a thread actually has to wait, so the fast path is not
+             * slowed down by reading the clock.
+             */
+            class queue_counters {
+
+                std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::now();
+                std::atomic<std::size_t> m_max_size{0};
+                std::atomic<std::uint64_t> m_bytes{0};
+                std::atomic<std::uint64_t> m_full_count{0};
+                std::atomic<std::uint64_t> m_empty_count{0};
+                std::atomic<std::int64_t> m_full_wait{0};
+                std::atomic<std::int64_t> m_empty_wait{0};
+
+                static std::int64_t nanoseconds_since(std::chrono::steady_clock::time_point start) noexcept {
+                    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                }
+
+            public:
+
+                static std::chrono::steady_clock::time_point now() noexcept {
+                    return std::chrono::steady_clock::now();
+                }
+
+                void update_max_size(std::size_t size) noexcept {
+                    std::size_t max_size = m_max_size.load(std::memory_order_relaxed);
+                    while (size > max_size && !m_max_size.compare_exchange_weak(max_size, size, std::memory_order_relaxed)) {
+                    }
+                }
+
+                void add_bytes(std::size_t bytes) noexcept {
+                    if (bytes > 0) {
+                        m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+                    }
+                }
+
+                void add_full_wait(std::chrono::steady_clock::time_point start) noexcept {
+                    m_full_count.fetch_add(1, std::memory_order_relaxed);
+                    m_full_wait.fetch_add(nanoseconds_since(start), std::memory_order_relaxed);
+                }
+
+                void add_empty_wait(std::chrono::steady_clock::time_point start) noexcept {
+                    m_empty_count.fetch_add(1, std::memory_order_relaxed);
+                    m_empty_wait.fetch_add(nanoseconds_since(start), std::memory_order_relaxed);
+                }
+
+                queue_stats get(const std::string& name, std::size_t capacity, std::size_t size, std::uint64_t pushed, std::uint64_t popped) const {
+                    queue_stats stats;
+                    stats.name = name;
+                    stats.capacity = capacity;
+                    stats.size = size;
+                    stats.max_size = std::max(size, m_max_size.load(std::memory_order_relaxed));
+                    stats.pushed = pushed;
+                    stats.popped = popped;
+                    stats.bytes_pushed = m_bytes.load(std::memory_order_relaxed);
+                    stats.full_count = m_full_count.load(std::memory_order_relaxed);
+                    stats.empty_count = m_empty_count.load(std::memory_order_relaxed);
+                    stats.full_wait = std::chrono::nanoseconds{m_full_wait.load(std::memory_order_relaxed)};
+                    stats.empty_wait = std::chrono::nanoseconds{m_empty_wait.load(std::memory_order_relaxed)};
+                    stats.lifetime = std::chrono::nanoseconds{nanoseconds_since(m_start)};
+                    return stats;
+                }
+
+            }; // class queue_counters
+
+            /**
+             * Keeps track of all queues currently in existence so that
+             * their statistics can be queried.
+             */
+            class queue_registry {
+
+                using stats_function_type = std::function<queue_stats()>;
+
+                mutable std::mutex m_mutex;
+                std::vector<std::pair<const void*, stats_function_type>> m_queues;
+
+            public:
+
+                static queue_registry& instance() {
+                    static queue_registry registry;
+                    return registry;
+                }
+
+                void add(const void* key, stats_function_type function) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_queues.emplace_back(key, std::move(function));
+                }
+
+                void remove(const void* key) noexcept {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    const auto it = std::find_if(m_queues.begin(), m_queues.end(), [key](const std::pair<const void*, stats_function_type>& entry) {
+                        return entry.first == key;
+                    });
+                    if (it != m_queues.end()) {
+                        m_queues.erase(it);
+                    }
+                }
+
+                std::vector<queue_stats> stats() const {
+                    std::vector<queue_stats> result;
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    result.reserve(m_queues.size());
+                    for (const auto& entry : m_queues) {
+                        result.push_back(entry.second());
+                    }
+                    return result;
+                }
+
+            }; // class queue_registry
+
+            /**
+             * Registers a queue with the queue_registry while it exists.
+             * This must be the last data member of the queue so that the
+             * queue is complete while it is registered.
+             */
+            class queue_registration {
+
+            public:
+
+                explicit queue_registration(std::function<queue_stats()> function) {
+                    queue_registry::instance().add(this, std::move(function));
+                }
+
+                queue_registration(const queue_registration&) = delete;
+                queue_registration& operator=(const queue_registration&) = delete;
+
+                queue_registration(queue_registration&&) = delete;
+                queue_registration& operator=(queue_registration&&) = delete;
+
+                ~queue_registration() noexcept {
+                    queue_registry::instance().remove(this);
+                }
+
+            }; // class queue_registration
+
+        } // namespace detail
+
+        /**
+         * Get the statistics of all queues (and thread pools) currently in
+         * existence. This includes the queues inside all Readers, Writers,
+         * and Pipelines.
+         */
+        inline std::vector<queue_stats> get_queue_stats() {
+            return detail::queue_registry::instance().stats();
+        }
+
+        /**
+         * Reports the statistics of all queues periodically from a
+         * separate thread while an object of this class exists.
+         *
+         * Usage:
+         * @code
+         * osmium::thread::QueueStatsReporter reporter{std::chrono::seconds{10}, std::cerr};
+         * @endcode
+         */
+        class QueueStatsReporter {
+
+            using callback_type = std::function<void(const std::vector<queue_stats>&)>;
+
+            std::chrono::milliseconds m_interval;
+            callback_type m_callback;
+            std::mutex m_mutex{};
+            std::condition_variable m_stop_requested{};
+            bool m_stop = false;
+            std::thread m_thread{};
+
+            void run() {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                while (!m_stop_requested.wait_for(lock, m_interval, [this] {
+                    return m_stop;
+                })) {
+                    lock.unlock();
+                    m_callback(get_queue_stats());
+                    lock.lock();
+                }
+            }
+
+        public:
+
+            /**
+             * Call the callback with the statistics of all queues every
+             * interval. The callback is called from a separate thread and
+             * must not throw.
+             */
+            QueueStatsReporter(std::chrono::milliseconds interval, callback_type callback) :
+                m_interval(interval),
+                m_callback(std::move(callback)) {
+                m_thread = std::thread{&QueueStatsReporter::run, this};
+            }
+
+            /**
+             * Write the statistics of all queues, one line per queue, to
+             * the output stream every interval.
+             */
+            QueueStatsReporter(std::chrono::milliseconds interval, std::ostream& out) :
+                QueueStatsReporter(interval, [&out](const std::vector<queue_stats>& stats) {
+                    for (const auto& s : stats) {
+                        out << s << '\n';
+                    }
+                }) {
+            }
+
+            QueueStatsReporter(const QueueStatsReporter&) = delete;
+            QueueStatsReporter& operator=(const QueueStatsReporter&) = delete;
+
+            QueueStatsReporter(QueueStatsReporter&&) = delete;
+            QueueStatsReporter& operator=(QueueStatsReporter&&) = delete;
+
+            ~QueueStatsReporter() noexcept {
+                {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_stop = true;
+                }
+                m_stop_requested.notify_all();
+                if (m_thread.joinable()) {
+                    m_thread.join();
+                }
+            }
+
+        }; // class QueueStatsReporter
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_QUEUE_STATS_HPP
@@ -0,0 +1,231 @@
+#ifndef OSMIUM_THREAD_RADIX_SORT_HPP
+#define OSMIUM_THREAD_RADIX_SORT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace thread {
+
+        namespace detail {
+
+            enum constant_radix : unsigned {
+                radix_bits = 8,
+                radix_buckets = 1U << radix_bits
+            };
+
+            using radix_counts = std::array<std::size_t, radix_buckets>;
+
+            /**
+             * Call func(0) ... func(num_chunks - 1), all but the first in
+             * the thread pool, and wait until all are done. Rethrows the
+             * first exception thrown by any of them.
+             */
+            template <typename TFunction>
+            void run_chunks(osmium::thread::Pool* pool, std::size_t num_chunks, TFunction&& func) {
+                if (!pool) {
+                    for (std::size_t chunk = 0; chunk < num_chunks; ++chunk) {
+                        func(chunk);
+                    }
+                    return;
+                }
+
+                std::vector<std::future<void>> futures;
+                std::exception_ptr exception;
+                try {
+                    for (std::size_t chunk = 1; chunk < num_chunks; ++chunk) {
+                        futures.push_back(pool->submit([&func, chunk]() {
+                            func(chunk);
+                        }));
+                    }
+                    func(0);
+                } catch (...) {
+                    exception = std::current_exception();
+                }
+
+                // Always wait for all tasks, they use data on our stack.
+                for (auto& future : futures) {
+                    try {
+                        future.get();
+                    } catch (...) {
+                        if (!exception) {
+                            exception = std::current_exception();
+                        }
+                    }
+                }
+
+                if (exception) {
+                    std::rethrow_exception(exception);
+                }
+            }
+
+            /**
+             * One pass of the LSD radix sort: Distribute the elements
+             * from [in, in + size) into out by the digit at shift. Returns
+             * false (and does nothing) if all elements have the same digit.
+             */
+            template <typename TInIterator, typename TOutIterator, typename TKey>
+            bool radix_pass(TInIterator in, std::size_t size, TOutIterator out, TKey& key, unsigned shift, osmium::thread::Pool* pool, std::size_t num_chunks) {
+                const auto chunk_begin = [size, num_chunks](std::size_t chunk) {
+                    return size * chunk / num_chunks;
+                };
+                const auto digit = [&key, shift](const typename std::iterator_traits<TInIterator>::value_type& element) {
+                    return static_cast<std::size_t>((static_cast<uint64_t>(key(element)) >> shift) & (radix_buckets - 1));
+                };
+
+                std::vector<radix_counts> counts(num_chunks);
+                run_chunks(pool, num_chunks, [&](std::size_t chunk) {
+                    auto& count = counts[chunk];
+                    count.fill(0);
+                    const auto end = in + chunk_begin(chunk + 1);
+                    for (auto it = in + chunk_begin(chunk); it != end; ++it) {
+                        ++count[digit(*it)];
+                    }
+                });
+
+                // Turn the counts into the position where each chunk
+                // starts writing elements with each digit.
+                std::size_t pos = 0;
+                for (std::size_t d = 0; d < radix_buckets; ++d) {
+                    std::size_t total = 0;
+                    for (auto& count : counts) {
+                        const std::size_t n = count[d];
+                        count[d] = pos + total;
+                        total += n;
+                    }
+                    if (total == size) {
+                        return false;
+                    }
+                    pos += total;
+                }
+
+                run_chunks(pool, num_chunks, [&](std::size_t chunk) {
+                    auto& next = counts[chunk];
+                    const auto end = in + chunk_begin(chunk + 1);
+                    for (auto it = in + chunk_begin(chunk); it != end; ++it) {
+                        *(out + next[digit(*it)]++) = std::move(*it);
+                    }
+                });
+
+                return true;
+            }
+
+        } // namespace detail
+
+        /**
+         * Sort the range [first, last) by an unsigned integer key using an
+         * LSD radix sort. The sort is stable. Counting and distributing the
+         * elements is done in parallel in the thread pool.
+         *
+         * This is much faster than std::sort for large numbers of elements
+         * with integer keys, such as the (id, value) pairs in the sparse
+         * index maps.
+         *
+         * Do not call this from a thread of the pool given, it waits for
+         * tasks running in the pool.
+         *
+         * @param first Beginning of the range to sort.
+         * @param last End of the range to sort.
+         * @param scratch Beginning of a range of at least the same size as
+         *                [first, last) which is used as temporary storage.
+         * @param key Function returning the key (an unsigned integer of
+         *            up to 64 bits) for an element.
+         * @param pool Thread pool to use. If this is nullptr, the sort is
+         *             done in the current thread.
+         */
+        template <typename TIterator, typename TScratchIterator, typename TKey>
+        void radix_sort(TIterator first, TIterator last, TScratchIterator scratch, TKey&& key, osmium::thread::Pool* pool = &osmium::thread::Pool::default_instance()) {
+            const auto size = static_cast<std::size_t>(std::distance(first, last));
+            if (size < 2) {
+                return;
+            }
+
+            // Use some chunks per thread so that the work is spread
+            // evenly even if some threads are busy with other things.
+            const std::size_t num_threads = pool ? static_cast<std::size_t>(pool->num_threads()) + 1 : 1;
+            std::size_t num_chunks = num_threads * 4;
+            if (num_chunks > size) {
+                num_chunks = size;
+            }
+
+            // Passes for digits above the largest key can be skipped.
+            std::vector<uint64_t> max_keys(num_chunks, 0);
+            detail::run_chunks(pool, num_chunks, [&](std::size_t chunk) {
+                uint64_t max_key = 0;
+                const auto end = first + size * (chunk + 1) / num_chunks;
+                for (auto it = first + size * chunk / num_chunks; it != end; ++it) {
+                    const auto k = static_cast<uint64_t>(key(*it));
+                    if (k > max_key) {
+                        max_key = k;
+                    }
+                }
+                max_keys[chunk] = max_key;
+            });
+            const uint64_t max_key = *std::max_element(max_keys.cbegin(), max_keys.cend());
+
+            bool data_in_scratch = false;
+            for (unsigned shift = 0; shift < 64 && (max_key >> shift) != 0; shift += detail::radix_bits) {
+                const bool moved = data_in_scratch
+                    ? detail::radix_pass(scratch, size, first, key, shift, pool, num_chunks)
+                    : detail::radix_pass(first, size, scratch, key, shift, pool, num_chunks);
+                if (moved) {
+                    data_in_scratch = !data_in_scratch;
+                }
+            }
+
+            if (data_in_scratch) {
+                detail::run_chunks(pool, num_chunks, [&](std::size_t chunk) {
+                    const auto begin = size * chunk / num_chunks;
+                    const auto end = size * (chunk + 1) / num_chunks;
+                    std::move(scratch + begin, scratch + end, first + begin);
+                });
+            }
+        }
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_RADIX_SORT_HPP
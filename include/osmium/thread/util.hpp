@@ -33,8 +33,11 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <atomic>
 #include <chrono>
+#include <functional>
 #include <future>
+#include <mutex>
 #include <thread>
 #include <utility>
 
@@ -69,6 +72,42 @@ namespace osmium {
             }
         }
 
+        namespace detail {
+
+            /**
+             * A function called when the state of a queue or similar
+             * object changes, so that somebody waiting for it can be woken
+             * up. Setting and calling are synchronized: Once set() returns,
+             * the old function is not called any more. Calling is cheap if
+             * no function is set.
+             */
+            class change_listener {
+
+                std::mutex m_mutex;
+                std::function<void()> m_function;
+                std::atomic<bool> m_active{false};
+
+            public:
+
+                void set(std::function<void()> function) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_function = std::move(function);
+                    m_active = static_cast<bool>(m_function);
+                }
+
+                void operator()() {
+                    if (m_active.load()) {
+                        std::lock_guard<std::mutex> lock{m_mutex};
+                        if (m_function) {
+                            m_function();
+                        }
+                    }
+                }
+
+            }; // class change_listener
+
+        } // namespace detail
+
         /**
          * Set name of current thread for debugging. This only works on Linux.
          */
@@ -80,6 +80,55 @@ namespace osmium {
             return true;
         }
 
+        inline bool use_huge_pages() noexcept {
+            auto env = osmium::detail::getenv_wrapper("OSMIUM_USE_HUGE_PAGES");
+            if (env) {
+                if (!strcasecmp(env, "on") ||
+                    !strcasecmp(env, "true") ||
+                    !strcasecmp(env, "yes") ||
+                    !strcasecmp(env, "1")) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * NUMA memory placement policy for large memory mappings. See
+         * osmium::set_numa_policy().
+         */
+        enum class numa_policy {
+            none       = 0, ///< leave it to the operating system
+            local      = 1, ///< allocate on the node of the touching thread
+            interleave = 2  ///< spread pages round-robin over all nodes
+        };
+
+        inline numa_policy get_numa_policy() noexcept {
+            auto env = osmium::detail::getenv_wrapper("OSMIUM_NUMA_POLICY");
+            if (env) {
+                if (!strcasecmp(env, "interleave")) {
+                    return numa_policy::interleave;
+                }
+                if (!strcasecmp(env, "local")) {
+                    return numa_policy::local;
+                }
+            }
+            return numa_policy::none;
+        }
+
+        inline bool pin_threads() noexcept {
+            auto env = osmium::detail::getenv_wrapper("OSMIUM_PIN_THREADS");
+            if (env) {
+                if (!strcasecmp(env, "on") ||
+                    !strcasecmp(env, "true") ||
+                    !strcasecmp(env, "yes") ||
+                    !strcasecmp(env, "1")) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
         inline std::size_t get_max_queue_size(const char* queue_name, std::size_t default_value) noexcept {
             assert(queue_name);
             std::string name{"OSMIUM_MAX_"};
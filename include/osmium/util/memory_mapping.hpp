@@ -34,14 +34,23 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/util/compatibility.hpp>
+#include <osmium/util/config.hpp>
 #include <osmium/util/file.hpp>
+#include <osmium/util/numa.hpp>
 
 #include <cassert>
 #include <cerrno>
 #include <cstddef>
+#include <cstdint>
 #include <stdexcept>
 #include <system_error>
 
+#ifdef __linux__
+# include <cstdlib>
+# include <fstream>
+# include <string>
+#endif
+
 #ifndef _WIN32
 # include <sys/mman.h>
 #else
@@ -91,6 +100,11 @@ namespace osmium {
          *
          * On Windows the file will be set to binary mode before the memory
          * mapping.
+         *
+         * On Linux you can ask the kernel to back the mapping with
+         * transparent huge pages by calling use_huge_pages(). This reduces
+         * the number of TLB misses for large mappings with random access
+         * patterns, for instance for node location indexes.
          */
         class MemoryMapping {
 
@@ -102,6 +116,14 @@ namespace osmium {
                 write_shared  = 2
             };
 
+            /// How the memory will be accessed, see advise().
+            enum class access_advice {
+                normal     = 0,
+                random     = 1,
+                sequential = 2,
+                will_need  = 3
+            };
+
         private:
 
             /// The size of the mapping
@@ -123,10 +145,18 @@ namespace osmium {
             /// The address where the memory is mapped
             void* m_addr;
 
+            /// Were huge pages requested for this mapping?
+            bool m_huge_pages = false;
+
+            /// NUMA memory policy set for this mapping
+            osmium::config::numa_policy m_numa_policy = osmium::config::numa_policy::none;
+
             bool is_valid() const noexcept;
 
             void make_invalid() noexcept;
 
+            bool advise_huge_pages() const noexcept;
+
 #ifdef _WIN32
             using flag_type = DWORD;
 #else
@@ -242,6 +272,91 @@ namespace osmium {
              */
             void resize(std::size_t new_size);
 
+            /**
+             * Ask the operating system to back this mapping with
+             * (transparent) huge pages. This is only a hint, the memory will
+             * work as before if the system doesn't support huge pages or
+             * doesn't have any available. The hint is kept when the mapping
+             * is resized.
+             *
+             * This is only implemented on Linux (using madvise() with
+             * MADV_HUGEPAGE), on other systems it does nothing. Call this
+             * before the memory is first used, otherwise the kernel will
+             * only later (if at all) move the data to huge pages.
+             *
+             * @returns true if the hint was accepted, false otherwise.
+             */
+            bool use_huge_pages() noexcept {
+                m_huge_pages = advise_huge_pages();
+                return m_huge_pages;
+            }
+
+            /**
+             * Was the use of huge pages requested successfully for this
+             * mapping? See use_huge_pages().
+             */
+            bool huge_pages() const noexcept {
+                return m_huge_pages;
+            }
+
+            /**
+             * Tell the operating system how the memory will be accessed.
+             * For file-backed mappings this controls the readahead:
+             * "random" switches it off, "sequential" makes it more
+             * aggressive, "will_need" starts reading the whole mapping in
+             * the background. Unlike huge pages this hint is not kept when
+             * the mapping is resized.
+             *
+             * This uses posix_madvise(), on Windows it does nothing.
+             *
+             * @returns true if the hint was accepted, false otherwise.
+             */
+            bool advise(access_advice advice) const noexcept;
+
+            /**
+             * Write all changes in a writable file-based mapping back to
+             * the file and wait until this is done. Use together with
+             * fsync() on the file descriptor if the data has to survive a
+             * system crash. Does nothing for other mappings.
+             *
+             * @throws std::system_error if msync() (FlushViewOfFile() on
+             *         Windows) fails.
+             */
+            void flush() const;
+
+            /**
+             * The number of bytes of this mapping currently backed by huge
+             * pages. This reads /proc/self/smaps and is therefore rather
+             * expensive, don't call it often.
+             *
+             * On systems other than Linux this always returns 0.
+             */
+            std::size_t huge_page_bytes() const;
+
+            /**
+             * Set the NUMA memory policy for this mapping, see
+             * osmium::set_numa_policy() for details. The policy is kept
+             * when the mapping is resized. Call this before the memory is
+             * first used.
+             *
+             * @returns true if the policy was set, false otherwise.
+             */
+            bool set_numa_policy(osmium::config::numa_policy policy) noexcept {
+                if (is_valid() && osmium::set_numa_policy(m_addr, m_size, policy)) {
+                    m_numa_policy = policy;
+                    return true;
+                }
+                m_numa_policy = osmium::config::numa_policy::none;
+                return false;
+            }
+
+            /**
+             * The NUMA memory policy successfully set for this mapping.
+             */
+            osmium::config::numa_policy numa_policy() const noexcept {
+                return m_numa_policy;
+            }
+
             /**
              * In a boolean context a MemoryMapping is true when it is a valid
              * existing mapping.
@@ -417,6 +532,63 @@ namespace osmium {
                 m_mapping.resize(sizeof(T) * new_size);
             }
 
+            /**
+             * Ask the operating system to back this mapping with huge
+             * pages. See MemoryMapping::use_huge_pages().
+             *
+             * @returns true if the hint was accepted, false otherwise.
+             */
+            bool use_huge_pages() noexcept {
+                return m_mapping.use_huge_pages();
+            }
+
+            /**
+             * Was the use of huge pages requested successfully for this
+             * mapping?
+             */
+            bool huge_pages() const noexcept {
+                return m_mapping.huge_pages();
+            }
+
+            /**
+             * The number of bytes of this mapping currently backed by huge
+             * pages. See MemoryMapping::huge_page_bytes().
+             */
+            std::size_t huge_page_bytes() const {
+                return m_mapping.huge_page_bytes();
+            }
+
+            /**
+             * Tell the operating system how the memory will be accessed.
+             * See MemoryMapping::advise().
+             */
+            bool advise(MemoryMapping::access_advice advice) const noexcept {
+                return m_mapping.advise(advice);
+            }
+
+            /**
+             * Write all changes back to the file. See
+             * MemoryMapping::flush().
+             */
+            void flush() const {
+                m_mapping.flush();
+            }
+
+            /**
+             * Set the NUMA memory policy for this mapping. See
+             * MemoryMapping::set_numa_policy().
+             */
+            bool set_numa_policy(osmium::config::numa_policy policy) noexcept {
+                return m_mapping.set_numa_policy(policy);
+            }
+
+            /**
+             * The NUMA memory policy successfully set for this mapping.
+             */
+            osmium::config::numa_policy numa_policy() const noexcept {
+                return m_mapping.numa_policy();
+            }
+
             /**
              * In a boolean context a TypedMemoryMapping is true when it is
              * a valid existing mapping.
@@ -567,7 +739,9 @@ inline osmium::MemoryMapping::MemoryMapping(MemoryMapping&& other) noexcept :
     m_offset(other.m_offset),
     m_fd(other.m_fd),
     m_mapping_mode(other.m_mapping_mode),
-    m_addr(other.m_addr) {
+    m_addr(other.m_addr),
+    m_huge_pages(other.m_huge_pages),
+    m_numa_policy(other.m_numa_policy) {
     other.make_invalid();
 }
 
@@ -578,10 +752,79 @@ inline osmium::MemoryMapping& osmium::MemoryMapping::operator=(osmium::MemoryMap
     m_fd           = other.m_fd;
     m_mapping_mode = other.m_mapping_mode;
     m_addr         = other.m_addr;
+    m_huge_pages   = other.m_huge_pages;
+    m_numa_policy  = other.m_numa_policy;
     other.make_invalid();
     return *this;
 }
 
+inline bool osmium::MemoryMapping::advise_huge_pages() const noexcept {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (is_valid()) {
+        return ::madvise(m_addr, m_size, MADV_HUGEPAGE) == 0;
+    }
+#endif
+    return false;
+}
+
+inline bool osmium::MemoryMapping::advise(access_advice advice) const noexcept {
+    if (!is_valid()) {
+        return false;
+    }
+    int posix_advice = POSIX_MADV_NORMAL;
+    switch (advice) {
+        case access_advice::normal:
+            break;
+        case access_advice::random:
+            posix_advice = POSIX_MADV_RANDOM;
+            break;
+        case access_advice::sequential:
+            posix_advice = POSIX_MADV_SEQUENTIAL;
+            break;
+        case access_advice::will_need:
+            posix_advice = POSIX_MADV_WILLNEED;
+            break;
+    }
+    return ::posix_madvise(m_addr, m_size, posix_advice) == 0;
+}
+
+inline void osmium::MemoryMapping::flush() const {
+    if (is_valid() && m_fd != -1 && m_mapping_mode == mapping_mode::write_shared) {
+        if (::msync(m_addr, m_size, MS_SYNC) != 0) {
+            throw std::system_error{errno, std::system_category(), "msync failed"};
+        }
+    }
+}
+
+inline std::size_t osmium::MemoryMapping::huge_page_bytes() const {
+#ifdef __linux__
+    if (!is_valid()) {
+        return 0;
+    }
+
+    // The header line of each mapping in /proc/self/smaps starts with its
+    // address range in hex, followed by lines with "Key: value kB".
+    std::ifstream smaps_file{"/proc/self/smaps"};
+    const auto addr = reinterpret_cast<std::uintptr_t>(m_addr);
+    bool in_mapping = false;
+    std::size_t bytes = 0;
+    std::string line;
+    while (std::getline(smaps_file, line)) {
+        const auto dash = line.find('-');
+        if (dash != std::string::npos && dash > 0 && line.find(':') > line.find(' ')) {
+            const auto start = std::strtoull(line.c_str(), nullptr, 16);
+            const auto end = std::strtoull(line.c_str() + dash + 1, nullptr, 16);
+            in_mapping = start < addr + m_size && addr < end;
+        } else if (in_mapping && line.compare(0, 14, "AnonHugePages:") == 0) {
+            bytes += std::strtoull(line.c_str() + 14, nullptr, 10) * 1024;
+        }
+    }
+    return bytes < m_size ? bytes : m_size;
+#else
+    return 0;
+#endif
+}
+
 inline void osmium::MemoryMapping::unmap() {
     if (is_valid()) {
         if (::munmap(m_addr, m_size) != 0) {
@@ -612,6 +855,12 @@ inline void osmium::MemoryMapping::resize(std::size_t new_size) {
             throw std::system_error{errno, std::system_category(), "mmap (remap) failed"};
         }
     }
+    if (m_huge_pages) {
+        m_huge_pages = advise_huge_pages();
+    }
+    if (m_numa_policy != osmium::config::numa_policy::none) {
+        set_numa_policy(m_numa_policy);
+    }
 }
 
 #else
@@ -696,6 +945,27 @@ inline bool osmium::MemoryMapping::is_valid() const noexcept {
     return m_addr != nullptr;
 }
 
+// Huge pages are not supported on Windows.
+inline bool osmium::MemoryMapping::advise_huge_pages() const noexcept {
+    return false;
+}
+
+inline bool osmium::MemoryMapping::advise(access_advice /*advice*/) const noexcept {
+    return false;
+}
+
+inline void osmium::MemoryMapping::flush() const {
+    if (is_valid() && m_fd != -1 && m_mapping_mode == mapping_mode::write_shared) {
+        if (!FlushViewOfFile(m_addr, 0)) {
+            throw std::system_error{last_error(), std::system_category(), "FlushViewOfFile failed"};
+        }
+    }
+}
+
+inline std::size_t osmium::MemoryMapping::huge_page_bytes() const {
+    return 0;
+}
+
 inline void osmium::MemoryMapping::make_invalid() noexcept {
     m_addr = nullptr;
 }
@@ -731,7 +1001,9 @@ inline osmium::MemoryMapping::MemoryMapping(MemoryMapping&& other) noexcept :
     m_fd(other.m_fd),
     m_mapping_mode(other.m_mapping_mode),
     m_handle(std::move(other.m_handle)),
-    m_addr(other.m_addr) {
+    m_addr(other.m_addr),
+    m_huge_pages(other.m_huge_pages),
+    m_numa_policy(other.m_numa_policy) {
     other.make_invalid();
     other.m_handle = nullptr;
 }
@@ -744,6 +1016,8 @@ inline osmium::MemoryMapping& osmium::MemoryMapping::operator=(osmium::MemoryMap
     m_mapping_mode = other.m_mapping_mode;
     m_handle       = std::move(other.m_handle);
     m_addr         = other.m_addr;
+    m_huge_pages   = other.m_huge_pages;
+    m_numa_policy  = other.m_numa_policy;
     other.make_invalid();
     other.m_handle = nullptr;
     return *this;
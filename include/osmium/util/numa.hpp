@@ -0,0 +1,325 @@
+#ifndef OSMIUM_UTIL_NUMA_HPP
+#define OSMIUM_UTIL_NUMA_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/util/config.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+# include <pthread.h>
+# include <sched.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+namespace osmium {
+
+    namespace detail {
+
+        // Sanity check for parse_cpu_list().
+        constexpr const long max_cpu_list_range = 1L << 16; // NOLINT(google-runtime-int)
+
+        /**
+         * Parse a list of CPU or node numbers in the format used by the
+         * Linux kernel in /sys, for instance "0-3,8,10-11".
+         */
+        inline std::vector<int> parse_cpu_list(const std::string& list) {
+            std::vector<int> result;
+
+            const char* str = list.c_str();
+            while (*str >= '0' && *str <= '9') {
+                char* end = nullptr;
+                const auto first = std::strtol(str, &end, 10);
+                auto last = first;
+                if (*end == '-') {
+                    last = std::strtol(end + 1, &end, 10);
+                }
+                if (last - first > max_cpu_list_range) {
+                    break;
+                }
+                for (auto n = first; n <= last; ++n) {
+                    result.push_back(static_cast<int>(n));
+                }
+                if (*end != ',') {
+                    break;
+                }
+                str = end + 1;
+            }
+
+            return result;
+        }
+
+        inline std::string read_first_line(const std::string& filename) {
+            std::ifstream file{filename};
+            std::string line;
+            std::getline(file, line);
+            return line;
+        }
+
+        // Values from linux/mempolicy.h. They are defined here so that we
+        // don't need libnuma.
+        enum constant_mpol_interleave : int {
+            mpol_interleave = 3
+        };
+
+        enum constant_mpol_local : int {
+            mpol_local = 4
+        };
+
+    } // namespace detail
+
+    inline namespace util {
+
+        /**
+         * The NUMA topology of the machine, ie. which CPUs belong to which
+         * NUMA node. Only nodes with CPUs that this process is allowed to
+         * run on are taken into account.
+         *
+         * This is only implemented on Linux where the information is read
+         * from /sys/devices/system/node. On other systems (or if the
+         * information is not available) there is always exactly one node
+         * with all CPUs.
+         */
+        class NumaTopology {
+
+            std::vector<int> m_node_ids;
+            std::vector<std::vector<int>> m_node_cpus;
+            std::size_t m_num_cpus = 0;
+
+#ifdef __linux__
+            static bool cpu_allowed(const cpu_set_t& allowed, int cpu) noexcept {
+                return cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed); // NOLINT(hicpp-signed-bitwise)
+            }
+
+            void read_from_sys() {
+                cpu_set_t allowed;
+                CPU_ZERO(&allowed);
+                if (::sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+                    return;
+                }
+
+                const std::string base{"/sys/devices/system/node/"};
+                for (const int node : osmium::detail::parse_cpu_list(osmium::detail::read_first_line(base + "online"))) {
+                    std::vector<int> cpus;
+                    for (const int cpu : osmium::detail::parse_cpu_list(osmium::detail::read_first_line(base + "node" + std::to_string(node) + "/cpulist"))) {
+                        if (cpu_allowed(allowed, cpu)) {
+                            cpus.push_back(cpu);
+                        }
+                    }
+                    if (!cpus.empty()) {
+                        m_num_cpus += cpus.size();
+                        m_node_ids.push_back(node);
+                        m_node_cpus.push_back(std::move(cpus));
+                    }
+                }
+            }
+#endif
+
+        public:
+
+            /**
+             * Read the topology of the machine we are running on. Usually
+             * you want to use the cached version from system() instead.
+             */
+            NumaTopology() {
+#ifdef __linux__
+                read_from_sys();
+#endif
+                if (m_node_cpus.empty()) {
+                    const auto num_cpus = std::max(1U, std::thread::hardware_concurrency());
+                    std::vector<int> cpus;
+                    for (unsigned cpu = 0; cpu < num_cpus; ++cpu) {
+                        cpus.push_back(static_cast<int>(cpu));
+                    }
+                    m_num_cpus = cpus.size();
+                    m_node_ids.push_back(0);
+                    m_node_cpus.push_back(std::move(cpus));
+                }
+            }
+
+            /**
+             * The topology of this machine. It is read only once on first
+             * use.
+             */
+            static const NumaTopology& system() {
+                static const NumaTopology topology{};
+                return topology;
+            }
+
+            /// The number of NUMA nodes (with usable CPUs). Always >= 1.
+            std::size_t num_nodes() const noexcept {
+                return m_node_cpus.size();
+            }
+
+            /// The number of usable CPUs on all nodes. Always >= 1.
+            std::size_t num_cpus() const noexcept {
+                return m_num_cpus;
+            }
+
+            /**
+             * The node number (as used by the operating system) of the
+             * nth node.
+             *
+             * @pre @code n < num_nodes() @endcode
+             */
+            int node_id(std::size_t n) const {
+                return m_node_ids[n];
+            }
+
+            /**
+             * The CPUs of the nth node.
+             *
+             * @pre @code n < num_nodes() @endcode
+             */
+            const std::vector<int>& cpus(std::size_t n) const {
+                return m_node_cpus[n];
+            }
+
+            /**
+             * The CPU the nth thread of a thread pool should run on.
+             * Threads are distributed round-robin over the nodes so that
+             * all nodes get their share of the work.
+             */
+            int cpu_for_thread(std::size_t n) const {
+                const auto& node_cpus = m_node_cpus[n % m_node_cpus.size()];
+                return node_cpus[(n / m_node_cpus.size()) % node_cpus.size()];
+            }
+
+        }; // class NumaTopology
+
+        /**
+         * Set the NUMA memory policy for the given memory range. The
+         * memory must be page aligned, for instance memory from mmap().
+         * This has only an effect for memory not touched yet.
+         *
+         * With numa_policy::interleave the pages are distributed
+         * round-robin over all nodes. This is a good choice for large
+         * indexes accessed from threads running on all nodes. With
+         * numa_policy::local the memory is allocated on the node of the
+         * thread first touching it (which is the default for most
+         * systems).
+         *
+         * This is only implemented on Linux (using mbind()), on other
+         * systems it does nothing.
+         *
+         * @returns true if the policy was set, false otherwise.
+         */
+        inline bool set_numa_policy(void* addr, std::size_t size, osmium::config::numa_policy policy, const NumaTopology& topology = NumaTopology::system()) noexcept {
+#if defined(__linux__) && defined(SYS_mbind)
+            if (policy == osmium::config::numa_policy::local) {
+                return ::syscall(SYS_mbind, addr, size, osmium::detail::mpol_local, nullptr, 0, 0) == 0;
+            }
+            if (policy == osmium::config::numa_policy::interleave) {
+                constexpr const std::size_t bits = sizeof(unsigned long) * 8; // NOLINT(google-runtime-int)
+                std::vector<unsigned long> mask; // NOLINT(google-runtime-int)
+                try {
+                    for (std::size_t n = 0; n < topology.num_nodes(); ++n) {
+                        const auto node = static_cast<std::size_t>(topology.node_id(n));
+                        if (mask.size() <= node / bits) {
+                            mask.resize(node / bits + 1);
+                        }
+                        mask[node / bits] |= 1UL << (node % bits);
+                    }
+                } catch (...) {
+                    return false;
+                }
+                // The kernel expects the maximum node number plus one.
+                return ::syscall(SYS_mbind, addr, size, osmium::detail::mpol_interleave, mask.data(), mask.size() * bits + 1, 0) == 0;
+            }
+#endif
+            return false;
+        }
+
+        /**
+         * Pin the current thread to the given CPU.
+         *
+         * This is only implemented on Linux, on other systems it does
+         * nothing.
+         *
+         * @returns true if the thread was pinned, false otherwise.
+         */
+        inline bool pin_current_thread_to_cpu(int cpu) noexcept {
+#ifdef __linux__
+            if (cpu < 0 || cpu >= CPU_SETSIZE) {
+                return false;
+            }
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(cpu, &cpus); // NOLINT(hicpp-signed-bitwise)
+            return ::pthread_setaffinity_np(::pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+            (void)cpu;
+            return false;
+#endif
+        }
+
+        /**
+         * Restrict the current thread to the CPUs of the nth NUMA node
+         * of the topology.
+         *
+         * This is only implemented on Linux, on other systems it does
+         * nothing.
+         *
+         * @returns true if the thread was pinned, false otherwise.
+         */
+        inline bool pin_current_thread_to_node(std::size_t n, const NumaTopology& topology = NumaTopology::system()) noexcept {
+#ifdef __linux__
+            if (n >= topology.num_nodes()) {
+                return false;
+            }
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            for (const int cpu : topology.cpus(n)) {
+                CPU_SET(cpu, &cpus); // NOLINT(hicpp-signed-bitwise)
+            }
+            return ::pthread_setaffinity_np(::pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+            (void)n;
+            (void)topology;
+            return false;
+#endif
+        }
+
+    } // namespace util
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_NUMA_HPP
@@ -0,0 +1,411 @@
+#ifndef OSMIUM_UTIL_TRACE_HPP
+#define OSMIUM_UTIL_TRACE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @file
+ *
+ * Tracing of the work done in the different threads when reading and
+ * writing OSM files. The trace is written in the Chrome trace event
+ * format (JSON) which can be viewed with chrome://tracing or Perfetto.
+ *
+ * Tracing is only available if OSMIUM_WITH_TRACE is defined before
+ * including any Osmium header. Otherwise all classes in this file do
+ * nothing and the compiler will remove them completely.
+ */
+
+#ifdef OSMIUM_WITH_TRACE
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+# include <sys/prctl.h>
+#endif
+
+namespace osmium {
+
+    namespace detail {
+
+        struct trace_event {
+            const char* name;
+            std::int64_t start; // nanoseconds since start of the session
+            std::int64_t duration; // nanoseconds
+            std::uint64_t sequence;
+        }; // struct trace_event
+
+        /// The events recorded in one thread.
+        struct trace_thread_buffer {
+
+            std::mutex mutex{};
+            std::vector<trace_event> events{};
+            int id;
+            std::string thread_name;
+
+            trace_thread_buffer(int thread_id, std::string name) :
+                id(thread_id),
+                thread_name(std::move(name)) {
+            }
+
+        }; // struct trace_thread_buffer
+
+        inline std::string current_thread_name() {
+#ifdef __linux__
+            char name[17] = {0};
+            if (prctl(PR_GET_NAME, name, 0, 0, 0) == 0) {
+                return name;
+            }
+#endif
+            return "";
+        }
+
+        /**
+         * Global state of the tracing. Events are recorded into a buffer
+         * per thread, so threads don't have to synchronize with each
+         * other.
+         */
+        class trace_registry {
+
+            std::mutex m_mutex{};
+            std::vector<std::shared_ptr<trace_thread_buffer>> m_buffers{};
+            int m_next_id = 1;
+
+            // Start of the session in nanoseconds since the epoch of the
+            // steady clock. Atomic because spans read it from any thread.
+            std::atomic<std::int64_t> m_start{now_ns()};
+
+            std::atomic<bool> m_active{false};
+
+            static std::int64_t now_ns() noexcept {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            }
+
+        public:
+
+            static trace_registry& instance() {
+                static trace_registry registry;
+                return registry;
+            }
+
+            bool active() const noexcept {
+                return m_active.load(std::memory_order_relaxed);
+            }
+
+            std::chrono::steady_clock::time_point start_time() const noexcept {
+                return std::chrono::steady_clock::time_point{std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds{m_start.load()})};
+            }
+
+            /**
+             * Start a new session. All events are removed and the buffers
+             * of threads that have finished are released. (They are kept
+             * until then, because their events still have to be written.)
+             */
+            void start() {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                // The registry holds the only reference to the buffer of
+                // a thread that has finished.
+                m_buffers.erase(std::remove_if(m_buffers.begin(), m_buffers.end(), [](const std::shared_ptr<trace_thread_buffer>& buffer) {
+                    return buffer.use_count() == 1;
+                }), m_buffers.end());
+                for (auto& buffer : m_buffers) {
+                    std::lock_guard<std::mutex> buffer_lock{buffer->mutex};
+                    buffer->events.clear();
+                }
+                m_start = now_ns();
+                m_active = true;
+            }
+
+            void stop() noexcept {
+                m_active = false;
+            }
+
+            trace_thread_buffer& thread_buffer() {
+                static thread_local std::shared_ptr<trace_thread_buffer> buffer;
+                if (!buffer) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    buffer = std::make_shared<trace_thread_buffer>(m_next_id++, current_thread_name());
+                    m_buffers.push_back(buffer);
+                }
+                return *buffer;
+            }
+
+            void add(const trace_event& event) {
+                auto& buffer = thread_buffer();
+                std::lock_guard<std::mutex> lock{buffer.mutex};
+                buffer.events.push_back(event);
+            }
+
+            std::size_t num_events() {
+                std::size_t count = 0;
+                std::lock_guard<std::mutex> lock{m_mutex};
+                for (auto& buffer : m_buffers) {
+                    std::lock_guard<std::mutex> buffer_lock{buffer->mutex};
+                    count += buffer->events.size();
+                }
+                return count;
+            }
+
+            template <typename TFunction>
+            void for_each_buffer(TFunction&& function) {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                for (auto& buffer : m_buffers) {
+                    std::lock_guard<std::mutex> buffer_lock{buffer->mutex};
+                    std::forward<TFunction>(function)(*buffer);
+                }
+            }
+
+        }; // class trace_registry
+
+        inline void write_json_string(std::ostream& out, const std::string& str) {
+            out << '"';
+            for (const char c : str) {
+                if (c == '"' || c == '\\') {
+                    out << '\\' << c;
+                } else if (static_cast<unsigned char>(c) >= 0x20) {
+                    out << c;
+                }
+            }
+            out << '"';
+        }
+
+    } // namespace detail
+
+    /**
+     * Records the time from its construction to its destruction as one
+     * span in the trace if a TraceSession is active.
+     */
+    class TraceSpan {
+
+        std::chrono::steady_clock::time_point m_start{};
+        const char* m_name;
+        std::uint64_t m_sequence;
+
+    public:
+
+        /**
+         * Start a span.
+         *
+         * @param name Name of the span. Must be a string literal (or
+         *             otherwise live as long as the trace).
+         * @param sequence Sequence number of the data handled in this
+         *                 span (for instance the number of the block).
+         */
+        explicit TraceSpan(const char* name, std::uint64_t sequence = 0) noexcept :
+            m_name(detail::trace_registry::instance().active() ? name : nullptr),
+            m_sequence(sequence) {
+            if (m_name) {
+                m_start = std::chrono::steady_clock::now();
+            }
+        }
+
+        TraceSpan(const TraceSpan&) = delete;
+        TraceSpan& operator=(const TraceSpan&) = delete;
+
+        TraceSpan(TraceSpan&&) = delete;
+        TraceSpan& operator=(TraceSpan&&) = delete;
+
+        ~TraceSpan() noexcept {
+            if (!m_name) {
+                return;
+            }
+            auto& registry = detail::trace_registry::instance();
+            const auto now = std::chrono::steady_clock::now();
+            try {
+                registry.add(detail::trace_event{
+                    m_name,
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(m_start - registry.start_time()).count(),
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_start).count(),
+                    m_sequence
+                });
+            } catch (...) {
+                // ignore events that can't be recorded
+            }
+        }
+
+    }; // class TraceSpan
+
+    /**
+     * Write all events recorded so far in the Chrome trace event format.
+     */
+    inline void write_chrome_trace(std::ostream& out) {
+        out << "{\"traceEvents\":[\n";
+        bool first = true;
+        const auto separator = [&out, &first]() {
+            if (!first) {
+                out << ",\n";
+            }
+            first = false;
+        };
+        out << std::fixed << std::setprecision(3);
+        detail::trace_registry::instance().for_each_buffer([&](const detail::trace_thread_buffer& buffer) {
+            separator();
+            out << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer.id << R"(,"args":{"name":)";
+            detail::write_json_string(out, buffer.thread_name.empty() ? "thread " + std::to_string(buffer.id) : buffer.thread_name);
+            out << "}}";
+            for (const auto& event : buffer.events) {
+                separator();
+                out << R"({"name":)";
+                detail::write_json_string(out, event.name);
+                out << R"(,"cat":"osmium","ph":"X","pid":1,"tid":)" << buffer.id
+                    << R"(,"ts":)" << static_cast<double>(event.start) / 1000.0
+                    << R"(,"dur":)" << static_cast<double>(event.duration) / 1000.0
+                    << R"(,"args":{"seq":)" << event.sequence << "}}";
+            }
+        });
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+
+    /**
+     * While an object of this class exists, TraceSpans are recorded. When
+     * it is closed or destroyed, the trace is written to the file given
+     * in the constructor. Only one session should exist at a time.
+     *
+     * Usage:
+     * @code
+     * osmium::TraceSession session{"trace.json"};
+     * ... read and write OSM files ...
+     * session.close();
+     * @endcode
+     */
+    class TraceSession {
+
+        std::string m_filename;
+        bool m_closed = false;
+
+    public:
+
+        explicit TraceSession(std::string filename) :
+            m_filename(std::move(filename)) {
+            detail::trace_registry::instance().start();
+        }
+
+        TraceSession(const TraceSession&) = delete;
+        TraceSession& operator=(const TraceSession&) = delete;
+
+        TraceSession(TraceSession&&) = delete;
+        TraceSession& operator=(TraceSession&&) = delete;
+
+        ~TraceSession() noexcept {
+            try {
+                close();
+            } catch (...) {
+                // Ignore any exceptions because destructor must not throw.
+            }
+        }
+
+        /// The number of events recorded so far.
+        std::size_t num_events() const {
+            return detail::trace_registry::instance().num_events();
+        }
+
+        /**
+         * Stop recording and write the trace file.
+         *
+         * @throws std::system_error If the file can't be written.
+         */
+        void close() {
+            if (m_closed) {
+                return;
+            }
+            m_closed = true;
+            detail::trace_registry::instance().stop();
+            std::ofstream out{m_filename};
+            if (!out) {
+                throw std::system_error{errno, std::system_category(), std::string{"Can not open trace file '"} + m_filename + "'"};
+            }
+            write_chrome_trace(out);
+            out.close();
+            if (!out) {
+                throw std::system_error{errno, std::system_category(), std::string{"Error writing trace file '"} + m_filename + "'"};
+            }
+        }
+
+    }; // class TraceSession
+
+} // namespace osmium
+
+#else
+
+#include <cstddef>
+#include <ostream>
+
+namespace osmium {
+
+    class TraceSpan {
+
+    public:
+
+        explicit TraceSpan(const char* /*name*/, std::uint64_t /*sequence*/ = 0) noexcept {
+        }
+
+    }; // class TraceSpan
+
+    inline void write_chrome_trace(std::ostream& /*out*/) {
+    }
+
+    class TraceSession {
+
+    public:
+
+        explicit TraceSession(const std::string& /*filename*/) {
+        }
+
+        std::size_t num_events() const noexcept {
+            return 0;
+        }
+
+        void close() {
+        }
+
+    }; // class TraceSession
+
+} // namespace osmium
+
+#endif
+
+#endif // OSMIUM_UTIL_TRACE_HPP
@@ -92,7 +92,9 @@ static header_buffer_type parse_xml(std::string input) {
         output_queue,
         header_promise,
         osmium::osm_entity_bits::all,
-        osmium::io::read_meta::yes
+        osmium::io::read_meta::yes,
+        nullptr,
+        nullptr
     };
     osmium::io::detail::XMLParser parser{args};
     parser.parse();
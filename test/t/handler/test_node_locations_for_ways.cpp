@@ -0,0 +1,283 @@
+#include "catch.hpp"
+
+#include <osmium/handler/check_order.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/handler/node_locations_for_ways_stages.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/opl.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pipeline.hpp>
+#include <osmium/visitor.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using sparse_index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+static osmium::memory::Buffer create_buffer(int num_ways, bool missing_node = false, bool sorted_nodes = false) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    // Nodes out of order (unless sorted_nodes is set) so that the index
+    // needs sorting.
+    for (int n = 1; n <= 1000; ++n) {
+        const int i = sorted_nodes ? n : 1001 - n;
+        REQUIRE(osmium::opl_parse(("n" + std::to_string(i) + " x" + std::to_string(i / 10) + "." + std::to_string(i % 10) + " y1").c_str(), buffer));
+    }
+    // The negative id is out of order, too.
+    if (!sorted_nodes) {
+        REQUIRE(osmium::opl_parse("n-5 x-0.5 y-1", buffer));
+    }
+
+    for (int i = 1; i <= num_ways; ++i) {
+        std::string line{"w" + std::to_string(i) + " N"};
+        for (int j = 0; j < 10; ++j) {
+            line += "n" + std::to_string((i * 37 + j * 101) % 1000 + 1) + ",";
+        }
+        if (missing_node && i == num_ways / 2) {
+            line += "n2000";
+        } else {
+            line += sorted_nodes ? "n1000" : "n-5";
+        }
+        REQUIRE(osmium::opl_parse(line.c_str(), buffer));
+    }
+
+    return buffer;
+}
+
+static void check_locations(const osmium::memory::Buffer& buffer, int num_ways) {
+    int count = 0;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        for (const auto& node_ref : way.nodes()) {
+            REQUIRE(node_ref.location().valid());
+            REQUIRE(node_ref.location().x() == node_ref.ref() * osmium::detail::coordinate_precision / 10);
+        }
+        ++count;
+    }
+    REQUIRE(count == num_ways);
+}
+
+TEST_CASE("NodeLocationsForWays with apply") {
+    auto buffer = create_buffer(100);
+
+    sparse_index_type index_pos;
+    sparse_index_type index_neg;
+    osmium::handler::NodeLocationsForWays<sparse_index_type, sparse_index_type> handler{index_pos, index_neg};
+    osmium::apply(buffer, handler);
+
+    check_locations(buffer, 100);
+    REQUIRE(handler.get_node_location(17) == (osmium::Location{1.7, 1.0}));
+}
+
+TEST_CASE("NodeLocationsForWays with apply_buffer") {
+    for (const int num_ways : {1, 100, 2000}) {
+        auto buffer = create_buffer(num_ways);
+
+        sparse_index_type index_pos;
+        sparse_index_type index_neg;
+        osmium::handler::NodeLocationsForWays<sparse_index_type, sparse_index_type> handler{index_pos, index_neg};
+        handler.apply_buffer(buffer);
+
+        check_locations(buffer, num_ways);
+    }
+}
+
+TEST_CASE("NodeLocationsForWays with apply_buffer and sorted nodes") {
+    auto buffer = create_buffer(1000, false, true);
+
+    sparse_index_type index_pos;
+    sparse_index_type index_neg;
+    osmium::handler::NodeLocationsForWays<sparse_index_type, sparse_index_type> handler{index_pos, index_neg};
+    handler.apply_buffer(buffer);
+
+    check_locations(buffer, 1000);
+
+    // The lookup table used for finding ids and prefetching in
+    // get_many() is only built by sort(), it needs memory on top of
+    // the vector.
+    REQUIRE(index_pos.size() == 1000);
+    REQUIRE(index_pos.used_memory() > index_pos.size() * sizeof(sparse_index_type::element_type));
+}
+
+TEST_CASE("NodeLocationsForWays with apply_buffer and dense index") {
+    using index_type = osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>;
+
+    auto buffer = create_buffer(1000);
+
+    index_type index_pos{true};
+    index_type index_neg;
+    osmium::handler::NodeLocationsForWays<index_type, index_type> handler{index_pos, index_neg};
+    handler.apply_buffer(buffer);
+
+    check_locations(buffer, 1000);
+}
+
+TEST_CASE("NodeLocationsForWays with apply_buffer and missing node") {
+    auto buffer = create_buffer(1000, true);
+
+    sparse_index_type index_pos;
+    sparse_index_type index_neg;
+    osmium::handler::NodeLocationsForWays<sparse_index_type, sparse_index_type> handler{index_pos, index_neg};
+
+    SECTION("throws") {
+        REQUIRE_THROWS_AS(handler.apply_buffer(buffer), const osmium::not_found&);
+    }
+
+    SECTION("ignores errors") {
+        handler.ignore_errors();
+        handler.apply_buffer(buffer);
+
+        int missing = 0;
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            for (const auto& node_ref : way.nodes()) {
+                if (!node_ref.location()) {
+                    REQUIRE(node_ref.ref() == 2000);
+                    ++missing;
+                }
+            }
+        }
+        REQUIRE(missing == 1);
+    }
+}
+
+TEST_CASE("NodeLocationsForWays with apply_buffer, sorted nodes, and missing node") {
+    auto buffer = create_buffer(1000, true, true);
+
+    sparse_index_type index_pos;
+    sparse_index_type index_neg;
+    osmium::handler::NodeLocationsForWays<sparse_index_type, sparse_index_type> handler{index_pos, index_neg};
+    handler.ignore_errors();
+    handler.apply_buffer(buffer);
+
+    int missing = 0;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        for (const auto& node_ref : way.nodes()) {
+            if (!node_ref.location()) {
+                REQUIRE(node_ref.ref() == 2000);
+                ++missing;
+            } else {
+                REQUIRE(node_ref.location().x() == node_ref.ref() * osmium::detail::coordinate_precision / 10);
+            }
+        }
+    }
+    REQUIRE(missing == 1);
+}
+
+// Source returning the buffer in pieces of num_items items.
+class SplitSource {
+
+    std::vector<osmium::memory::Buffer> m_buffers;
+    std::size_t m_next = 0;
+
+public:
+
+    SplitSource(const osmium::memory::Buffer& buffer, int num_items) {
+        int count = 0;
+        for (const auto& item : buffer) {
+            if (count % num_items == 0) {
+                m_buffers.emplace_back(1024, osmium::memory::Buffer::auto_grow::yes);
+            }
+            m_buffers.back().add_item(item);
+            m_buffers.back().commit();
+            ++count;
+        }
+    }
+
+    osmium::memory::Buffer read() {
+        if (m_next == m_buffers.size()) {
+            return osmium::memory::Buffer{};
+        }
+        return std::move(m_buffers[m_next++]);
+    }
+
+}; // class SplitSource
+
+TEST_CASE("NodeLocationsForWays in pipeline stages") {
+    const auto input = create_buffer(2000);
+    SplitSource source{input, 50};
+
+    sparse_index_type index_pos;
+    sparse_index_type index_neg;
+    osmium::handler::NodeLocationsForWays<sparse_index_type, sparse_index_type> handler{index_pos, index_neg};
+
+    osmium::thread::Pipeline pipeline{4};
+    osmium::handler::add_node_locations_stages(pipeline, handler, 3);
+    REQUIRE(pipeline.num_stages() == 2);
+
+    osmium::memory::Buffer output{1024, osmium::memory::Buffer::auto_grow::yes};
+    pipeline.run(source, [&output](osmium::memory::Buffer&& buffer) {
+        for (const auto& item : buffer) {
+            output.add_item(item);
+            output.commit();
+        }
+    });
+
+    check_locations(output, 2000);
+
+    // Ways still come out in the original order.
+    osmium::object_id_type last_id = 0;
+    for (const auto& way : output.select<osmium::Way>()) {
+        REQUIRE(way.id() == last_id + 1);
+        last_id = way.id();
+    }
+}
+
+TEST_CASE("NodeLocationsForWays in pipeline stages with sorted nodes") {
+    const auto input = create_buffer(2000, false, true);
+    SplitSource source{input, 50};
+
+    sparse_index_type index_pos;
+    sparse_index_type index_neg;
+    osmium::handler::NodeLocationsForWays<sparse_index_type, sparse_index_type> handler{index_pos, index_neg};
+
+    osmium::thread::Pipeline pipeline{4};
+    osmium::handler::add_node_locations_stages(pipeline, handler, 3);
+
+    osmium::memory::Buffer output{1024, osmium::memory::Buffer::auto_grow::yes};
+    pipeline.run(source, [&output](osmium::memory::Buffer&& buffer) {
+        for (const auto& item : buffer) {
+            output.add_item(item);
+            output.commit();
+        }
+    });
+
+    // The lookups went through get_many() of the sparse index with its
+    // lookup table, which does the prefetching.
+    REQUIRE(index_pos.used_memory() > index_pos.size() * sizeof(sparse_index_type::element_type));
+    check_locations(output, 2000);
+}
+
+TEST_CASE("NodeLocationsForWays in pipeline stages with missing node") {
+    const auto input = create_buffer(500, true);
+    SplitSource source{input, 100};
+
+    sparse_index_type index_pos;
+    sparse_index_type index_neg;
+    osmium::handler::NodeLocationsForWays<sparse_index_type, sparse_index_type> handler{index_pos, index_neg};
+
+    osmium::thread::Pipeline pipeline;
+    osmium::handler::add_node_locations_stages(pipeline, handler, 2);
+
+    REQUIRE_THROWS_AS(pipeline.run(source, [](osmium::memory::Buffer&& /*buffer*/) {
+    }), const osmium::not_found&);
+}
+
+TEST_CASE("NodeLocationsForWays in pipeline stages with node after way") {
+    auto input = create_buffer(10);
+    REQUIRE(osmium::opl_parse("n5000 x1 y1", input));
+    SplitSource source{input, 100};
+
+    sparse_index_type index_pos;
+    sparse_index_type index_neg;
+    osmium::handler::NodeLocationsForWays<sparse_index_type, sparse_index_type> handler{index_pos, index_neg};
+
+    osmium::thread::Pipeline pipeline;
+    osmium::handler::add_node_locations_stages(pipeline, handler, 2);
+
+    REQUIRE_THROWS_AS(pipeline.run(source, [](osmium::memory::Buffer&& /*buffer*/) {
+    }), const osmium::out_of_order_error&);
+}
@@ -0,0 +1,100 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/node_locations_updater.hpp>
+#include <osmium/index/map/dense_cache_file.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/updatable_sparse_file_array.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstdio>
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::memory::Buffer create_changes() {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_node(buffer, _id(1), _version(2), _location(1.0, 1.5));
+    osmium::builder::add_node(buffer, _id(2), _version(3), _visible(false));
+    osmium::builder::add_node(buffer, _id(4), _version(1), _location(4.0, 4.5));
+    osmium::builder::add_node(buffer, _id(4), _version(2), _location(4.1, 4.6));
+    osmium::builder::add_node(buffer, _id(-7), _version(1), _location(7.0, 7.5));
+
+    return buffer;
+}
+
+template <typename TIndex>
+static void fill_index(TIndex& index) {
+    index.set(1, osmium::Location{1.0, 1.0});
+    index.set(2, osmium::Location{2.0, 2.0});
+    index.set(3, osmium::Location{3.0, 3.0});
+}
+
+template <typename TIndex>
+static void check_index(const TIndex& index) {
+    REQUIRE(index.get(1) == osmium::Location(1.0, 1.5));
+    REQUIRE(index.get_noexcept(2) == osmium::Location{});
+    REQUIRE(index.get(3) == osmium::Location(3.0, 3.0));
+    REQUIRE(index.get(4) == osmium::Location(4.1, 4.6));
+}
+
+TEST_CASE("Update dense index with changes") {
+    using index_type = osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+    index_type index_pos;
+    index_type index_neg;
+    fill_index(index_pos);
+
+    osmium::handler::NodeLocationsUpdater<index_type, index_type> handler{index_pos, index_neg};
+    auto buffer = create_changes();
+    osmium::apply(buffer, handler);
+
+    REQUIRE(handler.updated() == 4);
+    REQUIRE(handler.removed() == 1);
+    check_index(index_pos);
+    REQUIRE(index_neg.get(7) == osmium::Location(7.0, 7.5));
+}
+
+TEST_CASE("Update dense cache file with changes") {
+    using index_type = osmium::index::map::DenseCacheFile<osmium::unsigned_object_id_type, osmium::Location>;
+    index_type index;
+    fill_index(index);
+    REQUIRE(index.count() == 3);
+
+    osmium::handler::NodeLocationsUpdater<index_type> handler{index};
+    auto buffer = create_changes();
+    osmium::apply(buffer, handler);
+
+    check_index(index);
+    REQUIRE(index.count() == 3);
+    index.commit();
+    REQUIRE(index.verify());
+}
+
+TEST_CASE("Update sparse index with changes") {
+    using index_type = osmium::index::map::UpdatableSparseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
+    const std::string filename{"test_node_locations_updater.idx"};
+    {
+        index_type index{filename};
+        fill_index(index);
+        index.merge();
+
+        osmium::handler::NodeLocationsUpdater<index_type> handler{index};
+        auto buffer = create_changes();
+        osmium::apply(buffer, handler);
+        index.checkpoint();
+
+        check_index(index);
+    }
+    {
+        index_type index{filename};
+        check_index(index);
+        index.merge();
+        REQUIRE(index.size() == 3);
+    }
+    std::remove(filename.c_str());
+    std::remove((filename + ".log").c_str());
+}
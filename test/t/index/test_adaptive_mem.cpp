@@ -0,0 +1,188 @@
+#include "catch.hpp"
+
+#include <osmium/index/map/adaptive_mem.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using index_type = osmium::index::map::AdaptiveMem<osmium::unsigned_object_id_type, osmium::Location>;
+
+static osmium::Location loc(osmium::unsigned_object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id % 1000000), static_cast<int32_t>(id / 1000000)};
+}
+
+static void check_range(const index_type& index, osmium::unsigned_object_id_type first, osmium::unsigned_object_id_type last, osmium::unsigned_object_id_type step) {
+    for (osmium::unsigned_object_id_type id = first; id < last; ++id) {
+        if ((id - first) % step == 0) {
+            REQUIRE(index.get(id) == loc(id));
+        } else {
+            REQUIRE(index.get_noexcept(id) == osmium::Location{});
+        }
+    }
+}
+
+TEST_CASE("AdaptiveMem chooses storage for each block") {
+    index_type index;
+
+    // Block 0: few ids
+    for (osmium::unsigned_object_id_type id = 10; id < 60000; id += 1000) {
+        index.set(id, loc(id));
+    }
+    // Block 1: every fourth id
+    for (osmium::unsigned_object_id_type id = 65536; id < 2 * 65536; id += 4) {
+        index.set(id, loc(id));
+    }
+    // Block 2: all ids
+    for (osmium::unsigned_object_id_type id = 2 * 65536; id < 3 * 65536; ++id) {
+        index.set(id, loc(id));
+    }
+
+    // Much smaller than a dense index for these blocks.
+    REQUIRE(index.used_memory() < 2 * 65536 * sizeof(osmium::Location));
+
+    // Far away block
+    index.set(20000000000ULL, loc(17));
+
+    const auto stats = index.stats();
+    REQUIRE(stats.sparse == 2);
+    REQUIRE(stats.bitmap == 1);
+    REQUIRE(stats.dense == 1);
+    REQUIRE(index.size() == 60 + 65536 / 4 + 65536 + 1);
+
+    check_range(index, 10, 60000, 1000);
+    check_range(index, 65536, 2 * 65536, 4);
+    check_range(index, 2 * 65536, 3 * 65536, 1);
+    REQUIRE(index.get(20000000000ULL) == loc(17));
+    REQUIRE(index.get_noexcept(20000000001ULL) == osmium::Location{});
+    REQUIRE(index.get_noexcept(3 * 65536) == osmium::Location{});
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    for (osmium::unsigned_object_id_type id = 0; id < 3 * 65536 + 100; id += 7) {
+        ids.push_back(id);
+    }
+    std::vector<osmium::Location> values(ids.size());
+    index.get_many(ids.data(), values.data(), ids.size());
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        REQUIRE(values[i] == index.get_noexcept(ids[i]));
+    }
+}
+
+TEST_CASE("AdaptiveMem can change existing values") {
+    index_type index;
+    for (osmium::unsigned_object_id_type id = 0; id < 20000; id += 2) {
+        index.set(id, loc(id));
+    }
+    REQUIRE(index.stats().bitmap == 1);
+
+    index.set(100, loc(1));
+    index.set(19998, loc(2));
+    REQUIRE(index.get(100) == loc(1));
+    REQUIRE(index.get(19998) == loc(2));
+    REQUIRE(index.get(102) == loc(102));
+    REQUIRE(index.size() == 10000);
+}
+
+TEST_CASE("AdaptiveMem with ids out of order needs sort") {
+    std::vector<osmium::unsigned_object_id_type> ids;
+    for (osmium::unsigned_object_id_type id = 1; id < 300000; id += 3) {
+        ids.push_back(id);
+    }
+    std::mt19937 gen{42};
+    std::shuffle(ids.begin(), ids.end(), gen);
+
+    index_type index;
+    for (const auto id : ids) {
+        index.set(id, loc(id));
+    }
+    index.set(4, loc(5));
+    index.set(4, loc(4));
+    index.sort();
+
+    REQUIRE(index.size() == ids.size());
+    check_range(index, 1, 300000, 3);
+    REQUIRE(index.stats().bitmap == 5);
+}
+
+TEST_CASE("AdaptiveMem converts blocks in sort") {
+    index_type index;
+    index.set(65535, loc(65535));
+    for (osmium::unsigned_object_id_type id = 0; id < 65535; ++id) {
+        index.set(id, loc(id));
+    }
+    REQUIRE(index.stats().sparse == 1);
+    REQUIRE(index.get_noexcept(0) == osmium::Location{});
+
+    index.sort();
+    REQUIRE(index.stats().dense == 1);
+    REQUIRE(index.size() == 65536);
+    check_range(index, 0, 65536, 1);
+
+    index.clear();
+    REQUIRE(index.size() == 0);
+    REQUIRE(index.get_noexcept(65535) == osmium::Location{});
+}
+
+TEST_CASE("AdaptiveMem keeps newer value if block becomes dense before sort") {
+    index_type index;
+    index.set(10, loc(10));
+    index.set(5, osmium::Location{2, 2});
+    for (osmium::unsigned_object_id_type id = 11; id < 65536; ++id) {
+        index.set(id, loc(id));
+    }
+    REQUIRE(index.stats().dense == 1);
+    index.set(5, osmium::Location{4, 4});
+    index.sort();
+
+    REQUIRE(index.get(5) == osmium::Location(4, 4));
+    REQUIRE(index.get(10) == loc(10));
+    REQUIRE(index.size() == 65527);
+}
+
+TEST_CASE("AdaptiveMem counts removed ids the same in all blocks") {
+    index_type index;
+    // Block 0 sparse, block 1 bitmap, block 2 dense
+    for (osmium::unsigned_object_id_type id = 0; id < 65536; id += 1000) {
+        index.set(id, loc(id));
+    }
+    for (osmium::unsigned_object_id_type id = 65536; id < 2 * 65536; id += 4) {
+        index.set(id, loc(id));
+    }
+    for (osmium::unsigned_object_id_type id = 2 * 65536; id < 3 * 65536; ++id) {
+        index.set(id, loc(id));
+    }
+    REQUIRE(index.stats().sparse == 1);
+    REQUIRE(index.stats().bitmap == 1);
+    REQUIRE(index.stats().dense == 1);
+    const std::size_t size = 66 + 16384 + 65536;
+    REQUIRE(index.size() == size);
+
+    index.set(2000, osmium::Location{});
+    index.set(65536 + 400, osmium::Location{});
+    index.set(2 * 65536 + 7, osmium::Location{});
+    REQUIRE(index.size() == size - 3);
+
+    // Removing an id that isn't there, at the end of a block, or twice
+    // doesn't change anything.
+    index.set(3001, osmium::Location{});
+    index.set(65535, osmium::Location{});
+    index.set(2000, osmium::Location{});
+    REQUIRE(index.size() == size - 3);
+
+    // Setting it again counts it again.
+    index.set(2000, loc(2000));
+    REQUIRE(index.size() == size - 2);
+
+    // Removing out of order (pending until sort()).
+    index.set(10, loc(10));
+    index.set(10, osmium::Location{});
+    index.sort();
+    REQUIRE(index.size() == size - 2);
+    REQUIRE(index.get_noexcept(10) == osmium::Location{});
+    REQUIRE(index.get_noexcept(65536 + 400) == osmium::Location{});
+    REQUIRE(index.get(65536 + 404) == loc(65536 + 404));
+    REQUIRE(index.get_noexcept(2 * 65536 + 7) == osmium::Location{});
+}
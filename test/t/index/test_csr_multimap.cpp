@@ -0,0 +1,135 @@
+#include "catch.hpp"
+
+#include <osmium/index/csr_multimap.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using id_type = uint64_t;
+using builder_type = osmium::index::CsrMultimapBuilder<id_type, uint32_t>;
+using map_type = osmium::index::CsrMultimap<id_type, uint32_t>;
+
+static map_type build(const std::vector<std::pair<id_type, uint32_t>>& data, osmium::thread::Pool* pool) {
+    builder_type builder;
+    for (const auto& p : data) {
+        builder.count(p.first);
+    }
+    builder.prepare(pool);
+    for (auto it = data.crbegin(); it != data.crend(); ++it) {
+        builder.set(it->first, it->second);
+    }
+    return builder.build(pool);
+}
+
+static void check(const map_type& map, const std::vector<std::pair<id_type, uint32_t>>& data) {
+    std::map<id_type, std::vector<uint32_t>> expected;
+    for (const auto& p : data) {
+        expected[p.first].push_back(p.second);
+    }
+    REQUIRE(map.size() == data.size());
+    for (auto& e : expected) {
+        std::sort(e.second.begin(), e.second.end());
+        const auto range = map.get_all(e.first);
+        REQUIRE(std::vector<uint32_t>(range.first, range.second) == e.second);
+        REQUIRE(map.count(e.first) == e.second.size());
+    }
+}
+
+TEST_CASE("Empty CsrMultimap") {
+    builder_type builder;
+    builder.prepare(nullptr);
+    const auto map = builder.build(nullptr);
+    REQUIRE(map.empty());
+    REQUIRE(map.size() == 0);
+    REQUIRE(map.count(17) == 0);
+    const auto range = map.get_all(17);
+    REQUIRE(range.first == range.second);
+}
+
+TEST_CASE("CsrMultimap with a few values") {
+    const std::vector<std::pair<id_type, uint32_t>> data = {
+        {17, 3}, {5, 1}, {17, 2}, {17, 9}, {100000, 1}, {5, 0}, {1ULL << 32U, 7}
+    };
+    const auto map = build(data, nullptr);
+    REQUIRE_FALSE(map.empty());
+    check(map, data);
+
+    REQUIRE(map.count(0) == 0);
+    REQUIRE(map.count(6) == 0);
+    REQUIRE(map.count(100001) == 0);
+    REQUIRE(map.count(1ULL << 33U) == 0);
+    REQUIRE(map.count(1ULL << 40U) == 0);
+
+    std::vector<uint32_t> values;
+    map.for_each(17, [&values](uint32_t v) {
+        values.push_back(v);
+    });
+    REQUIRE(values == (std::vector<uint32_t>{2, 3, 9}));
+}
+
+TEST_CASE("CsrMultimap with dense and wide blocks") {
+    osmium::thread::Pool pool{3};
+    std::vector<std::pair<id_type, uint32_t>> data;
+
+    // dense block: most ids in block 1 have values
+    for (id_type id = 65536; id < 65536 + 60000; ++id) {
+        data.emplace_back(id, static_cast<uint32_t>(id % 1000));
+        if (id % 3 == 0) {
+            data.emplace_back(id, static_cast<uint32_t>(id));
+        }
+    }
+
+    // wide block: more than 65535 values for a group of ids in block 3
+    for (uint32_t i = 0; i < 70000; ++i) {
+        data.emplace_back(3 * 65536 + 10 + (i % 2), i);
+    }
+    data.emplace_back(3 * 65536 + 1000, 42);
+
+    // sparse block
+    for (id_type id = 5 * 65536; id < 6 * 65536; id += 7) {
+        data.emplace_back(id, 1);
+        data.emplace_back(id, 2);
+    }
+
+    const auto map = build(data, &pool);
+    check(map, data);
+    REQUIRE(map.count(65536 + 60000) == 0);
+    REQUIRE(map.count(3 * 65536 + 12) == 0);
+    REQUIRE(map.count(5 * 65536 + 1) == 0);
+}
+
+TEST_CASE("CsrMultimap needs less memory than pairs") {
+    std::vector<std::pair<id_type, uint32_t>> data;
+    for (id_type id = 0; id < 1000000; ++id) {
+        data.emplace_back(id, static_cast<uint32_t>(id));
+        if (id % 4 == 0) {
+            data.emplace_back(id, static_cast<uint32_t>(id + 1));
+        }
+    }
+    const auto map = build(data, nullptr);
+    REQUIRE(map.used_memory() < data.size() * 16 / 2);
+}
+
+TEST_CASE("CsrMultimapBuilder detects wrong use") {
+    builder_type builder;
+    builder.count(10);
+    builder.count(10);
+    builder.prepare(nullptr);
+
+    REQUIRE_THROWS_AS(builder.set(11, 1), const osmium::not_found&);
+    REQUIRE_THROWS_AS(builder.set(1000000, 1), const osmium::not_found&);
+
+    builder.set(10, 1);
+    REQUIRE_THROWS_AS(builder.build(nullptr), const std::runtime_error&);
+
+    builder.set(10, 2);
+    REQUIRE_THROWS_AS(builder.set(10, 3), const std::runtime_error&);
+
+    const auto map = builder.build(nullptr);
+    REQUIRE(map.count(10) == 2);
+}
@@ -0,0 +1,138 @@
+#include "catch.hpp"
+
+#include <osmium/index/map/dense_compressed_array.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/node_locations_map.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+using index_type = osmium::index::map::DenseCompressedArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+TEST_CASE("Compressed dense index: empty") {
+    index_type index;
+    REQUIRE(index.size() == 0);
+    REQUIRE(index.get_noexcept(0) == osmium::Location{});
+    REQUIRE(index.get_noexcept(1000000) == osmium::Location{});
+    REQUIRE_THROWS_AS(index.get(17), const osmium::not_found&);
+}
+
+TEST_CASE("Compressed dense index: locations in increasing id order") {
+    std::mt19937 gen{42}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+    std::uniform_int_distribution<int32_t> step{-1000, 1000};
+    std::uniform_int_distribution<int> skip{1, 4};
+
+    std::vector<osmium::Location> locations(20000);
+    int32_t x = 100000000;
+    int32_t y = -50000000;
+    for (std::size_t id = 0; id < locations.size(); id += skip(gen)) {
+        x += step(gen);
+        y += step(gen);
+        locations[id] = osmium::Location{x, y};
+    }
+
+    index_type index;
+    for (std::size_t id = 0; id < locations.size(); ++id) {
+        if (locations[id]) {
+            index.set(id, locations[id]);
+        }
+        // reading while writing works
+        REQUIRE(index.get_noexcept(id) == locations[id]);
+    }
+    index.sort();
+
+    for (std::size_t id = 0; id < locations.size(); ++id) {
+        REQUIRE(index.get_noexcept(id) == locations[id]);
+    }
+
+    // Locations near each other need much less than 8 bytes per id.
+    REQUIRE(index.used_memory() < locations.size() * sizeof(osmium::Location) / 2);
+}
+
+TEST_CASE("Compressed dense index: extreme coordinates") {
+    const osmium::Location min_loc{-1800000000, -900000000};
+    const osmium::Location max_loc{1800000000, 900000000};
+    const osmium::Location invalid{std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max() - 1};
+
+    index_type index;
+    index.set(1, min_loc);
+    index.set(2, max_loc);
+    index.set(3, invalid);
+    index.set(5, osmium::Location{0, 0});
+    index.set(300, min_loc);
+    index.sort();
+
+    REQUIRE(index.get(1) == min_loc);
+    REQUIRE(index.get(2) == max_loc);
+    REQUIRE(index.get(3) == invalid);
+    REQUIRE_THROWS_AS(index.get(4), const osmium::not_found&);
+    REQUIRE(index.get(5) == osmium::Location(0, 0));
+    REQUIRE(index.get(300) == min_loc);
+    REQUIRE_THROWS_AS(index.get(299), const osmium::not_found&);
+}
+
+TEST_CASE("Compressed dense index: setting ids out of order") {
+    index_type index;
+    index.set(1000, osmium::Location{10, 20});
+    index.set(5, osmium::Location{1, 2});
+    index.set(1001, osmium::Location{11, 21});
+    index.set(6, osmium::Location{3, 4});
+    index.set(1000, osmium::Location{});
+
+    REQUIRE(index.get(5) == osmium::Location(1, 2));
+    REQUIRE(index.get(6) == osmium::Location(3, 4));
+    REQUIRE_THROWS_AS(index.get(1000), const osmium::not_found&);
+    REQUIRE(index.get(1001) == osmium::Location(11, 21));
+}
+
+TEST_CASE("Compressed dense index: sort() removes old versions of changed blocks") {
+    index_type index;
+    index_type in_order;
+    for (osmium::unsigned_object_id_type id = 0; id < 100; ++id) {
+        for (const osmium::unsigned_object_id_type block_start : {0, 256, 512}) {
+            index.set(block_start + id, osmium::Location{static_cast<int32_t>(id * 1000), static_cast<int32_t>(block_start)});
+        }
+    }
+    for (const osmium::unsigned_object_id_type block_start : {0, 256, 512}) {
+        for (osmium::unsigned_object_id_type id = 0; id < 100; ++id) {
+            in_order.set(block_start + id, osmium::Location{static_cast<int32_t>(id * 1000), static_cast<int32_t>(block_start)});
+        }
+    }
+    index.sort();
+    in_order.sort();
+
+    REQUIRE(index.used_memory() == in_order.used_memory());
+    for (osmium::unsigned_object_id_type id = 0; id < 768; ++id) {
+        REQUIRE(index.get_noexcept(id) == in_order.get_noexcept(id));
+    }
+
+    // Changing a block after sort() still works.
+    index.set(3, osmium::Location{5, 5});
+    index.sort();
+    REQUIRE(index.get(3) == osmium::Location(5, 5));
+    REQUIRE(index.get(259) == osmium::Location(3000, 256));
+    REQUIRE(index.get(611) == osmium::Location(99000, 512));
+}
+
+TEST_CASE("Compressed dense index: all y values the same") {
+    index_type index;
+    for (osmium::unsigned_object_id_type id = 0; id < 1000; ++id) {
+        index.set(id, osmium::Location{static_cast<int32_t>(id), 7});
+    }
+    index.sort();
+    for (osmium::unsigned_object_id_type id = 0; id < 1000; ++id) {
+        REQUIRE(index.get(id) == osmium::Location(static_cast<int32_t>(id), 7));
+    }
+}
+
+TEST_CASE("Compressed dense index: can be created through factory") {
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+    REQUIRE(map_factory.has_map_type("dense_compressed_array"));
+    auto index = map_factory.create_map("dense_compressed_array");
+    index->set(12, osmium::Location{1, 2});
+    REQUIRE(index->get(12) == osmium::Location(1, 2));
+}
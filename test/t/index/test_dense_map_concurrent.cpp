@@ -0,0 +1,102 @@
+#include "catch.hpp"
+
+#include <osmium/index/map/dense_file_array.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/dense_mmap_array.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <thread>
+#include <vector>
+
+static osmium::Location location_for(osmium::unsigned_object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id), static_cast<int32_t>(id * 2)};
+}
+
+template <typename TIndex>
+void test_set_range(TIndex& index) {
+    std::vector<osmium::Location> locations;
+    for (osmium::unsigned_object_id_type id = 10; id < 20; ++id) {
+        locations.push_back(location_for(id));
+    }
+
+    index.set_range(10, locations.cbegin(), locations.cend());
+    REQUIRE(index.size() >= 20);
+    for (osmium::unsigned_object_id_type id = 10; id < 20; ++id) {
+        REQUIRE(index.get(id) == location_for(id));
+    }
+    REQUIRE_THROWS_AS(index.get(9), const osmium::not_found&);
+    REQUIRE_THROWS_AS(index.get(20), const osmium::not_found&);
+
+    index.set_range(5, locations.cbegin(), locations.cbegin());
+    REQUIRE_THROWS_AS(index.get(5), const osmium::not_found&);
+}
+
+template <typename TIndex>
+void test_concurrent_set(TIndex& index) {
+    const int num_threads = 4;
+    const osmium::unsigned_object_id_type num_ids = 100000;
+
+    index.reserve_ids(num_ids - 1);
+    REQUIRE(index.size() == num_ids);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&index, t]() {
+            // Interleaved ids for half of the threads, ranges for the rest
+            if (t % 2 == 0) {
+                for (osmium::unsigned_object_id_type id = t / 2; id < num_ids / 2; id += num_threads / 2) {
+                    index.set_concurrent(id, location_for(id));
+                }
+            } else {
+                const auto chunk = num_ids / 2 / (num_threads / 2);
+                const auto first = num_ids / 2 + chunk * (t / 2);
+                std::vector<osmium::Location> locations;
+                for (auto id = first; id < first + chunk; ++id) {
+                    locations.push_back(location_for(id));
+                }
+                index.set_range(first, locations.cbegin(), locations.cend());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE(index.size() == num_ids);
+    for (osmium::unsigned_object_id_type id = 0; id < num_ids; ++id) {
+        REQUIRE(index.get_noexcept(id) == location_for(id));
+    }
+}
+
+TEST_CASE("Dense index: set_range and concurrent set on DenseMemArray") {
+    using index_type = osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+    test_set_range(index1);
+
+    index_type index2;
+    test_concurrent_set(index2);
+}
+
+#ifdef __linux__
+TEST_CASE("Dense index: set_range and concurrent set on DenseMmapArray") {
+    using index_type = osmium::index::map::DenseMmapArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+    test_set_range(index1);
+
+    index_type index2;
+    test_concurrent_set(index2);
+}
+#endif
+
+TEST_CASE("Dense index: set_range and concurrent set on DenseFileArray") {
+    using index_type = osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+    test_set_range(index1);
+
+    index_type index2;
+    test_concurrent_set(index2);
+}
@@ -1,12 +1,23 @@
 #include "catch.hpp"
 
 #include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/map/dense_cache_file.hpp>
 #include <osmium/index/map/dense_file_array.hpp>
 #include <osmium/index/map/sparse_file_array.hpp>
 #include <osmium/index/node_locations_map.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/types.hpp>
+#include <osmium/osm/timestamp.hpp>
 #include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifndef _WIN32
+# include <unistd.h>
+#endif
 
 TEST_CASE("File based dense index") {
     const int fd = osmium::detail::create_tmp_file();
@@ -41,6 +52,7 @@ TEST_CASE("File based dense index") {
         REQUIRE(index.size() == 7);
 
         index.sort();
+        index.flush();
 
         REQUIRE(loc1 == index.get(id1));
         REQUIRE(loc2 == index.get(id2));
@@ -156,3 +168,151 @@ TEST_CASE("File based sparse index") {
     }
 }
 
+
+TEST_CASE("Dense cache file") {
+    using index_type = osmium::index::map::DenseCacheFile<osmium::unsigned_object_id_type, osmium::Location>;
+
+    const int fd = osmium::detail::create_tmp_file();
+
+    const osmium::Location loc1{1.2, 4.5};
+    const osmium::Location loc2{3.5, -7.2};
+
+    {
+        index_type index{fd};
+        REQUIRE(index.size() == 0);
+        REQUIRE(index.count() == 0);
+        REQUIRE_FALSE(index.is_clean());
+
+        index.set(6, loc1);
+        index.set(3, loc2);
+        index.set(3, loc2);
+        index.set_timestamp(osmium::Timestamp{"2018-01-02T03:04:05Z"});
+        index.set_sequence_number(1234);
+
+        REQUIRE(index.size() == 7);
+        REQUIRE(index.count() == 2);
+        REQUIRE(index.min_id() == 3);
+        REQUIRE(index.max_id() == 6);
+
+        index.commit();
+        REQUIRE(index.is_clean());
+        REQUIRE(index.verify());
+    }
+
+    const auto size = osmium::file_size(fd);
+    REQUIRE(size > osmium::index::detail::cache_file_header_size);
+
+    {
+        index_type index{fd};
+        REQUIRE(index.is_clean());
+        REQUIRE(index.verify());
+        REQUIRE(index.header().layout == osmium::index::detail::cache_file_layout_dense);
+        REQUIRE(index.size() == 7);
+        REQUIRE(index.count() == 2);
+        REQUIRE(index.timestamp() == osmium::Timestamp{"2018-01-02T03:04:05Z"});
+        REQUIRE(index.sequence_number() == 1234);
+        REQUIRE(index.get(6) == loc1);
+        REQUIRE(index.get(3) == loc2);
+        REQUIRE_THROWS_AS(index.get(5), const osmium::not_found&);
+        REQUIRE(index.advise(osmium::MemoryMapping::access_advice::random));
+
+        // Update the cache, it grows and gets committed in the destructor.
+        index.set(3000000, loc1);
+        REQUIRE_FALSE(index.is_clean());
+    }
+
+    {
+        index_type index{fd};
+        REQUIRE(index.is_clean());
+        REQUIRE(index.verify());
+        REQUIRE(index.count() == 3);
+        REQUIRE(index.max_id() == 3000000);
+        REQUIRE(index.get(3000000) == loc1);
+        REQUIRE(index.get(6) == loc1);
+    }
+}
+
+TEST_CASE("Dense cache file is not clean after changing the header") {
+    using index_type = osmium::index::map::DenseCacheFile<osmium::unsigned_object_id_type, osmium::Location>;
+
+    const int fd = osmium::detail::create_tmp_file();
+    {
+        index_type index{fd};
+        index.set(3, osmium::Location{1.2, 4.5});
+    }
+
+    {
+        index_type index{fd};
+        REQUIRE(index.is_clean());
+        index.set_sequence_number(42);
+        REQUIRE_FALSE(index.is_clean());
+        index.set(6, osmium::Location{3.5, -7.2});
+        REQUIRE_FALSE(index.is_clean());
+        index.commit();
+        REQUIRE(index.is_clean());
+        REQUIRE(index.verify());
+    }
+
+    {
+        index_type index{fd};
+        REQUIRE(index.is_clean());
+        index.set_timestamp(osmium::Timestamp{"2018-01-02T03:04:05Z"});
+        REQUIRE_FALSE(index.is_clean());
+    }
+
+    index_type index{fd};
+    REQUIRE(index.is_clean());
+    REQUIRE(index.verify());
+    REQUIRE(index.sequence_number() == 42);
+    REQUIRE(index.timestamp() == osmium::Timestamp{"2018-01-02T03:04:05Z"});
+    REQUIRE(index.get(6) == osmium::Location(3.5, -7.2));
+}
+
+TEST_CASE("Dense cache file detects changes") {
+    using index_type = osmium::index::map::DenseCacheFile<osmium::unsigned_object_id_type, osmium::Location>;
+
+    const int fd = osmium::detail::create_tmp_file();
+    {
+        index_type index{fd};
+        index.set(6, osmium::Location{1.2, 4.5});
+    }
+
+    SECTION("corrupt data") {
+        const osmium::Location other{7.0, 7.0};
+        REQUIRE(::pwrite(fd, &other, sizeof(other), osmium::index::detail::cache_file_header_size + 6 * sizeof(other)) == sizeof(other));
+
+        index_type index{fd};
+        REQUIRE(index.is_clean());
+        REQUIRE_FALSE(index.verify());
+    }
+
+    SECTION("corrupt header") {
+        const uint64_t count = 17;
+        REQUIRE(::pwrite(fd, &count, sizeof(count), offsetof(osmium::index::detail::cache_file_header, count)) == sizeof(count));
+
+        REQUIRE_THROWS_AS(index_type{fd}, const osmium::index::cache_file_error&);
+    }
+
+    SECTION("wrong value type") {
+        using other_index_type = osmium::index::map::DenseCacheFile<osmium::unsigned_object_id_type, uint32_t>;
+        REQUIRE_THROWS_AS(other_index_type{fd}, const osmium::index::cache_file_error&);
+    }
+}
+
+TEST_CASE("Dense cache file rejects other files") {
+    using index_type = osmium::index::map::DenseCacheFile<osmium::unsigned_object_id_type, osmium::Location>;
+
+    const int fd = osmium::detail::create_tmp_file();
+
+    SECTION("too small") {
+        REQUIRE(::write(fd, "abc", 3) == 3);
+        REQUIRE_THROWS_AS(index_type{fd}, const osmium::index::cache_file_error&);
+        REQUIRE(osmium::file_size(fd) == 3);
+    }
+
+    SECTION("wrong magic") {
+        const std::vector<char> data(osmium::index::detail::cache_file_header_size, 'x');
+        REQUIRE(::write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+        REQUIRE_THROWS_WITH(index_type{fd}, "Not a cache file");
+    }
+}
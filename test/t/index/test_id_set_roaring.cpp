@@ -0,0 +1,255 @@
+#include "catch.hpp"
+
+#include <osmium/index/id_set_roaring.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using id_type = osmium::unsigned_object_id_type;
+using roaring_set = osmium::index::IdSetRoaring<id_type>;
+using roaring_view = osmium::index::IdSetRoaringView<id_type>;
+
+// Ids in several containers: few ids (array), many ids (bitmap), and
+// ranges (run after optimize()).
+static std::set<id_type> make_ids(unsigned seed) {
+    std::mt19937 gen{seed};
+    std::set<id_type> ids;
+    std::uniform_int_distribution<id_type> sparse{0, 1ULL << 20U};
+    for (int i = 0; i < 2000; ++i) {
+        ids.insert(sparse(gen));
+    }
+    std::uniform_int_distribution<id_type> dense{(1ULL << 32U), (1ULL << 32U) + 65535};
+    for (int i = 0; i < 30000; ++i) {
+        ids.insert(dense(gen));
+    }
+    const id_type start = (5ULL << 16U) + seed * 100;
+    for (id_type id = start; id < start + 20000; ++id) {
+        if (id % 1000 != 0) {
+            ids.insert(id);
+        }
+    }
+    return ids;
+}
+
+static roaring_set make_set(const std::set<id_type>& ids) {
+    roaring_set s;
+    for (const auto id : ids) {
+        s.set(id);
+    }
+    return s;
+}
+
+static std::vector<id_type> to_vector(const roaring_set& s) {
+    return std::vector<id_type>(s.begin(), s.end());
+}
+
+TEST_CASE("Basic functionality of IdSetRoaring") {
+    roaring_set s;
+
+    REQUIRE_FALSE(s.get(17));
+    REQUIRE(s.empty());
+    REQUIRE(s.size() == 0); // NOLINT(readability-container-size-empty)
+    REQUIRE(s.begin() == s.end());
+
+    s.set(17);
+    s.set(28);
+    s.set(1ULL << 40U);
+    REQUIRE(s.get(17));
+    REQUIRE(s.get(28));
+    REQUIRE(s.get(1ULL << 40U));
+    REQUIRE_FALSE(s.get(18));
+    REQUIRE_FALSE(s.get((1ULL << 40U) + 17));
+    REQUIRE(s.size() == 3);
+
+    REQUIRE_FALSE(s.check_and_set(17));
+    REQUIRE(s.check_and_set(99));
+    REQUIRE(s.size() == 4);
+
+    REQUIRE(to_vector(s) == (std::vector<id_type>{17, 28, 99, 1ULL << 40U}));
+
+    s.unset(28);
+    s.unset(1000);
+    REQUIRE_FALSE(s.get(28));
+    REQUIRE(s.size() == 3);
+
+    s.unset(1ULL << 40U);
+    REQUIRE(to_vector(s) == (std::vector<id_type>{17, 99}));
+
+    s.clear();
+    REQUIRE(s.empty());
+    REQUIRE_FALSE(s.get(17));
+}
+
+TEST_CASE("IdSetRoaring can be used through IdSet interface") {
+    roaring_set s;
+    osmium::index::IdSet<id_type>& base = s;
+    base.set(42);
+    REQUIRE(base.get(42));
+    REQUIRE_FALSE(base.empty());
+    REQUIRE(base.used_memory() > 0);
+}
+
+TEST_CASE("IdSetRoaring with all container types") {
+    const auto ids = make_ids(1);
+    auto s = make_set(ids);
+    REQUIRE(s.size() == ids.size());
+    REQUIRE(to_vector(s) == std::vector<id_type>(ids.begin(), ids.end()));
+
+    const auto memory = s.used_memory();
+    s.optimize();
+    REQUIRE(s.used_memory() < memory);
+    REQUIRE(s.size() == ids.size());
+    REQUIRE(to_vector(s) == std::vector<id_type>(ids.begin(), ids.end()));
+
+    for (id_type id = (5ULL << 16U); id < (6ULL << 16U) + 2000; ++id) {
+        REQUIRE(s.get(id) == (ids.count(id) == 1));
+    }
+}
+
+TEST_CASE("IdSetRoaring set and unset in all container types") {
+    auto ids = make_ids(2);
+    auto s = make_set(ids);
+    s.optimize();
+
+    std::mt19937 gen{17};
+    std::vector<id_type> candidates(ids.begin(), ids.end());
+    for (id_type id = (5ULL << 16U); id < (5ULL << 16U) + 30000; id += 7) {
+        candidates.push_back(id);
+    }
+    std::shuffle(candidates.begin(), candidates.end(), gen);
+    candidates.resize(20000);
+
+    std::bernoulli_distribution coin;
+    for (const auto id : candidates) {
+        if (coin(gen)) {
+            REQUIRE(s.check_and_set(id) == ids.insert(id).second);
+        } else {
+            s.unset(id);
+            ids.erase(id);
+        }
+    }
+
+    REQUIRE(s.size() == ids.size());
+    REQUIRE(to_vector(s) == std::vector<id_type>(ids.begin(), ids.end()));
+}
+
+TEST_CASE("IdSetRoaring set operations") {
+    const auto ids_a = make_ids(3);
+    const auto ids_b = make_ids(4);
+
+    std::vector<id_type> expected_union;
+    std::set_union(ids_a.begin(), ids_a.end(), ids_b.begin(), ids_b.end(), std::back_inserter(expected_union));
+    std::vector<id_type> expected_intersection;
+    std::set_intersection(ids_a.begin(), ids_a.end(), ids_b.begin(), ids_b.end(), std::back_inserter(expected_intersection));
+    std::vector<id_type> expected_difference;
+    std::set_difference(ids_a.begin(), ids_a.end(), ids_b.begin(), ids_b.end(), std::back_inserter(expected_difference));
+
+    for (int optimize = 0; optimize < 4; ++optimize) {
+        auto a = make_set(ids_a);
+        auto b = make_set(ids_b);
+        if (optimize & 1) {
+            a.optimize();
+        }
+        if (optimize & 2) {
+            b.optimize();
+        }
+
+        auto u = a;
+        u |= b;
+        REQUIRE(u.size() == expected_union.size());
+        REQUIRE(to_vector(u) == expected_union);
+
+        auto i = a;
+        i &= b;
+        REQUIRE(i.size() == expected_intersection.size());
+        REQUIRE(to_vector(i) == expected_intersection);
+
+        auto d = a;
+        d -= b;
+        REQUIRE(d.size() == expected_difference.size());
+        REQUIRE(to_vector(d) == expected_difference);
+    }
+}
+
+TEST_CASE("IdSetRoaring set operations with itself") {
+    const auto ids = make_ids(5);
+    auto s = make_set(ids);
+
+    s |= s;
+    REQUIRE(s.size() == ids.size());
+    s &= s;
+    REQUIRE(s.size() == ids.size());
+    s -= s;
+    REQUIRE(s.empty());
+}
+
+TEST_CASE("IdSetRoaring serialization") {
+    const auto ids = make_ids(6);
+    auto s = make_set(ids);
+    s.optimize();
+
+    const std::string data = s.serialize();
+    REQUIRE(data.size() == s.serialized_size());
+
+    // std::string data is not guaranteed to be 8 byte aligned
+    std::vector<uint64_t> buffer((data.size() + 7) / 8);
+    std::copy(data.begin(), data.end(), reinterpret_cast<char*>(buffer.data()));
+    const char* begin = reinterpret_cast<const char*>(buffer.data());
+
+    const roaring_view view{begin, data.size()};
+    REQUIRE(view.size() == ids.size());
+    REQUIRE_FALSE(view.empty());
+    REQUIRE(std::vector<id_type>(view.begin(), view.end()) == std::vector<id_type>(ids.begin(), ids.end()));
+    for (const auto id : ids) {
+        REQUIRE(view.get(id));
+    }
+    REQUIRE_FALSE(view.get(1ULL << 40U));
+
+    roaring_set copy;
+    copy |= view;
+    REQUIRE(to_vector(copy) == to_vector(s));
+
+    auto other = make_set(make_ids(7));
+    auto expected = other;
+    expected &= s;
+    other &= view;
+    REQUIRE(to_vector(other) == to_vector(expected));
+
+    other -= view;
+    REQUIRE(other.empty());
+}
+
+TEST_CASE("IdSetRoaringView of empty set") {
+    const roaring_set s;
+    std::vector<uint64_t> buffer(s.serialized_size() / 8);
+    s.serialize(reinterpret_cast<char*>(buffer.data()));
+
+    const roaring_view view{reinterpret_cast<const char*>(buffer.data()), s.serialized_size()};
+    REQUIRE(view.empty());
+    REQUIRE(view.begin() == view.end());
+    REQUIRE_FALSE(view.get(0));
+}
+
+TEST_CASE("IdSetRoaringView checks data") {
+    roaring_set s;
+    s.set(17);
+    s.set(1ULL << 20U);
+    const auto size = s.serialized_size();
+    std::vector<uint64_t> buffer(size / 8 + 1);
+    char* data = reinterpret_cast<char*>(buffer.data());
+    s.serialize(data);
+
+    REQUIRE_THROWS_AS(roaring_view(data, 10), const osmium::index::id_set_format_error&);
+    REQUIRE_THROWS_AS(roaring_view(data, size - 8), const osmium::index::id_set_format_error&);
+    REQUIRE_THROWS_AS(roaring_view(data + 1, size - 1), const osmium::index::id_set_format_error&);
+    REQUIRE_THROWS_AS(osmium::index::IdSetRoaringView<uint32_t>(data, size), const osmium::index::id_set_format_error&);
+
+    data[0] = 'X';
+    REQUIRE_THROWS_AS(roaring_view(data, size), const osmium::index::id_set_format_error&);
+}
@@ -1,5 +1,8 @@
 #include "catch.hpp"
 
+#include <osmium/index/map/adaptive_mem.hpp>
+#include <osmium/index/map/dense_cache_file.hpp>
+#include <osmium/index/map/dense_compressed_array.hpp>
 #include <osmium/index/map/dense_file_array.hpp>
 #include <osmium/index/map/dense_mem_array.hpp>
 #include <osmium/index/map/dense_mmap_array.hpp>
@@ -14,6 +17,8 @@
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/types.hpp>
 
+#include <vector>
+
 static_assert(osmium::index::empty_value<osmium::Location>() == osmium::Location{}, "Empty value for location is wrong");
 
 template <typename TIndex>
@@ -71,6 +76,18 @@ void test_func_real(TIndex& index) {
     REQUIRE(index.get_noexcept(5) == osmium::Location{});
     REQUIRE(index.get_noexcept(100) == osmium::Location{});
 
+    std::vector<osmium::unsigned_object_id_type> ids;
+    for (int i = 0; i < 10; ++i) {
+        ids.insert(ids.end(), {id1, 0, id2, 100, 5});
+    }
+    std::vector<osmium::Location> locations(ids.size());
+    index.get_many(ids.data(), locations.data(), ids.size());
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        REQUIRE(locations[i] == index.get_noexcept(ids[i]));
+    }
+    REQUIRE(locations[0] == loc1);
+    REQUIRE(locations[2] == loc2);
+
     index.clear();
 
     REQUIRE_THROWS_AS(index.get(id1), const osmium::not_found&);
@@ -125,10 +142,41 @@ TEST_CASE("Map Id to location: DenseMmapArray") {
     index_type index2;
     test_func_real<index_type>(index2);
 }
+
+TEST_CASE("Map Id to location: DenseMmapArray with huge pages") {
+    using index_type = osmium::index::map::DenseMmapArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index;
+    const bool huge_pages = index.use_huge_pages();
+    test_func_real<index_type>(index);
+    if (!huge_pages) {
+        REQUIRE(index.huge_page_bytes() == 0);
+    }
+}
 #else
 # pragma message("not running 'DenseMapMmap' test case on this machine")
 #endif
 
+TEST_CASE("Map Id to location: DenseCacheFile") {
+    using index_type = osmium::index::map::DenseCacheFile<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+    test_func_all<index_type>(index1);
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
+TEST_CASE("Map Id to location: DenseCompressedArray") {
+    using index_type = osmium::index::map::DenseCompressedArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+    test_func_all<index_type>(index1);
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
 TEST_CASE("Map Id to location: DenseFileArray") {
     using index_type = osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
 
@@ -199,6 +247,16 @@ TEST_CASE("Map Id to location: FlexMem dense") {
     test_func_real<index_type>(index2);
 }
 
+TEST_CASE("Map Id to location: AdaptiveMem") {
+    using index_type = osmium::index::map::AdaptiveMem<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+    test_func_all<index_type>(index1);
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
 TEST_CASE("Map Id to location: FlexMem switch") {
     using index_type = osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>;
 
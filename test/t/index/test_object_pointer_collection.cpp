@@ -82,3 +82,32 @@ TEST_CASE("Create ObjectPointerCollection") {
     REQUIRE(collection.empty());
 }
 
+
+TEST_CASE("Radix sort ObjectPointerCollection") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_node(buffer, _id(3), _version(1));
+    osmium::builder::add_node(buffer, _id(1), _version(2));
+    osmium::builder::add_node(buffer, _id(2), _version(3));
+    osmium::builder::add_node(buffer, _id(1), _version(1));
+
+    osmium::ObjectPointerCollection collection;
+    osmium::apply(buffer, collection);
+
+    collection.radix_sort([](const osmium::OSMObject& object) {
+        return object.positive_id();
+    });
+
+    auto it = collection.cbegin();
+    REQUIRE(it->id() == 1);
+    REQUIRE(it->version() == 2); // stable: order of objects with same id is kept
+    ++it;
+    REQUIRE(it->id() == 1);
+    REQUIRE(it->version() == 1);
+    ++it;
+    REQUIRE(it->id() == 2);
+    ++it;
+    REQUIRE(it->id() == 3);
+    ++it;
+    REQUIRE(it == collection.cend());
+}
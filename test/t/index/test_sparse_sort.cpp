@@ -0,0 +1,157 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/sort_by_id.hpp>
+#include <osmium/index/map/sparse_file_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/index/map/sparse_mmap_array.hpp>
+#include <osmium/index/multimap/sparse_mem_array.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Large enough to use the radix sort instead of std::sort.
+static const std::size_t num_elements = osmium::index::detail::min_radix_sort_size + 1000;
+
+template <typename TIndex>
+void test_sort_large_map(TIndex& index) {
+    std::mt19937_64 gen{17};
+    std::uniform_int_distribution<osmium::unsigned_object_id_type> dist{1, 10000000000ULL};
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    ids.reserve(num_elements);
+    for (std::size_t i = 0; i < num_elements; ++i) {
+        const auto id = dist(gen);
+        ids.push_back(id);
+        index.set(id, osmium::Location{static_cast<int32_t>(id % 1000), static_cast<int32_t>(id % 777)});
+    }
+
+    index.sort();
+
+    std::sort(ids.begin(), ids.end());
+    for (std::size_t i = 0; i < ids.size(); i += 997) {
+        const auto id = ids[i];
+        REQUIRE(index.get(id) == (osmium::Location{static_cast<int32_t>(id % 1000), static_cast<int32_t>(id % 777)}));
+    }
+    REQUIRE_THROWS_AS(index.get(0), const osmium::not_found&);
+}
+
+TEST_CASE("Sort large SparseMemArray map") {
+    osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    test_sort_large_map(index);
+}
+
+TEST_CASE("Sort large SparseMmapArray map") {
+    osmium::index::map::SparseMmapArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    test_sort_large_map(index);
+}
+
+TEST_CASE("Sort large SparseFileArray map") {
+    osmium::index::map::SparseFileArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    test_sort_large_map(index);
+}
+
+TEST_CASE("Sort by id gives the same result as std::sort") {
+    std::mt19937_64 gen{23};
+    std::uniform_int_distribution<int64_t> id_dist{-5000, 5000};
+    std::uniform_int_distribution<int32_t> value_dist{0, 100};
+
+    std::vector<std::pair<int64_t, int32_t>> data;
+    data.reserve(num_elements);
+    for (std::size_t i = 0; i < num_elements; ++i) {
+        data.emplace_back(id_dist(gen), value_dist(gen));
+    }
+
+    auto expected = data;
+    std::sort(expected.begin(), expected.end());
+
+    osmium::index::detail::sort_by_id(data);
+    REQUIRE(data == expected);
+}
+
+TEST_CASE("Sort large SparseMemArray multimap") {
+    osmium::index::multimap::SparseMemArray<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type> index;
+
+    // Add values in descending order, sort must order them ascending.
+    std::size_t count = 0;
+    for (std::size_t i = num_elements; i > 0; --i) {
+        index.set(i % 1000, i);
+        if (i % 1000 == 17) {
+            ++count;
+        }
+    }
+    index.sort();
+
+    const auto range = index.get_all(17);
+    std::vector<osmium::unsigned_object_id_type> values;
+    for (auto it = range.first; it != range.second; ++it) {
+        values.push_back(it->second);
+    }
+    REQUIRE(values.size() == count);
+    REQUIRE(std::is_sorted(values.cbegin(), values.cend()));
+    REQUIRE(values.front() == 17);
+}
+
+template <typename TId>
+void test_lookup_table(const std::vector<TId>& ids) {
+    osmium::index::map::SparseMemArray<TId, osmium::Location> index;
+    for (const auto id : ids) {
+        index.set(id, osmium::Location{static_cast<int32_t>(id % 1000), 1});
+    }
+    index.sort();
+    REQUIRE(index.used_memory() > index.size() * sizeof(std::pair<TId, osmium::Location>));
+
+    for (const auto id : ids) {
+        REQUIRE(index.get(id) == (osmium::Location{static_cast<int32_t>(id % 1000), 1}));
+        REQUIRE_FALSE(index.get_noexcept(id + 1).valid());
+        REQUIRE_THROWS_AS(index.get(id - 1), const osmium::not_found&);
+    }
+
+    // Adding elements after sort() makes the table invalid, lookups
+    // still work.
+    index.set(ids.back() + 10, osmium::Location{5, 5});
+    REQUIRE(index.get(ids.front()) == (osmium::Location{static_cast<int32_t>(ids.front() % 1000), 1}));
+    index.sort();
+    REQUIRE(index.get(ids.back() + 10) == (osmium::Location{5, 5}));
+}
+
+TEST_CASE("Lookup in sorted sparse map with uniform ids") {
+    std::vector<osmium::unsigned_object_id_type> ids;
+    for (osmium::unsigned_object_id_type id = 10; id < 100000; id += 7) {
+        ids.push_back(id);
+    }
+    test_lookup_table(ids);
+}
+
+TEST_CASE("Lookup in sorted sparse map with skewed ids") {
+    std::vector<osmium::unsigned_object_id_type> ids;
+    for (osmium::unsigned_object_id_type id = 10; id < 10000; id += 3) {
+        ids.push_back(id);
+    }
+    ids.push_back(1000000000000ULL);
+    ids.push_back(0xfffffffffffffff0ULL);
+    test_lookup_table(ids);
+}
+
+TEST_CASE("Lookup in sorted sparse map with one element") {
+    test_lookup_table(std::vector<osmium::unsigned_object_id_type>{17});
+}
+
+TEST_CASE("Sorting a sorted sparse map again") {
+    osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    for (osmium::unsigned_object_id_type id = 1; id < 1000; id += 2) {
+        index.set(id, osmium::Location{1, 2});
+    }
+    index.sort();
+    const auto memory = index.used_memory();
+
+    // Sorting sorted data again only rebuilds the table.
+    index.sort();
+    REQUIRE(index.used_memory() == memory);
+    REQUIRE(index.get(999) == (osmium::Location{1, 2}));
+    REQUIRE_FALSE(index.get_noexcept(1000).valid());
+}
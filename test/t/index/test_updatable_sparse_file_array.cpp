@@ -0,0 +1,220 @@
+#include "catch.hpp"
+
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/sparse_file_array.hpp>
+#include <osmium/index/map/updatable_sparse_file_array.hpp>
+#include <osmium/index/node_locations_map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/opl.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstdio>
+#include <fcntl.h>
+#include <string>
+#include <vector>
+
+using index_type = osmium::index::map::UpdatableSparseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
+using element_type = std::pair<osmium::unsigned_object_id_type, osmium::Location>;
+
+static const std::string filename{"test_updatable_sparse_file_array.idx"};
+
+static void remove_files() {
+    std::remove(filename.c_str());
+    std::remove((filename + ".log").c_str());
+    std::remove((filename + ".new").c_str());
+}
+
+static osmium::Location loc(int i) {
+    return osmium::Location{i, i * 2};
+}
+
+TEST_CASE("Updatable sparse file array: set, remove, and get") {
+    remove_files();
+    {
+        index_type index{filename};
+        REQUIRE(index.size() == 0);
+        REQUIRE(index.get_noexcept(1) == osmium::Location{});
+
+        index.set(17, loc(17));
+        index.set(3, loc(3));
+        index.set(17, loc(18));
+        REQUIRE(index.get(3) == loc(3));
+        REQUIRE(index.get(17) == loc(18));
+        REQUIRE(index.num_changes() == 2);
+
+        index.remove(3);
+        REQUIRE(index.get_noexcept(3) == osmium::Location{});
+        REQUIRE_THROWS_AS(index.get(3), const osmium::not_found&);
+        REQUIRE_THROWS_AS(index.get(4), const osmium::not_found&);
+    }
+    remove_files();
+}
+
+TEST_CASE("Updatable sparse file array: changes are read from log when opened again") {
+    remove_files();
+    {
+        index_type index{filename};
+        for (int i = 1; i <= 100; ++i) {
+            index.set(i, loc(i));
+        }
+        index.remove(50);
+        index.checkpoint();
+        REQUIRE(osmium::file_size(filename + ".log") == 101 * sizeof(element_type));
+    }
+    {
+        index_type index{filename};
+        REQUIRE(index.num_changes() == 100);
+        REQUIRE(index.get(1) == loc(1));
+        REQUIRE(index.get(100) == loc(100));
+        REQUIRE(index.get_noexcept(50) == osmium::Location{});
+    }
+    remove_files();
+}
+
+TEST_CASE("Updatable sparse file array: partially written log entry is ignored") {
+    remove_files();
+    {
+        index_type index{filename};
+        index.set(1, loc(1));
+        index.set(2, loc(2));
+        index.checkpoint();
+    }
+    osmium::resize_file(osmium::index::detail::open_index_file(filename + ".log", 0), 2 * sizeof(element_type) - 3);
+    {
+        index_type index{filename};
+        REQUIRE(index.num_changes() == 1);
+        REQUIRE(index.get(1) == loc(1));
+        REQUIRE(index.get_noexcept(2) == osmium::Location{});
+        REQUIRE(osmium::file_size(filename + ".log") == sizeof(element_type));
+    }
+    remove_files();
+}
+
+TEST_CASE("Updatable sparse file array: merge changes into main file") {
+    remove_files();
+    {
+        index_type index{filename};
+        for (int i = 1; i <= 1000; i += 2) {
+            index.set(i, loc(i));
+        }
+        index.merge();
+        REQUIRE(index.num_changes() == 0);
+        REQUIRE(index.size() == 500);
+        REQUIRE(osmium::file_size(filename + ".log") == 0);
+
+        // Update, insert, and remove some ids.
+        index.set(1, loc(2));
+        index.set(2, loc(2));
+        index.remove(3);
+        index.remove(4);
+        index.set(2000, loc(2000));
+        REQUIRE(index.get(1) == loc(2));
+        REQUIRE(index.get(5) == loc(5));
+
+        std::vector<osmium::unsigned_object_id_type> ids = {1, 2, 3, 4, 5, 2000};
+        std::vector<osmium::Location> values(ids.size());
+        index.get_many(ids.data(), values.data(), ids.size());
+        REQUIRE(values[0] == loc(2));
+        REQUIRE(values[1] == loc(2));
+        REQUIRE(values[2] == osmium::Location{});
+        REQUIRE(values[3] == osmium::Location{});
+        REQUIRE(values[4] == loc(5));
+        REQUIRE(values[5] == loc(2000));
+
+        index.merge();
+        REQUIRE(index.num_changes() == 0);
+        REQUIRE(index.size() == 501);
+    }
+    {
+        index_type index{filename};
+        REQUIRE(index.num_changes() == 0);
+        REQUIRE(index.get(1) == loc(2));
+        REQUIRE(index.get(2) == loc(2));
+        REQUIRE(index.get_noexcept(3) == osmium::Location{});
+        REQUIRE(index.get(999) == loc(999));
+        REQUIRE(index.get(2000) == loc(2000));
+    }
+    remove_files();
+}
+
+TEST_CASE("Updatable sparse file array: merge when threshold is reached") {
+    remove_files();
+    {
+        index_type index{filename, 10};
+        for (int i = 1; i <= 25; ++i) {
+            index.set(i, loc(i));
+        }
+        REQUIRE(index.num_changes() == 5);
+        for (int i = 1; i <= 25; ++i) {
+            REQUIRE(index.get(i) == loc(i));
+        }
+    }
+    remove_files();
+}
+
+TEST_CASE("Updatable sparse file array: no merge below threshold when used in handler") {
+    remove_files();
+    {
+        index_type index{filename, 1000};
+        for (int i = 1; i <= 10; ++i) {
+            index.set(i, loc(i));
+        }
+        index.merge();
+        REQUIRE(index.num_changes() == 0);
+
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        REQUIRE(osmium::opl_parse("n5 x1 y2", buffer));
+        REQUIRE(osmium::opl_parse("n20 x3 y4", buffer));
+        REQUIRE(osmium::opl_parse("w1 Nn5,n20,n7", buffer));
+
+        osmium::handler::NodeLocationsForWays<index_type> handler{index};
+        osmium::apply(buffer, handler);
+
+        // The changes were not merged into the main file.
+        REQUIRE(index.num_changes() == 2);
+
+        const auto& way = *buffer.select<osmium::Way>().begin();
+        REQUIRE(way.nodes()[0].location() == osmium::Location(1.0, 2.0));
+        REQUIRE(way.nodes()[1].location() == osmium::Location(3.0, 4.0));
+        REQUIRE(way.nodes()[2].location() == loc(7));
+    }
+    remove_files();
+}
+
+TEST_CASE("Updatable sparse file array: use file written by other sparse index") {
+    remove_files();
+    {
+        osmium::index::map::SparseFileArray<osmium::unsigned_object_id_type, osmium::Location> index;
+        index.set(30, loc(30));
+        index.set(10, loc(10));
+        index.set(20, loc(20));
+        index.sort();
+        const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+        index.dump_as_list(fd);
+        osmium::io::detail::reliable_close(fd);
+    }
+    {
+        index_type index{filename};
+        REQUIRE(index.size() == 3);
+        REQUIRE(index.get(10) == loc(10));
+        REQUIRE(index.get(30) == loc(30));
+        index.set(15, loc(15));
+
+        const int fd = osmium::io::detail::open_for_writing(filename + ".dump", osmium::io::overwrite::allow);
+        index.dump_as_list(fd);
+        osmium::io::detail::reliable_close(fd);
+        REQUIRE(osmium::file_size(filename + ".dump") == 4 * sizeof(element_type));
+        std::remove((filename + ".dump").c_str());
+
+        index.clear();
+        REQUIRE(index.size() == 0);
+        REQUIRE(index.get_noexcept(10) == osmium::Location{});
+        index.set(5, loc(5));
+        REQUIRE(index.get(5) == loc(5));
+    }
+    remove_files();
+}
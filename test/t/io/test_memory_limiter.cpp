@@ -0,0 +1,81 @@
+#include "catch.hpp"
+
+#include <osmium/io/detail/memory_limiter.hpp>
+
+#include <atomic>
+#include <thread>
+
+TEST_CASE("MemoryLimiter without limit never blocks") {
+    osmium::io::detail::MemoryLimiter limiter;
+    REQUIRE(limiter.limit() == 0);
+
+    limiter.acquire_input(1000);
+    limiter.acquire_output(1000);
+    limiter.add_output(1000);
+    REQUIRE(limiter.used() == 0);
+}
+
+TEST_CASE("MemoryLimiter accounts for input and output") {
+    osmium::io::detail::MemoryLimiter limiter{100};
+    REQUIRE(limiter.limit() == 100);
+
+    limiter.acquire_input(30);
+    limiter.acquire_output(20);
+    limiter.add_output(70);
+    REQUIRE(limiter.used() == 120);
+    REQUIRE(limiter.max_used() == 120);
+
+    limiter.release_input(30);
+    limiter.release_output(90);
+    REQUIRE(limiter.used() == 0);
+    REQUIRE(limiter.max_used() == 120);
+
+    // releasing too much must not underflow
+    limiter.release_output(10);
+    REQUIRE(limiter.used() == 0);
+}
+
+TEST_CASE("MemoryLimiter lets data larger than the limit pass if nothing else is used") {
+    osmium::io::detail::MemoryLimiter limiter{100};
+
+    limiter.acquire_input(1000);
+    REQUIRE(limiter.used() == 1000);
+
+    // there is input, but no output, parser must not block
+    limiter.acquire_output(1000);
+    REQUIRE(limiter.used() == 2000);
+}
+
+TEST_CASE("MemoryLimiter blocks reader until memory is released") {
+    osmium::io::detail::MemoryLimiter limiter{100};
+    limiter.add_output(80);
+
+    std::atomic<bool> done{false};
+    std::thread thread{[&](){
+        limiter.acquire_input(50);
+        done = true;
+    }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE_FALSE(done);
+
+    limiter.release_output(80);
+    thread.join();
+    REQUIRE(done);
+    REQUIRE(limiter.used() == 50);
+}
+
+TEST_CASE("MemoryLimiter does not block after shutdown") {
+    osmium::io::detail::MemoryLimiter limiter{100};
+    limiter.add_output(80);
+
+    std::thread thread{[&](){
+        limiter.acquire_output(50);
+    }};
+
+    limiter.shutdown();
+    thread.join();
+    limiter.acquire_input(500);
+    REQUIRE(limiter.used() == 630);
+}
+
@@ -7,8 +7,15 @@
 #include <osmium/io/pbf_input.hpp>
 #include <osmium/io/xml_input.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/thread/execution_context.hpp>
 #include <osmium/visitor.hpp>
 
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <vector>
+
 struct CountHandler : public osmium::handler::Handler {
 
     int count = 0;
@@ -64,6 +71,64 @@ TEST_CASE("Reader can be initialized with user-provided pool") {
     osmium::apply(reader, handler);
 }
 
+TEST_CASE("Reader can be initialized with read options") {
+    osmium::io::File file{with_data_dir("t/io/data.osm")};
+    osmium::io::Reader reader{file,
+                              osmium::io::read_advice::streaming,
+                              osmium::io::read_chunk_size{4096},
+                              osmium::io::read_ahead{50}};
+    CountHandler handler;
+
+    osmium::apply(reader, handler);
+    REQUIRE(handler.count == 1);
+}
+
+TEST_CASE("Reader with read options works with compressed files") {
+    osmium::io::File file{with_data_dir("t/io/data.osm.gz")};
+    osmium::io::Reader reader{file,
+                              osmium::io::read_advice::sequential,
+                              osmium::io::read_chunk_size{1}};
+    CountHandler handler;
+
+    osmium::apply(reader, handler);
+    REQUIRE(handler.count == 1);
+}
+
+TEST_CASE("Reader with queue memory limit") {
+    osmium::io::File file{with_data_dir("t/io/data.osm")};
+    osmium::io::Reader reader{file,
+                              osmium::io::read_chunk_size{4096},
+                              osmium::io::queue_memory_limit{1}};
+    CountHandler handler;
+
+    osmium::apply(reader, handler);
+    REQUIRE(handler.count == 1);
+}
+
+TEST_CASE("Reader with queue memory limit can be closed early") {
+    osmium::io::File file{with_data_dir("t/io/data.osm")};
+    osmium::io::Reader reader{file, osmium::io::queue_memory_limit{1}};
+
+    REQUIRE(reader.header().get("generator") == "testdata");
+    reader.close();
+}
+
+TEST_CASE("Reader with buffer pool") {
+    osmium::memory::BufferPool buffer_pool;
+    osmium::io::File file{with_data_dir("t/io/data.osm")};
+    osmium::io::Reader reader{file, buffer_pool};
+
+    int count = 0;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        count += std::distance(buffer.begin(), buffer.end());
+        buffer_pool.put(std::move(buffer));
+    }
+    reader.close();
+
+    REQUIRE(count == 1);
+    REQUIRE(buffer_pool.size() > 0);
+}
+
 TEST_CASE("Reader should throw after eof") {
     osmium::io::File file{with_data_dir("t/io/data.osm")};
     osmium::io::Reader reader{file};
@@ -256,3 +321,101 @@ TEST_CASE("Can not read after close") {
     REQUIRE_THROWS_AS(reader.read(), const osmium::io_error&);
 }
 
+
+TEST_CASE("Reader can be polled with try_read()") {
+    osmium::io::File file{with_data_dir("t/io/data.osm")};
+    osmium::io::Reader reader{file};
+    CountHandler handler;
+
+    osmium::memory::Buffer buffer;
+    while (true) {
+        if (!reader.try_read(buffer)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (!buffer) {
+            break;
+        }
+        osmium::apply(buffer, handler);
+    }
+
+    REQUIRE(handler.count == 1);
+    REQUIRE(reader.eof());
+    REQUIRE_THROWS_AS(reader.try_read(buffer), const osmium::io_error&);
+}
+
+TEST_CASE("Several readers can be polled from one thread") {
+    std::vector<std::unique_ptr<osmium::io::Reader>> readers;
+    for (int i = 0; i < 10; ++i) {
+        readers.emplace_back(new osmium::io::Reader{with_data_dir(i % 2 ? "t/io/data.osm" : "t/io/data.osm.gz")});
+    }
+    CountHandler handler;
+
+    std::size_t done = 0;
+    while (done < readers.size()) {
+        for (auto& reader : readers) {
+            osmium::memory::Buffer buffer;
+            if (reader->eof() || !reader->try_read(buffer)) {
+                continue;
+            }
+            if (buffer) {
+                osmium::apply(buffer, handler);
+            } else {
+                ++done;
+            }
+        }
+        std::this_thread::yield();
+    }
+
+    REQUIRE(handler.count == 10);
+}
+
+TEST_CASE("try_read() on Reader with entity_bits nothing") {
+    osmium::io::File file{with_data_dir("t/io/data.osm")};
+    osmium::io::Reader reader{file, osmium::osm_entity_bits::nothing};
+
+    osmium::memory::Buffer buffer;
+    REQUIRE(reader.try_read(buffer));
+    REQUIRE_FALSE(buffer);
+    REQUIRE(reader.eof());
+}
+
+TEST_CASE("Many readers sharing an execution context") {
+    osmium::thread::ExecutionContext context{2, 1};
+
+    std::vector<std::unique_ptr<osmium::io::Reader>> readers;
+    for (int i = 0; i < 20; ++i) {
+        readers.emplace_back(new osmium::io::Reader{with_data_dir(i % 2 ? "t/io/data.osm" : "t/io/data.osm.bz2"), context});
+    }
+    REQUIRE(context.num_tasks() > 0);
+
+    CountHandler handler;
+    for (auto& reader : readers) {
+        osmium::apply(*reader, handler);
+        reader->close();
+    }
+
+    REQUIRE(handler.count == 20);
+    REQUIRE(context.num_tasks() == 0);
+}
+
+TEST_CASE("Reader using an execution context can be closed early") {
+    osmium::thread::ExecutionContext context;
+    osmium::io::Reader reader{with_data_dir("t/io/data.osm"), context, osmium::io::read_chunk_size{10}, osmium::io::read_ahead{2}};
+    reader.close();
+    REQUIRE(reader.eof());
+    REQUIRE(context.num_tasks() == 0);
+}
+
+TEST_CASE("Reader using an execution context with memory limit") {
+    osmium::thread::ExecutionContext context;
+    osmium::io::Reader reader{with_data_dir("t/io/data.osm"), context, osmium::io::read_chunk_size{10}, osmium::io::queue_memory_limit{100}};
+    CountHandler handler;
+    osmium::apply(reader, handler);
+    REQUIRE(handler.count == 1);
+}
+
+TEST_CASE("Reader using an execution context with nonexistent file") {
+    osmium::thread::ExecutionContext context;
+    REQUIRE_THROWS((osmium::io::Reader{with_data_dir("t/io/nonexistent-file.osm"), context}));
+}
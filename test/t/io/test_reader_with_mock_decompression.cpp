@@ -49,6 +49,9 @@ public:
             if (m_fail_in == "first read") {
                 throw std::runtime_error{"error first read"};
             }
+            if (m_fail_in == "chunk size" && chunk_size() != 64 * 1024) {
+                throw std::runtime_error{"error chunk size"};
+            }
             buffer += "<?xml version='1.0' encoding='UTF-8'?>\n<osm version='0.6' generator='testdata'>\n";
             for (int i = 0; i < 1000; ++i) {
                 add_node(buffer, i);
@@ -136,6 +139,15 @@ TEST_CASE("Test Reader using MockDecompressor") {
         }
     }
 
+    SECTION("chunk size is set before first read") {
+        fail_in = "chunk size";
+
+        osmium::io::Reader reader{with_data_dir("t/io/data.osm.gz"), osmium::io::read_chunk_size{64 * 1024}};
+        reader.read();
+        reader.close();
+        REQUIRE(true);
+    }
+
     SECTION("not failing") {
         fail_in = "not";
 
@@ -147,3 +159,17 @@ TEST_CASE("Test Reader using MockDecompressor") {
 
 }
 
+
+TEST_CASE("Decompressor chunk size is clamped") {
+    MockDecompressor decompressor{""};
+    REQUIRE(decompressor.chunk_size() == std::size_t(osmium::io::Decompressor::input_buffer_size));
+
+    decompressor.set_chunk_size(1);
+    REQUIRE(decompressor.chunk_size() == std::size_t(osmium::io::Decompressor::min_input_buffer_size));
+
+    decompressor.set_chunk_size(64 * 1024);
+    REQUIRE(decompressor.chunk_size() == 64 * 1024);
+
+    decompressor.set_chunk_size(std::size_t(1) << 40U);
+    REQUIRE(decompressor.chunk_size() == std::size_t(osmium::io::Decompressor::max_input_buffer_size));
+}
@@ -7,9 +7,12 @@
 #include <osmium/io/xml_input.hpp>
 #include <osmium/io/xml_output.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/thread/execution_context.hpp>
 
 #include <algorithm>
 #include <stdexcept>
+#include <string>
 
 static osmium::memory::Buffer get_buffer() {
     osmium::io::Reader reader{with_data_dir("t/io/data.osm")};
@@ -182,3 +185,42 @@ TEST_CASE("Writer with user-provided pool with outlier positive number of thread
     writer.close();
 }
 
+TEST_CASE("Writer with buffer pool") {
+    auto buffer = get_buffer();
+    const auto num = buffer.select<osmium::OSMObject>().size();
+
+    osmium::memory::BufferPool buffer_pool;
+    std::string filename = "test-writer-buffer-pool.osm";
+    osmium::io::Writer writer{filename, buffer_pool, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    REQUIRE(buffer_pool.size() == 1);
+
+    osmium::io::Reader reader_check{filename};
+    const osmium::memory::Buffer buffer_check = reader_check.read();
+    REQUIRE(buffer_check.select<osmium::OSMObject>().size() == num);
+}
+
+
+TEST_CASE("Writers using an execution context") {
+    osmium::thread::ExecutionContext context{1, 1};
+
+    for (int i = 0; i < 3; ++i) {
+        auto buffer = get_and_check_buffer();
+        const auto num = buffer.select<osmium::OSMObject>().size();
+        const std::string filename = "test-writer-out-context-" + std::to_string(i) + ".osm.gz";
+
+        osmium::io::Writer writer{filename, context, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+
+        osmium::io::Reader reader_check{filename, context};
+        const osmium::memory::Buffer buffer_check = reader_check.read();
+        REQUIRE(buffer_check);
+        REQUIRE(buffer_check.select<osmium::OSMObject>().size() == num);
+        REQUIRE(buffer_check.select<osmium::OSMObject>().cbegin()->id() == 1);
+    }
+
+    REQUIRE(context.num_tasks() == 0);
+}
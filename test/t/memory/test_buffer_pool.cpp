@@ -0,0 +1,102 @@
+#include "catch.hpp"
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+
+#include <memory>
+#include <utility>
+
+TEST_CASE("Get buffer from empty pool allocates new buffer") {
+    osmium::memory::BufferPool pool;
+    REQUIRE(pool.size() == 0);
+
+    auto buffer = pool.get(1024);
+    REQUIRE(buffer);
+    REQUIRE(buffer.capacity() >= 1024);
+    REQUIRE(buffer.committed() == 0);
+    REQUIRE(pool.allocated() == 1);
+    REQUIRE(pool.reused() == 0);
+}
+
+TEST_CASE("Buffer given back to pool is reused") {
+    osmium::memory::BufferPool pool;
+
+    auto buffer = pool.get(4096);
+    buffer.reserve_space(128);
+    buffer.commit();
+    const auto data = buffer.data();
+
+    pool.put(std::move(buffer));
+    REQUIRE(pool.size() == 1);
+
+    auto buffer2 = pool.get(4000);
+    REQUIRE(pool.size() == 0);
+    REQUIRE(pool.reused() == 1);
+    REQUIRE(buffer2.data() == data);
+    REQUIRE(buffer2.committed() == 0);
+    REQUIRE(buffer2.written() == 0);
+}
+
+TEST_CASE("Buffer from pool is large enough") {
+    osmium::memory::BufferPool pool;
+
+    pool.put(osmium::memory::Buffer{1024 + 64});
+    REQUIRE(pool.size() == 1);
+
+    auto buffer = pool.get(2000);
+    REQUIRE(buffer.capacity() >= 2000);
+    REQUIRE(pool.size() == 1);
+    REQUIRE(pool.allocated() == 1);
+
+    auto buffer2 = pool.get(1024);
+    REQUIRE(buffer2.capacity() == 1024 + 64);
+    REQUIRE(pool.size() == 0);
+}
+
+TEST_CASE("Pool ignores invalid buffers and buffers with external memory") {
+    osmium::memory::BufferPool pool;
+
+    pool.put(osmium::memory::Buffer{});
+    REQUIRE(pool.size() == 0);
+
+    alignas(osmium::memory::align_bytes) unsigned char data[1024] = {0};
+    pool.put(osmium::memory::Buffer{data, sizeof(data), 0});
+    REQUIRE(pool.size() == 0);
+}
+
+TEST_CASE("Pool keeps at most max_buffers buffers") {
+    osmium::memory::BufferPool pool{2};
+
+    pool.put(osmium::memory::Buffer{1024});
+    pool.put(osmium::memory::Buffer{1024});
+    pool.put(osmium::memory::Buffer{1024});
+    REQUIRE(pool.size() == 2);
+
+    pool.clear();
+    REQUIRE(pool.size() == 0);
+}
+
+TEST_CASE("Buffer from pool gets requested auto_grow setting") {
+    osmium::memory::BufferPool pool;
+    pool.put(osmium::memory::Buffer{1024, osmium::memory::Buffer::auto_grow::yes});
+
+    auto buffer = pool.get(1024, osmium::memory::Buffer::auto_grow::no);
+    REQUIRE(pool.reused() == 1);
+    REQUIRE_THROWS_AS(buffer.reserve_space(2048), const osmium::buffer_is_full&);
+}
+
+TEST_CASE("BufferPoolDeleter gives buffer back to pool") {
+    osmium::memory::BufferPool pool;
+    {
+        std::shared_ptr<osmium::memory::Buffer> buffer{new osmium::memory::Buffer{1024},
+                                                       osmium::memory::BufferPoolDeleter{&pool}};
+    }
+    REQUIRE(pool.size() == 1);
+
+    {
+        std::shared_ptr<osmium::memory::Buffer> buffer{new osmium::memory::Buffer{1024},
+                                                       osmium::memory::BufferPoolDeleter{nullptr}};
+    }
+    REQUIRE(pool.size() == 1);
+}
+
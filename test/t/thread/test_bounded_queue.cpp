@@ -0,0 +1,128 @@
+#include "catch.hpp"
+
+#include <osmium/thread/bounded_queue.hpp>
+
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Basic use of bounded queue") {
+    osmium::thread::BoundedQueue<int> queue{10, "test"};
+    REQUIRE(queue.capacity() == 10);
+    REQUIRE(queue.empty());
+    queue.push(22);
+    REQUIRE_FALSE(queue.empty());
+    REQUIRE(queue.size() == 1);
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 22);
+    REQUIRE(queue.empty());
+    REQUIRE_FALSE(queue.try_pop(value));
+}
+
+TEST_CASE("Bounded queue with default capacity") {
+    osmium::thread::BoundedQueue<int> queue;
+    REQUIRE(queue.capacity() == osmium::thread::BoundedQueue<int>::default_capacity);
+}
+
+TEST_CASE("Bounded queue has a capacity of at least 2") {
+    osmium::thread::BoundedQueue<int> queue{1};
+    REQUIRE(queue.capacity() == 2);
+
+    int value = 1;
+    REQUIRE(queue.try_push(value));
+    value = 2;
+    REQUIRE(queue.try_push(value));
+    value = 3;
+    REQUIRE_FALSE(queue.try_push(value));
+
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(value == 1);
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(value == 2);
+    REQUIRE_FALSE(queue.try_pop(value));
+}
+
+TEST_CASE("Bounded queue keeps order and capacity") {
+    osmium::thread::BoundedQueue<std::string> queue{3};
+
+    for (int i = 0; i < 3; ++i) {
+        std::string s{std::to_string(i)};
+        REQUIRE(queue.try_push(s));
+    }
+    REQUIRE(queue.size() == 3);
+
+    std::string s{"x"};
+    REQUIRE_FALSE(queue.try_push(s));
+    REQUIRE(s == "x");
+
+    std::string value;
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(value == "0");
+    REQUIRE(queue.try_push(s));
+
+    queue.wait_and_pop(value);
+    REQUIRE(value == "1");
+    queue.wait_and_pop(value);
+    REQUIRE(value == "2");
+    queue.wait_and_pop(value);
+    REQUIRE(value == "x");
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Bounded queue works with move-only types") {
+    osmium::thread::BoundedQueue<std::future<int>> queue{2};
+
+    std::promise<int> promise;
+    queue.push(promise.get_future());
+    promise.set_value(5);
+
+    std::future<int> future;
+    queue.wait_and_pop(future);
+    REQUIRE(future.get() == 5);
+}
+
+TEST_CASE("Bounded queue with several producers and consumers") {
+    osmium::thread::BoundedQueue<int> queue{4};
+    const int num_producers = 3;
+    const int num_values = 10000;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < num_producers; ++p) {
+        producers.emplace_back([&queue]() {
+            for (int i = 1; i <= num_values; ++i) {
+                queue.push(i);
+            }
+        });
+    }
+
+    std::vector<long> sums(2, 0);
+    std::vector<std::thread> consumers;
+    for (std::size_t c = 0; c < sums.size(); ++c) {
+        consumers.emplace_back([&queue, &sums, c]() {
+            while (true) {
+                int value = 0;
+                queue.wait_and_pop(value);
+                if (value == 0) {
+                    return;
+                }
+                sums[c] += value;
+            }
+        });
+    }
+
+    for (auto& thread : producers) {
+        thread.join();
+    }
+    for (std::size_t c = 0; c < consumers.size(); ++c) {
+        queue.push(0);
+    }
+    for (auto& thread : consumers) {
+        thread.join();
+    }
+
+    REQUIRE(sums[0] + sums[1] == static_cast<long>(num_producers) * num_values * (num_values + 1) / 2);
+    REQUIRE(queue.empty());
+}
+
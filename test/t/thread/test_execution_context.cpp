@@ -0,0 +1,137 @@
+#include "catch.hpp"
+
+#include <osmium/thread/execution_context.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class CountingTask : public osmium::thread::ExecutionContext::Task {
+
+    int m_steps;
+    std::atomic<int>& m_total;
+
+public:
+
+    CountingTask(int steps, std::atomic<int>& total) :
+        m_steps(steps),
+        m_total(total) {
+    }
+
+    osmium::thread::ExecutionContext::step_result step() override {
+        if (m_steps == 0) {
+            return osmium::thread::ExecutionContext::step_result::done;
+        }
+        --m_steps;
+        ++m_total;
+        return osmium::thread::ExecutionContext::step_result::progress;
+    }
+
+}; // class CountingTask
+
+// Waits for a flag set from the outside, returning idle until then.
+class WaitingTask : public osmium::thread::ExecutionContext::Task {
+
+    std::atomic<bool>& m_go;
+    std::atomic<int>* m_steps;
+
+public:
+
+    explicit WaitingTask(std::atomic<bool>& go, std::atomic<int>* steps = nullptr) :
+        m_go(go),
+        m_steps(steps) {
+    }
+
+    osmium::thread::ExecutionContext::step_result step() override {
+        if (m_steps) {
+            ++*m_steps;
+        }
+        return m_go ? osmium::thread::ExecutionContext::step_result::done
+                    : osmium::thread::ExecutionContext::step_result::idle;
+    }
+
+}; // class WaitingTask
+
+TEST_CASE("Execution context with default settings") {
+    osmium::thread::ExecutionContext context;
+    REQUIRE(context.num_io_threads() == 1);
+    REQUIRE(context.pool().num_threads() >= 1);
+    REQUIRE(context.num_tasks() == 0);
+}
+
+TEST_CASE("Execution context has at least one I/O thread") {
+    osmium::thread::ExecutionContext context{0, 1};
+    REQUIRE(context.num_io_threads() == 1);
+    REQUIRE(context.pool().num_threads() == 1);
+}
+
+TEST_CASE("Execution context runs many tasks on few threads") {
+    osmium::thread::ExecutionContext context{2, 1};
+    std::atomic<int> total{0};
+
+    {
+        std::vector<osmium::thread::task_handler> handlers;
+        for (int i = 0; i < 50; ++i) {
+            handlers.emplace_back(context, std::make_shared<CountingTask>(100, total));
+        }
+    }
+
+    REQUIRE(total == 5000);
+    REQUIRE(context.num_tasks() == 0);
+}
+
+TEST_CASE("Idle tasks don't keep others from running") {
+    osmium::thread::ExecutionContext context{1, 1};
+    std::atomic<bool> go{false};
+    std::atomic<int> total{0};
+
+    osmium::thread::task_handler waiting{context, std::make_shared<WaitingTask>(go)};
+    {
+        osmium::thread::task_handler counting{context, std::make_shared<CountingTask>(10, total)};
+    }
+    REQUIRE(total == 10);
+    REQUIRE(context.num_tasks() == 1);
+
+    go = true;
+    waiting.notify();
+    waiting.wait();
+    REQUIRE(context.num_tasks() == 0);
+}
+
+TEST_CASE("Idle tasks are not run again until notified") {
+    osmium::thread::ExecutionContext context{2, 1};
+    std::atomic<bool> go{false};
+    std::atomic<int> steps{0};
+
+    osmium::thread::task_handler waiting{context, std::make_shared<WaitingTask>(go, &steps)};
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    REQUIRE(steps == 1);
+
+    waiting.notify();
+    while (steps < 2) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    REQUIRE(steps == 2);
+
+    go = true;
+    waiting.notify();
+    waiting.wait();
+    REQUIRE(steps == 3);
+    REQUIRE(context.num_tasks() == 0);
+}
+
+TEST_CASE("Move-assigning a task handler waits for its task") {
+    osmium::thread::ExecutionContext context{1, 1};
+    std::atomic<int> total{0};
+
+    osmium::thread::task_handler handler{context, std::make_shared<CountingTask>(1000, total)};
+    handler = osmium::thread::task_handler{context, std::make_shared<CountingTask>(10, total)};
+    REQUIRE(total >= 1000);
+
+    handler.wait();
+    REQUIRE(total == 1010);
+    REQUIRE(context.num_tasks() == 0);
+}
@@ -0,0 +1,89 @@
+#include "catch.hpp"
+
+#include <osmium/thread/function_wrapper.hpp>
+
+#include <array>
+#include <future>
+#include <memory>
+#include <utility>
+
+TEST_CASE("default constructed function wrapper is empty") {
+    osmium::thread::function_wrapper f;
+    REQUIRE_FALSE(f);
+}
+
+TEST_CASE("function wrapper with small function") {
+    int result = 0;
+    osmium::thread::function_wrapper f{[&result]() {
+        result = 17;
+    }};
+    REQUIRE(f);
+    REQUIRE_FALSE(f());
+    REQUIRE(result == 17);
+}
+
+TEST_CASE("function wrapper with large function") {
+    std::array<int, 100> data{};
+    data[99] = 5;
+    int result = 0;
+    osmium::thread::function_wrapper f{[data, &result]() {
+        result = data[99];
+    }};
+    REQUIRE_FALSE(f());
+    REQUIRE(result == 5);
+}
+
+TEST_CASE("function wrapper with move-only function") {
+    std::unique_ptr<int> ptr{new int{3}};
+    int result = 0;
+    struct func {
+        std::unique_ptr<int> ptr;
+        int* result;
+        void operator()() {
+            *result = *ptr;
+        }
+    };
+    osmium::thread::function_wrapper f{func{std::move(ptr), &result}};
+    REQUIRE_FALSE(f());
+    REQUIRE(result == 3);
+}
+
+TEST_CASE("function wrapper with packaged task") {
+    std::packaged_task<int()> task{[]() {
+        return 42;
+    }};
+    auto future = task.get_future();
+    osmium::thread::function_wrapper f{std::move(task)};
+    REQUIRE_FALSE(f());
+    REQUIRE(future.get() == 42);
+}
+
+TEST_CASE("function wrapper can be moved") {
+    auto count = std::make_shared<int>(0);
+    osmium::thread::function_wrapper f1{[count]() {
+        ++*count;
+    }};
+    REQUIRE(count.use_count() == 2);
+
+    osmium::thread::function_wrapper f2{std::move(f1)};
+    REQUIRE_FALSE(f1); // NOLINT(bugprone-use-after-move)
+    REQUIRE(f2);
+    f2();
+    REQUIRE(*count == 1);
+
+    osmium::thread::function_wrapper f3;
+    f3 = std::move(f2);
+    f3();
+    REQUIRE(*count == 2);
+    REQUIRE(count.use_count() == 2);
+
+    f3 = osmium::thread::function_wrapper{};
+    REQUIRE(count.use_count() == 1);
+}
+
+TEST_CASE("special function wrapper for shutdown") {
+    osmium::thread::function_wrapper f{0};
+    REQUIRE(f);
+    REQUIRE(f());
+}
+
@@ -0,0 +1,129 @@
+#include "catch.hpp"
+
+#include <osmium/thread/ordered_queue.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <chrono>
+#include <exception>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+TEST_CASE("Basic use of ordered queue") {
+    osmium::thread::OrderedQueue<int> queue{10, "test"};
+    REQUIRE(queue.capacity() == 10);
+    REQUIRE(queue.empty());
+
+    queue.push(22);
+    REQUIRE_FALSE(queue.empty());
+    REQUIRE(queue.size() == 1);
+
+    REQUIRE(queue.pop() == 22);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Ordered queue with default capacity") {
+    osmium::thread::OrderedQueue<int> queue;
+    REQUIRE(queue.capacity() == osmium::thread::OrderedQueue<int>::default_capacity);
+}
+
+TEST_CASE("Ordered queue returns values in order of reservation") {
+    osmium::thread::OrderedQueue<std::string> queue{3};
+
+    const auto t1 = queue.reserve();
+    const auto t2 = queue.reserve();
+    const auto t3 = queue.reserve();
+    REQUIRE(queue.size() == 3);
+
+    queue.set_value(t3, "c");
+    queue.set_value(t2, "b");
+    queue.set_value(t1, "a");
+
+    REQUIRE(queue.pop() == "a");
+    REQUIRE(queue.pop() == "b");
+    REQUIRE(queue.pop() == "c");
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Ordered queue transports exceptions") {
+    osmium::thread::OrderedQueue<int> queue{3};
+
+    queue.push(1);
+    queue.push_exception(std::make_exception_ptr(std::runtime_error{"error"}));
+    queue.push(3);
+
+    REQUIRE(queue.pop() == 1);
+    REQUIRE_THROWS_AS(queue.pop(), const std::runtime_error&);
+    REQUIRE(queue.pop() == 3);
+}
+
+TEST_CASE("Ordered queue can pop into futures") {
+    osmium::thread::OrderedQueue<std::string> queue{4};
+    queue.push("abc");
+    queue.push_exception(std::make_exception_ptr(std::runtime_error{"error"}));
+
+    std::future<std::string> future;
+    queue.wait_and_pop(future);
+    REQUIRE(future.get() == "abc");
+
+    queue.wait_and_pop(future);
+    REQUIRE_THROWS_AS(future.get(), const std::runtime_error&);
+}
+
+TEST_CASE("Ordered queue try_pop doesn't wait for value") {
+    osmium::thread::OrderedQueue<int> queue{3};
+    int value = 0;
+    REQUIRE_FALSE(queue.try_pop(value));
+
+    const auto t1 = queue.reserve();
+    const auto t2 = queue.reserve();
+    queue.set_value(t2, 2);
+    REQUIRE_FALSE(queue.try_pop(value));
+
+    queue.set_value(t1, 1);
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(value == 1);
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(value == 2);
+    REQUIRE_FALSE(queue.try_pop(value));
+
+    queue.push_exception(std::make_exception_ptr(std::runtime_error{"error"}));
+    REQUIRE_THROWS_AS(queue.try_pop(value), const std::runtime_error&);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Ordered queue pop waits for value") {
+    osmium::thread::OrderedQueue<int> queue{2};
+    const auto ticket = queue.reserve();
+
+    std::thread thread{[&queue, ticket]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        queue.set_value(ticket, 17);
+    }};
+
+    REQUIRE(queue.pop() == 17);
+    thread.join();
+}
+
+TEST_CASE("Ordered queue with values set in thread pool") {
+    osmium::thread::Pool pool{4};
+    osmium::thread::OrderedQueue<int> queue{5};
+    const int num_values = 1000;
+
+    std::thread producer{[&]() {
+        for (int i = 0; i < num_values; ++i) {
+            const auto ticket = queue.reserve();
+            pool.submit_detached([&queue, ticket, i]() {
+                queue.set_value(ticket, i);
+            });
+        }
+    }};
+
+    for (int i = 0; i < num_values; ++i) {
+        REQUIRE(queue.pop() == i);
+    }
+    producer.join();
+    REQUIRE(queue.empty());
+}
+
@@ -0,0 +1,218 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/thread/parallel_apply.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+class MockSource {
+
+    int m_num_buffers;
+    int m_nodes_per_buffer;
+    int m_fail_at;
+    int m_buffer_count = 0;
+
+public:
+
+    MockSource(int num_buffers, int nodes_per_buffer, int fail_at = -1) :
+        m_num_buffers(num_buffers),
+        m_nodes_per_buffer(nodes_per_buffer),
+        m_fail_at(fail_at) {
+    }
+
+    osmium::memory::Buffer read() {
+        if (m_buffer_count == m_fail_at) {
+            throw std::runtime_error{"source failed"};
+        }
+        if (m_buffer_count == m_num_buffers) {
+            return osmium::memory::Buffer{};
+        }
+
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        for (int i = 0; i < m_nodes_per_buffer; ++i) {
+            const auto id = m_buffer_count * m_nodes_per_buffer + i + 1;
+            osmium::builder::add_node(buffer, osmium::builder::attr::_id(id));
+        }
+        ++m_buffer_count;
+        return buffer;
+    }
+
+}; // class MockSource
+
+struct CountHandler : public osmium::handler::Handler {
+
+    int nodes = 0;
+    std::int64_t id_sum = 0;
+    int flushed = 0;
+
+    void node(const osmium::Node& node) noexcept {
+        ++nodes;
+        id_sum += node.id();
+    }
+
+    void flush() noexcept {
+        ++flushed;
+    }
+
+}; // struct CountHandler
+
+struct FailingHandler : public osmium::handler::Handler {
+
+    void node(const osmium::Node& node) {
+        if (node.id() == 250) {
+            throw std::runtime_error{"handler failed"};
+        }
+    }
+
+}; // struct FailingHandler
+
+TEST_CASE("Parallel apply with several threads") {
+    MockSource source{100, 10};
+
+    int num_handlers = 0;
+    int nodes = 0;
+    std::int64_t id_sum = 0;
+    int flushed = 0;
+
+    osmium::thread::parallel_apply(source, [&num_handlers]() {
+        ++num_handlers;
+        return CountHandler{};
+    }, [&](const CountHandler& handler) {
+        nodes += handler.nodes;
+        id_sum += handler.id_sum;
+        flushed += handler.flushed;
+    }, 4);
+
+    REQUIRE(num_handlers == 4);
+    REQUIRE(nodes == 1000);
+    REQUIRE(id_sum == 1000 * 1001 / 2);
+    REQUIRE(flushed == 4);
+}
+
+TEST_CASE("Parallel apply with empty source") {
+    MockSource source{0, 10};
+
+    int merged = 0;
+    osmium::thread::parallel_apply(source, []() {
+        return CountHandler{};
+    }, [&merged](const CountHandler& handler) {
+        REQUIRE(handler.nodes == 0);
+        ++merged;
+    }, 2);
+
+    REQUIRE(merged == 2);
+}
+
+TEST_CASE("Parallel apply re-throws exception from source") {
+    MockSource source{100, 10, 50};
+
+    int merged = 0;
+    REQUIRE_THROWS_AS(osmium::thread::parallel_apply(source, []() {
+        return CountHandler{};
+    }, [&merged](const CountHandler& /*handler*/) {
+        ++merged;
+    }, 3), const std::runtime_error&);
+
+    REQUIRE(merged == 0);
+}
+
+TEST_CASE("Parallel apply re-throws exception from handler") {
+    MockSource source{100, 10};
+
+    REQUIRE_THROWS_AS(osmium::thread::parallel_apply(source, []() {
+        return FailingHandler{};
+    }, [](const FailingHandler& /*handler*/) {
+    }, 3), const std::runtime_error&);
+}
+
+struct CopyEvenNodes {
+
+    osmium::memory::Buffer operator()(osmium::memory::Buffer&& buffer) {
+        osmium::memory::Buffer out{1024, osmium::memory::Buffer::auto_grow::yes};
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            if (node.id() % 2 == 0) {
+                out.add_item(node);
+                out.commit();
+            }
+        }
+        return out;
+    }
+
+}; // struct CopyEvenNodes
+
+TEST_CASE("Parallel apply with ordered output") {
+    MockSource source{200, 10};
+
+    std::vector<osmium::object_id_type> ids;
+    osmium::thread::parallel_apply_ordered(source, []() {
+        return CopyEvenNodes{};
+    }, [&ids](osmium::memory::Buffer&& buffer) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            ids.push_back(node.id());
+        }
+    }, 4);
+
+    REQUIRE(ids.size() == 1000);
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        REQUIRE(ids[i] == static_cast<osmium::object_id_type>(i + 1) * 2);
+    }
+}
+
+TEST_CASE("Parallel apply with ordered output doesn't output invalid buffers") {
+    MockSource source{20, 10};
+
+    int count = 0;
+    osmium::thread::parallel_apply_ordered(source, []() {
+        return [](osmium::memory::Buffer&& /*buffer*/) {
+            return osmium::memory::Buffer{};
+        };
+    }, [&count](osmium::memory::Buffer&& /*buffer*/) {
+        ++count;
+    }, 2);
+
+    REQUIRE(count == 0);
+}
+
+TEST_CASE("Parallel apply with ordered output re-throws exceptions") {
+    SECTION("from source") {
+        MockSource source{100, 10, 30};
+        REQUIRE_THROWS_AS(osmium::thread::parallel_apply_ordered(source, []() {
+            return CopyEvenNodes{};
+        }, [](osmium::memory::Buffer&& /*buffer*/) {
+        }, 3), const std::runtime_error&);
+    }
+
+    SECTION("from handler") {
+        MockSource source{100, 10};
+        int count = 0;
+        REQUIRE_THROWS_AS(osmium::thread::parallel_apply_ordered(source, []() {
+            return [](osmium::memory::Buffer&& buffer) -> osmium::memory::Buffer {
+                if (buffer.get<osmium::Node>(0).id() == 501) {
+                    throw std::runtime_error{"handler failed"};
+                }
+                return std::move(buffer);
+            };
+        }, [&count](osmium::memory::Buffer&& /*buffer*/) {
+            ++count;
+        }, 3), const std::runtime_error&);
+        REQUIRE(count == 50);
+    }
+
+    SECTION("from output") {
+        MockSource source{100, 10};
+        int count = 0;
+        REQUIRE_THROWS_AS(osmium::thread::parallel_apply_ordered(source, []() {
+            return CopyEvenNodes{};
+        }, [&count](osmium::memory::Buffer&& /*buffer*/) {
+            if (++count == 10) {
+                throw std::runtime_error{"output failed"};
+            }
+        }, 3), const std::runtime_error&);
+        REQUIRE(count == 10);
+    }
+}
@@ -0,0 +1,185 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/thread/pipeline.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+class MockSource {
+
+    int m_num_buffers;
+    int m_nodes_per_buffer;
+    int m_fail_at;
+    int m_buffer_count = 0;
+
+public:
+
+    MockSource(int num_buffers, int nodes_per_buffer, int fail_at = -1) :
+        m_num_buffers(num_buffers),
+        m_nodes_per_buffer(nodes_per_buffer),
+        m_fail_at(fail_at) {
+    }
+
+    osmium::memory::Buffer read() {
+        if (m_buffer_count == m_fail_at) {
+            throw std::runtime_error{"source failed"};
+        }
+        if (m_buffer_count == m_num_buffers) {
+            return osmium::memory::Buffer{};
+        }
+
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        for (int i = 0; i < m_nodes_per_buffer; ++i) {
+            const auto id = m_buffer_count * m_nodes_per_buffer + i + 1;
+            osmium::builder::add_node(buffer, osmium::builder::attr::_id(id));
+        }
+        ++m_buffer_count;
+        return buffer;
+    }
+
+}; // class MockSource
+
+osmium::memory::Buffer copy_even_nodes(osmium::memory::Buffer&& buffer) {
+    osmium::memory::Buffer out{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (const auto& node : buffer.select<osmium::Node>()) {
+        if (node.id() % 2 == 0) {
+            out.add_item(node);
+            out.commit();
+        }
+    }
+    return out;
+}
+
+struct SetVersionHandler : public osmium::handler::Handler {
+
+    osmium::object_version_type version = 0;
+
+    void node(osmium::Node& node) noexcept {
+        node.set_version(++version);
+    }
+
+}; // struct SetVersionHandler
+
+class Collector {
+
+    std::vector<osmium::Node*> m_nodes;
+    std::vector<osmium::memory::Buffer> m_buffers;
+
+public:
+
+    void operator()(osmium::memory::Buffer&& buffer) {
+        m_buffers.push_back(std::move(buffer));
+        for (auto& node : m_buffers.back().select<osmium::Node>()) {
+            m_nodes.push_back(&node);
+        }
+    }
+
+    const std::vector<osmium::Node*>& nodes() const noexcept {
+        return m_nodes;
+    }
+
+}; // class Collector
+
+TEST_CASE("Pipeline without stages") {
+    MockSource source{10, 10};
+    osmium::thread::Pipeline pipeline{5};
+    REQUIRE(pipeline.queue_size() == 5);
+    REQUIRE(pipeline.num_stages() == 0);
+
+    Collector collector;
+    pipeline.run(source, collector);
+
+    REQUIRE(collector.nodes().size() == 100);
+    for (std::size_t i = 0; i < collector.nodes().size(); ++i) {
+        REQUIRE(collector.nodes()[i]->id() == static_cast<osmium::object_id_type>(i + 1));
+    }
+}
+
+TEST_CASE("Pipeline with several stages keeps order") {
+    MockSource source{200, 10};
+    SetVersionHandler handler;
+
+    osmium::thread::Pipeline pipeline{4};
+    pipeline.add_stage(copy_even_nodes, 4, "filter")
+            .add_handler_stage(handler, "version")
+            .add_stage([](osmium::memory::Buffer&& buffer) {
+                return std::move(buffer);
+            }, 3);
+    REQUIRE(pipeline.num_stages() == 3);
+
+    Collector collector;
+    pipeline.run(source, collector);
+
+    REQUIRE(handler.version == 1000);
+    REQUIRE(collector.nodes().size() == 1000);
+    for (std::size_t i = 0; i < collector.nodes().size(); ++i) {
+        REQUIRE(collector.nodes()[i]->id() == static_cast<osmium::object_id_type>(i + 1) * 2);
+        REQUIRE(collector.nodes()[i]->version() == i + 1);
+    }
+}
+
+TEST_CASE("Pipeline doesn't give invalid buffers to later stages") {
+    MockSource source{20, 10};
+
+    int calls = 0;
+    int count = 0;
+    osmium::thread::Pipeline pipeline;
+    pipeline.add_stage([](osmium::memory::Buffer&& /*buffer*/) {
+        return osmium::memory::Buffer{};
+    }, 2).add_stage([&calls](osmium::memory::Buffer&& buffer) {
+        ++calls;
+        return std::move(buffer);
+    });
+
+    pipeline.run(source, [&count](osmium::memory::Buffer&& /*buffer*/) {
+        ++count;
+    });
+
+    REQUIRE(calls == 0);
+    REQUIRE(count == 0);
+}
+
+TEST_CASE("Pipeline re-throws exceptions") {
+    osmium::thread::Pipeline pipeline{3};
+    int count = 0;
+
+    SECTION("from source") {
+        MockSource source{100, 10, 30};
+        pipeline.add_stage(copy_even_nodes, 2);
+        REQUIRE_THROWS_AS(pipeline.run(source, [&count](osmium::memory::Buffer&& /*buffer*/) {
+            ++count;
+        }), const std::runtime_error&);
+        REQUIRE(count == 30);
+    }
+
+    SECTION("from stage") {
+        MockSource source{100, 10};
+        pipeline.add_stage(copy_even_nodes, 2);
+        pipeline.add_stage([](osmium::memory::Buffer&& buffer) -> osmium::memory::Buffer {
+            if (buffer.get<osmium::Node>(0).id() == 502) {
+                throw std::runtime_error{"stage failed"};
+            }
+            return std::move(buffer);
+        }, 3);
+        pipeline.add_stage(copy_even_nodes, 2);
+        REQUIRE_THROWS_AS(pipeline.run(source, [&count](osmium::memory::Buffer&& /*buffer*/) {
+            ++count;
+        }), const std::runtime_error&);
+        REQUIRE(count == 50);
+    }
+
+    SECTION("from sink") {
+        MockSource source{100, 10};
+        pipeline.add_stage(copy_even_nodes, 2);
+        REQUIRE_THROWS_AS(pipeline.run(source, [&count](osmium::memory::Buffer&& /*buffer*/) {
+            if (++count == 10) {
+                throw std::runtime_error{"sink failed"};
+            }
+        }), const std::runtime_error&);
+        REQUIRE(count == 10);
+    }
+}
@@ -3,9 +3,12 @@
 #include <osmium/thread/pool.hpp>
 #include <osmium/util/compatibility.hpp>
 
+#include <atomic>
 #include <chrono>
+#include <future>
 #include <stdexcept>
 #include <thread>
+#include <vector>
 
 struct test_job_with_result {
     int operator()() const {
@@ -116,3 +119,92 @@ TEST_CASE("thread (user-provided pool)") {
 
 }
 
+
+TEST_CASE("thread pool with pinned threads") {
+
+    osmium::thread::Pool pool{3, 0, true};
+    REQUIRE(pool.pin_threads());
+
+    auto future = pool.submit(test_job_with_result{});
+    REQUIRE(future.get() == 42);
+}
+
+TEST_CASE("thread pool runs all submitted tasks") {
+
+    osmium::thread::Pool pool{4, 3};
+    std::atomic<int> count{0};
+
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 1000; ++i) {
+        futures.push_back(pool.submit([&count, i]() {
+            ++count;
+            return i;
+        }));
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(futures[i].get() == i);
+    }
+    REQUIRE(count == 1000);
+    REQUIRE(pool.queue_empty());
+}
+
+TEST_CASE("thread pool tasks can be submitted from several threads") {
+
+    osmium::thread::Pool pool{3, 2};
+    std::atomic<int> count{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&pool, &count]() {
+            std::vector<std::future<void>> futures;
+            for (int i = 0; i < 200; ++i) {
+                futures.push_back(pool.submit([&count]() {
+                    ++count;
+                }));
+            }
+            for (auto& future : futures) {
+                future.get();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE(count == 800);
+}
+
+TEST_CASE("thread pool tasks can submit tasks") {
+
+    osmium::thread::Pool pool{2, 2};
+
+    auto future = pool.submit([&pool]() {
+        // Submitting from inside the pool must not block even if the
+        // queue is full.
+        std::vector<std::future<int>> futures;
+        for (int i = 0; i < 10; ++i) {
+            futures.push_back(pool.submit(test_job_with_result{}));
+        }
+        return static_cast<int>(futures.size());
+    });
+
+    REQUIRE(future.get() == 10);
+}
+
+TEST_CASE("thread pool finishes submitted tasks on destruction") {
+
+    std::atomic<int> count{0};
+    {
+        osmium::thread::Pool pool{2};
+        for (int i = 0; i < 5; ++i) {
+            pool.submit([&count]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                ++count;
+            });
+        }
+    }
+
+    REQUIRE(count == 5);
+}
+
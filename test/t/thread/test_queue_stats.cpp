@@ -0,0 +1,191 @@
+#include "catch.hpp"
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/bounded_queue.hpp>
+#include <osmium/thread/ordered_queue.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/queue.hpp>
+#include <osmium/thread/queue_stats.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static bool has_queue(const std::string& name) {
+    const auto stats = osmium::thread::get_queue_stats();
+    return std::any_of(stats.cbegin(), stats.cend(), [&name](const osmium::thread::queue_stats& s) {
+        return s.name == name;
+    });
+}
+
+TEST_CASE("Bytes of queue items") {
+    REQUIRE(osmium::thread::detail::queue_item_bytes(std::string{"abc"}) == 3);
+    REQUIRE(osmium::thread::detail::queue_item_bytes(17) == 0);
+
+    osmium::memory::Buffer buffer{1024};
+    buffer.reserve_space(64);
+    buffer.commit();
+    REQUIRE(osmium::thread::detail::queue_item_bytes(buffer) == 64);
+}
+
+TEST_CASE("Stats of bounded queue") {
+    osmium::thread::BoundedQueue<std::string> queue{4, "test_bounded"};
+
+    queue.push("abc");
+    queue.push("defgh");
+    std::string value;
+    queue.wait_and_pop(value);
+    REQUIRE(value == "abc");
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.name == "test_bounded");
+    REQUIRE(stats.capacity == 4);
+    REQUIRE(stats.size == 1);
+    REQUIRE(stats.max_size == 2);
+    REQUIRE(stats.pushed == 2);
+    REQUIRE(stats.popped == 1);
+    REQUIRE(stats.bytes_pushed == 8);
+    REQUIRE(stats.full_count == 0);
+    REQUIRE(stats.empty_count == 0);
+    REQUIRE(stats.lifetime.count() > 0);
+}
+
+TEST_CASE("Stats of ordered queue") {
+    osmium::thread::OrderedQueue<std::string> queue{4, "test_ordered"};
+
+    const auto t1 = queue.reserve();
+    const auto t2 = queue.reserve();
+    queue.set_value(t2, "xy");
+    queue.set_value(t1, "z");
+    REQUIRE(queue.pop() == "z");
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.name == "test_ordered");
+    REQUIRE(stats.capacity == 4);
+    REQUIRE(stats.size == 1);
+    REQUIRE(stats.max_size == 2);
+    REQUIRE(stats.pushed == 2);
+    REQUIRE(stats.popped == 1);
+    REQUIRE(stats.bytes_pushed == 3);
+}
+
+TEST_CASE("Stats of queue") {
+    osmium::thread::Queue<int> queue{0, "test_queue"};
+
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+    int value = 0;
+    REQUIRE(queue.try_pop(value));
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.name == "test_queue");
+    REQUIRE(stats.capacity == 0);
+    REQUIRE(stats.size == 2);
+    REQUIRE(stats.max_size == 3);
+    REQUIRE(stats.pushed == 3);
+    REQUIRE(stats.popped == 1);
+    REQUIRE(stats.bytes_pushed == 0);
+}
+
+TEST_CASE("Wait times are recorded") {
+    osmium::thread::BoundedQueue<int> queue{2, "test_wait"};
+
+    std::thread consumer{[&queue]() {
+        int value = 0;
+        queue.wait_and_pop(value);
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        queue.wait_and_pop(value);
+    }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+    queue.push(4); // blocks until the consumer pops the second time
+    consumer.join();
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.empty_count == 1);
+    REQUIRE(stats.empty_wait >= std::chrono::milliseconds{10});
+    REQUIRE(stats.full_count >= 1);
+    REQUIRE(stats.full_wait >= std::chrono::milliseconds{10});
+}
+
+TEST_CASE("Queues are registered while they exist") {
+    REQUIRE_FALSE(has_queue("test_registered"));
+    {
+        osmium::thread::BoundedQueue<int> queue{2, "test_registered"};
+        REQUIRE(has_queue("test_registered"));
+    }
+    REQUIRE_FALSE(has_queue("test_registered"));
+}
+
+TEST_CASE("Stats of pool") {
+    osmium::thread::Pool pool{2};
+    REQUIRE(has_queue("pool"));
+
+    auto f1 = pool.submit([] {
+        return 1;
+    });
+    auto f2 = pool.submit([] {
+        return 2;
+    });
+    REQUIRE(f1.get() + f2.get() == 3);
+
+    const auto stats = pool.stats();
+    REQUIRE(stats.name == "pool");
+    REQUIRE(stats.pushed == 2);
+    REQUIRE(stats.max_size >= 1);
+}
+
+TEST_CASE("Output of queue stats") {
+    osmium::thread::queue_stats stats;
+    stats.name = "test";
+    stats.capacity = 10;
+    stats.size = 3;
+
+    std::ostringstream out;
+    out << stats;
+    REQUIRE(out.str().substr(0, 24) == "queue 'test' size=3/10 m");
+}
+
+TEST_CASE("Rates of queue stats") {
+    osmium::thread::queue_stats stats;
+    REQUIRE(stats.items_per_second() == Approx(0.0));
+
+    stats.popped = 100;
+    stats.bytes_pushed = 1000;
+    stats.lifetime = std::chrono::seconds{2};
+    REQUIRE(stats.items_per_second() == Approx(50.0));
+    REQUIRE(stats.bytes_per_second() == Approx(500.0));
+}
+
+TEST_CASE("Queue stats reporter") {
+    osmium::thread::BoundedQueue<int> queue{2, "test_reporter"};
+    std::atomic<int> calls{0};
+    std::atomic<bool> found{false};
+
+    {
+        osmium::thread::QueueStatsReporter reporter{std::chrono::milliseconds{1}, [&](const std::vector<osmium::thread::queue_stats>& stats) {
+            ++calls;
+            for (const auto& s : stats) {
+                if (s.name == "test_reporter") {
+                    found = true;
+                }
+            }
+        }};
+
+        const auto start = std::chrono::steady_clock::now();
+        while (calls < 2 && std::chrono::steady_clock::now() - start < std::chrono::seconds{10}) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+    }
+
+    REQUIRE(calls >= 2);
+    REQUIRE(found);
+}
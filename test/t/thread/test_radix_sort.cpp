@@ -0,0 +1,93 @@
+#include "catch.hpp"
+
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/radix_sort.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+static std::vector<uint64_t> random_keys(std::size_t size, uint64_t max) {
+    std::mt19937_64 gen{42};
+    std::uniform_int_distribution<uint64_t> dist{0, max};
+    std::vector<uint64_t> keys;
+    keys.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        keys.push_back(dist(gen));
+    }
+    return keys;
+}
+
+static uint64_t identity(uint64_t value) noexcept {
+    return value;
+}
+
+TEST_CASE("Radix sort of empty and tiny ranges") {
+    std::vector<uint64_t> data;
+    std::vector<uint64_t> scratch(2);
+
+    osmium::thread::radix_sort(data.begin(), data.end(), scratch.begin(), identity);
+    REQUIRE(data.empty());
+
+    data.push_back(7);
+    osmium::thread::radix_sort(data.begin(), data.end(), scratch.begin(), identity);
+    REQUIRE(data == std::vector<uint64_t>{7});
+
+    data.push_back(3);
+    osmium::thread::radix_sort(data.begin(), data.end(), scratch.begin(), identity);
+    REQUIRE(data == (std::vector<uint64_t>{3, 7}));
+}
+
+TEST_CASE("Radix sort of random keys") {
+    osmium::thread::Pool pool{3};
+
+    for (const uint64_t max : {uint64_t{0}, uint64_t{255}, uint64_t{1} << 20U, uint64_t{1} << 40U, ~uint64_t{0}}) {
+        auto data = random_keys(100000, max);
+        auto expected = data;
+        std::sort(expected.begin(), expected.end());
+
+        auto data_single = data;
+        std::vector<uint64_t> scratch(data.size());
+
+        osmium::thread::radix_sort(data.begin(), data.end(), scratch.begin(), identity, &pool);
+        REQUIRE(data == expected);
+
+        osmium::thread::radix_sort(data_single.begin(), data_single.end(), scratch.begin(), identity, nullptr);
+        REQUIRE(data_single == expected);
+    }
+}
+
+TEST_CASE("Radix sort is stable") {
+    osmium::thread::Pool pool{2};
+
+    const auto keys = random_keys(50000, 1000);
+    std::vector<std::pair<uint64_t, std::size_t>> data;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        data.emplace_back(keys[i], i);
+    }
+
+    std::vector<std::pair<uint64_t, std::size_t>> scratch(data.size());
+    osmium::thread::radix_sort(data.begin(), data.end(), scratch.begin(), [](const std::pair<uint64_t, std::size_t>& element) {
+        return element.first;
+    }, &pool);
+
+    // Index is increasing within equal keys, so this is the same as
+    // sorting the pairs.
+    REQUIRE(std::is_sorted(data.cbegin(), data.cend()));
+}
+
+TEST_CASE("Radix sort re-throws exception from key function") {
+    osmium::thread::Pool pool{2};
+
+    auto data = random_keys(10000, 1000);
+    std::vector<uint64_t> scratch(data.size());
+    REQUIRE_THROWS_AS(osmium::thread::radix_sort(data.begin(), data.end(), scratch.begin(), [](uint64_t value) -> uint64_t {
+        if (value == 500) {
+            throw std::runtime_error{"key failed"};
+        }
+        return value;
+    }, &pool), const std::runtime_error&);
+}
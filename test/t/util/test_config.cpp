@@ -66,6 +66,51 @@ TEST_CASE("use_pool_threads_for_pbf_parsing") {
     REQUIRE(osmium::config::use_pool_threads_for_pbf_parsing());
 }
 
+TEST_CASE("use_huge_pages") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::use_huge_pages());
+    REQUIRE(osmium::detail::name == "OSMIUM_USE_HUGE_PAGES");
+    osmium::detail::env = "";
+    REQUIRE_FALSE(osmium::config::use_huge_pages());
+    osmium::detail::env = "off";
+    REQUIRE_FALSE(osmium::config::use_huge_pages());
+    osmium::detail::env = "0";
+    REQUIRE_FALSE(osmium::config::use_huge_pages());
+
+    osmium::detail::env = "on";
+    REQUIRE(osmium::config::use_huge_pages());
+    osmium::detail::env = "TRUE";
+    REQUIRE(osmium::config::use_huge_pages());
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::use_huge_pages());
+    osmium::detail::env = "1";
+    REQUIRE(osmium::config::use_huge_pages());
+}
+
+TEST_CASE("get_numa_policy") {
+    osmium::detail::env = nullptr;
+    REQUIRE(osmium::config::get_numa_policy() == osmium::config::numa_policy::none);
+    REQUIRE(osmium::detail::name == "OSMIUM_NUMA_POLICY");
+    osmium::detail::env = "";
+    REQUIRE(osmium::config::get_numa_policy() == osmium::config::numa_policy::none);
+    osmium::detail::env = "foo";
+    REQUIRE(osmium::config::get_numa_policy() == osmium::config::numa_policy::none);
+    osmium::detail::env = "interleave";
+    REQUIRE(osmium::config::get_numa_policy() == osmium::config::numa_policy::interleave);
+    osmium::detail::env = "Local";
+    REQUIRE(osmium::config::get_numa_policy() == osmium::config::numa_policy::local);
+}
+
+TEST_CASE("pin_threads") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::pin_threads());
+    REQUIRE(osmium::detail::name == "OSMIUM_PIN_THREADS");
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::pin_threads());
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::pin_threads());
+}
+
 TEST_CASE("get_max_queue_size") {
     osmium::detail::env = nullptr;
     REQUIRE(osmium::config::get_max_queue_size("NAME", 0) == 0);
@@ -3,6 +3,7 @@
 #include <osmium/util/file.hpp>
 #include <osmium/util/memory_mapping.hpp>
 
+#include <algorithm>
 #include <cstdlib>
 #include <limits>
 #include <utility>
@@ -110,6 +111,28 @@ TEST_CASE("Anonymous mapping: remapping to smaller size should work") {
 }
 #endif
 
+TEST_CASE("Anonymous mapping: requesting huge pages should work") {
+    const std::size_t size = 8 * 1024 * 1024;
+    osmium::MemoryMapping mapping{size, osmium::MemoryMapping::mapping_mode::write_private};
+    REQUIRE_FALSE(mapping.huge_pages());
+
+    const bool huge_pages = mapping.use_huge_pages();
+    REQUIRE(mapping.huge_pages() == huge_pages);
+
+    auto* addr = mapping.get_addr<char>();
+    std::fill_n(addr, size, 'x');
+    REQUIRE(mapping.huge_page_bytes() <= size);
+
+#ifdef __linux__
+    mapping.resize(2 * size);
+    REQUIRE(mapping.huge_pages() == huge_pages);
+    REQUIRE(mapping.get_addr<char>()[size - 1] == 'x');
+#endif
+
+    osmium::MemoryMapping mapping2{std::move(mapping)};
+    REQUIRE(mapping2.huge_pages() == huge_pages);
+}
+
 TEST_CASE("File-based mapping: writing to a mapped file should work") {
     char filename[] = "test_mmap_write_XXXXXX";
     const int fd = mkstemp(filename);
@@ -0,0 +1,76 @@
+#include "catch.hpp"
+
+#include <osmium/util/config.hpp>
+#include <osmium/util/memory_mapping.hpp>
+#include <osmium/util/numa.hpp>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Parse cpu list") {
+    REQUIRE(osmium::detail::parse_cpu_list("").empty());
+    REQUIRE(osmium::detail::parse_cpu_list("foo").empty());
+    REQUIRE(osmium::detail::parse_cpu_list("0") == std::vector<int>({0}));
+    REQUIRE(osmium::detail::parse_cpu_list("0-3") == std::vector<int>({0, 1, 2, 3}));
+    REQUIRE(osmium::detail::parse_cpu_list("0-1,4,8-9") == std::vector<int>({0, 1, 4, 8, 9}));
+    REQUIRE(osmium::detail::parse_cpu_list("2,5\n") == std::vector<int>({2, 5}));
+}
+
+TEST_CASE("NUMA topology has at least one node and cpu") {
+    const auto& topology = osmium::NumaTopology::system();
+    REQUIRE(topology.num_nodes() >= 1);
+    REQUIRE(topology.num_cpus() >= topology.num_nodes());
+
+    std::size_t num_cpus = 0;
+    for (std::size_t n = 0; n < topology.num_nodes(); ++n) {
+        REQUIRE_FALSE(topology.cpus(n).empty());
+        num_cpus += topology.cpus(n).size();
+    }
+    REQUIRE(num_cpus == topology.num_cpus());
+
+    const auto& cpus = topology.cpus(0);
+    REQUIRE(std::find(cpus.begin(), cpus.end(), topology.cpu_for_thread(0)) != cpus.end());
+    REQUIRE(topology.cpu_for_thread(topology.num_cpus()) == topology.cpu_for_thread(0));
+}
+
+#ifdef __linux__
+TEST_CASE("Pin thread to cpu and node") {
+    const auto& topology = osmium::NumaTopology::system();
+
+    bool pinned_to_cpu = false;
+    bool pinned_to_node = false;
+    std::thread thread{[&]() {
+        pinned_to_cpu = osmium::pin_current_thread_to_cpu(topology.cpu_for_thread(0));
+        pinned_to_node = osmium::pin_current_thread_to_node(0);
+    }};
+    thread.join();
+
+    REQUIRE(pinned_to_cpu);
+    REQUIRE(pinned_to_node);
+    REQUIRE_FALSE(osmium::pin_current_thread_to_cpu(-1));
+    REQUIRE_FALSE(osmium::pin_current_thread_to_node(topology.num_nodes()));
+}
+
+TEST_CASE("Set NUMA policy on memory mapping") {
+    const std::size_t size = 1024 * 1024;
+    osmium::MemoryMapping mapping{size, osmium::MemoryMapping::mapping_mode::write_private};
+    REQUIRE(mapping.numa_policy() == osmium::config::numa_policy::none);
+
+    // This might fail if the kernel doesn't support NUMA, but the mapping
+    // must work anyway.
+    const bool success = mapping.set_numa_policy(osmium::config::numa_policy::interleave);
+    if (success) {
+        REQUIRE(mapping.numa_policy() == osmium::config::numa_policy::interleave);
+    } else {
+        REQUIRE(mapping.numa_policy() == osmium::config::numa_policy::none);
+    }
+
+    auto* addr = mapping.get_addr<char>();
+    std::fill_n(addr, size, 'x');
+
+    mapping.resize(2 * size);
+    REQUIRE(mapping.get_addr<char>()[size - 1] == 'x');
+}
+#endif
+
@@ -0,0 +1,18 @@
+#include "catch.hpp"
+
+#include <osmium/util/trace.hpp>
+
+#include <sstream>
+
+TEST_CASE("Trace session without OSMIUM_WITH_TRACE") {
+    osmium::TraceSession session{"test-trace.json"};
+    {
+        osmium::TraceSpan span{"span", 1};
+    }
+    REQUIRE(session.num_events() == 0);
+
+    std::ostringstream out;
+    osmium::write_chrome_trace(out);
+    REQUIRE(out.str().empty());
+    session.close();
+}
@@ -0,0 +1,105 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#define OSMIUM_WITH_TRACE
+#include <osmium/util/trace.hpp>
+
+TEST_CASE("Spans outside of a trace session are not recorded") {
+    {
+        osmium::TraceSpan span{"outside"};
+    }
+    std::ostringstream out;
+    osmium::write_chrome_trace(out);
+    REQUIRE(out.str().find("outside") == std::string::npos);
+}
+
+TEST_CASE("Spans from several threads are recorded") {
+    osmium::TraceSession session{"test-trace.json"};
+    {
+        osmium::TraceSpan span{"main_span", 7};
+    }
+    std::thread thread{[]() {
+        osmium::TraceSpan span{"thread_span", 8};
+    }};
+    thread.join();
+    REQUIRE(session.num_events() == 2);
+
+    std::ostringstream out;
+    osmium::write_chrome_trace(out);
+    const std::string trace = out.str();
+    REQUIRE(trace.substr(0, 15) == "{\"traceEvents\":");
+    REQUIRE(trace.find(R"("name":"main_span","cat":"osmium","ph":"X")") != std::string::npos);
+    REQUIRE(trace.find(R"("name":"thread_span")") != std::string::npos);
+    REQUIRE(trace.find(R"("args":{"seq":7})") != std::string::npos);
+    REQUIRE(trace.find(R"("args":{"seq":8})") != std::string::npos);
+    REQUIRE(trace.find(R"("name":"thread_name","ph":"M")") != std::string::npos);
+
+    session.close();
+    {
+        osmium::TraceSpan span{"after_close"};
+    }
+    REQUIRE(session.num_events() == 2);
+}
+
+TEST_CASE("New trace session starts with no events") {
+    osmium::TraceSession session{"test-trace.json"};
+    REQUIRE(session.num_events() == 0);
+}
+
+TEST_CASE("Trace session throws if file can't be written") {
+    osmium::TraceSession session{"does-not-exist/test-trace.json"};
+    REQUIRE_THROWS_AS(session.close(), const std::system_error&);
+}
+
+static std::size_t count_threads_in_trace() {
+    std::ostringstream out;
+    osmium::write_chrome_trace(out);
+    const std::string trace = out.str();
+    std::size_t count = 0;
+    for (auto pos = trace.find("thread_name"); pos != std::string::npos; pos = trace.find("thread_name", pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+TEST_CASE("Buffers of finished threads are released when a new session starts") {
+    {
+        osmium::TraceSession session{"test-trace.json"};
+        for (int i = 0; i < 10; ++i) {
+            std::thread thread{[]() {
+                osmium::TraceSpan span{"thread_span"};
+            }};
+            thread.join();
+        }
+        REQUIRE(session.num_events() == 10);
+        REQUIRE(count_threads_in_trace() >= 10);
+    }
+
+    osmium::TraceSession session{"test-trace.json"};
+    // Only the buffer of the main thread (if it recorded anything) is left.
+    REQUIRE(count_threads_in_trace() <= 1);
+}
+
+TEST_CASE("Spans can end while a new session is started") {
+    std::atomic<bool> done{false};
+    osmium::TraceSession session{"test-trace.json"};
+    std::thread thread{[&done]() {
+        while (!done) {
+            osmium::TraceSpan span{"busy"};
+        }
+    }};
+    while (session.num_events() == 0) {
+        std::this_thread::yield();
+    }
+    for (int i = 0; i < 100; ++i) {
+        osmium::detail::trace_registry::instance().start();
+    }
+    done = true;
+    thread.join();
+}